@@ -217,6 +217,30 @@ out:
     return rc;
 }
 
+static int reconstruct_queues (std::shared_ptr<qmanager_ctx_t> &ctx)
+{
+    int rc = 0;
+
+    for (auto &kv : ctx->hello_jobs) {
+        const std::string &queue_name = kv.first;
+        std::shared_ptr<queue_policy_base_t> &queue
+            = ctx->queues.at (queue_name);
+        if ( (rc = queue->reconstruct (static_cast<void *> (ctx->h),
+                                       kv.second)) < 0) {
+            flux_log_error (ctx->h, "%s: reconstruct (queue=%s njobs=%zu)",
+                            __FUNCTION__, queue_name.c_str (),
+                            kv.second.size ());
+            goto out;
+        }
+        flux_log (ctx->h, LOG_DEBUG, "requeue success (queue=%s njobs=%zu)",
+                  queue_name.c_str (), kv.second.size ());
+    }
+
+out:
+    ctx->hello_jobs.clear ();
+    return rc;
+}
+
 static int handshake_jobmanager (std::shared_ptr<qmanager_ctx_t> &ctx)
 {
     int rc = -1;
@@ -226,6 +250,10 @@ static int handshake_jobmanager (std::shared_ptr<qmanager_ctx_t> &ctx)
         flux_log_error (ctx->h, "%s: schedutil_hello", __FUNCTION__);
         goto out;
     }
+    if (reconstruct_queues (ctx) < 0) {
+        flux_log_error (ctx->h, "%s: reconstruct_queues", __FUNCTION__);
+        goto out;
+    }
     if (schedutil_ready (ctx->schedutil, "unlimited", &queue_depth)) {
         flux_log_error (ctx->h, "%s: schedutil_ready", __FUNCTION__);
         goto out;
@@ -143,10 +143,8 @@ int qmanager_cb_t::jobmanager_hello_cb (flux_t *h, const flux_msg_t *msg,
     int rc = 0;
     json_t *o = NULL;
     json_error_t err;
-    std::string R_out;
     char *qn_attr = NULL;
     std::string queue_name;
-    std::shared_ptr<queue_policy_base_t> queue;
     std::shared_ptr<job_t> running_job = nullptr;
     qmanager_cb_ctx_t *ctx = static_cast<qmanager_cb_ctx_t *> (arg);
     flux_jobid_t id;
@@ -185,19 +183,20 @@ int qmanager_cb_t::jobmanager_hello_cb (flux_t *h, const flux_msg_t *msg,
 
     queue_name = qn_attr? qn_attr : ctx->opts.get_opt ().get_default_queue ();
     json_decref (o);
-    queue = ctx->queues.at (queue_name);
+    if (ctx->queues.find (queue_name) == ctx->queues.end ()) {
+        rc = -1;
+        errno = ENOENT;
+        flux_log_error (h, "%s: unknown queue (id=%jd queue=%s)", __FUNCTION__,
+                        static_cast<intmax_t> (id), queue_name.c_str ());
+        goto out;
+    }
     running_job = std::make_shared<job_t> (job_state_kind_t::RUNNING,
                                                    id, uid, calc_priority (prio),
                                                    ts, R);
 
-    if ( (rc = queue->reconstruct (static_cast<void *> (h),
-                                   running_job, R_out)) < 0) {
-        flux_log_error (h, "%s: reconstruct (id=%jd queue=%s)", __FUNCTION__,
-                       static_cast<intmax_t> (id), queue_name.c_str ());
-        goto out;
-    }
-    flux_log (h, LOG_DEBUG, "requeue success (queue=%s id=%jd)",
-              queue_name.c_str (), static_cast<intmax_t> (id));
+    // Running jobs are reconstructed in bulk once the hello
+    // handshake completes: see qmanager's handshake_jobmanager.
+    ctx->hello_jobs[queue_name].push_back (running_job);
 
 out:
     return rc;
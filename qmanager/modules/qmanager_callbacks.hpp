@@ -47,6 +47,8 @@ struct qmanager_cb_ctx_t {
         Flux::opts_manager::qmanager_opts_t> opts;
     std::map<std::string, std::shared_ptr<
         Flux::queue_manager::queue_policy_base_t>> queues;
+    std::map<std::string, std::vector<std::shared_ptr<
+        Flux::queue_manager::job_t>>> hello_jobs;
 
     int find_queue (
             flux_jobid_t id, std::string &queue_name,
@@ -38,6 +38,7 @@ extern "C" {
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <boost/intrusive/set.hpp>
 
 #include "resource/hlapi/bindings/c++/reapi.hpp"
 #include "qmanager/config/queue_system_defaults.hpp"
@@ -80,9 +81,31 @@ struct t_stamps_t {
     uint64_t canceled_ts = 0;
 };
 
+/*! Fixed-size key that orders the pending job queue: by priority,
+ *  then by submit time and then by the order in which jobs entered
+ *  the queue. Unlike a heap-allocated vector of doubles, it is
+ *  compared field by field without any allocation.
+ */
+struct pending_key_t {
+    pending_key_t () = default;
+    pending_key_t (unsigned int p, double t, uint64_t ts)
+        : priority (p), t_submit (t), pending_ts (ts) { }
+    bool operator< (const pending_key_t &o) const
+    {
+        if (priority != o.priority)
+            return priority < o.priority;
+        if (t_submit != o.t_submit)
+            return t_submit < o.t_submit;
+        return pending_ts < o.pending_ts;
+    }
+    unsigned int priority = 0;
+    double t_submit = 0.0f;
+    uint64_t pending_ts = 0;
+};
+
 /*! Type to store a job's attributes.
  */
-class job_t {
+class job_t : public std::enable_shared_from_this<job_t> {
 public:
     ~job_t () { flux_msg_destroy (msg); }
     job_t () = default;
@@ -96,6 +119,10 @@ public:
     job_t& operator= (const job_t &s) = default;
 
     bool is_pending () { return state == job_state_kind_t::PENDING; }
+    pending_key_t pending_key () const
+    {
+        return pending_key_t (priority, t_submit, t_stamps.pending_ts);
+    }
 
     flux_msg_t *msg = NULL;
     job_state_kind_t state = job_state_kind_t::INIT;
@@ -107,8 +134,34 @@ public:
     std::string note = "";
     t_stamps_t t_stamps;
     schedule_t schedule;
+
+    /*! Links the job into the pending queue that holds it. A pending
+     *  job is unlinked through its own hook without any key search.
+     */
+    boost::intrusive::set_member_hook<> pending_hook;
+    bool in_provisional = false;
 };
 
+/*! Orders jobs in a pending queue by their pending keys.
+ */
+struct pending_less_t {
+    bool operator() (const job_t &a, const job_t &b) const
+    {
+        return a.pending_key () < b.pending_key ();
+    }
+};
+
+/*! Pending job queue: an intrusive ordered tree linked through each
+ *  job's own hook. Insertion allocates nothing, iteration yields the
+ *  jobs directly and a job is unlinked in amortized constant time.
+ *  The queue does not own its jobs: m_jobs keeps them alive.
+ */
+using pending_queue_t = boost::intrusive::set<
+    job_t,
+    boost::intrusive::member_hook<job_t, boost::intrusive::set_member_hook<>,
+                                  &job_t::pending_hook>,
+    boost::intrusive::compare<pending_less_t>>;
+
 
 namespace detail {
 class queue_policy_base_impl_t
@@ -130,22 +183,19 @@ protected:
     int process_provisional_cancel ();
     int insert_pending_job (std::shared_ptr<job_t> &job, bool into_provisional);
     int erase_pending_job (std::shared_ptr<job_t> &job, bool &found_in_prov);
+    void merge_provisional ();
     std::shared_ptr<job_t> pending_pop ();
     std::shared_ptr<job_t> alloced_pop ();
     std::shared_ptr<job_t> rejected_pop ();
     std::shared_ptr<job_t> complete_pop ();
     std::shared_ptr<job_t> reserved_pop ();
     std::shared_ptr<job_t> canceled_pop ();
-    std::map<std::vector<double>, flux_jobid_t>::iterator to_running (
-        std::map<std::vector<double>,
-                 flux_jobid_t>::iterator pending_iter,
-        bool use_alloced_queue);
+    pending_queue_t::iterator to_running (
+        pending_queue_t::iterator pending_iter, bool use_alloced_queue);
     std::map<uint64_t, flux_jobid_t>::iterator to_complete (
         std::map<uint64_t, flux_jobid_t>::iterator running_iter);
-    std::map<std::vector<double>, flux_jobid_t>::iterator to_rejected (
-        std::map<std::vector<double>,
-                 flux_jobid_t>::iterator pending_iter,
-        const std::string &note);
+    pending_queue_t::iterator to_rejected (
+        pending_queue_t::iterator pending_iter, const std::string &note);
 
     bool m_schedulable = false;
     bool m_scheduled = false;
@@ -158,15 +208,16 @@ protected:
     uint64_t m_cancel_cnt = 0;
     unsigned int m_queue_depth = DEFAULT_QUEUE_DEPTH;
     unsigned int m_max_queue_depth = MAX_QUEUE_DEPTH;
-    std::map<std::vector<double>, flux_jobid_t> m_pending;
-    std::map<std::vector<double>, flux_jobid_t> m_pending_provisional;
+    // m_jobs must outlive the pending queues linked into its jobs
+    std::unordered_map<flux_jobid_t, std::shared_ptr<job_t>> m_jobs;
+    pending_queue_t m_pending;
+    pending_queue_t m_pending_provisional;
     std::map<uint64_t, flux_jobid_t> m_pending_cancel_provisional;
     std::map<uint64_t, flux_jobid_t> m_running;
     std::map<uint64_t, flux_jobid_t> m_alloced;
     std::map<uint64_t, flux_jobid_t> m_complete;
     std::map<uint64_t, flux_jobid_t> m_rejected;
     std::map<uint64_t, flux_jobid_t> m_canceled;
-    std::map<flux_jobid_t, std::shared_ptr<job_t>> m_jobs;
     std::unordered_map<std::string, std::string> m_qparams;
     std::unordered_map<std::string, std::string> m_pparams;
 };
@@ -231,6 +282,28 @@ public:
     virtual int reconstruct_resource (void *h, std::shared_ptr<job_t> job,
                                       std::string &ret_R) = 0;
 
+    /*! Resource reconstruct interface for multiple running jobs
+     *  that must be implemented by derived classes. Unlike
+     *  reconstruct_resource, the resource states of all of the jobs
+     *  are requested to be reconstructed with a single request.
+     *
+     * \param h          Opaque handle. How it is used is an implementation
+     *                   detail. However, when it is used within a Flux's
+     *                   service module such as qmanager, it is expected
+     *                   to be a pointer to a flux_t object.
+     * \param jobs       vector of shared pointers to the running jobs whose
+     *                   resource states are being requested to be
+     *                   reconstructed. job->schedule.R is the requested R.
+     * \return           0 on success; -1 on error.
+     *                       EINVAL: invalid argument.
+     *                       ENOMEM: out of memory.
+     *                       ERANGE: out of range request.
+     *                       EPROTO: job->schedule.R doesn't comply.
+     *                       ENOTSUP: job->schedule.R has unsupported feature.
+     */
+    virtual int reconstruct_resources (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs) = 0;
+
     /*! Set queue parameters. Can be called multiple times.
      *
      * \param params     comma-delimited key-value pairs string
@@ -321,6 +394,27 @@ public:
      */
     int reconstruct (void *h, std::shared_ptr<job_t> job, std::string &R_out);
 
+    /*! Append multiple jobs into the internal running-job queue to
+     *  reconstruct the queue state. The resource states of all of the
+     *  jobs are reconstructed at once through reconstruct_resources,
+     *  so the cost is not bound by one round-trip per job.
+     *
+     * \param h          Opaque handle. How it is used is an implementation
+     *                   detail. However, when it is used within a Flux's
+     *                   service module such as qmanager, it is expected
+     *                   to be a pointer to a flux_t object.
+     * \param jobs       vector of shared pointers to the running jobs whose
+     *                   resource states are being requested to be
+     *                   reconstructed. job->schedule.R is the requested R.
+     *  \return          0 on success; -1 on error.
+     *                       EINVAL: invalid argument.
+     *                       ENOMEM: out of memory.
+     *                       ERANGE: out of range request.
+     *                       EPROTO: job->schedule.R doesn't comply.
+     *                       ENOTSUP: job->schedule.R has unsupported feature.
+     */
+    int reconstruct (void *h, std::vector<std::shared_ptr<job_t>> &jobs);
+
     /*! Reprioritize a job with a new priority.
      *
      *  \param id        jobid of flux_jobid_t type.
@@ -439,7 +533,25 @@ public:
      *  resource API. When a match fails, this method is called back
      *  by reapi_t.
      */
-    virtual int handle_match_failure (int errcode);
+    virtual int handle_match_failure (int64_t jobid, int errcode);
+
+protected:
+    /*! Reconstruct the resource states of multiple running jobs with
+     *  a single update_allocate_multi request of reapi_type. Derived
+     *  classes implement reconstruct_resources through this method.
+     *
+     * \param h          Opaque handle passed to reapi_type.
+     * \param jobs       vector of shared pointers to the running jobs whose
+     *                   resource states are being requested to be
+     *                   reconstructed. job->schedule.R is the requested R.
+     *                   job->schedule.at and ov are set on success.
+     * \return           0 on success; -1 on error.
+     *                       ENOMEM: out of memory.
+     *                       EPROTO: the reply doesn't match jobs.
+     */
+    template<class reapi_type>
+    int reconstruct_resources_multi (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs);
 
 private:
     int set_params (const std::string &params,
@@ -448,7 +560,7 @@ private:
                    std::unordered_map<std::string, std::string> &p_map);
     bool is_number (const std::string &num_str);
 
-    std::map<std::vector<double>, flux_jobid_t>::iterator m_pending_iter;
+    pending_queue_t::iterator m_pending_iter;
     bool m_iter_valid = false;
 };
 
@@ -242,7 +242,7 @@ int queue_policy_base_t::handle_match_success (
    return 0;
 }
 
-int queue_policy_base_t::handle_match_failure (int errcode)
+int queue_policy_base_t::handle_match_failure (int64_t jobid, int errcode)
 {
    return 0;
 }
@@ -261,6 +261,71 @@ int queue_policy_base_t::reconstruct (void *h, std::shared_ptr<job_t> job,
     return detail::queue_policy_base_impl_t::reconstruct_queue (job);
 }
 
+int queue_policy_base_t::reconstruct (void *h,
+                                      std::vector<std::shared_ptr<job_t>> &jobs)
+{
+    int rc = 0;
+    if (jobs.empty ())
+        return 0;
+    if ( (rc = reconstruct_resources (h, jobs)) < 0)
+        return rc;
+    for (auto &job : jobs) {
+        if ( (rc = detail::queue_policy_base_impl_t::reconstruct_queue (job)) < 0)
+            return rc;
+    }
+    return 0;
+}
+
+template<class reapi_type>
+int queue_policy_base_t::reconstruct_resources_multi (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs)
+{
+    size_t i = 0;
+    json_t *jarr = nullptr;
+    char *jobs_str = nullptr;
+    std::vector<resource_model::update_result_t> results;
+
+    if (!(jarr = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (auto &job : jobs) {
+        json_t *jobdesc;
+        if ( !(jobdesc = json_pack ("{s:I s:s}",
+                                      "jobid", job->id,
+                                      "R", job->schedule.R.c_str ()))
+            || json_array_append_new (jarr, jobdesc) < 0) {
+            json_decref (jarr);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    if ( !(jobs_str = json_dumps (jarr, JSON_COMPACT))) {
+        json_decref (jarr);
+        errno = ENOMEM;
+        return -1;
+    }
+    json_decref (jarr);
+    if (reapi_type::update_allocate_multi (h, jobs_str, results) < 0) {
+        free (jobs_str);
+        return -1;
+    }
+    free (jobs_str);
+    if (results.size () != jobs.size ()) {
+        errno = EPROTO;
+        return -1;
+    }
+    for (i = 0; i < jobs.size (); i++) {
+        if (results[i].jobid != jobs[i]->id) {
+            errno = EPROTO;
+            return -1;
+        }
+        jobs[i]->schedule.at = results[i].at;
+        jobs[i]->schedule.ov = results[i].ov;
+    }
+    return 0;
+}
+
 int queue_policy_base_t::pending_reprioritize (flux_jobid_t id,
                                                unsigned int priority)
 {
@@ -279,11 +344,8 @@ std::shared_ptr<job_t> queue_policy_base_t::pending_begin ()
     if (m_pending_iter == m_pending.end ()) {
         m_iter_valid = false;
     } else {
-        flux_jobid_t id = m_pending_iter->second;
         m_iter_valid = true;
-        if (detail::queue_policy_base_impl_t::m_jobs.find (id)
-            != detail::queue_policy_base_impl_t::m_jobs.end ())
-            job_p = detail::queue_policy_base_impl_t::m_jobs[id];
+        job_p = m_pending_iter->shared_from_this ();
     }
     return job_p;
 }
@@ -297,11 +359,8 @@ std::shared_ptr<job_t> queue_policy_base_t::pending_next ()
     if (m_pending_iter == m_pending.end ()) {
         m_iter_valid = false;
     } else {
-        flux_jobid_t id = m_pending_iter->second;
         m_iter_valid = true;
-        if (detail::queue_policy_base_impl_t::m_jobs.find (id)
-            != detail::queue_policy_base_impl_t::m_jobs.end ())
-            job_p = detail::queue_policy_base_impl_t::m_jobs[id];
+        job_p = m_pending_iter->shared_from_this ();
     }
 ret:
     return job_p;
@@ -338,10 +397,8 @@ int queue_policy_base_impl_t::insert (std::shared_ptr<job_t> job)
     }
     job->state = job_state_kind_t::PENDING;
     job->t_stamps.pending_ts = m_pq_cnt++;
-    m_pending_provisional.insert (std::pair<std::vector<double>, flux_jobid_t> (
-        {static_cast<double> (job->priority),
-         static_cast<double> (job->t_submit),
-         static_cast<double> (job->t_stamps.pending_ts)}, job->id));
+    job->in_provisional = true;
+    m_pending_provisional.insert (*job);
     m_jobs.insert (std::pair<flux_jobid_t, std::shared_ptr<job_t>> (job->id,
                                                                     job));
     m_schedulable = true;
@@ -460,8 +517,8 @@ int queue_policy_base_impl_t::reconstruct_queue (std::shared_ptr<job_t> job)
 {
     int rc = -1;
     std::pair<std::map<uint64_t, flux_jobid_t>::iterator, bool> ret;
-    std::pair<std::map<flux_jobid_t,
-                       std::shared_ptr<job_t>>::iterator, bool> ret2;
+    std::pair<std::unordered_map<flux_jobid_t,
+                                 std::shared_ptr<job_t>>::iterator, bool> ret2;
 
     if (job == nullptr || m_jobs.find (job->id) != m_jobs.end ()) {
         errno = EINVAL;
@@ -490,18 +547,10 @@ out:
     return rc;
 }
 
-std::map<std::vector<double>, flux_jobid_t>::iterator queue_policy_base_impl_t::
-    to_running (std::map<std::vector<double>,
-                         flux_jobid_t>::iterator pending_iter,
-                bool use_alloced_queue)
+pending_queue_t::iterator queue_policy_base_impl_t::to_running (
+    pending_queue_t::iterator pending_iter, bool use_alloced_queue)
 {
-    flux_jobid_t id = pending_iter->second;
-    if (m_jobs.find (id) == m_jobs.end ()) {
-        errno = EINVAL;
-        return pending_iter;
-    }
-
-    std::shared_ptr<job_t> job = m_jobs[id];
+    std::shared_ptr<job_t> job = pending_iter->shared_from_this ();
     job->state = job_state_kind_t::RUNNING;
     job->t_stamps.running_ts = m_rq_cnt++;
     auto res = m_running.insert (std::pair<uint64_t, flux_jobid_t>(
@@ -526,18 +575,10 @@ std::map<std::vector<double>, flux_jobid_t>::iterator queue_policy_base_impl_t::
     return m_pending.erase (pending_iter);
 }
 
-std::map<std::vector<double>, flux_jobid_t>::iterator queue_policy_base_impl_t::
-    to_rejected (std::map<std::vector<double>,
-                          flux_jobid_t>::iterator pending_iter,
-                 const std::string &note)
+pending_queue_t::iterator queue_policy_base_impl_t::to_rejected (
+    pending_queue_t::iterator pending_iter, const std::string &note)
 {
-    flux_jobid_t id = pending_iter->second;
-    if (m_jobs.find (id) == m_jobs.end ()) {
-        errno = EINVAL;
-        return pending_iter;
-    }
-
-    std::shared_ptr<job_t> job = m_jobs[id];
+    std::shared_ptr<job_t> job = pending_iter->shared_from_this ();
     job->state = job_state_kind_t::REJECTED;
     job->note = note;
     job->t_stamps.rejected_ts = m_dq_cnt++;
@@ -579,22 +620,31 @@ int queue_policy_base_impl_t::pending_reprioritize (flux_jobid_t id,
                                                     unsigned int priority)
 {
     std::shared_ptr<job_t> job = nullptr;
-    bool found_in_prov = false;
+    auto it = m_jobs.find (id);
 
-    if (m_jobs.find (id) == m_jobs.end ()) {
+    if (it == m_jobs.end ()) {
         errno = ENOENT;
         return -1;
     }
-    job = m_jobs[id];
+    job = it->second;
     if (job->state != job_state_kind_t::PENDING) {
         errno = EINVAL;
         return -1;
     }
-    if (erase_pending_job (job, found_in_prov) < 0)
+    if (job->priority == priority)
+        return 0;
+    if (!job->pending_hook.is_linked ()) {
+        errno = ENOENT;
         return -1;
+    }
+    pending_queue_t &q = job->in_provisional? m_pending_provisional
+                                            : m_pending;
+    // Unlink the job through its own hook and relink it with its
+    // old successor as the hint: a priority change that keeps the
+    // job in place costs amortized constant time.
+    auto next = q.erase (q.iterator_to (*job));
     job->priority = priority;
-    if (insert_pending_job (job, found_in_prov) < 0)
-        return -1;
+    q.insert (next, *job);
     m_schedulable = true;
     return 0;
 }
@@ -629,69 +679,55 @@ int queue_policy_base_impl_t::process_provisional_cancel ()
 int queue_policy_base_impl_t::insert_pending_job (std::shared_ptr<job_t> &job,
                                                   bool into_provisional)
 {
-    if (into_provisional) {
-        auto res = m_pending_provisional.insert (
-                       std::pair<std::vector<double>, flux_jobid_t> (
-                           {static_cast<double> (job->priority),
-                            static_cast<double> (job->t_submit),
-                            static_cast<double> (job->t_stamps.pending_ts)},
-                           job->id));
-        if (!res.second) {
-            errno = EEXIST;
-            return -1;
-        }
-    } else {
-        auto res = m_pending.insert (
-                       std::pair<std::vector<double>, flux_jobid_t> (
-                           {static_cast<double> (job->priority),
-                            static_cast<double> (job->t_submit),
-                            static_cast<double> (job->t_stamps.pending_ts)},
-                           job->id));
-        if (!res.second) {
-            errno = EEXIST;
-            return -1;
-        }
+    pending_queue_t &q = into_provisional? m_pending_provisional : m_pending;
+    if (job->pending_hook.is_linked ()) {
+        errno = EEXIST;
+        return -1;
     }
+    auto res = q.insert (*job);
+    if (!res.second) {
+        errno = EEXIST;
+        return -1;
+    }
+    job->in_provisional = into_provisional;
     return 0;
 }
 
 int queue_policy_base_impl_t::erase_pending_job (std::shared_ptr<job_t> &job,
                                                  bool &found_in_prov)
 {
-    size_t s;
-    s = m_pending.erase ({static_cast<double> (job->priority),
-                          static_cast<double> (job->t_submit),
-                          static_cast<double> (job->t_stamps.pending_ts)});
-    if (s == 0) {
-        // job must be in m_pending_provisional in this case
-        s = m_pending_provisional.erase (
-                          {static_cast<double> (job->priority),
-                           static_cast<double> (job->t_submit),
-                           static_cast<double> (job->t_stamps.pending_ts)});
-        if (s == 0) {
-            errno = ENOENT;
-            return -1;
-        }
-        found_in_prov = true;
+    if (!job->pending_hook.is_linked ()) {
+        errno = ENOENT;
+        return -1;
     }
+    found_in_prov = job->in_provisional;
+    if (found_in_prov)
+        m_pending_provisional.erase (m_pending_provisional.iterator_to (*job));
+    else
+        m_pending.erase (m_pending.iterator_to (*job));
+    job->in_provisional = false;
     return 0;
 }
 
+void queue_policy_base_impl_t::merge_provisional ()
+{
+    while (!m_pending_provisional.empty ()) {
+        job_t &job = *m_pending_provisional.begin ();
+        m_pending_provisional.erase (m_pending_provisional.begin ());
+        job.in_provisional = false;
+        m_pending.insert (job);
+    }
+}
+
 std::shared_ptr<job_t> queue_policy_base_impl_t::pending_pop ()
 {
     std::shared_ptr<job_t> job;
-    flux_jobid_t id;
 
     if (m_pending.empty ())
         return nullptr;
-    id = m_pending.begin ()->second;
-    if (m_jobs.find (id) == m_jobs.end ())
-        return nullptr;
-    job = m_jobs[id];
-    m_pending.erase ({static_cast<double> (job->priority),
-                      static_cast<double> (job->t_submit),
-                      static_cast<double> (job->t_stamps.pending_ts)});
-    m_jobs.erase (id);
+    job = m_pending.begin ()->shared_from_this ();
+    m_pending.erase (m_pending.begin ());
+    m_jobs.erase (job->id);
     return job;
 }
 
@@ -39,7 +39,12 @@ public:
     virtual int run_sched_loop (void *h, bool use_alloced_queue);
     virtual int reconstruct_resource (void *h, std::shared_ptr<job_t> job,
                                       std::string &R_out);
+    virtual int reconstruct_resources (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs);
     virtual int apply_params ();
+    virtual int handle_match_success (int64_t jobid, const char *status,
+                                      const char *R, int64_t at, double ov);
+    virtual int handle_match_failure (int64_t jobid, int errcode);
 
 protected:
     unsigned int m_reservation_depth;
@@ -48,17 +53,14 @@ protected:
 private:
     int cancel_completed_jobs (void *h);
     int cancel_reserved_jobs (void *h);
-    std::map<std::vector<double>, flux_jobid_t>::iterator &
-        allocate_orelse_reserve (void *h, std::shared_ptr<job_t> job,
-                                 bool use_alloced_queue,
-                                 std::map<std::vector<double>,
-                                     flux_jobid_t>::iterator &iter);
-    std::map<std::vector<double>, flux_jobid_t>::iterator &
-        allocate (void *h, std::shared_ptr<job_t> job, bool use_alloced_queue,
-        std::map<std::vector<double>, flux_jobid_t>::iterator &iter);
+    int pack_jobs (json_t *jobs);
     int allocate_orelse_reserve_jobs (void *h, bool use_alloced_queue);
+    pending_queue_t::iterator
+        find_pending (std::shared_ptr<job_t> &job);
     std::map<uint64_t, flux_jobid_t> m_reserved;
     unsigned int m_reservation_cnt;
+    bool m_queue_depth_limit = false;
+    bool m_use_alloced_queue = true;
 };
 
 } // namespace Flux::queue_manager::detail
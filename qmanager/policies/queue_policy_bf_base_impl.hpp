@@ -62,114 +62,90 @@ int queue_policy_bf_base_t<reapi_type>::cancel_reserved_jobs (void *h)
 }
 
 template<class reapi_type>
-std::map<std::vector<double>, flux_jobid_t>::iterator &
-queue_policy_bf_base_t<reapi_type>::allocate_orelse_reserve (void *h,
-                                               std::shared_ptr<job_t> job,
-                                               bool use_alloced_queue,
-                                               std::map<std::vector<double>,
-                                                  flux_jobid_t>::iterator &iter)
-
-
+int queue_policy_bf_base_t<reapi_type>::pack_jobs (json_t *jobs)
 {
-    int64_t at = job->schedule.at;
-    if (reapi_type::match_allocate (h, true, job->jobspec, job->id,
-                                    job->schedule.reserved, job->schedule.R,
-                                    job->schedule.at, job->schedule.ov) == 0) {
-
-        if (job->schedule.reserved) {
-            // High-priority job has been reserved, continue
-            m_reserved.insert (std::pair<uint64_t, flux_jobid_t> (m_oq_cnt++,
-                                                                  job->id));
-	    job->schedule.old_at = at;
-            m_reservation_cnt++;
-            iter++;
-        } else {
-            // move the job to the running queue and make sure the job
-            // is enqueued into allocated job queue as well.
-            // When this is used within a module, it allows the module
-            // to fetch those newly allocated jobs, which have flux_msg_t to
-            // respond to job-manager.
-            iter = to_running (iter, use_alloced_queue);
+    unsigned int qd = 0;
+    std::shared_ptr<job_t> job;
+    auto iter = m_pending.begin ();
+    // A stream cut short by a failed callback never reports its end
+    m_queue_depth_limit = false;
+    while (iter != m_pending.end () && qd < m_queue_depth) {
+        json_t *jobdesc;
+        job = iter->shared_from_this ();
+        if ( !(jobdesc = json_pack ("{s:I s:s}",
+                                      "jobid", job->id,
+                                      "jobspec", job->jobspec.c_str ()))) {
+            json_decref (jobs);
+            errno = ENOMEM;
+            return -1;
         }
-    } else {
-        if (errno != EBUSY) {
-            // The request must be rejected. The job is enqueued into
-            // rejected job queue to the upper layer to react on this.
-            iter = to_rejected (iter, (errno == ENODEV)? "unsatisfiable"
-                                                       : "match error");
-        } else {
-            // This can happen if there are "down" resources.
-            // The semantics of our backfill policies is to skip this job
-            iter++;
+        if (json_array_append_new (jobs, jobdesc) < 0) {
+            json_decref (jobs);
+            errno = ENOMEM;
+            return -1;
         }
+        iter++;
+        qd++;
     }
-    return iter;
+    if (qd == m_queue_depth && m_pending.size () != m_queue_depth)
+        m_queue_depth_limit = true;
+
+    return 0;
 }
 
 template<class reapi_type>
-std::map<std::vector<double>, flux_jobid_t>::iterator &
-queue_policy_bf_base_t<reapi_type>::allocate (void *h, std::shared_ptr<job_t> job,
-                                              bool use_alloced_queue,
-                                              std::map<std::vector<double>,
-                                                  flux_jobid_t>::iterator &iter)
+pending_queue_t::iterator
+queue_policy_bf_base_t<reapi_type>::find_pending (std::shared_ptr<job_t> &job)
 {
-    if (reapi_type::match_allocate (h, false, job->jobspec, job->id,
-                                    job->schedule.reserved, job->schedule.R,
-                                    job->schedule.at, job->schedule.ov) == 0) {
-        // move the job to the running queue and make sure the job
-        // is enqueued into allocated job queue as well.
-        // When this is used within a module, it allows the module
-        // to fetch those newly allocated jobs, which have flux_msg_t to
-        // respond to job-manager.
-        iter = to_running (iter, use_alloced_queue);
-    } else {
-        if (errno != EBUSY) {
-            // The request must be rejected. The job is enqueued into
-            // rejected job queue to the upper layer to react on this.
-            iter = to_rejected (iter, (errno == ENODEV)? "unsatisfiable"
-                                                       : "match error");
-        } else {
-            iter++;
-        }
-    }
-    return iter;
+    // Locate the job through its own hook rather than keeping an
+    // iterator across callbacks: the pending queue can be
+    // reprioritized while the scheduling loop is active.
+    if (!job->pending_hook.is_linked () || job->in_provisional)
+        return m_pending.end ();
+    return m_pending.iterator_to (*job);
 }
 
 template<class reapi_type>
 int queue_policy_bf_base_t<reapi_type>::allocate_orelse_reserve_jobs (void *h,
                                             bool use_alloced_queue)
 {
-    unsigned int i = 0;
-    std::shared_ptr<job_t> job;
+    json_t *jobs = nullptr;
+    char *jobs_str = nullptr;
 
     // move jobs in m_pending_provisional queue into
-    // m_pending. Note that c++11 doesn't have a clean way
-    // to "move" elements between two std::map objects so
-    // we use copy for the time being.
-    m_pending.insert (m_pending_provisional.begin (),
-                      m_pending_provisional.end ());
-    m_pending_provisional.clear ();
+    // m_pending by relinking them: no job is copied.
+    merge_provisional ();
+    m_reservation_cnt = 0;
+    m_use_alloced_queue = use_alloced_queue;
+    if (m_pending.empty ())
+        return 0;
+    if (!(jobs = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (pack_jobs (jobs) < 0)
+        return -1;
 
+    // Stream the pending window to the resource service. It tries
+    // to allocate each job until it can't; the first
+    // m_reservation_depth jobs it can't allocate are reserved and
+    // later jobs are backfilled. Results come back through
+    // handle_match_success and handle_match_failure.
     set_sched_loop_active (true);
-
-    // Iterate jobs in the pending job queue and try to allocate each
-    // until you can't. When you can't allocate a job, you reserve it
-    // and then try to backfill later jobs.
-    std::map<std::vector<double>, flux_jobid_t>::iterator iter
-        = m_pending.begin ();
-    m_reservation_cnt = 0;
-    int saved_errno = errno;
-    while ((iter != m_pending.end ()) && (i < m_queue_depth)) {
-        errno = 0;
-        job = m_jobs[iter->second];
-        if (m_reservation_cnt < m_reservation_depth)
-            iter = allocate_orelse_reserve (h, job, use_alloced_queue, iter);
-        else
-            iter = allocate (h, job, use_alloced_queue, iter);
-       i++;
+    if ( !(jobs_str = json_dumps (jobs, JSON_INDENT (0)))) {
+        errno = ENOMEM;
+        json_decref (jobs);
+        set_sched_loop_active (false);
+        return -1;
+    }
+    json_decref (jobs);
+    if (reapi_type::match_allocate_orelse_reserve_multi (
+            h, m_reservation_depth, jobs_str, this) < 0) {
+        free (jobs_str);
+        set_sched_loop_active (false);
+        return -1;
     }
-    set_sched_loop_active (false);
-    errno = saved_errno;
+    free (jobs_str);
     return 0;
 }
 
@@ -196,6 +172,8 @@ template<class reapi_type>
 int queue_policy_bf_base_t<reapi_type>::run_sched_loop (void *h,
                                                         bool use_alloced_queue)
 {
+    if (is_sched_loop_active ())
+        return 1;
     int rc = 0;
     set_schedulability (false);
     rc = cancel_completed_jobs (h);
@@ -204,6 +182,88 @@ int queue_policy_bf_base_t<reapi_type>::run_sched_loop (void *h,
     return rc;
 }
 
+template<class reapi_type>
+int queue_policy_bf_base_t<reapi_type>::handle_match_success (
+                                         int64_t jobid, const char *status,
+                                         const char *R, int64_t at, double ov)
+{
+    std::shared_ptr<job_t> job;
+    pending_queue_t::iterator iter;
+    auto jit = m_jobs.find (static_cast<flux_jobid_t> (jobid));
+
+    if (!is_sched_loop_active () || jit == m_jobs.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    job = jit->second;
+    if ( (iter = find_pending (job)) == m_pending.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    job->schedule.old_at = job->schedule.at;
+    job->schedule.reserved = std::string ("RESERVED") == status?  true : false;
+    job->schedule.R = R;
+    job->schedule.at = at;
+    job->schedule.ov = ov;
+    if (job->schedule.reserved) {
+        // High-priority job has been reserved, continue
+        m_reserved.insert (std::pair<uint64_t, flux_jobid_t> (m_oq_cnt++,
+                                                              job->id));
+        m_reservation_cnt++;
+    } else {
+        // move the job to the running queue and make sure the job
+        // is enqueued into allocated job queue as well.
+        // When this is used within a module, it allows the module
+        // to fetch those newly allocated jobs, which have flux_msg_t to
+        // respond to job-manager.
+        to_running (iter, m_use_alloced_queue);
+    }
+    return 0;
+}
+
+template<class reapi_type>
+int queue_policy_bf_base_t<reapi_type>::handle_match_failure (int64_t jobid,
+                                                              int errcode)
+{
+    std::shared_ptr<job_t> job;
+    pending_queue_t::iterator iter;
+    std::unordered_map<flux_jobid_t, std::shared_ptr<job_t>>::iterator jit;
+
+    if (!is_sched_loop_active ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (jobid < 0) {
+        // The match stream has terminated, successfully or not.
+        if (errcode == ENODATA && m_queue_depth_limit) {
+            // Because the scheduling loop is being terminated
+            // per queue_depth_limit, the queue should still be
+            // schedulable.
+            set_schedulability (true);
+        }
+        m_queue_depth_limit = false;
+        return 0;
+    }
+    if ( (jit = m_jobs.find (static_cast<flux_jobid_t> (jobid)))
+         == m_jobs.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    job = jit->second;
+    if ( (iter = find_pending (job)) == m_pending.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    // EBUSY can happen if there are "down" resources.
+    // The semantics of our backfill policies is to skip this job.
+    // Otherwise, the request must be rejected. The job is enqueued into
+    // rejected job queue to the upper layer to react on this.
+    if (errcode != EBUSY)
+        to_rejected (iter, (errcode == ENODEV)? "unsatisfiable"
+                                              : "match error");
+    return 0;
+}
+
 template<class reapi_type>
 int queue_policy_bf_base_t<reapi_type>::reconstruct_resource (
         void *h, std::shared_ptr< job_t> job, std::string &R_out)
@@ -213,6 +273,13 @@ int queue_policy_bf_base_t<reapi_type>::reconstruct_resource (
                                         job->schedule.ov, R_out);
 }
 
+template<class reapi_type>
+int queue_policy_bf_base_t<reapi_type>::reconstruct_resources (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs)
+{
+    return reconstruct_resources_multi<reapi_type> (h, jobs);
+}
+
 } // namespace Flux::queue_manager::detail
 } // namespace Flux::queue_manager
 } // namespace Flux
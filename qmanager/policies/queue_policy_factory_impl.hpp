@@ -28,8 +28,6 @@
 #include "resource/hlapi/bindings/c++/reapi.hpp"
 #include "resource/hlapi/bindings/c++/reapi_module.hpp"
 #include "resource/hlapi/bindings/c++/reapi_module_impl.hpp"
-#include "resource/hlapi/bindings/c++/reapi_cli.hpp"
-#include "resource/hlapi/bindings/c++/reapi_cli_impl.hpp"
 #include "qmanager/policies/base/queue_policy_base.hpp"
 #include "qmanager/policies/base/queue_policy_base_impl.hpp"
 #include "qmanager/policies/queue_policy_fcfs.hpp"
@@ -49,41 +47,26 @@ namespace detail {
 using namespace resource_model;
 using namespace resource_model::detail;
 
+/*! Create a queue policy that matches through reapi_type. Only the
+ *  reapi types a program instantiates are compiled into it, e.g.,
+ *  qmanager-sim calls create_queue_policy<reapi_cli_t> () and the
+ *  qmanager module never links the resource matcher.
+ */
+template<class reapi_type>
 std::shared_ptr<queue_policy_base_t> create_queue_policy (
-                                         const std::string &policy,
-                                         const std::string &reapi)
+                                         const std::string &policy)
 {
     std::shared_ptr<queue_policy_base_t> p = nullptr;
 
     try {
-        if (policy == "fcfs") {
-            if (reapi == "module")
-                p = std::make_shared<queue_policy_fcfs_t<reapi_module_t>> ();
-            else if (reapi == "cli")
-                p = std::make_shared<queue_policy_fcfs_t<reapi_cli_t>> ();
-        }
-        else if (policy == "easy") {
-            if (reapi == "module")
-                p = std::make_shared<queue_policy_easy_t<reapi_module_t>> ();
-            else if (reapi == "cli")
-                p = std::make_shared<queue_policy_easy_t<reapi_cli_t>> ();
-        }
-        else if (policy == "hybrid") {
-            if (reapi == "module")
-                p = std::make_shared<queue_policy_hybrid_t<reapi_module_t>> ();
-            else if (reapi == "cli")
-                p = std::make_shared<queue_policy_hybrid_t<reapi_cli_t>> ();
-        }
-        else if (policy == "conservative") {
-            if (reapi == "module") {
-                p = std::make_shared<queue_policy_conservative_t<
-                                         reapi_module_t>> ();
-            }
-            else if (reapi == "cli") {
-                p = std::make_shared<queue_policy_conservative_t<
-                                         reapi_cli_t>> ();
-            }
-        }
+        if (policy == "fcfs")
+            p = std::make_shared<queue_policy_fcfs_t<reapi_type>> ();
+        else if (policy == "easy")
+            p = std::make_shared<queue_policy_easy_t<reapi_type>> ();
+        else if (policy == "hybrid")
+            p = std::make_shared<queue_policy_hybrid_t<reapi_type>> ();
+        else if (policy == "conservative")
+            p = std::make_shared<queue_policy_conservative_t<reapi_type>> ();
     } catch (std::bad_alloc &e) {
         errno = ENOMEM;
         p = nullptr;
@@ -92,6 +75,15 @@ std::shared_ptr<queue_policy_base_t> create_queue_policy (
     return p;
 }
 
+std::shared_ptr<queue_policy_base_t> create_queue_policy (
+                                         const std::string &policy,
+                                         const std::string &reapi)
+{
+    if (reapi == "module")
+        return create_queue_policy<reapi_module_t> (policy);
+    return nullptr;
+}
+
 } // namespace Flux::queue_manager::detail
 } // namespace Flux::queue_manager
 } // namespace Flux
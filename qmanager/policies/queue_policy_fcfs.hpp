@@ -39,17 +39,19 @@ public:
     virtual int run_sched_loop (void *h, bool use_alloced_queue);
     virtual int reconstruct_resource (void *h, std::shared_ptr<job_t> job,
                                       std::string &R_out);
+    virtual int reconstruct_resources (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs);
     virtual int apply_params ();
     virtual int handle_match_success (int64_t jobid, const char *status,
                                       const char *R, int64_t at, double ov);
-    virtual int handle_match_failure (int errcode);
+    virtual int handle_match_failure (int64_t jobid, int errcode);
 
 private:
     int cancel_completed_jobs (void *h);
     int pack_jobs (json_t *jobs);
     int allocate_jobs (void *h, bool use_alloced_queue);
     bool m_queue_depth_limit = false;
-    std::map<std::vector<double>, flux_jobid_t>::iterator m_iter;
+    pending_queue_t::iterator m_iter;
 };
 
 } // namespace Flux::queue_manager::detail
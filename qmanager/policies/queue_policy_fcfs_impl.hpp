@@ -58,9 +58,11 @@ int queue_policy_fcfs_t<reapi_type>::pack_jobs (json_t *jobs)
     unsigned int qd = 0;
     std::shared_ptr<job_t> job;
     auto iter = m_pending.begin ();
+    // A stream cut short by a failed callback never reports its end
+    m_queue_depth_limit = false;
     while (iter != m_pending.end () && qd < m_queue_depth) {
         json_t *jobdesc;
-        job = m_jobs[iter->second];
+        job = iter->shared_from_this ();
         if ( !(jobdesc = json_pack ("{s:I s:s}",
                                       "jobid", job->id,
                                       "jobspec", job->jobspec.c_str ()))) {
@@ -88,15 +90,11 @@ int queue_policy_fcfs_t<reapi_type>::allocate_jobs (void *h,
 {
     json_t *jobs = nullptr;
     char *jobs_str = nullptr;
-    std::map<std::vector<double>, flux_jobid_t>::iterator iter;
+    pending_queue_t::iterator iter;
 
     // move jobs in m_pending_provisional queue into
-    // m_pending. Note that c++11 doesn't have a clean way
-    // to "move" elements between two std::map objects so
-    // we use copy for the time being.
-    m_pending.insert (m_pending_provisional.begin (),
-                      m_pending_provisional.end ());
-    m_pending_provisional.clear ();
+    // m_pending by relinking them: no job is copied.
+    merge_provisional ();
     m_iter = m_pending.begin ();
     if (m_pending.empty ())
         return 0;
@@ -132,7 +130,7 @@ int queue_policy_fcfs_t<reapi_type>::handle_match_success (
         errno = EINVAL;
         return -1;
     }
-    std::shared_ptr<job_t> job = m_jobs[m_iter->second];
+    std::shared_ptr<job_t> job = m_iter->shared_from_this ();
     if (job->id != static_cast<flux_jobid_t> (jobid)) {
         errno = EINVAL;
         return -1;
@@ -146,7 +144,8 @@ int queue_policy_fcfs_t<reapi_type>::handle_match_success (
 }
 
 template<class reapi_type>
-int queue_policy_fcfs_t<reapi_type>::handle_match_failure (int errcode)
+int queue_policy_fcfs_t<reapi_type>::handle_match_failure (int64_t jobid,
+                                                          int errcode)
 {
     if (!is_sched_loop_active ()) {
         errno = EINVAL;
@@ -157,11 +156,14 @@ int queue_policy_fcfs_t<reapi_type>::handle_match_failure (int errcode)
                               (errcode == ENODEV)? "unsatisfiable"
                                                  : "match error");
     }
-    if (errcode == ENODATA && m_queue_depth_limit) {
-        // Because the scheduling loop is being terminated
-        // per queue_depth_limit, the queue should still be
-        // schedulable.
-        set_schedulability (true);
+    if (jobid < 0) {
+        // The match stream has terminated, successfully or not.
+        if (errcode == ENODATA && m_queue_depth_limit) {
+            // Because the scheduling loop is being terminated
+            // per queue_depth_limit, the queue should still be
+            // schedulable.
+            set_schedulability (true);
+        }
         m_queue_depth_limit = false;
     }
     return 0;
@@ -208,6 +210,13 @@ int queue_policy_fcfs_t<reapi_type>::reconstruct_resource (
                                         job->schedule.ov, R_out);
 }
 
+template<class reapi_type>
+int queue_policy_fcfs_t<reapi_type>::reconstruct_resources (
+        void *h, std::vector<std::shared_ptr<job_t>> &jobs)
+{
+    return reconstruct_resources_multi<reapi_type> (h, jobs);
+}
+
 
 } // namespace Flux::queue_manager::detail
 } // namespace Flux::queue_manager
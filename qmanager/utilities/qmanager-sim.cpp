@@ -0,0 +1,584 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+extern "C" {
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+#include <jansson.h>
+#include <time.h>
+}
+
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cinttypes>
+#include <getopt.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include "qmanager/policies/base/queue_policy_base.hpp"
+#include "qmanager/policies/base/queue_policy_base_impl.hpp"
+#include "qmanager/policies/queue_policy_factory_impl.hpp"
+#include "resource/hlapi/bindings/c++/reapi_cli.hpp"
+#include "resource/hlapi/bindings/c++/reapi_cli_impl.hpp"
+#include "resource/traversers/match_perf.hpp"
+
+using namespace Flux;
+using namespace Flux::queue_manager;
+using namespace Flux::queue_manager::detail;
+using Flux::resource_model::log_linear_hist_t;
+using Flux::resource_model::detail::reapi_cli_t;
+using Flux::resource_model::detail::resource_query_t;
+using Flux::resource_model::detail::resource_params_t;
+
+/*! A job of the input trace.
+ */
+struct sim_job_t {
+    flux_jobid_t id = 0;
+    int64_t submit = 0;
+    int64_t duration = 0;
+    uint64_t ncores = 0;
+    int64_t start = -1;
+    std::string jobspec = "";
+};
+
+struct sim_params_t {
+    std::string load_file = "";
+    std::string trace_file = "";
+    std::string queue_policy = "fcfs";
+    std::string queue_params = "";
+    std::string policy_params = "";
+    std::string o_fname = "";
+    std::string e_fname = "";
+    resource_params_t rparams;
+};
+
+/*! Counters and distributions gathered while the clock advances.
+ */
+struct sim_stats_t {
+    uint64_t events = 0;
+    uint64_t loops = 0;
+    uint64_t started = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;
+    uint64_t busy_cores = 0;
+    int64_t first = -1;
+    int64_t last = 0;
+    double core_seconds = 0.0f;
+    uint64_t cpu_ns = 0;
+    log_linear_hist_t wait;
+    log_linear_hist_t cpu;
+};
+
+#define OPTIONS "L:f:P:S:p:F:Q:q:r:t:o:E:h"
+static const struct option longopts[] = {
+    {"load-file",        required_argument,  0, 'L'},
+    {"load-format",      required_argument,  0, 'f'},
+    {"match-policy",     required_argument,  0, 'P'},
+    {"match-subsystems", required_argument,  0, 'S'},
+    {"prune-filters",    required_argument,  0, 'p'},
+    {"match-format",     required_argument,  0, 'F'},
+    {"queue-policy",     required_argument,  0, 'Q'},
+    {"queue-params",     required_argument,  0, 'q'},
+    {"policy-params",    required_argument,  0, 'r'},
+    {"trace",            required_argument,  0, 't'},
+    {"output",           required_argument,  0, 'o'},
+    {"events",           required_argument,  0, 'E'},
+    {"help",             no_argument,        0, 'h'},
+    { 0, 0, 0, 0 },
+};
+
+static void usage (int code)
+{
+    std::cerr <<
+"usage: qmanager-sim [OPTIONS...] -L <load-file> -t <trace>\n"
+"\n"
+"Offline driver of the qmanager scheduling loop on a virtual clock.\n"
+"\n"
+"Link a queue policy against an in-process resource matcher that\n"
+"loads the resource graph from load-file, and replay a job trace.\n"
+"Each line of the trace describes a job as:\n"
+"    <submit time> <duration> <jobspec file>\n"
+"where the times are integral seconds on the virtual clock and a\n"
+"relative jobspec path is taken from the directory of the trace.\n"
+"Lines starting with # are ignored. A job runs for its duration,\n"
+"capped at the duration of its jobspec if it has one.\n"
+"\n"
+"The clock jumps from one event time to the next. At each event time,\n"
+"due completions are removed from the queue, submissions are inserted\n"
+"and the scheduling loop of the queue policy is run if the queue is\n"
+"schedulable. The scheduler CPU time is measured per event.\n"
+"\n"
+"At the end, a JSON object summarizing the run is written to the output:\n"
+"job counts, makespan, core utilization, wait time distribution in\n"
+"seconds and scheduler CPU time distribution per event in nanoseconds.\n"
+"\n"
+"OPTIONS:\n"
+"    -h, --help\n"
+"            Display this usage information\n"
+"\n"
+"    -L, --load-file=filepath\n"
+"            Input file from which to load the resource graph\n"
+"\n"
+"    -f, --load-format=<grug|hwloc|jgf>\n"
+"            Format of the load file (default=grug)\n"
+"\n"
+"    -P, --match-policy=<low|high|first|locality|variation>\n"
+"            Resource match policy (default=first)\n"
+"\n"
+"    -S, --match-subsystems=<subsystems>\n"
+"            Subsystems to match on (default=containment)\n"
+"\n"
+"    -p, --prune-filters=<HL-resource1:LL-resource1[,...]>\n"
+"            Pruning filters of the matcher (default=ALL:core)\n"
+"\n"
+"    -F, --match-format=<simple|pretty_simple|jgf|rlite|rv1|rv1_nosched>\n"
+"            Emit format of the matched resource set (default=rv1_nosched)\n"
+"\n"
+"    -Q, --queue-policy=<fcfs|easy|hybrid|conservative>\n"
+"            Queuing policy (default=fcfs)\n"
+"\n"
+"    -q, --queue-params=<key=value[,key=value...]>\n"
+"            Queue parameters (e.g., queue-depth=64)\n"
+"\n"
+"    -r, --policy-params=<key=value[,key=value...]>\n"
+"            Queue policy parameters (e.g., reservation-depth=16)\n"
+"\n"
+"    -t, --trace=filepath\n"
+"            Job trace to replay\n"
+"\n"
+"    -o, --output=filepath\n"
+"            Write the summary into filepath instead of standard output\n"
+"\n"
+"    -E, --events=filepath\n"
+"            Write one JSON object per event into filepath\n"
+"\n";
+    exit (code);
+}
+
+static void process_args (sim_params_t &params, int argc, char *argv[])
+{
+    int ch = 0;
+
+    params.rparams.load_format = "grug";
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'h': /* --help */
+                usage (0);
+                break;
+            case 'L': /* --load-file */
+                params.load_file = optarg;
+                break;
+            case 'f': /* --load-format */
+                params.rparams.load_format = optarg;
+                break;
+            case 'P': /* --match-policy */
+                params.rparams.match_policy = optarg;
+                break;
+            case 'S': /* --match-subsystems */
+                params.rparams.match_subsystems = optarg;
+                break;
+            case 'p': /* --prune-filters */
+                params.rparams.prune_filters = optarg;
+                break;
+            case 'F': /* --match-format */
+                params.rparams.match_format = optarg;
+                break;
+            case 'Q': /* --queue-policy */
+                params.queue_policy = optarg;
+                break;
+            case 'q': /* --queue-params */
+                params.queue_params = optarg;
+                break;
+            case 'r': /* --policy-params */
+                params.policy_params = optarg;
+                break;
+            case 't': /* --trace */
+                params.trace_file = optarg;
+                break;
+            case 'o': /* --output */
+                params.o_fname = optarg;
+                break;
+            case 'E': /* --events */
+                params.e_fname = optarg;
+                break;
+            default:
+                usage (1);
+                break;
+        }
+    }
+    if (optind != argc || params.load_file == "" || params.trace_file == "")
+        usage (1);
+}
+
+static uint64_t cpu_now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL
+           + static_cast<uint64_t> (ts.tv_nsec);
+}
+
+static uint64_t count_cores (const std::vector<Jobspec::Resource> &resources)
+{
+    uint64_t n = 0;
+    for (auto &r : resources) {
+        if (r.type == "core")
+            n += r.count.min;
+        else
+            n += r.count.min * count_cores (r.with);
+    }
+    return n;
+}
+
+static int read_file (const std::string &path, std::string &out)
+{
+    std::ifstream in;
+    std::stringstream buffer;
+
+    in.open (path.c_str (), std::ifstream::in);
+    if (!in.good ()) {
+        std::cerr << "ERROR: can't open " << path << std::endl;
+        return -1;
+    }
+    buffer << in.rdbuf ();
+    in.close ();
+    out = buffer.str ();
+    return 0;
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ *                              Trace Loading                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+static int load_jobspec (const std::string &path, sim_job_t &job,
+                         std::map<std::string, sim_job_t> &cache)
+{
+    auto it = cache.find (path);
+    if (it == cache.end ()) {
+        sim_job_t proto;
+        if (read_file (path, proto.jobspec) < 0)
+            return -1;
+        try {
+            Jobspec::Jobspec js {proto.jobspec};
+            proto.ncores = count_cores (js.resources);
+            proto.duration = static_cast<int64_t> (
+                                 js.attributes.system.duration);
+        } catch (Jobspec::parse_error &e) {
+            std::cerr << "ERROR: can't parse " << path << ": "
+                      << e.what () << std::endl;
+            return -1;
+        }
+        it = cache.insert (std::make_pair (path, proto)).first;
+    }
+    job.jobspec = it->second.jobspec;
+    job.ncores = it->second.ncores;
+    if (it->second.duration > 0 && job.duration > it->second.duration)
+        job.duration = it->second.duration;
+    return 0;
+}
+
+static int load_trace (const std::string &path, std::vector<sim_job_t> &jobs)
+{
+    int lineno = 0;
+    std::string line;
+    std::ifstream in;
+    std::string dir = "";
+    std::map<std::string, sim_job_t> cache;
+    size_t slash = path.find_last_of ('/');
+
+    if (slash != std::string::npos)
+        dir = path.substr (0, slash + 1);
+    in.open (path.c_str (), std::ifstream::in);
+    if (!in.good ()) {
+        std::cerr << "ERROR: can't open " << path << std::endl;
+        return -1;
+    }
+    while (std::getline (in, line)) {
+        sim_job_t job;
+        std::string fn;
+        std::istringstream istr (line);
+
+        lineno++;
+        if (line.find_first_not_of (" \t") == std::string::npos
+            || line[line.find_first_not_of (" \t")] == '#')
+            continue;
+        if (!(istr >> job.submit >> job.duration >> fn)
+            || job.submit < 0 || job.duration <= 0) {
+            std::cerr << "ERROR: " << path << ":" << lineno
+                      << ": malformed job" << std::endl;
+            return -1;
+        }
+        if (fn[0] != '/')
+            fn = dir + fn;
+        if (load_jobspec (fn, job, cache) < 0)
+            return -1;
+        jobs.push_back (job);
+    }
+    std::stable_sort (jobs.begin (), jobs.end (),
+                      [] (const sim_job_t &a, const sim_job_t &b) {
+                          return a.submit < b.submit;
+                      });
+    for (size_t i = 0; i < jobs.size (); i++)
+        jobs[i].id = static_cast<flux_jobid_t> (i + 1);
+    return 0;
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ *                             Event Processing                               *
+ *                                                                            *
+ ******************************************************************************/
+
+static int sched_event (int64_t now, std::shared_ptr<queue_policy_base_t> &q,
+                        resource_query_t &rq, std::vector<sim_job_t> &jobs,
+                        std::multimap<int64_t, flux_jobid_t> &completions,
+                        sim_stats_t &stats, uint64_t &nstarted)
+{
+    std::shared_ptr<job_t> job;
+    uint64_t nrejected = 0;
+
+    nstarted = 0;
+    rq.set_now (now);
+    // A rejected job ends the loop that rejected it. Treat the rejection
+    // as an event of its own so that the jobs behind it are scheduled
+    // at the same instant.
+    do {
+        if (nrejected > 0)
+            q->set_schedulability (true);
+        nrejected = 0;
+        if (!q->is_schedulable ())
+            break;
+        if (q->run_sched_loop (static_cast<void *> (&rq), true) < 0) {
+            std::cerr << "ERROR: run_sched_loop at t=" << now << ": "
+                      << strerror (errno) << std::endl;
+            return -1;
+        }
+        stats.loops++;
+        while ( (job = q->alloced_pop ()) != nullptr) {
+            sim_job_t &j = jobs.at (job->id - 1);
+            j.start = now;
+            stats.wait.record (static_cast<uint64_t> (now - j.submit));
+            stats.busy_cores += j.ncores;
+            completions.insert (std::make_pair (now + j.duration, j.id));
+            nstarted++;
+        }
+        while ( (job = q->rejected_pop ()) != nullptr) {
+            std::cerr << "WARN: job " << job->id << " rejected ("
+                      << job->note << ")" << std::endl;
+            stats.rejected++;
+            nrejected++;
+        }
+        while ( (job = q->canceled_pop ()) != nullptr);
+    } while (nrejected > 0);
+    stats.started += nstarted;
+    return 0;
+}
+
+static int simulate (const sim_params_t &params,
+                     std::shared_ptr<queue_policy_base_t> &q,
+                     resource_query_t &rq, std::vector<sim_job_t> &jobs,
+                     std::ostream *events, sim_stats_t &stats)
+{
+    size_t next = 0;
+    std::multimap<int64_t, flux_jobid_t> completions;
+
+    while (next < jobs.size () || !completions.empty ()) {
+        int64_t now = INT64_MAX;
+        uint64_t nsubmitted = 0;
+        uint64_t ncompleted = 0;
+        uint64_t nstarted = 0;
+        uint64_t start = 0;
+        uint64_t elapse = 0;
+
+        if (next < jobs.size ())
+            now = jobs[next].submit;
+        if (!completions.empty () && completions.begin ()->first < now)
+            now = completions.begin ()->first;
+        if (stats.first < 0)
+            stats.first = now;
+
+        start = cpu_now ();
+        while (!completions.empty () && completions.begin ()->first == now) {
+            sim_job_t &j = jobs.at (completions.begin ()->second - 1);
+            if (q->remove (j.id) < 0) {
+                std::cerr << "ERROR: remove job " << j.id << ": "
+                          << strerror (errno) << std::endl;
+                return -1;
+            }
+            stats.busy_cores -= j.ncores;
+            stats.core_seconds += static_cast<double> (j.ncores)
+                                  * static_cast<double> (now - j.start);
+            stats.completed++;
+            stats.last = now;
+            completions.erase (completions.begin ());
+            ncompleted++;
+        }
+        while (next < jobs.size () && jobs[next].submit == now) {
+            std::shared_ptr<job_t> job = std::make_shared<job_t> ();
+            job->id = jobs[next].id;
+            job->t_submit = static_cast<double> (jobs[next].submit);
+            job->jobspec = jobs[next].jobspec;
+            if (q->insert (job) < 0) {
+                std::cerr << "ERROR: insert job " << job->id << ": "
+                          << strerror (errno) << std::endl;
+                return -1;
+            }
+            next++;
+            nsubmitted++;
+        }
+        if (sched_event (now, q, rq, jobs, completions, stats, nstarted) < 0)
+            return -1;
+        elapse = cpu_now () - start;
+        stats.cpu.record (elapse);
+        stats.cpu_ns += elapse;
+        stats.events++;
+
+        if (events)
+            *events << "{\"t\": " << now
+                    << ", \"submitted\": " << nsubmitted
+                    << ", \"completed\": " << ncompleted
+                    << ", \"started\": " << nstarted
+                    << ", \"running\": " << completions.size ()
+                    << ", \"busy_cores\": " << stats.busy_cores
+                    << ", \"sched_cpu_ns\": " << elapse << "}" << std::endl;
+    }
+    return 0;
+}
+
+static void hist_to_json (std::ostream &o, const std::string &key,
+                          const log_linear_hist_t &h)
+{
+    o << "\"" << key << "\": {"
+      << "\"count\": " << h.count ()
+      << ", \"min\": " << h.min ()
+      << ", \"mean\": " << h.mean ()
+      << ", \"p50\": " << h.percentile (0.50)
+      << ", \"p90\": " << h.percentile (0.90)
+      << ", \"p99\": " << h.percentile (0.99)
+      << ", \"max\": " << h.max () << "}";
+}
+
+static void summary_to_json (std::ostream &o, const sim_params_t &params,
+                             size_t njobs, uint64_t ncores,
+                             const sim_stats_t &stats)
+{
+    int64_t makespan = (stats.first >= 0)? stats.last - stats.first : 0;
+    double capacity = static_cast<double> (ncores)
+                      * static_cast<double> (makespan);
+    double util = (capacity > 0.0f)? stats.core_seconds / capacity : 0.0f;
+
+    o << "{\"queue_policy\": \"" << params.queue_policy << "\""
+      << ", \"queue_params\": \"" << params.queue_params << "\""
+      << ", \"policy_params\": \"" << params.policy_params << "\""
+      << ", \"match_policy\": \"" << params.rparams.match_policy << "\""
+      << ", \"cores\": " << ncores
+      << ", \"jobs\": " << njobs
+      << ", \"started\": " << stats.started
+      << ", \"completed\": " << stats.completed
+      << ", \"rejected\": " << stats.rejected
+      << ", \"events\": " << stats.events
+      << ", \"sched_loops\": " << stats.loops
+      << ", \"makespan\": " << makespan
+      << ", \"utilization\": " << util
+      << ", ";
+    hist_to_json (o, "wait", stats.wait);
+    o << ", ";
+    hist_to_json (o, "sched_cpu_ns", stats.cpu);
+    o << ", \"sched_cpu_s\": "
+      << static_cast<double> (stats.cpu_ns) / 1000000000.0f
+      << "}" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+    sim_params_t params;
+    sim_stats_t stats;
+    std::string rgraph;
+    std::ofstream o_file, e_file;
+    std::vector<sim_job_t> jobs;
+    resource_query_t rq;
+    std::shared_ptr<queue_policy_base_t> q;
+
+    process_args (params, argc, argv);
+    if (read_file (params.load_file, rgraph) < 0
+        || load_trace (params.trace_file, jobs) < 0)
+        return EXIT_FAILURE;
+    if (rq.initialize (rgraph, params.rparams) < 0) {
+        std::cerr << "ERROR: can't initialize the resource matcher: "
+                  << rq.err_message () << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ( !(q = create_queue_policy<reapi_cli_t> (params.queue_policy))) {
+        std::cerr << "ERROR: unknown queue policy " << params.queue_policy
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ((params.queue_params != ""
+         && q->set_queue_params (params.queue_params) < 0)
+        || (params.policy_params != ""
+            && q->set_policy_params (params.policy_params) < 0)
+        || q->apply_params () < 0) {
+        std::cerr << "ERROR: invalid queue or policy parameters" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (params.e_fname != "") {
+        e_file.open (params.e_fname);
+        if (!e_file.good ()) {
+            std::cerr << "ERROR: can't open " << params.e_fname << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (params.o_fname != "") {
+        o_file.open (params.o_fname);
+        if (!o_file.good ()) {
+            std::cerr << "ERROR: can't open " << params.o_fname << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (simulate (params, q, rq, jobs,
+                  (params.e_fname != "")? &e_file : nullptr, stats) < 0)
+        return EXIT_FAILURE;
+    if (stats.started + stats.rejected != jobs.size ())
+        std::cerr << "WARN: " << jobs.size () - stats.started - stats.rejected
+                  << " jobs never started" << std::endl;
+
+    summary_to_json ((params.o_fname != "")? o_file : std::cout, params,
+                     jobs.size (), rq.nresources ("core"), stats);
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
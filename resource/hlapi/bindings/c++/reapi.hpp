@@ -34,6 +34,7 @@ extern "C" {
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Flux {
 namespace resource_model {
@@ -73,14 +74,18 @@ public:
      *  to the next pending job or return 0 if the scheduling loop
      *  must be terminated per its queuing policy (e.g., FCFS).
      *
-     *  \param           errno returned from the resource match service.
+     *  \param jobid     Job ID of the failed match when the failure is
+     *                   reported for a job within a backfill window
+     *                   (see reapi_t::match_allocate_orelse_reserve_multi);
+     *                   -1 when the failure terminates the match stream.
+     *  \param errcode   errno returned from the resource match service.
      *                       EBUSY: resource unavailable
      *                       ENODEV: unsatisfiable jobspec
      *                       ENODATA: no more jobspec to process
      *                       Others: one that can raised from match_multi RPC
      *  \return          0 when the loop must terminate; -1 on error.
      */
-    virtual int handle_match_failure (int errcode) = 0;
+    virtual int handle_match_failure (int64_t jobid, int errcode) = 0;
 
     /*! Return true if the scheduling loop is active under asynchronous
      *  execution; otherwise false.
@@ -100,6 +105,16 @@ public:
 };
 
 
+/*! Type to store the result of an update operation on a job.
+ */
+struct update_result_t {
+    uint64_t jobid = 0;
+    int64_t at = 0;
+    double ov = 0.0f;
+    std::string R = "";
+};
+
+
 /*! High-level resource API base class. Derived classes must implement
  *  the methods.
  */
@@ -159,6 +174,31 @@ public:
                                      const char *jobs,
                                      queue_adapter_base_t *adapter);
 
+    /*! Multi-Match a backfill window of jobspecs to the "best" resources
+     *  and either allocate orelse reserve them. Jobspecs are tried in
+     *  order: each is allocated or else reserved until reservation_depth
+     *  jobs have been reserved; only allocation is tried for the rest.
+     *  Unlike match_allocate_multi, a failed match does not terminate
+     *  the stream: it is reported through adapter->handle_match_failure
+     *  with the jobid of the failed job.
+     *
+     *  \param h         Opaque handle. How it is used is an implementation
+     *                   detail. However, when it is used within a Flux's
+     *                   service module, it is expected to be a pointer
+     *                   to a flux_t object.
+     *  \param reservation_depth
+     *                   maximum number of jobs that can be reserved.
+     *  \param jobs      JSON array of jobspecs.
+     *  \param adapter   queue_adapter_base_t object that provides
+     *                   a set of callback methods to be called each time
+     *                   the result of a match is returned from the
+     *                   resource match service.
+     *  \return          0 on success; -1 on error.
+     */
+    static int match_allocate_orelse_reserve_multi (
+        void *h, unsigned int reservation_depth, const char *jobs,
+        queue_adapter_base_t *adapter);
+
     /*! Update the resource state with R.
      *
      *  \param h         Opaque handle. How it is used is an implementation
@@ -181,6 +221,28 @@ public:
         return -1;
     }
 
+    /*! Update the resource state with the R of each of multiple jobs.
+     *  All of the (jobid, R) pairs are sent to the resource service
+     *  at once and the results are streamed back, one per job,
+     *  in the order of jobs.
+     *
+     *  \param h         Opaque handle. How it is used is an implementation
+     *                   detail. However, when it is used within a Flux's
+     *                   service module, it is expected to be a pointer
+     *                   to a flux_t object.
+     *  \param jobs      JSON array of objects each with jobid and R keys.
+     *  \param results   vector into which to append the result of
+     *                   each job in the order of jobs. On error, it
+     *                   contains the results of the jobs updated before
+     *                   the failed job.
+     *  \return          0 on success; -1 on error.
+     */
+    static int update_allocate_multi (void *h, const char *jobs,
+                                      std::vector<update_result_t> &results)
+    {
+        return -1;
+    }
+
     /*! Cancel the allocation or reservation corresponding to jobid.
      *
      *  \param h         Opaque handle. How it is used is an implementation
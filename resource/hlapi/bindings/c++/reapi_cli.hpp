@@ -34,12 +34,121 @@ extern "C" {
 #include <cerrno>
 }
 
+#include <map>
+#include <limits>
+#include <memory>
+#include <string>
 #include "resource/hlapi/bindings/c++/reapi.hpp"
+#include "resource/schema/resource_graph.hpp"
+#include "resource/readers/resource_reader_factory.hpp"
+#include "resource/traversers/dfu.hpp"
+#include "resource/jobinfo/jobinfo.hpp"
+#include "resource/policies/dfu_match_policy_factory.hpp"
 
 namespace Flux {
 namespace resource_model {
 namespace detail {
 
+/*! Parameters of the in-process resource matcher. The defaults
+ *  are the same as those of the resource module.
+ */
+struct resource_params_t {
+    std::string load_format = "jgf";
+    std::string load_allowlist = "";
+    std::string match_policy = "first";
+    std::string match_subsystems = "containment";
+    std::string prune_filters = "ALL:core";
+    std::string match_format = "rv1_nosched";
+};
+
+/*! In-process resource matcher: owns a resource graph and the
+ *  traverser that matches jobs against it so that a caller can
+ *  schedule without going through the resource module.
+ *  reapi_cli_t methods take a pointer to an object of this class
+ *  as their handle.
+ */
+class resource_query_t {
+public:
+    /*! Load the resource graph from rgraph and initialize the traverser.
+     *
+     *  \param rgraph   resource graph string (e.g., JGF).
+     *  \param params   matcher parameters.
+     *  \return         0 on success; -1 on error with errno set:
+     *                       EINVAL: invalid parameter
+     *                       ENOMEM: out of memory
+     */
+    int initialize (const std::string &rgraph,
+                    const resource_params_t &params);
+
+    /*! Match jobspec with op and track the resulting schedule.
+     *
+     *  \return         0 on success; -1 on error with errno set:
+     *                       EBUSY: resources are unavailable
+     *                       ENODEV: unsatisfiable jobspec
+     *                       EINVAL: invalid argument or existent jobid
+     */
+    int match (int64_t jobid, match_op_t op, const std::string &jobspec,
+               bool &reserved, std::string &R, int64_t &at, double &ov);
+
+    /*! Update the resource graph with the allocation in R.
+     *  An allocated job with the same R_lite is accepted as is.
+     *
+     *  \return         0 on success; -1 on error with errno set.
+     */
+    int update (int64_t jobid, const std::string &R, int64_t &at, double &ov,
+                std::string &R_out);
+
+    /*! Release the allocation or reservation of jobid.
+     *
+     *  \return         0 on success; -1 on error with errno set:
+     *                       ENOENT: unknown jobid unless noent_ok
+     */
+    int cancel (int64_t jobid, bool noent_ok);
+
+    int info (int64_t jobid, bool &reserved, int64_t &at, double &ov);
+    void stat (int64_t &V, int64_t &E, int64_t &J,
+               double &load, double &min, double &max, double &avg) const;
+
+    /*! Match at now instead of the wall-clock time: e.g., to drive
+     *  the matcher from a simulated clock. A negative now restores
+     *  the wall clock.
+     */
+    void set_now (int64_t now);
+
+    /*! Return the number of resource vertices of type in the graph.
+     */
+    size_t nresources (const std::string &type) const;
+
+    const std::string &err_message () const;
+    void clear_err_message ();
+
+private:
+    int select_subsystems ();
+    int parse_R (const char *R, std::string &jgf,
+                 int64_t &starttime, uint64_t &duration);
+    int Rlite_equal (const char *R1, const char *R2);
+    int track (int64_t jobid, bool reserved, int64_t at,
+               const std::string &jobspec, const std::string &R, double ov);
+    void update_perf (double elapse);
+
+    resource_params_t m_params;
+    std::shared_ptr<dfu_match_cb_t> m_matcher = nullptr;
+    std::shared_ptr<dfu_traverser_t> m_traverser = nullptr;
+    std::shared_ptr<resource_graph_db_t> m_db = nullptr;
+    std::shared_ptr<f_resource_graph_t> m_fgraph = nullptr;
+    std::shared_ptr<match_writers_t> m_writers = nullptr;
+    std::map<uint64_t, std::shared_ptr<job_info_t>> m_jobs;
+    std::map<uint64_t, uint64_t> m_allocations;
+    std::map<uint64_t, uint64_t> m_reservations;
+    double m_load = 0.0f;
+    uint64_t m_njobs = 0;
+    double m_min = std::numeric_limits<double>::max ();
+    double m_max = 0.0f;
+    double m_accum = 0.0f;
+    int64_t m_now = -1;
+    std::string m_err_msg = "";
+};
+
 class reapi_cli_t : public reapi_t {
 public:
     static int match_allocate (void *h, bool orelse_reserve,
@@ -49,9 +158,14 @@ public:
     static int match_allocate_multi (void *h, bool orelse_reserve,
                                      const char *jobs,
                                      queue_adapter_base_t *adapter);
+    static int match_allocate_orelse_reserve_multi (
+        void *h, unsigned int reservation_depth, const char *jobs,
+        queue_adapter_base_t *adapter);
     static int update_allocate (void *h, const uint64_t jobid,
                                 const std::string &R, int64_t &at, double &ov,
                                 std::string &R_out);
+    static int update_allocate_multi (void *h, const char *jobs,
+                                      std::vector<update_result_t> &results);
     static int cancel (void *h, const int64_t jobid, bool noent_ok);
     static int info (void *h, const int64_t jobid,
                      bool &reserved, int64_t &at, double &ov);
@@ -64,7 +178,7 @@ public:
 } // namespace Flux::resource_model
 } // namespace Flux
 
-#endif // REAPI_MODULE_HPP
+#endif // REAPI_CLI_HPP
 
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
@@ -30,53 +30,635 @@ extern "C" {
 #include "config.h"
 #endif
 #include <flux/core.h>
+#include <jansson.h>
+#include <sys/time.h>
 }
 
+#include <climits>
+#include <sstream>
 #include "resource/hlapi/bindings/c++/reapi_cli.hpp"
 
 namespace Flux {
 namespace resource_model {
 namespace detail {
 
-const int NOT_YET_IMPLEMENTED = -1;
+/****************************************************************************
+ *                                                                          *
+ *                 In-Process Resource Matcher Private API                  *
+ *                                                                          *
+ ****************************************************************************/
+
+static double get_elapse_time (timeval &st, timeval &et)
+{
+    double ts1 = (double)st.tv_sec + (double)st.tv_usec/1000000.0f;
+    double ts2 = (double)et.tv_sec + (double)et.tv_usec/1000000.0f;
+    return ts2 - ts1;
+}
+
+int resource_query_t::select_subsystems ()
+{
+    /*
+     * Format of match_subsystems
+     * subsystem1[:relation1[:relation2...]],subsystem2[...
+     */
+    std::stringstream ss (m_params.match_subsystems);
+    subsystem_t subsystem;
+    std::string token;
+
+    while (getline (ss, token, ',')) {
+        size_t found = token.find_first_of (":");
+        subsystem = token.substr (0, found);
+        if (!m_db->known_subsystem (subsystem)) {
+            errno = EINVAL;
+            m_err_msg += __FUNCTION__;
+            m_err_msg += ": unknown subsystem " + token + ".\n";
+            return -1;
+        }
+        if (found == std::string::npos) {
+            m_matcher->add_subsystem (subsystem, "*");
+        } else {
+            std::stringstream relations (token.substr (found+1,
+                                                       std::string::npos));
+            std::string relation;
+            while (getline (relations, relation, ':'))
+                m_matcher->add_subsystem (subsystem, relation);
+        }
+    }
+    return 0;
+}
+
+int resource_query_t::parse_R (const char *R, std::string &jgf,
+                               int64_t &starttime, uint64_t &duration)
+{
+    int rc = -1;
+    int version = 0;
+    int saved_errno;
+    uint64_t st = 0;
+    uint64_t et = 0;
+    json_t *o = NULL;
+    json_t *graph = NULL;
+    json_error_t error;
+    char *jgf_str = NULL;
+
+    if ( (o = json_loads (R, 0, &error)) == NULL) {
+        errno = EINVAL;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": " + std::string (error.text) + ".\n";
+        goto out;
+    }
+    if (json_unpack (o, "{s:i s:{s:I s:I} s?:o}",
+                            "version", &version,
+                            "execution",
+                                "starttime", &st,
+                                "expiration", &et,
+                            "scheduling", &graph) < 0) {
+        errno = EINVAL;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": json_unpack.\n";
+        goto freemem_out;
+    }
+    if (version != 1 || et < st) {
+        errno = EPROTO;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": invalid version or execution window.\n";
+        goto freemem_out;
+    }
+    if (graph == NULL) {
+        errno = ENOENT;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": no scheduling key in R.\n";
+        goto freemem_out;
+    }
+    if ( !(jgf_str = json_dumps (graph, JSON_INDENT (0)))) {
+        errno = ENOMEM;
+        goto freemem_out;
+    }
+    jgf = jgf_str;
+    free (jgf_str);
+    starttime = static_cast<int64_t> (st);
+    duration = et - st;
+    rc = 0;
+
+freemem_out:
+    saved_errno = errno;
+    json_decref (o);
+    errno = saved_errno;
+out:
+    return rc;
+}
+
+int resource_query_t::Rlite_equal (const char *R1, const char *R2)
+{
+    int rc = -1;
+    int saved_errno;
+    json_t *o1 = NULL;
+    json_t *o2 = NULL;
+    json_t *rlite1 = NULL;
+    json_t *rlite2 = NULL;
+
+    if ( !(o1 = json_loads (R1, 0, NULL))
+        || !(o2 = json_loads (R2, 0, NULL))
+        || json_unpack (o1, "{s:{s:o}}", "execution", "R_lite", &rlite1) < 0
+        || json_unpack (o2, "{s:{s:o}}", "execution", "R_lite", &rlite2) < 0) {
+        errno = EINVAL;
+        goto out;
+    }
+    rc = (json_equal (rlite1, rlite2) == 1)? 0 : 1;
+
+out:
+    saved_errno = errno;
+    json_decref (o1);
+    json_decref (o2);
+    errno = saved_errno;
+    return rc;
+}
+
+int resource_query_t::track (int64_t jobid, bool reserved, int64_t at,
+                             const std::string &jobspec,
+                             const std::string &R, double ov)
+{
+    job_lifecycle_t state = (!reserved)? job_lifecycle_t::ALLOCATED
+                                       : job_lifecycle_t::RESERVED;
+    if (jobid < 0 || at < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    try {
+        m_jobs[jobid] = std::make_shared<job_info_t> (jobid, state, at, "",
+                                                      jobspec, R, ov);
+        if (!reserved)
+            m_allocations[jobid] = jobid;
+        else
+            m_reservations[jobid] = jobid;
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+void resource_query_t::update_perf (double elapse)
+{
+    m_njobs++;
+    m_min = (m_min > elapse)? elapse : m_min;
+    m_max = (m_max < elapse)? elapse : m_max;
+    m_accum += elapse;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                  In-Process Resource Matcher Public API                  *
+ *                                                                          *
+ ****************************************************************************/
+
+int resource_query_t::initialize (const std::string &rgraph,
+                                  const resource_params_t &params)
+{
+    int rc = -1;
+    struct timeval st, et;
+    std::shared_ptr<resource_reader_base_t> rd;
+
+    gettimeofday (&st, NULL);
+    try {
+        m_params = params;
+        m_db = std::make_shared<resource_graph_db_t> ();
+        m_traverser = std::make_shared<dfu_traverser_t> ();
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto done;
+    }
+    if ( !(m_matcher = create_match_cb (m_params.match_policy))) {
+        errno = EINVAL;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": unknown match policy "
+                     + m_params.match_policy + ".\n";
+        goto done;
+    }
+    if ( !(rd = create_resource_reader (m_params.load_format))) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't create reader for "
+                     + m_params.load_format + ".\n";
+        goto done;
+    }
+    if (m_params.load_allowlist != ""
+        && rd->set_allowlist (m_params.load_allowlist) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't set allowlist.\n";
+        goto done;
+    }
+    if (m_db->load (rgraph, rd) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": reader: " + rd->err_message ();
+        goto done;
+    }
+    if (select_subsystems () < 0)
+        goto done;
+    try {
+        resource_graph_t &g = m_db->resource_graph;
+        vtx_infra_map_t vmap = get (&resource_pool_t::idata, g);
+        edg_infra_map_t emap = get (&resource_relation_t::idata, g);
+        const multi_subsystemsS &filter = m_matcher->subsystemsS ();
+        subsystem_selector_t<vtx_t, f_vtx_infra_map_t> vtxsel (vmap, filter);
+        subsystem_selector_t<edg_t, f_edg_infra_map_t> edgsel (emap, filter);
+        m_fgraph = std::make_shared<f_resource_graph_t> (g, edgsel, vtxsel);
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto done;
+    }
+    if ( !(m_writers = match_writers_factory_t::create (
+                           match_writers_factory_t::get_writers_type (
+                               m_params.match_format)))) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't create writers for "
+                     + m_params.match_format + ".\n";
+        goto done;
+    }
+    if (m_params.prune_filters != ""
+        && m_matcher->set_pruning_types_w_spec (m_matcher->dom_subsystem (),
+                                                m_params.prune_filters) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": invalid prune filters "
+                     + m_params.prune_filters + ".\n";
+        goto done;
+    }
+    if (m_traverser->initialize (m_fgraph, m_db, m_matcher) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": traverser: " + m_traverser->err_message ();
+        goto done;
+    }
+    gettimeofday (&et, NULL);
+    m_load = get_elapse_time (st, et);
+    rc = 0;
+
+done:
+    return rc;
+}
+
+int resource_query_t::match (int64_t jobid, match_op_t op,
+                             const std::string &jobspec, bool &reserved,
+                             std::string &R, int64_t &at, double &ov)
+{
+    int rc = -1;
+    int64_t now = 0;
+    struct timeval st, et;
+    std::stringstream o;
+
+    if (jobid < 0 || m_jobs.find (jobid) != m_jobs.end ()) {
+        errno = EINVAL;
+        goto done;
+    }
+    gettimeofday (&st, NULL);
+    at = now = (m_now >= 0)? m_now : static_cast<int64_t> (st.tv_sec);
+    try {
+        Flux::Jobspec::Jobspec j {jobspec};
+        if ( (rc = m_traverser->run (j, m_writers, op, jobid, &at)) < 0)
+            goto done;
+    } catch (Flux::Jobspec::parse_error &e) {
+        errno = EINVAL;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": jobspec parse error: " + std::string (e.what ())
+                     + ".\n";
+        goto done;
+    }
+    if ( (rc = m_writers->emit (o)) < 0)
+        goto done;
+    gettimeofday (&et, NULL);
+    ov = get_elapse_time (st, et);
+    update_perf (ov);
+    reserved = (at != now);
+    R = o.str ();
+    rc = track (jobid, reserved, at, jobspec, R, ov);
+
+done:
+    return rc;
+}
+
+int resource_query_t::update (int64_t jobid, const std::string &R,
+                              int64_t &at, double &ov, std::string &R_out)
+{
+    int rc = -1;
+    uint64_t duration = 0;
+    struct timeval st, et;
+    std::string jgf;
+    std::stringstream o;
+    std::shared_ptr<resource_reader_base_t> rd;
+    auto it = m_jobs.find (jobid);
+
+    if (it != m_jobs.end ()) {
+        // A reconstructed job may be updated again (e.g., across a
+        // scheduler reload); accept it only if R_lite is unchanged.
+        if (it->second->state != job_lifecycle_t::ALLOCATED
+            || Rlite_equal (R.c_str (), it->second->R.c_str ()) != 0) {
+            errno = EINVAL;
+            goto done;
+        }
+        at = it->second->scheduled_at;
+        ov = it->second->overhead;
+        R_out = it->second->R;
+        rc = 0;
+        goto done;
+    }
+    gettimeofday (&st, NULL);
+    if (parse_R (R.c_str (), jgf, at, duration) < 0)
+        goto done;
+    if ( !(rd = create_resource_reader ("jgf")))
+        goto done;
+    if (m_traverser->run (jgf, m_writers, rd, jobid, at, duration) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": traverser: " + m_traverser->err_message ();
+        m_traverser->clear_err_message ();
+        goto done;
+    }
+    if (m_writers->emit (o) < 0)
+        goto done;
+    gettimeofday (&et, NULL);
+    ov = get_elapse_time (st, et);
+    update_perf (ov);
+    R_out = o.str ();
+    rc = track (jobid, false, at, "", R_out, ov);
+
+done:
+    return rc;
+}
+
+int resource_query_t::cancel (int64_t jobid, bool noent_ok)
+{
+    int rc = -1;
+    int64_t now = 0;
+    struct timeval st;
+
+    if (m_allocations.find (jobid) != m_allocations.end ())
+        m_allocations.erase (jobid);
+    else if (m_reservations.find (jobid) != m_reservations.end ())
+        m_reservations.erase (jobid);
+    else {
+        if (noent_ok)
+            return 0;
+        errno = ENOENT;
+        return -1;
+    }
+    gettimeofday (&st, NULL);
+    now = (m_now >= 0)? m_now : static_cast<int64_t> (st.tv_sec);
+    if ( (rc = m_traverser->remove (jobid, now)) < 0) {
+        // Keep the errored job in the table so that its jobid
+        // can't be reused up front.
+        if (m_jobs.find (jobid) != m_jobs.end ())
+            m_jobs[jobid]->state = job_lifecycle_t::ERROR;
+        return rc;
+    }
+    m_jobs.erase (jobid);
+    return 0;
+}
+
+int resource_query_t::info (int64_t jobid, bool &reserved,
+                            int64_t &at, double &ov)
+{
+    auto it = m_jobs.find (jobid);
+    if (it == m_jobs.end ()) {
+        errno = ENOENT;
+        return -1;
+    }
+    reserved = (it->second->state == job_lifecycle_t::RESERVED);
+    at = it->second->scheduled_at;
+    ov = it->second->overhead;
+    return 0;
+}
+
+void resource_query_t::stat (int64_t &V, int64_t &E, int64_t &J,
+                             double &load, double &min, double &max,
+                             double &avg) const
+{
+    V = static_cast<int64_t> (num_vertices (m_db->resource_graph));
+    E = static_cast<int64_t> (num_edges (m_db->resource_graph));
+    J = static_cast<int64_t> (m_njobs);
+    load = m_load;
+    min = m_njobs? m_min : 0.0f;
+    max = m_max;
+    avg = m_njobs? m_accum / static_cast<double> (m_njobs) : 0.0f;
+}
+
+void resource_query_t::set_now (int64_t now)
+{
+    m_now = now;
+}
+
+size_t resource_query_t::nresources (const std::string &type) const
+{
+    if (!m_db)
+        return 0;
+    auto it = m_db->metadata.by_type.find (type);
+    return (it != m_db->metadata.by_type.end ())? it->second.size () : 0;
+}
+
+const std::string &resource_query_t::err_message () const
+{
+    return m_err_msg;
+}
+
+void resource_query_t::clear_err_message ()
+{
+    m_err_msg = "";
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                          reapi_cli_t Public API                          *
+ *                                                                          *
+ ****************************************************************************/
+
+/* Run each {jobid, jobspec} entry of jobs through rq and report
+ * the result to adapter synchronously. When rdepth is negative, the
+ * first failed match terminates the loop (FCFS); otherwise, up to
+ * rdepth jobs may be reserved and a failed match is reported for
+ * that job only (backfill). This mirrors match_multi of the resource
+ * module.
+ */
+static int match_multi (resource_query_t *rq, match_op_t op, int rdepth,
+                        const char *jobs, queue_adapter_base_t *adapter)
+{
+    size_t index;
+    json_t *value;
+    json_t *o = nullptr;
+    int nreserved = 0;
+    int errnum = ENODATA;
+
+    if (!rq || !jobs || !adapter) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ( !(o = json_loads (jobs, 0, NULL))) {
+        errno = EINVAL;
+        return -1;
+    }
+    json_array_foreach (o, index, value) {
+        json_int_t jobid = 0;
+        const char *jobspec = nullptr;
+        match_op_t job_op = op;
+        bool reserved = false;
+        int64_t at = 0;
+        double ov = 0.0f;
+        std::string R;
+
+        if (json_unpack (value, "{s:I s:s}",
+                                  "jobid", &jobid,
+                                  "jobspec", &jobspec) < 0) {
+            errnum = EPROTO;
+            break;
+        }
+        if (rdepth >= 0 && nreserved >= rdepth)
+            job_op = match_op_t::MATCH_ALLOCATE_W_SATISFIABILITY;
+        if (rq->match (jobid, job_op, jobspec, reserved, R, at, ov) == 0) {
+            if (reserved)
+                nreserved++;
+            if (adapter->handle_match_success (jobid,
+                                               reserved? "RESERVED"
+                                                       : "ALLOCATED",
+                                               R.c_str (), at, ov) < 0) {
+                json_decref (o);
+                adapter->set_sched_loop_active (false);
+                return 0;
+            }
+            continue;
+        }
+        if (rdepth < 0) {
+            errnum = errno;
+            break;
+        }
+        if (adapter->handle_match_failure (jobid, errno) < 0) {
+            json_decref (o);
+            adapter->set_sched_loop_active (false);
+            return 0;
+        }
+    }
+    json_decref (o);
+    adapter->handle_match_failure (-1, errnum);
+    adapter->set_sched_loop_active (false);
+    return 0;
+}
 
 int reapi_cli_t::match_allocate (void *h, bool orelse_reserve,
                                  const std::string &jobspec,
                                  const uint64_t jobid, bool &reserved,
                                  std::string &R, int64_t &at, double &ov)
 {
-    return NOT_YET_IMPLEMENTED;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+    match_op_t op = orelse_reserve? match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE
+                                  : match_op_t::MATCH_ALLOCATE;
+    if (!rq || jobid > INT64_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    return rq->match (static_cast<int64_t> (jobid), op, jobspec,
+                      reserved, R, at, ov);
 }
 
 int reapi_cli_t::update_allocate (void *h, const uint64_t jobid,
                                   const std::string &R, int64_t &at, double &ov,
                                   std::string &R_out)
 {
-    return NOT_YET_IMPLEMENTED;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+    if (!rq || R == "" || jobid > INT64_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    return rq->update (static_cast<int64_t> (jobid), R, at, ov, R_out);
+}
+
+int reapi_cli_t::update_allocate_multi (void *h, const char *jobs,
+                                        std::vector<update_result_t> &results)
+{
+    int rc = -1;
+    size_t index;
+    json_t *value;
+    json_t *o = nullptr;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+
+    if (!rq || !jobs) {
+        errno = EINVAL;
+        goto out;
+    }
+    if ( !(o = json_loads (jobs, 0, NULL))) {
+        errno = EINVAL;
+        goto out;
+    }
+    json_array_foreach (o, index, value) {
+        json_int_t jobid = 0;
+        const char *R = nullptr;
+        update_result_t result;
+
+        if (json_unpack (value, "{s:I s:s}", "jobid", &jobid, "R", &R) < 0) {
+            errno = EPROTO;
+            goto out;
+        }
+        if (rq->update (jobid, R, result.at, result.ov, result.R) < 0)
+            goto out;
+        result.jobid = static_cast<uint64_t> (jobid);
+        results.push_back (std::move (result));
+    }
+    rc = 0;
+
+out:
+    json_decref (o);
+    return rc;
 }
 
 int reapi_cli_t::match_allocate_multi (void *h, bool orelse_reserve,
                                        const char *jobs,
                                        queue_adapter_base_t *adapter)
 {
-    return NOT_YET_IMPLEMENTED;
+    match_op_t op = orelse_reserve?
+                        match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE
+                      : match_op_t::MATCH_ALLOCATE_W_SATISFIABILITY;
+    return match_multi (static_cast<resource_query_t *> (h),
+                        op, -1, jobs, adapter);
+}
+
+int reapi_cli_t::match_allocate_orelse_reserve_multi (
+        void *h, unsigned int reservation_depth, const char *jobs,
+        queue_adapter_base_t *adapter)
+{
+    if (reservation_depth > INT_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    return match_multi (static_cast<resource_query_t *> (h),
+                        match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE,
+                        static_cast<int> (reservation_depth), jobs, adapter);
 }
 
 int reapi_cli_t::cancel (void *h, const int64_t jobid, bool noent_ok)
 {
-    return NOT_YET_IMPLEMENTED;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+    if (!rq) {
+        errno = EINVAL;
+        return -1;
+    }
+    return rq->cancel (jobid, noent_ok);
 }
 
 int reapi_cli_t::info (void *h, const int64_t jobid,
                        bool &reserved, int64_t &at, double &ov)
 {
-    return NOT_YET_IMPLEMENTED;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+    if (!rq) {
+        errno = EINVAL;
+        return -1;
+    }
+    return rq->info (jobid, reserved, at, ov);
 }
 
 int reapi_cli_t::stat (void *h, int64_t &V, int64_t &E,int64_t &J,
                        double &load, double &min, double &max, double &avg)
 {
-    return NOT_YET_IMPLEMENTED;
+    resource_query_t *rq = static_cast<resource_query_t *> (h);
+    if (!rq) {
+        errno = EINVAL;
+        return -1;
+    }
+    rq->stat (V, E, J, load, min, max, avg);
+    return 0;
 }
 
 
@@ -34,6 +34,7 @@ extern "C" {
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include "resource/hlapi/bindings/c++/reapi.hpp"
 
 namespace Flux {
@@ -49,9 +50,14 @@ public:
     static int match_allocate_multi (void *h, bool orelse_reserve,
                                      const char *jobs,
                                      queue_adapter_base_t *adapter);
+    static int match_allocate_orelse_reserve_multi (
+        void *h, unsigned int reservation_depth, const char *jobs,
+        queue_adapter_base_t *adapter);
     static int update_allocate (void *h, const uint64_t jobid,
                                 const std::string &R, int64_t &at, double &ov,
                                 std::string &R_out);
+    static int update_allocate_multi (void *h, const char *jobs,
+                                      std::vector<update_result_t> &results);
     static int cancel (void *h, const uint64_t jobid, bool noent_ok);
     static int info (void *h, const uint64_t jobid,
                      bool &reserved, int64_t &at, double &ov);
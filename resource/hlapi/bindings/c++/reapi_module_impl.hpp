@@ -33,6 +33,7 @@ extern "C" {
 }
 
 #include <cerrno>
+#include <climits>
 #include "resource/hlapi/bindings/c++/reapi_module.hpp"
 
 namespace Flux {
@@ -86,26 +87,34 @@ out:
 
 void match_allocate_multi_cont (flux_future_t *f, void *arg)
 {
+    int rc = 0;
     int64_t rj = -1;
-    int64_t at;
-    double ov;
+    int64_t at = 0;
+    double ov = 0.0f;
+    int errnum = 0;
     const char *rset = nullptr;
     const char *status = nullptr;
     queue_adapter_base_t *adapter = static_cast<queue_adapter_base_t *> (arg);
 
-    if (flux_rpc_get_unpack (f, "{s:I s:s s:f s:s s:I}",
+    if (flux_rpc_get_unpack (f, "{s:I s:s s?f s?s s?I s?i}",
                                   "jobid", &rj,
                                   "status", &status,
                                   "overhead", &ov,
                                   "R", &rset,
-                                  "at", &at) == 0) {
-        if (adapter->handle_match_success (rj, status, rset, at, ov) < 0) {
+                                  "at", &at,
+                                  "errnum", &errnum) == 0) {
+        // A failed match within a backfill window does not end the stream
+        if (std::string ("FAILED") == status)
+            rc = adapter->handle_match_failure (rj, errnum);
+        else
+            rc = adapter->handle_match_success (rj, status, rset, at, ov);
+        if (rc < 0) {
             adapter->set_sched_loop_active (false);
             flux_future_destroy (f);
             return;
         }
     } else {
-        adapter->handle_match_failure (errno);
+        adapter->handle_match_failure (-1, errno);
         adapter->set_sched_loop_active (false);
         flux_future_destroy (f);
         return;
@@ -114,27 +123,30 @@ void match_allocate_multi_cont (flux_future_t *f, void *arg)
     return;
 }
 
-int reapi_module_t::match_allocate_multi (void *h,
-                                          bool orelse_reserve,
-                                          const char *jobs,
-                                          queue_adapter_base_t *adapter)
+static int match_multi (flux_t *fh, const char *cmd, int reservation_depth,
+                        const char *jobs, queue_adapter_base_t *adapter)
 {
     int rc = -1;
-    flux_t *fh = static_cast<flux_t *> (h);
     flux_future_t *f = nullptr;
 
-    const char *cmd = orelse_reserve ? "allocate_orelse_reserve"
-                                     : "allocate_with_satisfiability";
-    if (!fh) {
+    if (!fh || !jobs || !adapter) {
         errno = EINVAL;
         goto error;
     }
-    if ( !(f = flux_rpc_pack (fh,
-                              "sched-fluxion-resource.match_multi",
-                              FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
-                              "{s:s s:s}",
-                                "cmd", cmd,
-                                "jobs", jobs)))
+    if (reservation_depth < 0)
+        f = flux_rpc_pack (fh, "sched-fluxion-resource.match_multi",
+                           FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
+                           "{s:s s:s}",
+                             "cmd", cmd,
+                             "jobs", jobs);
+    else
+        f = flux_rpc_pack (fh, "sched-fluxion-resource.match_multi",
+                           FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
+                           "{s:s s:s s:i}",
+                             "cmd", cmd,
+                             "jobs", jobs,
+                             "reservation_depth", reservation_depth);
+    if (!f)
         goto error;
     if (flux_future_then (f,
                           -1.0f,
@@ -148,6 +160,28 @@ error:
     return rc;
 }
 
+int reapi_module_t::match_allocate_multi (void *h,
+                                          bool orelse_reserve,
+                                          const char *jobs,
+                                          queue_adapter_base_t *adapter)
+{
+    const char *cmd = orelse_reserve ? "allocate_orelse_reserve"
+                                     : "allocate_with_satisfiability";
+    return match_multi (static_cast<flux_t *> (h), cmd, -1, jobs, adapter);
+}
+
+int reapi_module_t::match_allocate_orelse_reserve_multi (
+        void *h, unsigned int reservation_depth, const char *jobs,
+        queue_adapter_base_t *adapter)
+{
+    if (reservation_depth > INT_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    return match_multi (static_cast<flux_t *> (h), "allocate_orelse_reserve",
+                        static_cast<int> (reservation_depth), jobs, adapter);
+}
+
 int reapi_module_t::update_allocate (void *h, const uint64_t jobid,
                                     const std::string &R, int64_t &at,
                                     double &ov, std::string &R_out)
@@ -195,6 +229,59 @@ out:
     return rc;
 }
 
+int reapi_module_t::update_allocate_multi (
+        void *h, const char *jobs, std::vector<update_result_t> &results)
+{
+    int rc = -1;
+    flux_t *fh = static_cast<flux_t *> (h);
+    flux_future_t *f = nullptr;
+
+    if (!fh || !jobs) {
+        errno = EINVAL;
+        goto out;
+    }
+    if ( !(f = flux_rpc_pack (fh, "sched-fluxion-resource.update_multi",
+                                  FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
+                                  "{s:s}", "jobs", jobs)))
+        goto out;
+
+    // The resource service applies all of the jobs back-to-back
+    // and streams the results; consume them until ENODATA.
+    for (;;) {
+        int64_t rj = -1;
+        int64_t at = -1;
+        double ov = 0.0f;
+        const char *rset = nullptr;
+        const char *status = nullptr;
+        update_result_t result;
+
+        if (flux_rpc_get_unpack (f, "{s:I s:s s:f s:s s:I}",
+                                     "jobid", &rj,
+                                     "status", &status,
+                                     "overhead", &ov,
+                                     "R", &rset,
+                                     "at", &at) < 0) {
+            if (errno == ENODATA)
+                rc = 0;
+            goto out;
+        }
+        if (rj < 0 || std::string ("ALLOCATED") != status) {
+            errno = EPROTO;
+            goto out;
+        }
+        result.jobid = static_cast<uint64_t> (rj);
+        result.at = at;
+        result.ov = ov;
+        result.R = rset;
+        results.push_back (std::move (result));
+        flux_future_reset (f);
+    }
+
+out:
+    flux_future_destroy (f);
+    return rc;
+}
+
 int reapi_module_t::cancel (void *h, const uint64_t jobid, bool noent_ok)
 {
     int rc = -1;
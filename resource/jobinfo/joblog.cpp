@@ -0,0 +1,598 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+extern "C" {
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstring>
+#include <cinttypes>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include "resource/jobinfo/joblog.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+static const char *joblog_header = "fluxion-joblog 1";
+
+
+/****************************************************************************
+ *                                                                          *
+ *                        Job Log Private Methods                           *
+ *                                                                          *
+ ****************************************************************************/
+
+int job_log_t::write_header (FILE *fp)
+{
+    if (fprintf (fp, "%s\n", joblog_header) < 0) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+static std::string allocate_record (uint64_t jobid, int64_t at,
+                                    const std::string &R)
+{
+    return "A " + std::to_string (jobid) + " " + std::to_string (at) + " "
+           + std::to_string (R.size ()) + "\n" + R + "\n";
+}
+
+static int pread_R (int fd, const job_log_pos_t &p, std::string &R)
+{
+    size_t n = 0;
+
+    R.resize (p.len);
+    while (n < p.len) {
+        ssize_t rc = pread (fd, &R[n], p.len - n, p.offset + n);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0) {
+            errno = EIO;
+            return -1;
+        }
+        n += static_cast<size_t> (rc);
+    }
+    return 0;
+}
+
+int job_log_t::scan (std::ifstream &in, const std::string &path,
+                     std::map<uint64_t, job_log_pos_t> &pos)
+{
+    std::string line;
+
+    if (!std::getline (in, line) || line != joblog_header) {
+        errno = EPROTO;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": unknown job log header in " + path + ".\n";
+        return -1;
+    }
+
+    try {
+        while (std::getline (in, line)) {
+            char op;
+            uint64_t jobid = 0;
+            int64_t at = -1;
+            size_t len = 0;
+            std::istringstream istr (line);
+
+            if (!(istr >> op >> jobid))
+                break;
+            if (op == 'A') {
+                job_log_pos_t p;
+                if (!(istr >> at >> len))
+                    break;
+                p.offset = in.tellg ();
+                if (!in.seekg (len, std::ios_base::cur)
+                    || in.get () != '\n')
+                    break;
+                p.state = job_lifecycle_t::ALLOCATED;
+                p.at = at;
+                p.len = len;
+                pos[jobid] = p;
+            } else if (op == 'R') {
+                job_log_pos_t p;
+                if (!(istr >> at))
+                    break;
+                p.state = job_lifecycle_t::RESERVED;
+                p.at = at;
+                pos[jobid] = p;
+            } else if (op == 'C') {
+                pos.erase (jobid);
+            } else {
+                break;
+            }
+        }
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": out of memory.\n";
+        return -1;
+    }
+    // A torn record leaves failbit/eofbit set; clear them so that
+    // R can still be read back through the recorded offsets.
+    in.clear ();
+    return 0;
+}
+
+int job_log_t::read_R (std::ifstream &in, const job_log_pos_t &p,
+                       std::string &R)
+{
+    R.resize (p.len);
+    if (p.len && (!in.seekg (p.offset) || !in.read (&R[0], p.len))) {
+        errno = EIO;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't read R back from the job log.\n";
+        in.clear ();
+        return -1;
+    }
+    return 0;
+}
+
+int job_log_t::append (const std::string &record, bool counted,
+                       uint64_t jobid, job_lifecycle_t state, int64_t at,
+                       size_t len)
+{
+    std::lock_guard<std::mutex> guard (m_lock);
+
+    if (!m_fp) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Flush to the kernel on every record so that the log survives
+    // a module reload or a crash of the broker. fsync is only paid
+    // at checkpoints.
+    if (fwrite (record.data (), 1, record.size (), m_fp) != record.size ()
+        || fflush (m_fp) == EOF) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": " + std::string (strerror (errno)) + ".\n";
+        return -1;
+    }
+    if (state == job_lifecycle_t::ALLOCATED) {
+        // R ends the record, right before its trailing newline
+        job_log_pos_t p;
+        p.state = state;
+        p.at = at;
+        p.offset = m_size + record.size () - len - 1;
+        p.len = len;
+        m_pos[jobid] = p;
+    } else {
+        m_pos.erase (jobid);
+    }
+    m_size += record.size ();
+    // The checkpoint in progress took its snapshot before this record
+    if (m_ckpt_running)
+        m_pending += record;
+    if (counted)
+        m_nrecords++;
+    return 0;
+}
+
+void job_log_t::relocate (const std::map<uint64_t, job_log_pos_t> &ckpt,
+                          std::streamoff base)
+{
+    auto it = m_pos.begin ();
+
+    // Records appended since the snapshot now follow those of the
+    // checkpoint at base; jobs no longer allocated in the snapshot
+    // were left out of the checkpoint.
+    while (it != m_pos.end ()) {
+        auto c = ckpt.find (it->first);
+        if (it->second.offset >= m_pending_base) {
+            it->second.offset += base - m_pending_base;
+            ++it;
+        } else if (c != ckpt.end ()) {
+            it->second = c->second;
+            ++it;
+        } else {
+            it = m_pos.erase (it);
+        }
+    }
+}
+
+void job_log_t::checkpoint_worker (std::vector<ckpt_job_t> snapshot, int fd)
+{
+    int rc = -1;
+    FILE *fp = nullptr;
+    std::string R;
+    std::string err = "";
+    std::string tmp = m_path + ".tmp";
+    std::map<uint64_t, job_log_pos_t> ckpt;
+
+    // R is copied from the current log, whose records in the snapshot
+    // stay in place until the new log is swapped in. Records appended
+    // after the snapshot are not needed here: they are in m_pending.
+    if ( !(fp = fopen (tmp.c_str (), "w+"))) {
+        m_ckpt_errno = errno;
+        err += __FUNCTION__;
+        err += ": fopen (" + tmp + "): "
+               + std::string (strerror (m_ckpt_errno)) + ".\n";
+        goto done;
+    }
+    if (write_header (fp) < 0)
+        goto error;
+    try {
+        for (auto &job : snapshot) {
+            job_log_pos_t p = job.pos;
+            if (pread_R (fd, job.pos, R) < 0
+                || fprintf (fp, "A %ju %jd %zu\n",
+                            static_cast<uintmax_t> (job.jobid),
+                            static_cast<intmax_t> (p.at), p.len) < 0
+                || (p.offset = ftell (fp)) < 0
+                || fwrite (R.data (), 1, R.size (), fp) != R.size ()
+                || fputc ('\n', fp) == EOF)
+                goto error;
+            ckpt[job.jobid] = p;
+        }
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (fflush (fp) == EOF || fsync (fileno (fp)) < 0)
+        goto error;
+
+    {
+        // Catch up with the records appended since the snapshot and swap
+        // the new log in. They have only been flushed to the old log,
+        // so they need not be synced here either.
+        std::lock_guard<std::mutex> guard (m_lock);
+        std::streamoff base = ftell (fp);
+        if (base < 0
+            || fwrite (m_pending.data (), 1, m_pending.size (), fp)
+                   != m_pending.size ()
+            || fflush (fp) == EOF
+            || rename (tmp.c_str (), m_path.c_str ()) < 0) {
+            m_pending.clear ();
+            m_ckpt_running = false;
+            goto error;
+        }
+        if (m_fp)
+            fclose (m_fp);
+        m_fp = fp;
+        fp = nullptr;
+        relocate (ckpt, base);
+        m_size = base + m_pending.size ();
+        m_pending.clear ();
+        m_ckpt_running = false;
+    }
+    rc = 0;
+    goto done;
+
+error:
+    m_ckpt_errno = errno;
+    err += __FUNCTION__;
+    err += ": can't write " + tmp + ": "
+           + std::string (strerror (m_ckpt_errno)) + ".\n";
+    if (fp)
+        fclose (fp);
+    unlink (tmp.c_str ());
+done:
+    if (rc < 0) {
+        std::lock_guard<std::mutex> guard (m_lock);
+        m_pending.clear ();
+        m_ckpt_running = false;
+    }
+    m_ckpt_rc = rc;
+    m_ckpt_err = err;
+    m_ckpt_done = true;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                         Job Log Public API                               *
+ *                                                                          *
+ ****************************************************************************/
+
+job_log_t::~job_log_t ()
+{
+    close ();
+}
+
+int job_log_t::replay (const std::string &path,
+                       std::map<uint64_t, job_log_entry_t> &live)
+{
+    int rc = -1;
+    std::ifstream in;
+    std::map<uint64_t, job_log_pos_t> pos;
+
+    in.open (path.c_str (), std::ifstream::in | std::ifstream::binary);
+    if (!in.good ())
+        return 0; // Nothing to replay
+    if (scan (in, path, pos) < 0)
+        goto done;
+
+    try {
+        for (auto &kv : pos) {
+            job_log_entry_t e;
+            e.jobid = kv.first;
+            e.state = kv.second.state;
+            e.at = kv.second.at;
+            if (e.state == job_lifecycle_t::ALLOCATED
+                && read_R (in, kv.second, e.R) < 0)
+                goto done;
+            live[kv.first] = std::move (e);
+        }
+        rc = 0;
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": out of memory.\n";
+    }
+
+done:
+    in.close ();
+    return rc;
+}
+
+int job_log_t::open (const std::string &path)
+{
+    long pos = 0;
+    std::ifstream in;
+    std::map<uint64_t, job_log_pos_t> all;
+
+    close ();
+    // R is read back through the same stream, hence a+
+    if ( !(m_fp = fopen (path.c_str (), "a+"))) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": fopen (" + path + "): "
+                     + std::string (strerror (errno)) + ".\n";
+        return -1;
+    }
+    if (fseek (m_fp, 0, SEEK_END) < 0 || (pos = ftell (m_fp)) < 0
+        || (pos == 0 && write_header (m_fp) < 0) || fflush (m_fp) == EOF
+        || (m_size = ftell (m_fp)) < 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't initialize " + path + ".\n";
+        close ();
+        return -1;
+    }
+    if (pos > 0) {
+        in.open (path.c_str (), std::ifstream::in | std::ifstream::binary);
+        if (!in.good () || scan (in, path, all) < 0) {
+            m_err_msg += __FUNCTION__;
+            m_err_msg += ": can't index " + path + ".\n";
+            close ();
+            return -1;
+        }
+        for (auto &kv : all)
+            if (kv.second.state == job_lifecycle_t::ALLOCATED)
+                m_pos[kv.first] = kv.second;
+    }
+    m_path = path;
+    m_nrecords = 0;
+    return 0;
+}
+
+void job_log_t::close ()
+{
+    int saved_errno = errno;
+    // A checkpoint that fails here leaves the old log in place
+    checkpoint_wait ();
+    errno = saved_errno;
+    if (m_fp) {
+        fclose (m_fp);
+        m_fp = nullptr;
+    }
+    m_pos.clear ();
+    m_size = 0;
+}
+
+bool job_log_t::is_open () const
+{
+    std::lock_guard<std::mutex> guard (m_lock);
+    return m_fp != nullptr;
+}
+
+int job_log_t::log_allocate (uint64_t jobid, int64_t at, const std::string &R)
+{
+    try {
+        if (append (allocate_record (jobid, at, R), true, jobid,
+                    job_lifecycle_t::ALLOCATED, at, R.size ()) < 0)
+            goto error;
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return 0;
+
+error:
+    m_err_msg += __FUNCTION__;
+    m_err_msg += ": can't append jobid=" + std::to_string (jobid) + ".\n";
+    return -1;
+}
+
+int job_log_t::log_reserve (uint64_t jobid, int64_t at)
+{
+    try {
+        if (append ("R " + std::to_string (jobid) + " "
+                    + std::to_string (at) + "\n", false, jobid,
+                    job_lifecycle_t::RESERVED) < 0)
+            goto error;
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return 0;
+
+error:
+    m_err_msg += __FUNCTION__;
+    m_err_msg += ": can't append jobid=" + std::to_string (jobid) + ".\n";
+    return -1;
+}
+
+int job_log_t::log_cancel (uint64_t jobid, bool freed)
+{
+    try {
+        if (append ("C " + std::to_string (jobid) + "\n", freed, jobid,
+                    job_lifecycle_t::CANCELED) < 0)
+            goto error;
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return 0;
+
+error:
+    m_err_msg += __FUNCTION__;
+    m_err_msg += ": can't append jobid=" + std::to_string (jobid) + ".\n";
+    return -1;
+}
+
+int job_log_t::read_R (uint64_t jobid, std::string &R)
+{
+    std::lock_guard<std::mutex> guard (m_lock);
+    auto it = m_pos.find (jobid);
+
+    if (!m_fp || it == m_pos.end ()) {
+        errno = ENOENT;
+        return -1;
+    }
+    try {
+        if (pread_R (fileno (m_fp), it->second, R) < 0) {
+            m_err_msg += __FUNCTION__;
+            m_err_msg += ": can't read R back from the job log.\n";
+            return -1;
+        }
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": out of memory.\n";
+        return -1;
+    }
+    return 0;
+}
+
+int job_log_t::checkpoint (const job_table_t &jobs)
+{
+    if (checkpoint_wait () < 0 || checkpoint_async (jobs) < 0)
+        return -1;
+    return checkpoint_wait ();
+}
+
+int job_log_t::checkpoint_async (const job_table_t &jobs)
+{
+    int fd = -1;
+    std::vector<ckpt_job_t> snapshot;
+
+    if (m_worker.joinable ()) {
+        if (!m_ckpt_done)
+            return 0;
+        if (checkpoint_wait () < 0)
+            return -1;
+    }
+    if (m_path == "" || !m_fp) {
+        errno = EINVAL;
+        return -1;
+    }
+    m_lock.lock ();
+    try {
+        jobs.for_each ([this, &snapshot] (const job_entry_t &e) {
+            auto it = m_pos.find (e.jobid);
+            if (e.state == job_lifecycle_t::ALLOCATED && it != m_pos.end ())
+                snapshot.push_back ({e.jobid, it->second});
+        });
+    } catch (std::bad_alloc &e) {
+        m_lock.unlock ();
+        errno = ENOMEM;
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": out of memory.\n";
+        return -1;
+    }
+    m_pending.clear ();
+    m_pending_base = m_size;
+    m_ckpt_running = true;
+    fd = fileno (m_fp);
+    m_lock.unlock ();
+    m_ckpt_done = false;
+    m_ckpt_rc = 0;
+    m_ckpt_errno = 0;
+    m_ckpt_err = "";
+    try {
+        m_worker = std::thread (&job_log_t::checkpoint_worker, this,
+                                std::move (snapshot), fd);
+    } catch (std::system_error &e) {
+        m_lock.lock ();
+        m_ckpt_running = false;
+        m_lock.unlock ();
+        errno = e.code ().value ();
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": can't start the checkpoint thread.\n";
+        return -1;
+    }
+    m_nrecords = 0;
+    return 0;
+}
+
+int job_log_t::checkpoint_wait ()
+{
+    if (!m_worker.joinable ())
+        return 0;
+    m_worker.join ();
+    if (m_ckpt_rc < 0) {
+        m_err_msg += m_ckpt_err;
+        m_ckpt_rc = 0;
+        errno = m_ckpt_errno;
+        return -1;
+    }
+    return 0;
+}
+
+bool job_log_t::need_checkpoint () const
+{
+    return m_interval != 0 && m_nrecords >= m_interval;
+}
+
+void job_log_t::set_checkpoint_interval (unsigned int interval)
+{
+    m_interval = interval;
+}
+
+unsigned int job_log_t::get_checkpoint_interval () const
+{
+    return m_interval;
+}
+
+const std::string &job_log_t::err_message () const
+{
+    return m_err_msg;
+}
+
+void job_log_t::clear_err_message ()
+{
+    m_err_msg = "";
+}
+
+} // namespace resource_model
+} // namespace Flux
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,227 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef JOBLOG_HPP
+#define JOBLOG_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "resource/jobinfo/jobinfo.hpp"
+#include "resource/jobinfo/jobtable.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+/*! A job log entry surviving the replay of a job log.
+ */
+struct job_log_entry_t {
+    uint64_t jobid = UINT64_MAX;
+    job_lifecycle_t state = job_lifecycle_t::INIT;
+    int64_t at = -1;
+    std::string R = "";
+};
+
+/*! Where the last surviving record of a job lies in a job log.
+ *  For an allocate record, offset and len locate its R.
+ */
+struct job_log_pos_t {
+    job_lifecycle_t state = job_lifecycle_t::INIT;
+    int64_t at = -1;
+    std::streamoff offset = 0;
+    size_t len = 0;
+};
+
+/*! Append-only log of allocate, reserve and cancel events.
+ *  Each record is written and flushed before the corresponding
+ *  match result is returned to the requester so that a restarted
+ *  resource service can rebuild its allocation state from the log
+ *  instead of waiting for one update RPC per running job.
+ *  A checkpoint atomically replaces the log with the allocated jobs only,
+ *  which bounds its size. The log is also the only place where the R of
+ *  an allocated job is kept: it indexes the last allocate record of each
+ *  allocated job and reads R back from there on demand.
+ *  Checkpoints can run on a background thread: records appended while
+ *  one is in progress are also copied to the new log before it replaces
+ *  the old one, so the appending thread never waits for an fsync.
+ *
+ *  Record format (one record per event):
+ *      A <jobid> <at> <len>\n<R of len bytes>\n   allocate
+ *      R <jobid> <at>\n                           reserve
+ *      C <jobid>\n                                cancel
+ */
+class job_log_t {
+public:
+    ~job_log_t ();
+
+    /*! Read the job log at path and fold its records into live.
+     *  A truncated or malformed record (e.g., a torn write at the time
+     *  of a crash) ends the replay; all records before it are kept.
+     *
+     * \param path   job log file path
+     * \param live   map into which surviving jobs are returned
+     * \return       0 on success (including when path does not exist);
+     *               -1 on error with errno set:
+     *                   EPROTO: unknown log header.
+     *                   ENOMEM: out of memory.
+     */
+    int replay (const std::string &path,
+                std::map<uint64_t, job_log_entry_t> &live);
+
+    /*! Open path for appending. Create it if it does not exist;
+     *  otherwise, index the allocate records it already contains.
+     *
+     * \param path   job log file path
+     * \return       0 on success; -1 on error with errno set:
+     *                   EPROTO: unknown log header.
+     */
+    int open (const std::string &path);
+
+    /*! Close the job log.
+     */
+    void close ();
+
+    /*! Return true if the log is open for appending.
+     */
+    bool is_open () const;
+
+    /*! Append an allocate, reserve or cancel record.
+     *
+     * \return       0 on success; -1 on error with errno set.
+     */
+    int log_allocate (uint64_t jobid, int64_t at, const std::string &R);
+    int log_reserve (uint64_t jobid, int64_t at);
+
+    /*! Append a cancel record.
+     *
+     * \param jobid  jobid
+     * \param freed  true if the job held an allocation. Only the records
+     *               of allocations and their frees count toward the
+     *               checkpoint interval: reservations are never replayed.
+     * \return       0 on success; -1 on error with errno set.
+     */
+    int log_cancel (uint64_t jobid, bool freed);
+
+    /*! Read back the R of the last allocate record of jobid.
+     *
+     * \param jobid  jobid
+     * \param R      string into which R is returned
+     * \return       0 on success; -1 on error with errno set:
+     *                   ENOENT: jobid is not allocated in the log.
+     *                   EIO: R can't be read back.
+     */
+    int read_R (uint64_t jobid, std::string &R);
+
+    /*! Replace the log with one allocate record per allocated job
+     *  in jobs, whose R is copied from its last allocate record in the
+     *  current log. An allocated job without one is left out. The new
+     *  log is written to a temporary file, synced and renamed over the
+     *  old one.
+     *  checkpoint waits for the new log to be in place; checkpoint_async
+     *  only takes the snapshot of jobs and leaves the writing to a
+     *  background thread. It returns 0 without starting a new checkpoint
+     *  while the previous one is still running; the failure of a previous
+     *  checkpoint is reported by the next call or by checkpoint_wait.
+     *
+     * \param jobs   jobs table
+     * \return       0 on success; -1 on error with errno set.
+     */
+    int checkpoint (const job_table_t &jobs);
+    int checkpoint_async (const job_table_t &jobs);
+
+    /*! Wait for the background checkpoint, if any, to finish.
+     *
+     * \return       0 on success; -1 if it failed with errno set.
+     */
+    int checkpoint_wait ();
+
+    /*! Return true when the number of allocate and free records appended
+     *  since the last checkpoint has reached the checkpoint interval.
+     */
+    bool need_checkpoint () const;
+    void set_checkpoint_interval (unsigned int interval);
+    unsigned int get_checkpoint_interval () const;
+
+    /*! Return the error message string.
+     */
+    const std::string &err_message () const;
+
+    /*! Clear the error message string.
+     */
+    void clear_err_message ();
+
+private:
+    struct ckpt_job_t {
+        uint64_t jobid;
+        job_log_pos_t pos;
+    };
+
+    int scan (std::ifstream &in, const std::string &path,
+              std::map<uint64_t, job_log_pos_t> &pos);
+    int read_R (std::ifstream &in, const job_log_pos_t &p, std::string &R);
+    int write_header (FILE *fp);
+    int append (const std::string &record, bool counted, uint64_t jobid,
+                job_lifecycle_t state, int64_t at = -1, size_t len = 0);
+    void relocate (const std::map<uint64_t, job_log_pos_t> &ckpt,
+                   std::streamoff base);
+    void checkpoint_worker (std::vector<ckpt_job_t> snapshot, int fd);
+
+    FILE *m_fp = nullptr;
+    std::string m_path = "";
+    unsigned int m_nrecords = 0;
+    unsigned int m_interval = 1024;
+    std::string m_err_msg = "";
+
+    // m_lock guards m_fp, m_size, m_pos, m_pending and m_ckpt_running,
+    // which the checkpoint thread swaps in once the new log is synced.
+    // m_pos locates the R of each allocated job in the current log;
+    // records at or past m_pending_base were appended during the
+    // checkpoint in progress.
+    mutable std::mutex m_lock;
+    std::thread m_worker;
+    std::atomic<bool> m_ckpt_done {false};
+    bool m_ckpt_running = false;
+    std::streamoff m_size = 0;
+    std::streamoff m_pending_base = 0;
+    std::map<uint64_t, job_log_pos_t> m_pos;
+    std::string m_pending = "";
+    int m_ckpt_rc = 0;
+    int m_ckpt_errno = 0;
+    std::string m_ckpt_err = "";
+};
+
+} // namespace resource_model
+} // namespace Flux
+
+#endif // JOBLOG_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
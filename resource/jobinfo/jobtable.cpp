@@ -0,0 +1,201 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <cerrno>
+#include <new>
+#include <utility>
+#include "resource/jobinfo/jobtable.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+static const size_t min_slots = 64;
+
+
+/****************************************************************************
+ *                                                                          *
+ *                        Job Table Private Methods                         *
+ *                                                                          *
+ ****************************************************************************/
+
+size_t job_table_t::slot_of (uint64_t jobid) const
+{
+    // Flux jobids (FLUIDs) carry a timestamp in their upper bits and a
+    // sequence number in their lower bits; mix them before masking.
+    uint64_t h = jobid;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t> (h) & (m_slots.size () - 1);
+}
+
+size_t job_table_t::probe (uint64_t jobid) const
+{
+    size_t mask = m_slots.size () - 1;
+    size_t i = slot_of (jobid);
+    while (m_slots[i].jobid != UINT64_MAX && m_slots[i].jobid != jobid)
+        i = (i + 1) & mask;
+    return i;
+}
+
+int job_table_t::grow ()
+{
+    size_t n = m_slots.empty ()? min_slots : m_slots.size () * 2;
+    std::vector<job_entry_t> old;
+
+    try {
+        old.swap (m_slots);
+        m_slots.resize (n);
+    } catch (std::bad_alloc &e) {
+        m_slots.swap (old);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (auto &e : old) {
+        if (e.jobid != UINT64_MAX)
+            m_slots[probe (e.jobid)] = std::move (e);
+    }
+    return 0;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                         Job Table Public API                             *
+ *                                                                          *
+ ****************************************************************************/
+
+job_entry_t *job_table_t::find (uint64_t jobid)
+{
+    if (m_size == 0 || jobid == UINT64_MAX)
+        return nullptr;
+    size_t i = probe (jobid);
+    return (m_slots[i].jobid == jobid)? &m_slots[i] : nullptr;
+}
+
+const job_entry_t *job_table_t::find (uint64_t jobid) const
+{
+    if (m_size == 0 || jobid == UINT64_MAX)
+        return nullptr;
+    size_t i = probe (jobid);
+    return (m_slots[i].jobid == jobid)? &m_slots[i] : nullptr;
+}
+
+int job_table_t::insert (const job_entry_t &e)
+{
+    job_entry_t copy = e;
+    return insert (std::move (copy));
+}
+
+int job_table_t::insert (job_entry_t &&e)
+{
+    size_t i;
+    if (e.jobid == UINT64_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Keep the load factor at or below 3/4
+    if ((m_size + 1) * 4 > m_slots.size () * 3 && grow () < 0)
+        return -1;
+    i = probe (e.jobid);
+    if (m_slots[i].jobid == UINT64_MAX)
+        m_size++;
+    if (!m_max_stale && e.jobid > m_max_jobid)
+        m_max_jobid = e.jobid;
+    m_slots[i] = std::move (e);
+    return 0;
+}
+
+int job_table_t::erase (uint64_t jobid)
+{
+    size_t mask, i, j;
+
+    if (m_size == 0 || jobid == UINT64_MAX)
+        return 0;
+    mask = m_slots.size () - 1;
+    i = probe (jobid);
+    if (m_slots[i].jobid != jobid)
+        return 0;
+
+    // Backward-shift deletion: pull each later member of the probe run
+    // into the hole unless its home slot lies cyclically in (i, j].
+    j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (m_slots[j].jobid == UINT64_MAX)
+            break;
+        size_t home = slot_of (m_slots[j].jobid);
+        if ((i <= j)? (i < home && home <= j) : (i < home || home <= j))
+            continue;
+        m_slots[i] = std::move (m_slots[j]);
+        i = j;
+    }
+    m_slots[i] = job_entry_t ();
+    m_size--;
+    if (jobid == m_max_jobid)
+        m_max_stale = true;
+    return 1;
+}
+
+bool job_table_t::contains (uint64_t jobid) const
+{
+    return find (jobid) != nullptr;
+}
+
+size_t job_table_t::size () const
+{
+    return m_size;
+}
+
+uint64_t job_table_t::max_jobid () const
+{
+    // Recomputed lazily: only test tooling asks for it.
+    if (m_max_stale) {
+        m_max_jobid = 0;
+        for_each ([this] (const job_entry_t &e) {
+            if (e.jobid > m_max_jobid)
+                m_max_jobid = e.jobid;
+        });
+        m_max_stale = false;
+    }
+    return m_max_jobid;
+}
+
+uint64_t job_table_t::digest (const std::string &canonical_R_lite)
+{
+    // 64-bit FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : canonical_R_lite) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+} // namespace resource_model
+} // namespace Flux
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
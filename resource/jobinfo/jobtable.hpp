@@ -0,0 +1,124 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef JOBTABLE_HPP
+#define JOBTABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "resource/jobinfo/jobinfo.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+/*! Compact record of a job tracked by the resource service.
+ *  Neither the jobspec nor R is retained: the R of an allocated job
+ *  is read back from the job log on demand. Only the digest of its
+ *  R_lite is kept, for the cheap equality check performed on a
+ *  re-issued update.
+ */
+struct job_entry_t {
+    uint64_t jobid = UINT64_MAX;
+    int64_t scheduled_at = -1;
+    uint64_t R_digest = 0;
+    double overhead = 0.0f;
+    job_lifecycle_t state = job_lifecycle_t::INIT;
+};
+
+/*! Job table indexed by jobid through open addressing with linear
+ *  probing. Entries are stored inline in a power-of-two sized slot
+ *  array and removal uses backward-shift deletion, so no tombstones
+ *  are needed and there is no per-job heap allocation.
+ */
+class job_table_t {
+public:
+    /*! Return the entry of jobid or nullptr if it is not tracked.
+     *  The pointer is invalidated by the next insert or erase.
+     */
+    job_entry_t *find (uint64_t jobid);
+    const job_entry_t *find (uint64_t jobid) const;
+
+    /*! Insert or overwrite the entry of e.jobid.
+     *
+     * \param e      job entry; e.jobid must not be UINT64_MAX.
+     * \return       0 on success; -1 on error with errno set:
+     *                   EINVAL: invalid jobid.
+     *                   ENOMEM: out of memory.
+     */
+    int insert (const job_entry_t &e);
+    int insert (job_entry_t &&e);
+
+    /*! Remove the entry of jobid.
+     *
+     * \return       1 if removed; 0 if jobid was not tracked.
+     */
+    int erase (uint64_t jobid);
+
+    /*! Return true if jobid is tracked.
+     */
+    bool contains (uint64_t jobid) const;
+
+    /*! Return the number of tracked jobs.
+     */
+    size_t size () const;
+
+    /*! Return the largest tracked jobid or 0 if the table is empty.
+     */
+    uint64_t max_jobid () const;
+
+    /*! Call f (const job_entry_t &) on every tracked job in slot order.
+     */
+    template<typename F>
+    void for_each (F f) const
+    {
+        for (const auto &e : m_slots)
+            if (e.jobid != UINT64_MAX)
+                f (e);
+    }
+
+    /*! Return the digest of an R_lite string in its canonical form
+     *  (compact encoding with sorted keys).
+     */
+    static uint64_t digest (const std::string &canonical_R_lite);
+
+private:
+    size_t slot_of (uint64_t jobid) const;
+    size_t probe (uint64_t jobid) const;
+    int grow ();
+
+    std::vector<job_entry_t> m_slots;
+    size_t m_size = 0;
+    mutable uint64_t m_max_jobid = 0;
+    mutable bool m_max_stale = false;
+};
+
+} // namespace resource_model
+} // namespace Flux
+
+#endif // JOBTABLE_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
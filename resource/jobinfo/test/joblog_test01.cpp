@@ -0,0 +1,241 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Unit tests for job_log_t: append, replay, checkpoint, reading R back
+ * from the log and the replay of a log whose last record was torn
+ * by a crash.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+extern "C" {
+#include <unistd.h>
+#include <sys/stat.h>
+}
+
+#include <map>
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include "resource/jobinfo/joblog.hpp"
+#include "src/common/libtap/tap.h"
+
+using namespace Flux::resource_model;
+
+static std::string dir;
+
+static long file_size (const std::string &path)
+{
+    struct stat sb;
+    return (stat (path.c_str (), &sb) < 0)? -1 : sb.st_size;
+}
+
+static void track (job_table_t &jobs, uint64_t jobid,
+                   job_lifecycle_t state, int64_t at)
+{
+    job_entry_t e;
+    e.jobid = jobid;
+    e.state = state;
+    e.scheduled_at = at;
+    jobs.insert (e);
+}
+
+static void test_append_replay ()
+{
+    job_log_t log;
+    std::string R;
+    std::map<uint64_t, job_log_entry_t> live;
+    std::string path = dir + "/append.log";
+
+    ok (log.replay (path, live) == 0 && live.empty (),
+        "replaying a missing log is a no-op");
+    ok (log.open (path) == 0 && log.is_open (), "open creates the log");
+    ok (log.log_allocate (1, 0, "{\"R1\"}") == 0
+        && log.log_allocate (2, 10, "{\"R2\"}") == 0
+        && log.log_reserve (3, 100) == 0
+        && log.log_cancel (2, true) == 0
+        && log.log_allocate (4, 20, "") == 0,
+        "records are appended");
+    ok (log.read_R (1, R) == 0 && R == "{\"R1\"}"
+        && log.read_R (2, R) < 0 && errno == ENOENT
+        && log.read_R (3, R) < 0 && errno == ENOENT,
+        "R of allocated jobs only is read back");
+    log.close ();
+
+    ok (log.replay (path, live) == 0 && live.size () == 3,
+        "replay folds cancels into the surviving jobs");
+    ok (live[1].state == job_lifecycle_t::ALLOCATED && live[1].at == 0
+        && live[1].R == "{\"R1\"}", "allocated job keeps its R");
+    ok (live[3].state == job_lifecycle_t::RESERVED && live[3].at == 100,
+        "reserved job keeps its start time");
+    ok (live[4].state == job_lifecycle_t::ALLOCATED && live[4].R == "",
+        "an empty R is replayed");
+    ok (log.open (path) == 0 && log.read_R (1, R) == 0 && R == "{\"R1\"}"
+        && log.read_R (4, R) == 0 && R == ""
+        && log.read_R (2, R) < 0, "reopening indexes the existing records");
+    log.close ();
+}
+
+static void test_checkpoint ()
+{
+    job_log_t log;
+    job_table_t jobs;
+    long before = 0;
+    std::string R;
+    std::map<uint64_t, job_log_entry_t> live;
+    std::string path = dir + "/checkpoint.log";
+
+    log.set_checkpoint_interval (4);
+    ok (log.open (path) == 0, "open the log to checkpoint");
+    for (uint64_t id = 1; id <= 3; id++) {
+        log.log_allocate (id, id * 10, "R" + std::to_string (id));
+        track (jobs, id, job_lifecycle_t::ALLOCATED, id * 10);
+    }
+    log.log_reserve (4, 100);
+    track (jobs, 4, job_lifecycle_t::RESERVED, 100);
+    log.log_cancel (4, false);
+    jobs.erase (4);
+    ok (!log.need_checkpoint (),
+        "reserve records and their cancels do not count");
+    log.log_cancel (2, true);
+    jobs.erase (2);
+    ok (log.need_checkpoint (), "allocate and free records count");
+
+    before = file_size (path);
+    ok (log.checkpoint (jobs) == 0, "checkpoint succeeds");
+    ok (!log.need_checkpoint (), "checkpoint resets the record count");
+    ok (file_size (path) < before, "checkpoint shrinks the log");
+    ok (file_size (path + ".tmp") < 0, "no temporary file is left behind");
+    ok (log.read_R (3, R) == 0 && R == "R3" && log.read_R (2, R) < 0,
+        "R is read back from the checkpointed log");
+
+    // Records appended after a checkpoint go to the new log
+    ok (log.log_allocate (5, 50, "R5") == 0, "append after checkpoint");
+    track (jobs, 5, job_lifecycle_t::ALLOCATED, 50);
+    log.close ();
+    ok (log.replay (path, live) == 0 && live.size () == 3
+        && live[1].R == "R1" && live[3].R == "R3" && live[3].at == 30
+        && live[5].R == "R5", "checkpointed log replays the live jobs");
+}
+
+static void test_checkpoint_async ()
+{
+    job_log_t log;
+    job_table_t jobs;
+    std::map<uint64_t, job_log_entry_t> live;
+    std::string path = dir + "/async.log";
+    std::string R;
+    int rc = 0;
+
+    ok (log.open (path) == 0, "open the log to checkpoint in background");
+    for (uint64_t id = 1; id <= 1000; id++) {
+        rc += log.log_allocate (id, 0, "R" + std::to_string (id));
+        track (jobs, id, job_lifecycle_t::ALLOCATED, 0);
+    }
+    ok (rc == 0 && log.checkpoint_async (jobs) == 0,
+        "background checkpoint starts");
+    // Records racing with the checkpoint must survive it
+    for (uint64_t id = 1; id <= 500; id++) {
+        rc += log.log_cancel (id, true);
+        jobs.erase (id);
+    }
+    rc += log.log_allocate (1001, 5, "R1001");
+    track (jobs, 1001, job_lifecycle_t::ALLOCATED, 5);
+    ok (rc == 0 && log.checkpoint_wait () == 0,
+        "background checkpoint completes");
+    ok (log.log_allocate (1002, 6, "R1002") == 0,
+        "append to the swapped-in log");
+    ok (log.read_R (501, R) == 0 && R == "R501"
+        && log.read_R (1001, R) == 0 && R == "R1001"
+        && log.read_R (1002, R) == 0 && R == "R1002"
+        && log.read_R (1, R) < 0 && errno == ENOENT,
+        "R is read back across the swap");
+    log.close ();
+    ok (log.replay (path, live) == 0 && live.size () == 502
+        && live.find (1) == live.end () && live[501].R == "R501"
+        && live[1001].R == "R1001" && live[1002].R == "R1002",
+        "records appended during the checkpoint are kept");
+}
+
+static void test_truncated_tail ()
+{
+    FILE *fp = nullptr;
+    job_log_t log;
+    std::map<uint64_t, job_log_entry_t> live;
+    std::string path = dir + "/torn.log";
+
+    ok (log.open (path) == 0 && log.log_allocate (1, 0, "R1") == 0
+        && log.log_allocate (2, 0, "R2") == 0, "write an intact prefix");
+    log.close ();
+    // A torn allocate record: its R is shorter than its length field
+    fp = fopen (path.c_str (), "a");
+    fputs ("A 3 0 100\n{\"par", fp);
+    fclose (fp);
+    ok (log.replay (path, live) == 0 && live.size () == 2
+        && live[2].R == "R2", "replay stops at a torn allocate record");
+
+    live.clear ();
+    fp = fopen (path.c_str (), "a");
+    fputs ("\nC", fp);
+    fclose (fp);
+    ok (log.replay (path, live) == 0 && live.size () == 2,
+        "replay ignores malformed trailing records");
+
+    live.clear ();
+    fp = fopen ((dir + "/bad.log").c_str (), "w");
+    fputs ("not-a-joblog\n", fp);
+    fclose (fp);
+    ok (log.replay (dir + "/bad.log", live) < 0 && errno == EPROTO,
+        "an unknown header is rejected");
+}
+
+int main (int argc, char *argv[])
+{
+    char tmpl[] = "/tmp/joblog_test01.XXXXXX";
+
+    plan (29);
+    if (!mkdtemp (tmpl))
+        BAIL_OUT ("mkdtemp failed");
+    dir = tmpl;
+
+    test_append_replay ();
+    test_checkpoint ();
+    test_checkpoint_async ();
+    test_truncated_tail ();
+
+    for (const char *f : {"append.log", "checkpoint.log", "async.log",
+                          "torn.log", "bad.log"})
+        unlink ((dir + "/" + f).c_str ());
+    rmdir (dir.c_str ());
+    done_testing ();
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,163 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Unit tests for job_table_t: insert, find, erase with backward-shift
+ * deletion across growth, and the R_lite digest kept for allocated
+ * jobs. Every operation is checked against a std::map reference.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <cerrno>
+#include <cstdlib>
+#include "resource/jobinfo/jobtable.hpp"
+#include "src/common/libtap/tap.h"
+
+using namespace Flux::resource_model;
+
+static job_entry_t make_entry (uint64_t jobid, job_lifecycle_t state)
+{
+    job_entry_t e;
+    e.jobid = jobid;
+    e.state = state;
+    e.scheduled_at = static_cast<int64_t> (jobid % 1000);
+    if (state == job_lifecycle_t::ALLOCATED)
+        e.R_digest = job_table_t::digest ("R" + std::to_string (jobid));
+    return e;
+}
+
+static bool same_as (const job_table_t &jobs,
+                     const std::map<uint64_t, job_lifecycle_t> &ref)
+{
+    size_t n = 0;
+    bool same = (jobs.size () == ref.size ());
+
+    for (const auto &kv : ref) {
+        const job_entry_t *e = jobs.find (kv.first);
+        if (!e || e->jobid != kv.first || e->state != kv.second)
+            same = false;
+        else if (kv.second == job_lifecycle_t::ALLOCATED
+                 && e->R_digest
+                        != job_table_t::digest ("R"
+                                                + std::to_string (kv.first)))
+            same = false;
+    }
+    jobs.for_each ([&n, &ref, &same] (const job_entry_t &e) {
+        n++;
+        if (ref.find (e.jobid) == ref.end ())
+            same = false;
+    });
+    return same && n == ref.size ();
+}
+
+static void test_basic ()
+{
+    job_table_t jobs;
+    job_entry_t *e = nullptr;
+
+    ok (jobs.size () == 0 && jobs.find (1) == nullptr
+        && jobs.max_jobid () == 0, "empty table");
+    ok (jobs.insert (make_entry (UINT64_MAX, job_lifecycle_t::ALLOCATED)) < 0
+        && errno == EINVAL, "the invalid jobid is rejected");
+    ok (jobs.insert (make_entry (7, job_lifecycle_t::RESERVED)) == 0
+        && jobs.contains (7) && jobs.size () == 1, "insert a reserved job");
+    e = jobs.find (7);
+    ok (e && e->scheduled_at == 7 && e->R_digest == 0,
+        "a reserved job keeps no R_lite digest");
+    ok (jobs.insert (make_entry (7, job_lifecycle_t::ALLOCATED)) == 0
+        && jobs.size () == 1, "insert overwrites an existing job");
+    e = jobs.find (7);
+    ok (e && e->state == job_lifecycle_t::ALLOCATED
+        && e->R_digest == job_table_t::digest ("R7"),
+        "an allocated job keeps its R_lite digest");
+    ok (jobs.erase (8) == 0 && jobs.erase (7) == 1 && jobs.size () == 0
+        && !jobs.contains (7), "erase");
+}
+
+static void test_no_R ()
+{
+    ok (std::is_trivially_copyable<job_entry_t>::value,
+        "entries own no heap-allocated R");
+}
+
+static void test_against_map ()
+{
+    job_table_t jobs;
+    std::map<uint64_t, job_lifecycle_t> ref;
+    uint64_t x = 88172645463325252ULL;
+    int bad_erase = 0;
+
+    // FLUID-like ids: a timestamp in the upper bits, a sequence below
+    for (int i = 0; i < 20000; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint64_t jobid = ((x % 4096) << 24) | (x % 64);
+        if (x % 3 == 0) {
+            if (jobs.erase (jobid) != static_cast<int> (ref.erase (jobid)))
+                bad_erase++;
+        } else {
+            job_lifecycle_t state = (x % 5 == 0)? job_lifecycle_t::RESERVED
+                                                : job_lifecycle_t::ALLOCATED;
+            jobs.insert (make_entry (jobid, state));
+            ref[jobid] = state;
+        }
+    }
+    ok (bad_erase == 0, "erase agrees with the reference");
+    ok (same_as (jobs, ref), "%zu jobs agree with the reference",
+        ref.size ());
+    ok (jobs.max_jobid () == (ref.empty ()? 0 : ref.rbegin ()->first),
+        "max_jobid after erases");
+}
+
+static void test_digest ()
+{
+    ok (job_table_t::digest ("") == 0xcbf29ce484222325ULL,
+        "digest of the empty string is the FNV-1a offset basis");
+    ok (job_table_t::digest ("{\"a\":1}") != job_table_t::digest ("{\"a\":2}"),
+        "different R_lite yield different digests");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (13);
+
+    test_basic ();
+    test_no_R ();
+    test_against_map ();
+    test_digest ();
+
+    done_testing ();
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -41,8 +41,12 @@ extern "C" {
 
 #include "resource/schema/resource_graph.hpp"
 #include "resource/readers/resource_reader_factory.hpp"
+#include "resource/readers/resource_reader_hwloc.hpp"
 #include "resource/traversers/dfu.hpp"
 #include "resource/jobinfo/jobinfo.hpp"
+#include "resource/jobinfo/joblog.hpp"
+#include "resource/jobinfo/jobtable.hpp"
+#include "resource/traversers/match_perf.hpp"
 #include "resource/policies/dfu_match_policy_factory.hpp"
 
 using namespace Flux::resource_model;
@@ -62,6 +66,8 @@ struct resource_args_t {
     std::string prune_filters;
     std::string match_format;
     int reserve_vtx_vec;           /* Allow for reserving vertex vector size */
+    std::string joblog_file;       /* job log file name */
+    unsigned int joblog_checkpoint;/* job log records between checkpoints */
 };
 
 struct match_perf_t {
@@ -70,6 +76,7 @@ struct match_perf_t {
     double min;                    /* Min match time */
     double max;                    /* Max match time */
     double accum;                  /* Total match time accumulated */
+    std::map<std::string, match_op_perf_t> ops; /* Per-op distributions */
 };
 
 class msg_wrap_t {
@@ -123,10 +130,12 @@ struct resource_ctx_t : public resource_interface_t {
     std::shared_ptr<match_writers_t> writers;   /* Vertex/Edge writers */
     std::shared_ptr<resource_reader_base_t> reader; /* resource reader */
     match_perf_t perf;             /* Match performance stats */
-    std::map<uint64_t, std::shared_ptr<job_info_t>> jobs; /* Jobs table */
+    job_table_t jobs;              /* Jobs table */
     std::map<uint64_t, uint64_t> allocations;  /* Allocation table */
     std::map<uint64_t, uint64_t> reservations; /* Reservation table */
     std::map<std::string, std::shared_ptr<msg_wrap_t>> notify_msgs;
+    job_log_t joblog;              /* Allocation/reservation event log */
+    std::set<uint64_t> replayed;   /* Replayed jobs yet to be confirmed */
 };
 
 
@@ -239,6 +248,9 @@ static void match_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
 static void update_request_cb (flux_t *h, flux_msg_handler_t *w,
                                const flux_msg_t *msg, void *arg);
 
+static void update_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
+                                     const flux_msg_t *msg, void *arg);
+
 static void cancel_request_cb (flux_t *h, flux_msg_handler_t *w,
                                const flux_msg_t *msg, void *arg);
 
@@ -272,6 +284,9 @@ static void status_request_cb (flux_t *h, flux_msg_handler_t *w,
 static void ns_info_request_cb (flux_t *h, flux_msg_handler_t *w,
                                 const flux_msg_t *msg, void *arg);
 
+static void trace_request_cb (flux_t *h, flux_msg_handler_t *w,
+                              const flux_msg_t *msg, void *arg);
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,
       "sched-fluxion-resource.match", match_request_cb, 0 },
@@ -279,6 +294,8 @@ static const struct flux_msg_handler_spec htab[] = {
        "sched-fluxion-resource.match_multi", match_multi_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,
       "sched-fluxion-resource.update", update_request_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,
+      "sched-fluxion-resource.update_multi", update_multi_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,
       "sched-fluxion-resource.cancel", cancel_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,
@@ -301,6 +318,8 @@ static const struct flux_msg_handler_spec htab[] = {
       "sched-fluxion-resource.status", status_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,
       "sched-fluxion-resource.ns-info", ns_info_request_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,
+      "sched-fluxion-resource.trace", trace_request_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END
 };
 
@@ -327,6 +346,8 @@ static void set_default_args (resource_args_t &args)
     args.prune_filters = "ALL:core";
     args.match_format = "rv1_nosched";
     args.reserve_vtx_vec = 0;
+    args.joblog_file = "";
+    args.joblog_checkpoint = 1024;
 }
 
 static std::shared_ptr<resource_ctx_t> getctx (flux_t *h)
@@ -341,6 +362,10 @@ static std::shared_ptr<resource_ctx_t> getctx (flux_t *h)
             ctx = std::make_shared<resource_ctx_t> ();
             ctx->traverser = std::make_shared<dfu_traverser_t> ();
             ctx->db = std::make_shared<resource_graph_db_t> ();
+            for (const char *op : { "allocate", "allocate_orelse_reserve",
+                                    "allocate_with_satisfiability",
+                                    "update" })
+                ctx->perf.ops[op];
         } catch (std::bad_alloc &e) {
             errno = ENOMEM;
             goto done;
@@ -427,6 +452,19 @@ static int process_args (std::shared_ptr<resource_ctx_t> &ctx,
                           __FUNCTION__, args.reserve_vtx_vec);
                 args.reserve_vtx_vec = 0;
             }
+        } else if (!strncmp ("joblog-file=",
+                             argv[i], sizeof ("joblog-file"))) {
+            args.joblog_file = strstr (argv[i], "=") + 1;
+        } else if (!strncmp ("joblog-checkpoint=",
+                             argv[i], sizeof ("joblog-checkpoint"))) {
+            int n = atoi (strstr (argv[i], "=") + 1);
+            if (n < 0) {
+                flux_log (ctx->h, LOG_ERR,
+                          "%s: out of range specified for joblog-checkpoint "
+                          "(%d)", __FUNCTION__, n);
+                n = 1024;
+            }
+            args.joblog_checkpoint = static_cast<unsigned int> (n);
         } else {
             rc = -1;
             errno = EINVAL;
@@ -826,6 +864,7 @@ static int grow_resource_db_hwloc (std::shared_ptr<resource_ctx_t> &ctx,
     flux_future_t *f = NULL;
     json_t *xml_array;
     const char *hwloc_xml;
+    std::shared_ptr<resource_reader_hwloc_t> reader;
 
     if (!(f = flux_rpc (ctx->h, "resource.get-xml", NULL, 0, 0)))
         goto done;
@@ -856,14 +895,38 @@ static int grow_resource_db_hwloc (std::shared_ptr<resource_ctx_t> &ctx,
     }
     v = db.metadata.roots.at ("containment");
 
-    rank = idset_next (ids, rank);
-    while (rank != IDSET_INVALID_ID) {
-        // For the rest of the ranks -- general case
-        if (!(hwloc_xml = get_array_string (xml_array, rank)))
-            goto done;
-        if ( (rc = grow (ctx, v, rank, hwloc_xml)) < 0)
-            goto done;
+    // For the rest of the ranks -- general case. Their XML is parsed
+    // and walked in parallel, then grafted in rank order.
+    try {
+        std::vector<std::pair<int, const char *>> xmls;
         rank = idset_next (ids, rank);
+        while (rank != IDSET_INVALID_ID) {
+            if (!(hwloc_xml = get_array_string (xml_array, rank))) {
+                rc = -1;
+                goto done;
+            }
+            xmls.push_back (std::make_pair (static_cast<int> (rank),
+                                            hwloc_xml));
+            rank = idset_next (ids, rank);
+        }
+        db.metadata.generation++;
+        if (!(reader = std::dynamic_pointer_cast<
+                           resource_reader_hwloc_t> (ctx->reader))) {
+            for (auto &kv : xmls) {
+                if ( (rc = grow (ctx, v, kv.first, kv.second)) < 0)
+                    goto done;
+            }
+        } else if ( (rc = reader->unpack_ranks_at (db.resource_graph,
+                                                   db.metadata,
+                                                   v, xmls)) < 0) {
+            flux_log (ctx->h, LOG_ERR, "%s: reader: %s",
+                      __FUNCTION__, reader->err_message ().c_str ());
+            goto done;
+        }
+    } catch (std::bad_alloc &) {
+        rc = -1;
+        errno = ENOMEM;
+        goto done;
     }
 
 done:
@@ -1132,15 +1195,49 @@ static int mark (std::shared_ptr<resource_ctx_t> &ctx,
                                               : mark_lazy (ctx, ids, status);
 }
 
+static int shrink_resource_db (std::shared_ptr<resource_ctx_t> &ctx,
+                               const char *ids)
+{
+    int rc = -1;
+    std::set<int64_t> ranks;
+
+    // "shrink" shouldn't be a part of the first response of resource.acquire
+    if (!ctx->traverser->is_initialized ()) {
+        errno = EINVAL;
+        goto done;
+    }
+    if ( (rc = decode_rankset (ctx, ids, ranks)) < 0)
+        goto done;
+    if ( (rc = ctx->traverser->shrink (ranks)) < 0) {
+        flux_log_error (ctx->h, "%s: traverser::shrink: %s", __FUNCTION__,
+                                ctx->traverser->err_message ().c_str ());
+        ctx->traverser->clear_err_message ();
+        goto done;
+    }
+    flux_log (ctx->h, LOG_DEBUG, "resource graph shrunk (rankset=[%s])", ids);
+done:
+    return rc;
+}
+
 static int update_resource_db (std::shared_ptr<resource_ctx_t> &ctx,
                                json_t *resources,
-                               const char *up, const char *down)
+                               const char *up, const char *down,
+                               const char *shrink)
 {
     int rc = 0;
     if (resources && (rc = grow_resource_db (ctx, resources)) < 0) {
         flux_log_error (ctx->h, "%s: grow_resource_db", __FUNCTION__);
         goto done;
     }
+    // Once bootstrapped, prime only the grafted vertices so that the
+    // subtree plans of existing vertices keep their spans
+    if (resources && ctx->traverser->is_initialized ()
+        && (rc = ctx->traverser->grow ()) < 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: traverser::grow: %s", __FUNCTION__,
+                  ctx->traverser->err_message ().c_str ());
+        ctx->traverser->clear_err_message ();
+        goto done;
+    }
     if (up && (rc = mark (ctx, up, resource_pool_t::status_t::UP)) < 0) {
         flux_log_error (ctx->h, "%s: mark (up)", __FUNCTION__);
         goto done;
@@ -1149,6 +1246,10 @@ static int update_resource_db (std::shared_ptr<resource_ctx_t> &ctx,
         flux_log_error (ctx->h, "%s: mark (down)", __FUNCTION__);
         goto done;
     }
+    if (shrink && (rc = shrink_resource_db (ctx, shrink)) < 0) {
+        flux_log_error (ctx->h, "%s: shrink_resource_db", __FUNCTION__);
+        goto done;
+    }
 done:
     return rc;
 }
@@ -1158,19 +1259,22 @@ static void update_resource (flux_future_t *f, void *arg)
     int rc = -1;
     const char *up = NULL;
     const char *down = NULL;
+    const char *shrink = NULL;
     json_t *resources = NULL;
     std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
 
-    if ( (rc = flux_rpc_get_unpack (f, "{s?:o s?:s s?:s}",
+    if ( (rc = flux_rpc_get_unpack (f, "{s?:o s?:s s?:s s?:s}",
                                            "resources", &resources,
                                            "up", &up,
-                                           "down", &down)) < 0) {
+                                           "down", &down,
+                                           "shrink", &shrink)) < 0) {
         flux_log_error (ctx->h, "%s: exiting due to resource.acquire failure",
                         __FUNCTION__);
         flux_reactor_stop (flux_get_reactor (ctx->h));
         goto done;
     }
-    if ( (rc = update_resource_db (ctx, resources, up, down)) < 0) {
+    if ( (rc = update_resource_db (ctx, resources,
+                                  up, down, shrink)) < 0) {
         flux_log_error (ctx->h, "%s: update_resource_db", __FUNCTION__);
         goto done;
     }
@@ -1394,6 +1498,38 @@ static void update_match_perf (std::shared_ptr<resource_ctx_t> &ctx,
     ctx->perf.accum += elapse;
 }
 
+/* Record the phase breakdown of a match or update request of kind op.
+ * The traversal phases come from the traverser; visit counts are only
+ * meaningful for match requests.
+ */
+static void update_phase_perf (std::shared_ptr<resource_ctx_t> &ctx,
+                               const char *op, match_phase_times_t &pt,
+                               uint64_t start, bool visits)
+{
+    auto it = ctx->perf.ops.find (op);
+    const match_phase_times_t &tr_pt = ctx->traverser->get_phase_times ();
+
+    if (it == ctx->perf.ops.end ())
+        return;
+    pt[match_phase_t::SELECT] = tr_pt[match_phase_t::SELECT];
+    pt[match_phase_t::AVAIL] = tr_pt[match_phase_t::AVAIL];
+    pt[match_phase_t::UPDATE] = tr_pt[match_phase_t::UPDATE];
+    pt[match_phase_t::TOTAL] = match_perf_now () - start;
+    it->second.record (pt,
+                       visits? ctx->traverser->get_total_preorder_count () : 0,
+                       visits? ctx->traverser->get_total_postorder_count () : 0);
+}
+
+static void reset_match_perf (std::shared_ptr<resource_ctx_t> &ctx)
+{
+    ctx->perf.njobs = 0;
+    ctx->perf.min = std::numeric_limits<double>::max();
+    ctx->perf.max = 0.0f;
+    ctx->perf.accum = 0.0f;
+    for (auto &kv : ctx->perf.ops)
+        kv.second.reset ();
+}
+
 static inline std::string get_status_string (int64_t now, int64_t at)
 {
     return (at == now)? "ALLOCATED" : "RESERVED";
@@ -1403,23 +1539,110 @@ static inline bool is_existent_jobid (
                        const std::shared_ptr<resource_ctx_t> &ctx,
                        uint64_t jobid)
 {
-    return (ctx->jobs.find (jobid) != ctx->jobs.end ())? true : false;
+    return ctx->jobs.contains (jobid);
 }
 
+/* Compute the digest of the R_lite key of R in canonical form.
+ * Nothing is logged since R may legitimately not be in RV1 format
+ * (e.g., with match-format=simple).
+ */
+static int Rlite_digest (const char *R, uint64_t &digest)
+{
+    int rc = -1;
+    int saved_errno;
+    json_t *o = NULL;
+    json_t *rlite = NULL;
+    char *str = NULL;
+
+    if ( (o = json_loads (R, 0, NULL)) == NULL) {
+        errno = EINVAL;
+        goto out;
+    }
+    if ( (rc = json_unpack (o, "{s:{s:o}}",
+                                   "execution",
+                                   "R_lite", &rlite)) < 0) {
+        errno = EINVAL;
+        goto out;
+    }
+    if ( !(str = json_dumps (rlite, JSON_COMPACT | JSON_SORT_KEYS))) {
+        rc = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+    digest = job_table_t::digest (str);
+    free (str);
+    rc = 0;
+
+out:
+    saved_errno = errno;
+    json_decref (o);
+    errno = saved_errno;
+    return rc;
+}
+
+/* Append a schedule event to the job log if one is configured.
+ * A failure to log is not fatal: the job will simply be reconstructed
+ * from its R on the next restart. For a cancel, freed tells whether
+ * the job held an allocation. The log is checkpointed in the background.
+ */
+static void log_schedule_info (std::shared_ptr<resource_ctx_t> &ctx,
+                               int64_t id, job_lifecycle_t state, int64_t at,
+                               const std::string &R, bool freed = false)
+{
+    int rc = 0;
+    job_log_t &joblog = ctx->joblog;
+
+    if (!joblog.is_open ())
+        return;
+    switch (state) {
+    case job_lifecycle_t::ALLOCATED:
+        rc = joblog.log_allocate (id, at, R);
+        break;
+    case job_lifecycle_t::RESERVED:
+        rc = joblog.log_reserve (id, at);
+        break;
+    case job_lifecycle_t::CANCELED:
+        rc = joblog.log_cancel (id, freed);
+        break;
+    default:
+        break;
+    }
+    if (rc == 0 && joblog.need_checkpoint ())
+        rc = joblog.checkpoint_async (ctx->jobs);
+    if (rc < 0) {
+        flux_log_error (ctx->h, "%s: job log (id=%jd): %s", __FUNCTION__,
+                        static_cast<intmax_t> (id),
+                        joblog.err_message ().c_str ());
+        joblog.clear_err_message ();
+    }
+}
+
+/* Neither the jobspec nor R is kept in the jobs table: the R of an
+ * allocated job is only in the job log, from which it is read back on
+ * demand. An allocated job keeps the digest of its R_lite that
+ * update_allocation compares against.
+ */
 static int track_schedule_info (std::shared_ptr<resource_ctx_t> &ctx,
                                 int64_t id, bool reserved, int64_t at,
-                                const std::string &jspec,
                                 const std::stringstream &R, double elapse)
 {
+    job_entry_t e;
+    const std::string &R_str = R.str ();
+    job_lifecycle_t state = (!reserved)? job_lifecycle_t::ALLOCATED
+                                       : job_lifecycle_t::RESERVED;
     if (id < 0 || at < 0) {
         errno = EINVAL;
         return -1;
     }
+    e.jobid = static_cast<uint64_t> (id);
+    e.state = state;
+    e.scheduled_at = at;
+    e.overhead = elapse;
+    if (!reserved && Rlite_digest (R_str.c_str (), e.R_digest) < 0)
+        e.R_digest = 0;
+    if (ctx->jobs.insert (std::move (e)) < 0)
+        return -1;
     try {
-        job_lifecycle_t state = (!reserved)? job_lifecycle_t::ALLOCATED
-                                           : job_lifecycle_t::RESERVED;
-        ctx->jobs[id] = std::make_shared<job_info_t> (id, state, at, "",
-                                                      jspec, R.str (), elapse);
         if (!reserved)
             ctx->allocations[id] = id;
         else
@@ -1429,6 +1652,7 @@ static int track_schedule_info (std::shared_ptr<resource_ctx_t> &ctx,
         errno = ENOMEM;
         return -1;
     }
+    log_schedule_info (ctx, id, state, at, R_str);
     return 0;
 }
 
@@ -1495,57 +1719,59 @@ out:
     return rc;
 }
 
+/* Compare R_lite of R with that of the allocated job e.
+ * Return 0 if equal, 1 if different, and -1 on error.
+ */
 static int Rlite_equal (const std::shared_ptr<resource_ctx_t> &ctx,
-                        const char *R1, const char *R2)
+                        const char *R, const job_entry_t *e)
 {
-    int rc = -1;
-    int saved_errno;
-    json_t *o1 = NULL;
-    json_t *o2 = NULL;
-    json_t *rlite1 = NULL;
-    json_t *rlite2 = NULL;
-    json_error_t error1;
-    json_error_t error2;
-
-    if ( (o1 = json_loads (R1, 0, &error1)) == NULL) {
-        errno = EINVAL;
-        flux_log (ctx->h, LOG_ERR, "%s: %s", __FUNCTION__, error1.text);
-        goto out;
-    }
-    if ( (rc = json_unpack (o1, "{s:{s:o}}",
-                                    "execution",
-                                    "R_lite", &rlite1)) < 0) {
-        errno = EINVAL;
-        goto out;
-    }
-    if ( (o2 = json_loads (R2, 0, &error2)) == NULL) {
-        errno = EINVAL;
-        flux_log (ctx->h, LOG_ERR, "%s: %s", __FUNCTION__, error2.text);
-        goto out;
+    uint64_t digest = 0;
+
+    if (Rlite_digest (R, digest) < 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: no R_lite in R", __FUNCTION__);
+        return -1;
     }
-    if ( (rc = json_unpack (o2, "{s:{s:o}}",
-                                    "execution",
-                                    "R_lite", &rlite2)) < 0) {
+    if (e->R_digest == 0) {
         errno = EINVAL;
-        goto out;
+        flux_log (ctx->h, LOG_ERR, "%s: no R_lite recorded (id=%ju)",
+                  __FUNCTION__, static_cast<uintmax_t> (e->jobid));
+        return -1;
     }
-    rc = (json_equal (rlite1, rlite2) == 1)? 0 : 1;
+    return (digest == e->R_digest)? 0 : 1;
+}
 
-out:
-    saved_errno = errno;
-    json_decref (o1);
-    json_decref (o2);
-    errno = saved_errno;
-    return rc;
+/* Read the R of jobid back from the job log.
+ * Return 0 on success and -1 if the job log has no R for it.
+ */
+static int get_logged_R (std::shared_ptr<resource_ctx_t> &ctx,
+                         int64_t jobid, std::string &R)
+{
+    job_log_t &joblog = ctx->joblog;
+
+    if (!joblog.is_open ())
+        return -1;
+    if (joblog.read_R (static_cast<uint64_t> (jobid), R) < 0) {
+        if (errno != ENOENT) {
+            flux_log_error (ctx->h, "%s: job log (id=%jd): %s", __FUNCTION__,
+                            static_cast<intmax_t> (jobid),
+                            joblog.err_message ().c_str ());
+            joblog.clear_err_message ();
+        }
+        return -1;
+    }
+    return 0;
 }
 
 static int run (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
-                const char *cmd, const std::string &jstr, int64_t *at)
+                const char *cmd, const std::string &jstr, int64_t *at,
+                match_phase_times_t &pt)
 {
     int rc = 0;
+    uint64_t t0 = match_perf_now ();
     Flux::Jobspec::Jobspec j {jstr};
     dfu_traverser_t &tr = *(ctx->traverser);
 
+    pt[match_phase_t::PARSE] = match_perf_now () - t0;
     if (std::string ("allocate") == cmd)
         rc = tr.run (j, ctx->writers, match_op_t::MATCH_ALLOCATE, jobid, at);
     else if (std::string ("allocate_with_satisfiability") == cmd)
@@ -1589,6 +1815,9 @@ static int run_match (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
     struct timeval start;
     struct timeval end;
     bool rsv = false;
+    uint64_t t0 = 0;
+    uint64_t start_ns = match_perf_now ();
+    match_phase_times_t pt;
 
     if ( (rc = gettimeofday (&start, NULL)) < 0) {
         flux_log_error (ctx->h, "%s: gettimeofday", __FUNCTION__);
@@ -1604,13 +1833,18 @@ static int run_match (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
     }
 
     *at = *now = (int64_t)start.tv_sec;
-    if ( (rc = run (ctx, jobid, cmd, jstr, at)) < 0) {
+    if ( (rc = run (ctx, jobid, cmd, jstr, at, pt)) < 0) {
+        // Failed matches are part of what makes a scheduling loop slow
+        update_phase_perf (ctx, cmd, pt, start_ns, true);
         goto done;
     }
+    t0 = match_perf_now ();
     if ( (rc = ctx->writers->emit (o)) < 0) {
         flux_log_error (ctx->h, "%s: writer can't emit", __FUNCTION__);
         goto done;
     }
+    pt[match_phase_t::EMIT] = match_perf_now () - t0;
+    update_phase_perf (ctx, cmd, pt, start_ns, true);
 
     rsv = (*now != *at)? true : false;
     if ( (rc = gettimeofday (&end, NULL)) < 0) {
@@ -1620,7 +1854,7 @@ static int run_match (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
     *ov = get_elapse_time (start, end);
     update_match_perf (ctx, *ov);
 
-    if ( (rc = track_schedule_info (ctx, jobid, rsv, *at, jstr, o, *ov)) != 0) {
+    if ( (rc = track_schedule_info (ctx, jobid, rsv, *at, o, *ov)) != 0) {
         flux_log_error (ctx->h, "%s: can't add job info (id=%jd)",
                         __FUNCTION__, (intmax_t)jobid);
         goto done;
@@ -1641,6 +1875,9 @@ static int run_update (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
     struct timeval end;
     std::string jgf;
     std::string R2;
+    uint64_t t0 = 0;
+    uint64_t start_ns = match_perf_now ();
+    match_phase_times_t pt;
 
     if ( (rc = gettimeofday (&start, NULL)) < 0) {
         flux_log_error (ctx->h, "%s: gettimeofday", __FUNCTION__);
@@ -1650,21 +1887,25 @@ static int run_update (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid,
         flux_log_error (ctx->h, "%s: parsing R", __FUNCTION__);
         goto done;
     }
+    pt[match_phase_t::PARSE] = match_perf_now () - start_ns;
     if ( (rc = run (ctx, jobid, jgf, at, duration)) < 0) {
         flux_log_error (ctx->h, "%s: run", __FUNCTION__);
         goto done;
     }
+    t0 = match_perf_now ();
     if ( (rc = ctx->writers->emit (o)) < 0) {
         flux_log_error (ctx->h, "%s: writers->emit", __FUNCTION__);
         goto done;
     }
+    pt[match_phase_t::EMIT] = match_perf_now () - t0;
+    update_phase_perf (ctx, "update", pt, start_ns, false);
     if ( (rc = gettimeofday (&end, NULL)) < 0) {
         flux_log_error (ctx->h, "%s: gettimeofday", __FUNCTION__);
         goto done;
     }
     ov = get_elapse_time (start, end);
     update_match_perf (ctx, ov);
-    if ( (rc = track_schedule_info (ctx, jobid, false, at, "", o, ov)) != 0) {
+    if ( (rc = track_schedule_info (ctx, jobid, false, at, o, ov)) != 0) {
         flux_log_error (ctx->h, "%s: can't add job info (id=%jd)",
                         __FUNCTION__, (intmax_t)jobid);
         goto done;
@@ -1674,61 +1915,228 @@ done:
     return rc;
 }
 
-static void update_request_cb (flux_t *h, flux_msg_handler_t *w,
-                               const flux_msg_t *msg, void *arg)
+static int run_remove (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid)
 {
-    char *R = NULL;
-    int64_t at = 0;
-    double ov = 0.0f;
-    int64_t jobid = 0;
-    uint64_t duration = 0;
-    std::string status = "";
-    std::stringstream o;
+    int rc = -1;
+    bool freed = false;
+    struct timeval now;
+    job_entry_t *e = nullptr;
+    dfu_traverser_t &tr = *(ctx->traverser);
 
-    std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
-    if (flux_request_unpack (msg, NULL, "{s:I s:s}",
-                                            "jobid", &jobid,
-                                            "R", &R) < 0) {
-        flux_log_error (ctx->h, "%s: flux_request_unpack", __FUNCTION__);
-        goto error;
+    // Without the time of the cancel, the traversing order is left as is
+    if (gettimeofday (&now, NULL) < 0)
+        now.tv_sec = -1;
+    if ((rc = tr.remove (jobid, static_cast<int64_t> (now.tv_sec))) < 0) {
+        if ( (e = ctx->jobs.find (jobid))) {
+           // When this condition arises, we will be less likely
+           // to be able to reuse this jobid. Having the errored job
+           // in the jobs map will prevent us from reusing the jobid
+           // up front.  Note that a same jobid can be reserved and
+           // removed multiple times by the upper queuing layer
+           // as part of providing advanced queueing policies
+           // (e.g., conservative backfill).
+           e->state = job_lifecycle_t::ERROR;
+        }
+        goto out;
     }
-    if (is_existent_jobid (ctx, jobid)) {
-        int rc = 0;
+    if ( (e = ctx->jobs.find (jobid)))
+        freed = (e->state == job_lifecycle_t::ALLOCATED);
+    ctx->jobs.erase (jobid);
+    log_schedule_info (ctx, jobid, job_lifecycle_t::CANCELED, -1, "", freed);
+
+    rc = 0;
+out:
+    return rc;
+}
+
+/* Release the allocations replayed from the job log that qmanager
+ * has not confirmed through an update request. qmanager reconstructs
+ * all of its running jobs before it issues its first match, so these
+ * are jobs that ended while the resource module was not running.
+ */
+static int reap_replayed_jobs (std::shared_ptr<resource_ctx_t> &ctx)
+{
+    int rc = 0;
+    size_t n = ctx->replayed.size ();
+
+    for (auto id : ctx->replayed) {
+        ctx->allocations.erase (id);
+        if (run_remove (ctx, id) < 0) {
+            rc = -1;
+            flux_log_error (ctx->h, "%s: remove (id=%jd)",
+                            __FUNCTION__, static_cast<intmax_t> (id));
+        }
+    }
+    ctx->replayed.clear ();
+    if (n)
+        flux_log (ctx->h, LOG_INFO, "%s: released %zu unconfirmed job(s)",
+                  __FUNCTION__, n);
+    return rc;
+}
+
+/* Confirm a job replayed from the job log with the R that qmanager
+ * reconstructs it with. On a mismatch, the replayed allocation is
+ * released so that the caller can fall back to R-based reconstruction.
+ */
+static int confirm_replayed_job (std::shared_ptr<resource_ctx_t> &ctx,
+                                 int64_t jobid, const char *R)
+{
+    auto it = ctx->replayed.find (jobid);
+    if (it == ctx->replayed.end ())
+        return 0;
+    ctx->replayed.erase (it);
+    const job_entry_t *e = ctx->jobs.find (jobid);
+    if (e && Rlite_equal (ctx, R, e) == 0)
+        return 0;
+    flux_log (ctx->h, LOG_DEBUG, "%s: stale job log entry (id=%jd)",
+              __FUNCTION__, static_cast<intmax_t> (jobid));
+    ctx->allocations.erase (jobid);
+    return run_remove (ctx, jobid);
+}
+
+/* Rebuild the allocations recorded in the job log and start a new log
+ * with a checkpoint of them. Reservations are not replayed as qmanager
+ * recomputes them on every scheduling loop. Jobs that fail to replay are
+ * left to R-based reconstruction through update requests. A log that
+ * can't be opened or checkpointed is not fatal either: the module runs
+ * without a job log.
+ */
+static int replay_job_log (std::shared_ptr<resource_ctx_t> &ctx)
+{
+    int rc = 0;
+    size_t n = 0;
+    std::map<uint64_t, job_log_entry_t> live;
+    job_log_t &joblog = ctx->joblog;
+    const std::string &path = ctx->args.joblog_file;
+
+    if (path == "")
+        return 0;
+    if (joblog.replay (path, live) < 0) {
+        flux_log_error (ctx->h, "%s: replay (%s): %s", __FUNCTION__,
+                        path.c_str (), joblog.err_message ().c_str ());
+        joblog.clear_err_message ();
+        live.clear ();
+    }
+    for (auto &kv : live) {
+        int64_t at = 0;
+        double ov = 0.0f;
+        std::stringstream o;
+        int64_t jobid = static_cast<int64_t> (kv.first);
+
+        if (kv.second.state != job_lifecycle_t::ALLOCATED)
+            continue;
+        n++;
+        if (run_update (ctx, jobid, kv.second.R.c_str (), at, ov, o) < 0) {
+            flux_log (ctx->h, LOG_DEBUG, "%s: can't replay (id=%jd)",
+                      __FUNCTION__, static_cast<intmax_t> (jobid));
+            continue;
+        }
+        ctx->replayed.insert (kv.first);
+    }
+    joblog.set_checkpoint_interval (ctx->args.joblog_checkpoint);
+    if (joblog.open (path) < 0 || joblog.checkpoint (ctx->jobs) < 0) {
+        flux_log_error (ctx->h, "%s: job log disabled: %s", __FUNCTION__,
+                        joblog.err_message ().c_str ());
+        joblog.clear_err_message ();
+        joblog.close ();
+        goto done;
+    }
+    flux_log (ctx->h, LOG_INFO, "%s: replayed %zu of %zu job(s) from %s",
+              __FUNCTION__, ctx->replayed.size (), n, path.c_str ());
+done:
+    return rc;
+}
+
+static int update_allocation (std::shared_ptr<resource_ctx_t> &ctx,
+                              int64_t jobid, const char *R, int64_t &at,
+                              double &ov, std::string &status,
+                              std::stringstream &o)
+{
+    int rc = -1;
+    std::string stored_R;
+    const job_entry_t *e = nullptr;
+
+    if ( (rc = confirm_replayed_job (ctx, jobid, R)) < 0) {
+        flux_log_error (ctx->h, "%s: confirm_replayed_job (id=%jd)",
+                        __FUNCTION__, static_cast<intmax_t> (jobid));
+        goto done;
+    }
+    if ( (e = ctx->jobs.find (jobid))) {
         struct timeval st, et;
         if ( (rc = gettimeofday (&st, NULL)) < 0) {
             flux_log_error (ctx->h, "%s: gettimeofday", __FUNCTION__);
-            goto error;
+            goto done;
         }
-        if ( (rc = Rlite_equal (ctx, R, ctx->jobs[jobid]->R.c_str ())) < 0) {
+        if ( (rc = Rlite_equal (ctx, R, e)) < 0) {
             flux_log_error (ctx->h, "%s: Rlite_equal", __FUNCTION__);
-            goto error;
+            goto done;
         } else if (rc == 1) {
-            errno=EINVAL;
+            rc = -1;
+            errno = EINVAL;
             flux_log (ctx->h, LOG_ERR,
                       "%s: jobid (%jd) with different R exists!",
                       __FUNCTION__, static_cast<intmax_t> (jobid));
-            goto error;
+            goto done;
         }
         if ( (rc = gettimeofday (&et, NULL)) < 0) {
             flux_log_error (ctx->h, "%s: gettimeofday", __FUNCTION__);
-            goto error;
+            goto done;
         }
         // If a jobid with matching R exists, no need to update
         ov = get_elapse_time (st, et);
-        get_jobstate_str (ctx->jobs[jobid]->state, status);
-        o << ctx->jobs[jobid]->R;
-        at = ctx->jobs[jobid]->scheduled_at;
+        get_jobstate_str (e->state, status);
+        at = e->scheduled_at;
+        // Without a job log, the requester's R is equal in R_lite
+        if (get_logged_R (ctx, jobid, stored_R) == 0)
+            o << stored_R;
+        else
+            o << R;
         flux_log (ctx->h, LOG_DEBUG, "%s: jobid (%jd) with matching R exists",
                   __FUNCTION__, static_cast<intmax_t> (jobid));
-    } else if (run_update (ctx, jobid, R, at, ov, o) < 0) {
-        flux_log_error (ctx->h,
-                        "%s: update failed (id=%jd)",
-                        __FUNCTION__, static_cast<intmax_t> (jobid));
-        goto error;
+    } else if ( (rc = run_update (ctx, jobid, R, at, ov, o)) < 0) {
+        // Unconfirmed replayed jobs may hold on to the resources
+        // of this job when the job log is stale: release them and retry.
+        if (ctx->replayed.empty () || reap_replayed_jobs (ctx) < 0) {
+            flux_log_error (ctx->h,
+                            "%s: update failed (id=%jd)",
+                            __FUNCTION__, static_cast<intmax_t> (jobid));
+            goto done;
+        }
+        o.str ("");
+        if ( (rc = run_update (ctx, jobid, R, at, ov, o)) < 0) {
+            flux_log_error (ctx->h,
+                            "%s: update failed (id=%jd)",
+                            __FUNCTION__, static_cast<intmax_t> (jobid));
+            goto done;
+        }
     }
-
-    if ( status == "")
+    if (status == "")
         status = get_status_string (at, at);
+    rc = 0;
+
+done:
+    return rc;
+}
+
+static void update_request_cb (flux_t *h, flux_msg_handler_t *w,
+                               const flux_msg_t *msg, void *arg)
+{
+    char *R = NULL;
+    int64_t at = 0;
+    double ov = 0.0f;
+    int64_t jobid = 0;
+    std::string status = "";
+    std::stringstream o;
+
+    std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
+    if (flux_request_unpack (msg, NULL, "{s:I s:s}",
+                                            "jobid", &jobid,
+                                            "R", &R) < 0) {
+        flux_log_error (ctx->h, "%s: flux_request_unpack", __FUNCTION__);
+        goto error;
+    }
+    if (update_allocation (ctx, jobid, R, at, ov, status, o) < 0)
+        goto error;
 
     if (flux_respond_pack (h, msg, "{s:I s:s s:f s:s s:I}",
                                        "jobid", jobid,
@@ -1745,31 +2153,71 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
-static int run_remove (std::shared_ptr<resource_ctx_t> &ctx, int64_t jobid)
+static void update_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
+                                     const flux_msg_t *msg, void *arg)
 {
-    int rc = -1;
-    dfu_traverser_t &tr = *(ctx->traverser);
+    size_t index;
+    json_t *value;
+    json_error_t err;
+    int saved_errno;
+    json_t *jobs = nullptr;
+    int64_t jobid = 0;
+    std::string errmsg;
+    const char *jobs_str = nullptr;
+    std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
 
-    if ((rc = tr.remove (jobid)) < 0) {
-        if (is_existent_jobid (ctx, jobid)) {
-           // When this condition arises, we will be less likely
-           // to be able to reuse this jobid. Having the errored job
-           // in the jobs map will prevent us from reusing the jobid
-           // up front.  Note that a same jobid can be reserved and
-           // removed multiple times by the upper queuing layer
-           // as part of providing advanced queueing policies
-           // (e.g., conservative backfill).
-           std::shared_ptr<job_info_t> info = ctx->jobs[jobid];
-           info->state = job_lifecycle_t::ERROR;
-        }
-        goto out;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (flux_request_unpack (msg, NULL, "{s:s}", "jobs", &jobs_str) < 0)
+        goto error;
+    if ( !(jobs = json_loads (jobs_str, 0, &err))) {
+        errno = ENOMEM;
+        goto error;
     }
-    if (is_existent_jobid (ctx, jobid))
-        ctx->jobs.erase (jobid);
 
-    rc = 0;
-out:
-    return rc;
+    // One response per (jobid, R) pair is streamed back as soon as
+    // the pair is applied so that the requester can pipeline
+    // the processing of the results with the update of the rest.
+    json_array_foreach(jobs, index, value) {
+        const char *R;
+        int64_t at = 0;
+        double ov = 0.0f;
+        std::string status = "";
+        std::stringstream o;
+
+        if (json_unpack (value, "{s:I s:s}",
+                                  "jobid", &jobid,
+                                  "R", &R) < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (update_allocation (ctx, jobid, R, at, ov, status, o) < 0)
+            goto error;
+        if (flux_respond_pack (h, msg, "{s:I s:s s:f s:s s:I}",
+                                         "jobid", jobid,
+                                         "status", status.c_str (),
+                                         "overhead", ov,
+                                         "R", o.str ().c_str (),
+                                         "at", at) < 0) {
+            flux_log_error (h, "%s", __FUNCTION__);
+            goto error;
+        }
+    }
+    errno = ENODATA;
+    jobid = 0;
+error:
+    if (jobs) {
+        saved_errno = errno;
+        json_decref (jobs);
+        errno = saved_errno;
+    }
+    if (jobid != 0)
+        errmsg += "jobid=" + std::to_string (jobid);
+    if (flux_respond_error (h, msg, errno,
+                            !errmsg.empty ()? errmsg.c_str () : nullptr) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
 static void match_request_cb (flux_t *h, flux_msg_handler_t *w,
@@ -1788,6 +2236,8 @@ static void match_request_cb (flux_t *h, flux_msg_handler_t *w,
     if (flux_request_unpack (msg, NULL, "{s:s s:I s:s}", "cmd", &cmd,
                              "jobid", &jobid, "jobspec", &js_str) < 0)
         goto error;
+    if (!ctx->replayed.empty ())
+        reap_replayed_jobs (ctx);
     if (is_existent_jobid (ctx, jobid)) {
         errno = EINVAL;
         flux_log_error (h, "%s: existent job (%jd).",
@@ -1827,6 +2277,8 @@ static void match_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
     int saved_errno;
     json_t *jobs = nullptr;
     uint64_t jobid = 0;
+    int rdepth = -1;
+    int nreserved = 0;
     std::string errmsg;
     const char *cmd = nullptr;
     const char *jobs_str = nullptr;
@@ -1836,17 +2288,26 @@ static void match_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
         errno = EPROTO;
         goto error;
     }
-    if (flux_request_unpack (msg, NULL, "{s:s s:s}",
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s?i}",
                                           "cmd", &cmd,
-                                          "jobs", &jobs_str) < 0)
+                                          "jobs", &jobs_str,
+                                          "reservation_depth", &rdepth) < 0)
         goto error;
     if ( !(jobs = json_loads (jobs_str, 0, &err))) {
         errno = ENOMEM;
         goto error;
     }
+    if (!ctx->replayed.empty ())
+        reap_replayed_jobs (ctx);
 
+    // Without reservation_depth, the first failed match terminates
+    // the stream (FCFS). With it, the jobs form a backfill window:
+    // up to reservation_depth jobs may be reserved, only allocation
+    // is tried for the rest, and a failed match is reported for that
+    // job without ending the stream.
     json_array_foreach(jobs, index, value) {
         const char *js_str;
+        const char *job_cmd = cmd;
         int64_t at = 0;
         int64_t now = 0;
         double ov = 0.0f;
@@ -1857,27 +2318,38 @@ static void match_multi_request_cb (flux_t *h, flux_msg_handler_t *w,
                                   "jobid", &jobid,
                                   "jobspec", &js_str) < 0)
             goto error;
+        if (rdepth >= 0 && nreserved >= rdepth)
+            job_cmd = "allocate_with_satisfiability";
         if (is_existent_jobid (ctx, jobid)) {
             errno = EINVAL;
             flux_log_error (h, "%s: existent job (%jd).",
                             __FUNCTION__, static_cast<intmax_t> (jobid));
-            goto error;
+        } else if (run_match (ctx, jobid, job_cmd,
+                              js_str, &now, &at, &ov, R) == 0) {
+            status = get_status_string (now, at);
+            if (status == "RESERVED")
+                nreserved++;
+            if (flux_respond_pack (h, msg, "{s:I s:s s:f s:s s:I}",
+                                             "jobid", jobid,
+                                             "status", status.c_str (),
+                                             "overhead", ov,
+                                             "R", R.str ().c_str (),
+                                             "at", at) < 0) {
+                flux_log_error (h, "%s", __FUNCTION__);
+                goto error;
+            }
+            continue;
+        } else if (errno != EBUSY && errno != ENODEV) {
+            flux_log_error (ctx->h,
+                    "%s: match failed due to match error (id=%jd)",
+                    __FUNCTION__, static_cast<intmax_t> (jobid));
         }
-        if (run_match (ctx, jobid, cmd, js_str, &now, &at, &ov, R) < 0) {
-            if (errno != EBUSY && errno != ENODEV)
-                flux_log_error (ctx->h,
-                        "%s: match failed due to match error (id=%jd)",
-                        __FUNCTION__, static_cast<intmax_t> (jobid));
+        if (rdepth < 0)
             goto error;
-        }
-
-        status = get_status_string (now, at);
-        if (flux_respond_pack (h, msg, "{s:I s:s s:f s:s s:I}",
+        if (flux_respond_pack (h, msg, "{s:I s:s s:i}",
                                          "jobid", jobid,
-                                         "status", status.c_str (),
-                                         "overhead", ov,
-                                         "R", R.str ().c_str (),
-                                         "at", at) < 0) {
+                                         "status", "FAILED",
+                                         "errnum", errno) < 0) {
             flux_log_error (h, "%s", __FUNCTION__);
             goto error;
         }
@@ -1936,19 +2408,20 @@ static void info_request_cb (flux_t *h, flux_msg_handler_t *w,
 {
     std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
     int64_t jobid = -1;
-    std::shared_ptr<job_info_t> info = NULL;
+    const job_entry_t *info = NULL;
     std::string status = "";
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "jobid", &jobid) < 0)
         goto error;
-    if (!is_existent_jobid (ctx, jobid)) {
+    if (!is_existent_jobid (ctx, jobid)
+        || ctx->replayed.find (jobid) != ctx->replayed.end ()) {
         errno = ENOENT;
         flux_log (h, LOG_DEBUG, "%s: nonexistent job (id=%jd)",
                   __FUNCTION__,  (intmax_t)jobid);
         goto error;
     }
 
-    info = ctx->jobs[jobid];
+    info = ctx->jobs.find (jobid);
     get_jobstate_str (info->state, status);
     if (flux_respond_pack (h, msg, "{s:I s:s s:I s:f}",
                                    "jobid", jobid,
@@ -2012,15 +2485,87 @@ done:
     return rc;
 }
 
+/* Summarize a histogram; scale converts recorded samples to output units.
+ */
+static json_t *hist_to_json (const log_linear_hist_t &hist, double scale)
+{
+    json_t *o = nullptr;
+    if ( !(o = json_pack ("{s:I s:f s:f s:f s:f s:f s:f}",
+                          "count", static_cast<json_int_t> (hist.count ()),
+                          "min", hist.min () * scale,
+                          "max", hist.max () * scale,
+                          "mean", hist.mean () * scale,
+                          "p50", hist.percentile (0.50) * scale,
+                          "p99", hist.percentile (0.99) * scale,
+                          "p999", hist.percentile (0.999) * scale)))
+        errno = ENOMEM;
+    return o;
+}
+
+static json_t *op_perf_to_json (const match_op_perf_t &perf)
+{
+    json_t *o = nullptr;
+    json_t *phases = nullptr;
+
+    if ( !(phases = json_object ()))
+        goto nomem;
+    for (int i = 0; i < static_cast<int> (match_phase_t::COUNT); i++) {
+        const char *name = match_phase_name (static_cast<match_phase_t> (i));
+        if (json_object_set_new (phases, name,
+                                 hist_to_json (perf.phases[i], 1e-9)) < 0)
+            goto nomem;
+    }
+    // json_pack steals the reference to phases even on failure
+    if ( !(o = json_pack ("{s:o s:o s:o}",
+                          "phases", phases,
+                          "preorder", hist_to_json (perf.preorder, 1.0f),
+                          "postorder", hist_to_json (perf.postorder, 1.0f))))
+        errno = ENOMEM;
+    return o;
+
+nomem:
+    json_decref (phases);
+    errno = ENOMEM;
+    return nullptr;
+}
+
+static json_t *get_match_perf (std::shared_ptr<resource_ctx_t> &ctx)
+{
+    json_t *o = nullptr;
+    json_t *op = nullptr;
+
+    if ( !(o = json_object ()))
+        goto nomem;
+    for (auto &kv : ctx->perf.ops) {
+        if ( !(op = op_perf_to_json (kv.second))
+            || json_object_set_new (o, kv.first.c_str (), op) < 0)
+            goto nomem;
+    }
+    return o;
+
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return nullptr;
+}
+
 static void stat_request_cb (flux_t *h, flux_msg_handler_t *w,
                              const flux_msg_t *msg, void *arg)
 {
     std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
     int saved_errno;
+    int reset = 0;
+    const char *payload = nullptr;
     json_t *o = nullptr;
+    json_t *match = nullptr;
     double avg = 0.0f;
     double min = 0.0f;
 
+    if (flux_request_decode (msg, NULL, &payload) < 0)
+        goto error;
+    if (payload && flux_request_unpack (msg, NULL, "{s?:b}",
+                                        "reset", &reset) < 0)
+        goto error;
     if (ctx->perf.njobs) {
         avg = ctx->perf.accum / (double)ctx->perf.njobs;
         min = ctx->perf.min;
@@ -2033,7 +2578,11 @@ static void stat_request_cb (flux_t *h, flux_msg_handler_t *w,
         flux_log_error (h, "%s: get_stat_by_rank", __FUNCTION__);
         goto error_free;
     }
-    if (flux_respond_pack (h, msg, "{s:I s:I s:o s:f s:I s:f s:f s:f}",
+    if ( !(match = get_match_perf (ctx))) {
+        flux_log_error (h, "%s: get_match_perf", __FUNCTION__);
+        goto error_free;
+    }
+    if (flux_respond_pack (h, msg, "{s:I s:I s:o s:f s:I s:f s:f s:f s:o}",
                                    "V", num_vertices (ctx->db->resource_graph),
                                    "E", num_edges (ctx->db->resource_graph),
                                    "by_rank", o,
@@ -2041,9 +2590,12 @@ static void stat_request_cb (flux_t *h, flux_msg_handler_t *w,
                                    "njobs", ctx->perf.njobs,
                                    "min-match", min,
                                    "max-match", ctx->perf.max,
-                                   "avg-match", avg) < 0) {
+                                   "avg-match", avg,
+                                   "match", match) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     }
+    if (reset)
+        reset_match_perf (ctx);
 
     return;
 
@@ -2056,14 +2608,13 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
-static inline int64_t next_jobid (const std::map<uint64_t,
-                                            std::shared_ptr<job_info_t>> &m)
+static inline int64_t next_jobid (const job_table_t &m)
 {
     int64_t jobid = -1;
-    if (m.empty ())
+    if (m.size () == 0)
         jobid = 0;
-    else if (m.rbegin ()->first < INT64_MAX)
-        jobid = m.rbegin ()->first + 1;
+    else if (m.max_jobid () < INT64_MAX)
+        jobid = m.max_jobid () + 1;
     return jobid;
 }
 
@@ -2096,8 +2647,7 @@ static void set_property_request_cb (flux_t *h, flux_msg_handler_t *w,
     std::string property_key = "", property_value = "";
     size_t pos;
     std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
-    std::map<std::string, vtx_t>::const_iterator it;
-    std::pair<std::map<std::string, std::string>::iterator, bool> ret;
+    std::pair<shared_map_t::const_iterator, bool> ret;
     vtx_t v;
 
     if (flux_request_unpack (msg, NULL, "{s:s s:s}",
@@ -2121,17 +2671,15 @@ static void set_property_request_cb (flux_t *h, flux_msg_handler_t *w,
     property_key = keyval.substr (0, pos);
     property_value = keyval.substr (pos + 1);
 
-    it = ctx->db->metadata.by_path.find (resource_path);
+    v = ctx->db->metadata.by_path.find (resource_path);
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         errno = ENOENT;
         flux_log_error (h, "%s: Couldn't find %s in resource graph.",
                         __FUNCTION__, resource_path.c_str ());
         goto error;
      }
 
-    v = it->second;
-
     ret = ctx->db->resource_graph[v].properties.insert (
         std::pair<std::string, std::string> (property_key,property_value));
 
@@ -2140,6 +2688,7 @@ static void set_property_request_cb (flux_t *h, flux_msg_handler_t *w,
         ctx->db->resource_graph[v].properties.insert (
             std::pair<std::string, std::string> (property_key,property_value));
     }
+    ctx->db->metadata.generation++;
 
     if (flux_respond_pack (h, msg, "{}") < 0)
         flux_log_error (h, "%s", __FUNCTION__);
@@ -2157,7 +2706,6 @@ static void get_property_request_cb (flux_t *h, flux_msg_handler_t *w,
     const char *rp = NULL, *gp_key = NULL;
     std::string resource_path = "", property_key = "";
     std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
-    std::map<std::string, vtx_t>::const_iterator it;
     std::map<std::string, std::string>::const_iterator p_it;
     vtx_t v;
     std::string resp_value = "";
@@ -2170,17 +2718,15 @@ static void get_property_request_cb (flux_t *h, flux_msg_handler_t *w,
     resource_path = rp;
     property_key = gp_key;
 
-    it = ctx->db->metadata.by_path.find (resource_path);
+    v = ctx->db->metadata.by_path.find (resource_path);
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         errno = ENOENT;
         flux_log_error (h, "%s: Couldn't find %s in resource graph.",
                         __FUNCTION__, resource_path.c_str ());
         goto error;
      }
 
-    v = it->second;
-
     for (p_it = ctx->db->resource_graph[v].properties.begin ();
          p_it != ctx->db->resource_graph[v].properties.end (); p_it++) {
 
@@ -2377,6 +2923,66 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Turn tracing of slow matches on or off. Respond with the state of
+ * the tracer so that the request without payload can be used to query it.
+ */
+static void trace_request_cb (flux_t *h, flux_msg_handler_t *w,
+                              const flux_msg_t *msg, void *arg)
+{
+    std::shared_ptr<resource_ctx_t> ctx = getctx ((flux_t *)arg);
+    int enable = -1;
+    int sample = 1;
+    double threshold = 0.0f;
+    const char *file = nullptr;
+    const char *payload = nullptr;
+    std::shared_ptr<dfu_trace_t> t = nullptr;
+
+    if (flux_request_decode (msg, NULL, &payload) < 0)
+        goto error;
+    if (payload && flux_request_unpack (msg, NULL, "{s?:b s?:s s?:F s?:i}",
+                                        "enable", &enable,
+                                        "file", &file,
+                                        "threshold", &threshold,
+                                        "sample", &sample) < 0)
+        goto error;
+    if (enable == 0) {
+        ctx->traverser->disable_trace ();
+    } else if (enable == 1) {
+        if (!file || threshold < 0.0f || sample < 1) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (ctx->traverser->enable_trace (file,
+                                          static_cast<uint64_t> (threshold
+                                                                 * 1e9),
+                                          static_cast<unsigned int> (sample))
+                                          < 0) {
+            flux_log_error (h, "%s: enable_trace (%s)", __FUNCTION__, file);
+            goto error;
+        }
+        flux_log (h, LOG_INFO, "%s: tracing matches slower than %fs into %s",
+                  __FUNCTION__, threshold, file);
+    }
+
+    if ( (t = ctx->traverser->get_trace ())) {
+        if (flux_respond_pack (h, msg, "{s:b s:s s:f s:i s:I s:I}",
+                               "enabled", 1,
+                               "file", t->get_path ().c_str (),
+                               "threshold", t->get_threshold () / 1e9,
+                               "sample", t->get_sample (),
+                               "kept", t->get_kept (),
+                               "dropped", t->get_dropped ()) < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    } else if (flux_respond_pack (h, msg, "{s:b}", "enabled", 0) < 0) {
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    }
+    return;
+
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static void ns_info_request_cb (flux_t *h, flux_msg_handler_t *w,
                                 const flux_msg_t *msg, void *arg)
 {
@@ -2454,6 +3060,10 @@ extern "C" int mod_main (flux_t *h, int argc, char **argv)
         }
         flux_log (h, LOG_DEBUG, "%s: resource graph database loaded",
                   __FUNCTION__);
+        if ( (rc = replay_job_log (ctx)) != 0) {
+            flux_log (h, LOG_ERR, "%s: can't replay job log", __FUNCTION__);
+            goto done;
+        }
 
         if (( rc = flux_reactor_run (flux_get_reactor (h), 0)) < 0) {
             flux_log (h, LOG_ERR, "%s: flux_reactor_run: %s",
@@ -25,6 +25,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 #include <string.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -75,7 +77,13 @@ struct span {
     scheduled_point_t *last_p;   /* scheduled point object at last */
 };
 
-/*! Planner context
+/*! Planner context. The scheduled point trees, the span tables and the
+ *  iteration request are only allocated once the planner is first asked to
+ *  hold a span or to iterate over available times (see materialize). Until
+ *  then p0 and unit are NULL and the planner is fully available throughout
+ *  its time window, so availability queries are answered from
+ *  total_resources alone. Most vertices of a large graph never get a span
+ *  and stay that way.
  */
 struct planner {
     int64_t total_resources;
@@ -90,6 +98,7 @@ struct planner {
     request_t *current_request;  /* the req copy for avail time iteration */
     int avail_time_iter_set;     /* iterator set flag */
     uint64_t span_counter;       /* current span counter */
+    struct unit_timeline *unit;  /* used instead of the above for a total of 1 */
 };
 
 
@@ -364,6 +373,253 @@ static scheduled_point_t *mintime_resource_mintime (int64_t request,
 }
 
 
+static int span_input_check (planner_t *ctx, int64_t start_time,
+                             uint64_t duration, int64_t request);
+
+/*******************************************************************************
+ *                                                                             *
+ *        Unit-Capacity Timeline: Sorted Arrays for Single-Unit Resources      *
+ *                                                                             *
+ *******************************************************************************/
+
+/*! A planner with a single unit of resource (e.g., a core or a gpu) can never
+ *  have overlapping non-empty spans, so it only ever holds a handful of
+ *  scheduled points. It keeps them in a sorted array searched by bisection
+ *  rather than in the scheduled point and min-time resource trees, and keeps
+ *  its spans in an array sorted by span id instead of a hash table. Queries
+ *  follow the semantics of the tree-based planner: planner_avail_time_next
+ *  visits the scheduled points that can hold the request in time order.
+ */
+typedef struct unit_point {
+    int64_t at;                  /* Resource-state changing time */
+    int64_t scheduled;           /* scheduled quantity at this point */
+    int ref_count;               /* reference counter */
+} unit_point_t;
+
+typedef struct unit_span {
+    int64_t start;               /* start time of the span */
+    int64_t last;                /* end time of the span */
+    int64_t span_id;             /* unique span id */
+    int64_t planned;             /* required resource quantity */
+} unit_span_t;
+
+struct unit_timeline {
+    unit_point_t *points;        /* scheduled points sorted by time */
+    size_t npoints;
+    size_t points_cap;
+    unit_span_t *spans;          /* spans sorted by span id */
+    size_t nspans;
+    size_t spans_cap;
+    size_t span_cursor;          /* cursor for span_first/span_next */
+    size_t iter_cursor;          /* next point avail_time_next considers */
+};
+
+static void *grow_array (void *array, size_t *cap, size_t elem_size)
+{
+    size_t ncap = (*cap)? *cap * 2 : 4;
+    void *n = realloc (array, ncap * elem_size);
+    if (!n) {
+        fprintf (stderr, "Out of memory\n");
+        exit (1);
+    }
+    *cap = ncap;
+    return n;
+}
+
+static struct unit_timeline *unit_new (int64_t base_time)
+{
+    struct unit_timeline *tl = xzmalloc (sizeof (*tl));
+    tl->points = grow_array (NULL, &(tl->points_cap), sizeof (*(tl->points)));
+    tl->points[0].at = base_time;
+    tl->points[0].scheduled = 0;
+    tl->points[0].ref_count = 1;
+    tl->npoints = 1;
+    tl->span_cursor = SIZE_MAX;
+    return tl;
+}
+
+static void unit_destroy (struct unit_timeline **tl_p)
+{
+    if (tl_p && *tl_p) {
+        free ((*tl_p)->points);
+        free ((*tl_p)->spans);
+        free (*tl_p);
+        *tl_p = NULL;
+    }
+}
+
+/*! Index of the first point at or after time at.
+ */
+static size_t unit_lower_bound (struct unit_timeline *tl, int64_t at)
+{
+    size_t lo = 0, hi = tl->npoints;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (tl->points[mid].at < at)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*! Index of the most recent point at or before time at, representing
+ *  the resource state at that time; -1 if at precedes every point.
+ */
+static ssize_t unit_state (struct unit_timeline *tl, int64_t at)
+{
+    size_t i = unit_lower_bound (tl, at);
+    if (i < tl->npoints && tl->points[i].at == at)
+        return (ssize_t)i;
+    return (ssize_t)i - 1;
+}
+
+static size_t unit_get_or_new_point (struct unit_timeline *tl, int64_t at)
+{
+    size_t i = unit_lower_bound (tl, at);
+    if (i < tl->npoints && tl->points[i].at == at)
+        return i;
+    if (tl->npoints == tl->points_cap)
+        tl->points = grow_array (tl->points, &(tl->points_cap),
+                                 sizeof (*(tl->points)));
+    memmove (&(tl->points[i + 1]), &(tl->points[i]),
+             (tl->npoints - i) * sizeof (*(tl->points)));
+    tl->npoints++;
+    tl->points[i].at = at;
+    tl->points[i].scheduled = (i > 0)? tl->points[i - 1].scheduled : 0;
+    tl->points[i].ref_count = 0;
+    return i;
+}
+
+static void unit_unref_point (struct unit_timeline *tl, int64_t at)
+{
+    size_t i = unit_lower_bound (tl, at);
+    if (i == tl->npoints || tl->points[i].at != at)
+        return;
+    if (--(tl->points[i].ref_count) == 0) {
+        memmove (&(tl->points[i]), &(tl->points[i + 1]),
+                 (tl->npoints - i - 1) * sizeof (*(tl->points)));
+        tl->npoints--;
+    }
+}
+
+static unit_span_t *unit_span_lookup (struct unit_timeline *tl,
+                                      int64_t span_id)
+{
+    size_t lo = 0, hi = tl->nspans;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (tl->spans[mid].span_id < span_id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < tl->nspans && tl->spans[lo].span_id == span_id)
+        return &(tl->spans[lo]);
+    return NULL;
+}
+
+static bool unit_avail_from (planner_t *ctx, size_t i, int64_t at,
+                             uint64_t duration, int64_t request)
+{
+    struct unit_timeline *tl = ctx->unit;
+    for (; i < tl->npoints; i++) {
+        if (tl->points[i].at >= (at + (int64_t)duration))
+            break;
+        if (request > ctx->total_resources - tl->points[i].scheduled)
+            return false;
+    }
+    return true;
+}
+
+static int64_t unit_avail_at (planner_t *ctx, int64_t on_or_after,
+                              uint64_t duration, int64_t request)
+{
+    struct unit_timeline *tl = ctx->unit;
+    while (tl->iter_cursor < tl->npoints) {
+        unit_point_t *point = &(tl->points[tl->iter_cursor++]);
+        if (request > ctx->total_resources - point->scheduled
+            || point->at < on_or_after)
+            continue;
+        if (unit_avail_from (ctx, tl->iter_cursor - 1,
+                             point->at, duration, request))
+            return ((point->at + duration) > ctx->plan_end)? -1 : point->at;
+    }
+    return -1;
+}
+
+static int64_t unit_avail_resources_during (planner_t *ctx, int64_t at,
+                                            uint64_t duration)
+{
+    struct unit_timeline *tl = ctx->unit;
+    ssize_t s = unit_state (tl, at);
+    size_t i = (s < 0)? 0 : (size_t)s;
+    int64_t max_scheduled = tl->points[i].scheduled;
+    for (; i < tl->npoints; i++) {
+        if (tl->points[i].at >= (at + (int64_t)duration))
+            break;
+        if (tl->points[i].scheduled > max_scheduled)
+            max_scheduled = tl->points[i].scheduled;
+    }
+    return ctx->total_resources - max_scheduled;
+}
+
+static int64_t unit_add_span (planner_t *ctx, int64_t start_time,
+                              uint64_t duration, uint64_t request)
+{
+    size_t i;
+    unit_span_t *span = NULL;
+    struct unit_timeline *tl = ctx->unit;
+
+    if (span_input_check (ctx, start_time, duration, (int64_t)request) == -1)
+        return -1;
+    if (tl->nspans == tl->spans_cap)
+        tl->spans = grow_array (tl->spans, &(tl->spans_cap),
+                                sizeof (*(tl->spans)));
+    // span ids only grow, so appending keeps spans sorted by id
+    span = &(tl->spans[tl->nspans++]);
+    span->start = start_time;
+    span->last = start_time + duration;
+    ctx->span_counter++;
+    span->span_id = ctx->span_counter;
+    span->planned = request;
+
+    i = unit_get_or_new_point (tl, span->start);
+    tl->points[i].ref_count++;
+    i = unit_get_or_new_point (tl, span->last);
+    tl->points[i].ref_count++;
+    for (i = unit_lower_bound (tl, span->start);
+         i < tl->npoints && tl->points[i].at < span->last; i++)
+        tl->points[i].scheduled += span->planned;
+
+    ctx->avail_time_iter_set = 0;
+    return span->span_id;
+}
+
+static int unit_rem_span (planner_t *ctx, int64_t span_id)
+{
+    size_t i;
+    unit_span_t *span = NULL;
+    struct unit_timeline *tl = ctx->unit;
+
+    if ( !(span = unit_span_lookup (tl, span_id))) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = unit_lower_bound (tl, span->start);
+         i < tl->npoints && tl->points[i].at < span->last; i++)
+        tl->points[i].scheduled -= span->planned;
+    unit_unref_point (tl, span->start);
+    unit_unref_point (tl, span->last);
+
+    i = span - tl->spans;
+    memmove (&(tl->spans[i]), &(tl->spans[i + 1]),
+             (tl->nspans - i - 1) * sizeof (*(tl->spans)));
+    tl->nspans--;
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
 /*******************************************************************************
  *                                                                             *
  *                  Scheduled Point and Resource Update APIs                   *
@@ -382,8 +638,11 @@ static void restore_track_points (planner_t *ctx)
 {
     scheduled_point_t *point = NULL;
     struct rb_root *root = &(ctx->mt_resource_tree);
-    zlistx_t *keys = zhashx_keys (ctx->avail_time_iter);
+    zlistx_t *keys = NULL;
     const char *k = NULL;
+    if (!ctx->avail_time_iter || zhashx_size (ctx->avail_time_iter) == 0)
+        return;
+    keys = zhashx_keys (ctx->avail_time_iter);
     for (k = zlistx_first (keys); k; k = zlistx_next (keys)) {
         point = zhashx_lookup (ctx->avail_time_iter, k);
         mintime_resource_insert (point, root);
@@ -536,6 +795,13 @@ static bool avail_during (planner_t *ctx, int64_t at, uint64_t duration,
         return -1;
     }
 
+    if (ctx->unit) {
+        ssize_t i = unit_state (ctx->unit, at);
+        return (i < 0) || unit_avail_from (ctx, i, at, duration, request);
+    } else if (!ctx->p0) {
+        return request <= ctx->total_resources;
+    }
+
     spr = &(ctx->sched_point_tree);
     scheduled_point_t *point = scheduled_point_state (at, spr);
     while (point) {
@@ -552,15 +818,19 @@ static bool avail_during (planner_t *ctx, int64_t at, uint64_t duration,
     return ok;
 }
 
-static scheduled_point_t *avail_resources_during (planner_t *ctx, int64_t at,
-                                                  uint64_t duration)
+static int64_t avail_resources_during (planner_t *ctx, int64_t at,
+                                       uint64_t duration)
 {
     struct rb_root *spr = NULL;
 
     if ((at + duration) > ctx->plan_end) {
         errno = ERANGE;
-        return NULL;
+        return -1;
     }
+    if (ctx->unit)
+        return unit_avail_resources_during (ctx, at, duration);
+    else if (!ctx->p0)
+        return ctx->total_resources;
 
     spr = &(ctx->sched_point_tree);
     scheduled_point_t *point = scheduled_point_state (at, spr);
@@ -574,7 +844,7 @@ static scheduled_point_t *avail_resources_during (planner_t *ctx, int64_t at,
         struct rb_node *n = rb_next (&(point->point_rb));
         point = rb_entry (n, scheduled_point_t, point_rb);
     }
-    return min;
+    return min->remaining;
 }
 
 
@@ -590,8 +860,29 @@ static void initialize (planner_t *ctx, int64_t base_time, uint64_t duration)
     ctx->plan_end = base_time + (int64_t)duration;
     ctx->sched_point_tree = RB_ROOT;
     ctx->mt_resource_tree = RB_ROOT;
+    ctx->p0 = NULL;
+    ctx->span_lookup = NULL;
+    ctx->avail_time_iter = NULL;
+    ctx->current_request = NULL;
+    ctx->avail_time_iter_set = 0;
+    ctx->span_counter = 0;
+    ctx->unit = NULL;
+}
+
+/*! Allocate the scheduled point at base time along with the tables
+ *  needed to hold spans and iterate over available times.
+ */
+static void materialize (planner_t *ctx)
+{
+    if (ctx->p0 || ctx->unit)
+        return;
+    if (ctx->total_resources == 1) {
+        ctx->unit = unit_new (ctx->plan_start);
+        ctx->current_request = xzmalloc (sizeof (*(ctx->current_request)));
+        return;
+    }
     ctx->p0 = xzmalloc (sizeof (*(ctx->p0)));
-    ctx->p0->at = base_time;
+    ctx->p0->at = ctx->plan_start;
     ctx->p0->ref_count = 1;
     ctx->p0->remaining = ctx->total_resources;
     scheduled_point_insert (ctx->p0, &(ctx->sched_point_tree));
@@ -599,8 +890,53 @@ static void initialize (planner_t *ctx, int64_t base_time, uint64_t duration)
     ctx->span_lookup = zhashx_new ();
     ctx->avail_time_iter = zhashx_new ();
     ctx->current_request = xzmalloc (sizeof (*(ctx->current_request)));
-    ctx->avail_time_iter_set = 0;
-    ctx->span_counter = 0;
+}
+
+/*! Move the scheduled points and spans of a unit timeline into the
+ *  scheduled point and min-time resource trees, keeping span ids, so
+ *  that the planner can manage a total other than 1.
+ */
+static void unit_to_tree (planner_t *ctx)
+{
+    size_t i;
+    char key[32];
+    struct unit_timeline *tl = ctx->unit;
+    struct rb_root *spt = &(ctx->sched_point_tree);
+    struct rb_root *mtrt = &(ctx->mt_resource_tree);
+
+    ctx->unit = NULL;
+    free (ctx->current_request);
+    ctx->current_request = NULL;
+    materialize (ctx);
+
+    // The first unit point is always at base time, i.e., p0
+    mintime_resource_remove (ctx->p0, mtrt);
+    for (i = 0; i < tl->npoints; i++) {
+        scheduled_point_t *point = ctx->p0;
+        if (i > 0) {
+            point = xzmalloc (sizeof (*point));
+            point->at = tl->points[i].at;
+            scheduled_point_insert (point, spt);
+        }
+        point->ref_count = tl->points[i].ref_count;
+        point->scheduled = tl->points[i].scheduled;
+        point->remaining = ctx->total_resources - point->scheduled;
+        mintime_resource_insert (point, mtrt);
+    }
+    for (i = 0; i < tl->nspans; i++) {
+        span_t *span = xzmalloc (sizeof (*span));
+        span->start = tl->spans[i].start;
+        span->last = tl->spans[i].last;
+        span->span_id = tl->spans[i].span_id;
+        span->planned = tl->spans[i].planned;
+        span->start_p = scheduled_point_search (span->start, spt);
+        span->last_p = scheduled_point_search (span->last, spt);
+        span->in_system = 1;
+        sprintf (key, "%jd", (intmax_t)span->span_id);
+        zhashx_insert (ctx->span_lookup, key, span);
+        zhashx_freefn (ctx->span_lookup, key, free);
+    }
+    unit_destroy (&tl);
 }
 
 static inline void erase (planner_t *ctx)
@@ -622,6 +958,7 @@ static inline void erase (planner_t *ctx)
         mintime_resource_remove (ctx->p0, &(ctx->mt_resource_tree));
     if ((n = ctx->sched_point_tree.rb_node))
         scheduled_points_destroy (n);
+    unit_destroy (&(ctx->unit));
 }
 
 static inline bool not_feasable (planner_t *ctx, int64_t start_time,
@@ -713,6 +1050,64 @@ int planner_reset (planner_t *ctx, int64_t base_time, uint64_t duration)
     return 0;
 }
 
+int planner_resize (planner_t *ctx, uint64_t resource_total)
+{
+    struct rb_node *n = NULL;
+    scheduled_point_t *point = NULL;
+    struct rb_root *mtrt = NULL;
+    int64_t total = (int64_t)resource_total;
+
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    } else if (resource_total > INT64_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    if (ctx->unit) {
+        size_t i;
+        for (i = 0; i < ctx->unit->npoints; i++) {
+            if (ctx->unit->points[i].scheduled > total) {
+                errno = ERANGE;
+                return -1;
+            }
+        }
+        ctx->total_resources = total;
+        if (total != 1)
+            unit_to_tree (ctx);
+        ctx->avail_time_iter_set = 0;
+        return 0;
+    }
+    if (!ctx->p0) {
+        ctx->total_resources = total;
+        return 0;
+    }
+
+    for (n = rb_first (&(ctx->sched_point_tree)); n; n = rb_next (n)) {
+        point = rb_entry (n, scheduled_point_t, point_rb);
+        if (point->scheduled > total) {
+            errno = ERANGE;
+            return -1;
+        }
+    }
+    // Every point's remaining count changes: rebuild the min-time tree
+    restore_track_points (ctx);
+    mtrt = &(ctx->mt_resource_tree);
+    for (n = rb_first (&(ctx->sched_point_tree)); n; n = rb_next (n)) {
+        point = rb_entry (n, scheduled_point_t, point_rb);
+        if (point->in_mt_resource_tree)
+            mintime_resource_remove (point, mtrt);
+    }
+    for (n = rb_first (&(ctx->sched_point_tree)); n; n = rb_next (n)) {
+        point = rb_entry (n, scheduled_point_t, point_rb);
+        point->remaining = total - point->scheduled;
+        mintime_resource_insert (point, mtrt);
+    }
+    ctx->total_resources = total;
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
 void planner_destroy (planner_t **ctx_p)
 {
     if (ctx_p && *ctx_p) {
@@ -774,10 +1169,17 @@ int64_t planner_avail_time_first (planner_t *ctx, int64_t on_or_after,
         errno = ERANGE;
         return -1;
     }
+    materialize (ctx);
     restore_track_points (ctx);
     ctx->avail_time_iter_set = 1;
     copy_req (ctx->current_request, on_or_after, duration, request);
-    if ( (t = avail_at (ctx, on_or_after, duration, (int64_t)request)) == -1)
+    if (ctx->unit) {
+        ctx->unit->iter_cursor = unit_lower_bound (ctx->unit, on_or_after);
+        t = unit_avail_at (ctx, on_or_after, duration, (int64_t)request);
+    } else {
+        t = avail_at (ctx, on_or_after, duration, (int64_t)request);
+    }
+    if (t == -1)
         errno = ENOENT;
     return t;
 }
@@ -799,8 +1201,11 @@ int64_t planner_avail_time_next (planner_t *ctx)
         errno = ERANGE;
         return -1;
     }
-    if ( (t = avail_at (ctx, on_or_after, duration, (int64_t)request_count)) ==
-          -1)
+    if (ctx->unit)
+        t = unit_avail_at (ctx, on_or_after, duration, request_count);
+    else
+        t = avail_at (ctx, on_or_after, duration, request_count);
+    if (t == -1)
         errno = ENOENT;
     return t;
 }
@@ -824,13 +1229,11 @@ int planner_avail_during (planner_t *ctx, int64_t start_time, uint64_t duration,
 int64_t planner_avail_resources_during (planner_t *ctx, int64_t at,
                                         uint64_t duration)
 {
-    scheduled_point_t *min_point = NULL;
     if (!ctx || at > ctx->plan_end || duration < 1) {
         errno = EINVAL;
         return -1;
     }
-    min_point = avail_resources_during (ctx, at, duration);
-    return min_point->remaining;
+    return avail_resources_during (ctx, at, duration);
 }
 
 int64_t planner_avail_resources_at (planner_t *ctx, int64_t at)
@@ -841,6 +1244,13 @@ int64_t planner_avail_resources_at (planner_t *ctx, int64_t at)
         errno = EINVAL;
         return -1;
     }
+    if (ctx->unit) {
+        ssize_t i = unit_state (ctx->unit, at);
+        return ctx->total_resources
+               - ((i < 0)? 0 : ctx->unit->points[i].scheduled);
+    } else if (!ctx->p0) {
+        return ctx->total_resources;
+    }
     spt = &(ctx->sched_point_tree);
     state = scheduled_point_state (at, spt);
     return state->remaining;
@@ -854,10 +1264,13 @@ int64_t planner_add_span (planner_t *ctx, int64_t start_time,
     scheduled_point_t *start_point = NULL;
     scheduled_point_t *last_point = NULL;
 
-    if (!avail_during (ctx, start_time, duration, (int64_t)request)) {
+    if (!ctx || !avail_during (ctx, start_time, duration, (int64_t)request)) {
         errno = EINVAL;
         return -1;
     }
+    materialize (ctx);
+    if (ctx->unit)
+        return unit_add_span (ctx, start_time, duration, request);
     if ( !(span = span_new (ctx, start_time, duration, request)))
         return -1;
 
@@ -897,8 +1310,13 @@ int planner_rem_span (planner_t *ctx, int64_t span_id)
         errno = EINVAL;
         goto done;
     }
+    if (ctx->unit) {
+        rc = unit_rem_span (ctx, span_id);
+        goto done;
+    }
     sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(span = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -946,7 +1364,16 @@ int64_t planner_span_first (planner_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_first (ctx->span_lookup))) {
+    if (ctx->unit) {
+        ctx->unit->span_cursor = 0;
+        if (ctx->unit->nspans == 0) {
+            errno = EINVAL;
+            goto done;
+        }
+        rc = ctx->unit->spans[0].span_id;
+        goto done;
+    }
+    if (!ctx->span_lookup || !(span = zhashx_first (ctx->span_lookup))) {
         errno = EINVAL;
         goto done;
 
@@ -964,7 +1391,17 @@ int64_t planner_span_next (planner_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_next (ctx->span_lookup))) {
+    if (ctx->unit) {
+        struct unit_timeline *tl = ctx->unit;
+        if (tl->span_cursor == SIZE_MAX || ++(tl->span_cursor) >= tl->nspans) {
+            tl->span_cursor = SIZE_MAX;
+            errno = EINVAL;
+            goto done;
+        }
+        rc = tl->spans[tl->span_cursor].span_id;
+        goto done;
+    }
+    if (!ctx->span_lookup || !(span = zhashx_next (ctx->span_lookup))) {
         errno = EINVAL;
         goto done;
 
@@ -980,7 +1417,9 @@ size_t planner_span_size (planner_t *ctx)
         errno = EINVAL;
         return 0;
     }
-    return zhashx_size (ctx->span_lookup);
+    if (ctx->unit)
+        return ctx->unit->nspans;
+    return (ctx->span_lookup)? zhashx_size (ctx->span_lookup) : 0;
 }
 
 
@@ -993,8 +1432,18 @@ bool planner_is_active_span (planner_t *ctx, int64_t span_id)
         errno = EINVAL;
         goto done;
     }
+    if (ctx->unit) {
+        unit_span_t *uspan = unit_span_lookup (ctx->unit, span_id);
+        if (!uspan) {
+            errno = EINVAL;
+            goto done;
+        }
+        rc = true;
+        goto done;
+    }
     sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(span = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -1012,8 +1461,18 @@ int64_t planner_span_start_time (planner_t *ctx, int64_t span_id)
         errno = EINVAL;
         goto done;
     }
+    if (ctx->unit) {
+        unit_span_t *uspan = unit_span_lookup (ctx->unit, span_id);
+        if (!uspan) {
+            errno = EINVAL;
+            goto done;
+        }
+        rc = uspan->start;
+        goto done;
+    }
     sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(span = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -1031,8 +1490,18 @@ int64_t planner_span_duration (planner_t *ctx, int64_t span_id)
         errno = EINVAL;
         goto done;
     }
+    if (ctx->unit) {
+        unit_span_t *uspan = unit_span_lookup (ctx->unit, span_id);
+        if (!uspan) {
+            errno = EINVAL;
+            goto done;
+        }
+        rc = uspan->last - uspan->start;
+        goto done;
+    }
     sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(span = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -1050,8 +1519,18 @@ int64_t planner_span_resource_count (planner_t *ctx, int64_t span_id)
         errno = EINVAL;
         goto done;
     }
+    if (ctx->unit) {
+        unit_span_t *uspan = unit_span_lookup (ctx->unit, span_id);
+        if (!uspan) {
+            errno = EINVAL;
+            goto done;
+        }
+        rc = uspan->planned;
+        goto done;
+    }
     sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(span = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -34,7 +34,9 @@ extern "C" {
 
 typedef struct planner planner_t;
 
-/*! Construct a planner.
+/*! Construct a planner. Its scheduling state is only allocated when
+ *  the first span is added or available times are first iterated over;
+ *  until then, the planner is fully available and cheap to keep around.
  *
  *  \param base_time    earliest schedulable point expressed in integer time
  *                      (i.e., the base time of the planner to be constructed).
@@ -66,6 +68,20 @@ planner_t *planner_new (int64_t base_time, uint64_t duration,
  */
 int planner_reset (planner_t *ctx, int64_t base_time, uint64_t duration);
 
+/*! Change the total amount of resources the planner manages, keeping
+ *  all existing planned spans.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param resource_total
+ *                      new total count of the resource.
+ *  \return             0 on success; -1 on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ *                          ERANGE: resource_total is greater than INT64_MAX
+ *                                  or smaller than the amount planned at
+ *                                  some instant.
+ */
+int planner_resize (planner_t *ctx, uint64_t resource_total);
+
 /*! Destroy the planner.
  *
  *  \param ctx_p        pointer to a planner context pointer returned.
@@ -89,7 +89,8 @@ planner_multi_t *planner_multi_new (int64_t base_time, uint64_t duration,
         ctx->planners[i] = planner_new (base_time, duration,
                                         resource_totals[i], resource_types[i]);
     }
-    ctx->span_lookup = zhashx_new ();
+    // Allocated on the first span: most pruning filters never see one
+    ctx->span_lookup = NULL;
     ctx->span_counter = 0;
 done:
     return ctx;
@@ -191,6 +192,32 @@ done:
     return rc;
 }
 
+int planner_multi_resize (planner_multi_t *ctx,
+                          const uint64_t *resource_totals, size_t len)
+{
+    int i = 0;
+    int saved_errno;
+    if (!ctx || !resource_totals || len != ctx->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < len; ++i) {
+        if (planner_resize (ctx->planners[i], resource_totals[i]) < 0)
+            goto rollback;
+    }
+    for (i = 0; i < len; ++i)
+        ctx->resource_totals[i] = resource_totals[i];
+    return 0;
+
+rollback:
+    // The old totals held all planned spans, so restoring them succeeds
+    saved_errno = errno;
+    while (--i >= 0)
+        planner_resize (ctx->planners[i], ctx->resource_totals[i]);
+    errno = saved_errno;
+    return -1;
+}
+
 void planner_multi_destroy (planner_multi_t **ctx_p)
 {
     int i = 0;
@@ -372,6 +399,8 @@ int64_t planner_multi_add_span (planner_multi_t *ctx, int64_t start_time,
     if (!ctx || !resource_requests || len != ctx->size)
         return -1;
 
+    if (!ctx->span_lookup)
+        ctx->span_lookup = zhashx_new ();
     list = zlist_new ();
     mspan = ctx->span_counter;
     ctx->span_counter++;
@@ -409,7 +438,8 @@ int planner_multi_rem_span (planner_multi_t *ctx, int64_t span_id)
     }
 
     sprintf (key, "%jd", (intmax_t)span_id);
-    if (!(list = zhashx_lookup (ctx->span_lookup, key))) {
+    if (!ctx->span_lookup
+        || !(list = zhashx_lookup (ctx->span_lookup, key))) {
         errno = EINVAL;
         goto done;
     }
@@ -432,7 +462,7 @@ int64_t planner_multi_span_first (planner_multi_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_first (ctx->span_lookup))) {
+    if (!ctx->span_lookup || !(span = zhashx_first (ctx->span_lookup))) {
         errno = ENOENT;
         goto done;
 
@@ -450,7 +480,7 @@ int64_t planner_multi_span_next (planner_multi_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_next (ctx->span_lookup))) {
+    if (!ctx->span_lookup || !(span = zhashx_next (ctx->span_lookup))) {
         errno = ENOENT;
         goto done;
     }
@@ -465,7 +495,7 @@ size_t planner_multi_span_size (planner_multi_t *ctx)
         errno = EINVAL;
         return 0;
     }
-    return zhashx_size (ctx->span_lookup);
+    return (ctx->span_lookup)? zhashx_size (ctx->span_lookup) : 0;
 }
 
 /*
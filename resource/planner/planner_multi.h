@@ -90,6 +90,26 @@ int64_t planner_multi_resource_total_by_type (planner_multi_t *ctx,
 int planner_multi_reset (planner_multi_t *ctx, int64_t base_time,
                          uint64_t duration);
 
+/*! Change the resource totals of the planner_multi_t context, keeping
+ *  all existing planned spans. Either all totals are changed or, on an
+ *  error, none is.
+ *
+ *  \param ctx          an opaque planner_multi_t context returned from
+ *                      planner_multi_new.
+ *  \param resource_totals
+ *                      new resource totals in the order of the resource
+ *                      types passed in via planner_multi_new ().
+ *  \param len          length of resource_totals; must equal the number
+ *                      of resource types.
+ *  \return             0 on success; -1 on error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ *                          ERANGE: a total is greater than INT64_MAX or
+ *                                  smaller than the amount planned at
+ *                                  some instant.
+ */
+int planner_multi_resize (planner_multi_t *ctx,
+                          const uint64_t *resource_totals, size_t len);
+
 /*! Destroy the planner_multi.
  *
  *  \param ctx_p        a pointer to a planner_multi_t context pointer returned
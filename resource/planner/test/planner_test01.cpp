@@ -663,9 +663,116 @@ static int test_more_add_remove ()
     return 0;
 }
 
+static int test_unit_capacity ()
+{
+    int rc;
+    int64_t t, span1, span2, span3;
+    bool bo = false;
+    const char resource_type[] = "core";
+    planner_t *ctx = NULL;
+    std::stringstream ss;
+
+    errno = 0;
+    to_stream (0, 1000, 1, resource_type, ss);
+    ctx = planner_new (0, 1000, 1, resource_type);
+    ok ((ctx && !errno), "new with (%s)", ss.str ().c_str ());
+    ss.str ("");
+
+    span1 = planner_add_span (ctx, 100, 100, 1);
+    bo = (bo || span1 == -1);
+    span2 = planner_add_span (ctx, 250, 50, 1);
+    bo = (bo || span2 == -1);
+    span3 = planner_add_span (ctx, 150, 200, 0);
+    bo = (bo || span3 == -1);
+    bo = (bo || planner_add_span (ctx, 150, 10, 1) != -1);
+    bo = (bo || planner_avail_resources_during (ctx, 0, 260) != 0);
+    bo = (bo || planner_avail_resources_at (ctx, 200) != 1);
+    ok (!bo, "unit: overlapping spans are rejected");
+
+    t = planner_avail_time_first (ctx, 0, 50, 1);
+    bo = (bo || t != 0);
+    t = planner_avail_time_next (ctx);
+    bo = (bo || t != 200);
+    t = planner_avail_time_next (ctx);
+    bo = (bo || t != 300);
+    t = planner_avail_time_next (ctx);
+    bo = (bo || t != 350);
+    t = planner_avail_time_next (ctx);
+    bo = (bo || t != -1 || errno != ENOENT);
+    ok (!bo, "unit: avail_time_next visits every free point in order");
+
+    errno = 0;
+    rc = planner_rem_span (ctx, span1);
+    bo = (bo || rc == -1);
+    t = planner_avail_time_first (ctx, 0, 250, 1);
+    bo = (bo || t != 0);
+    bo = (bo || planner_span_size (ctx) != 2);
+    t = planner_span_first (ctx);
+    t += planner_span_next (ctx);
+    bo = (bo || t != span2 + span3 || planner_span_next (ctx) != -1);
+    bo = (bo || planner_span_start_time (ctx, span2) != 250);
+    bo = (bo || planner_is_active_span (ctx, span1));
+    ok (!bo, "unit: remove and span iteration work");
+
+    planner_destroy (&ctx);
+    return 0;
+}
+
+static int test_resize ()
+{
+    int64_t t, span1, span2, span3;
+    bool bo = false;
+    const char resource_type[] = "core";
+    planner_t *ctx = NULL;
+
+    errno = 0;
+    ctx = planner_new (0, 1000, 4, resource_type);
+    span1 = planner_add_span (ctx, 100, 100, 3);
+    bo = (bo || span1 == -1);
+    bo = (bo || planner_resize (ctx, 2) != -1 || errno != ERANGE);
+    bo = (bo || planner_resource_total (ctx) != 4);
+    errno = 0;
+    bo = (bo || planner_resize (ctx, 8) != 0);
+    bo = (bo || planner_resource_total (ctx) != 8);
+    bo = (bo || planner_avail_resources_at (ctx, 150) != 5);
+    t = planner_avail_time_first (ctx, 0, 500, 5);
+    bo = (bo || t != 0);
+    ok (!bo && !errno, "resize: growing keeps spans");
+
+    span2 = planner_add_span (ctx, 150, 100, 5);
+    bo = (bo || span2 == -1);
+    bo = (bo || planner_resize (ctx, 7) != -1 || errno != ERANGE);
+    errno = 0;
+    bo = (bo || planner_rem_span (ctx, span1) != 0);
+    bo = (bo || planner_resize (ctx, 5) != 0);
+    bo = (bo || planner_avail_resources_at (ctx, 150) != 0);
+    t = planner_avail_time_first (ctx, 0, 100, 5);
+    bo = (bo || t != 0);
+    t = planner_avail_time_next (ctx);
+    bo = (bo || t != 250);
+    ok (!bo && !errno, "resize: shrinking is bounded by planned spans");
+    planner_destroy (&ctx);
+
+    ctx = planner_new (0, 1000, 1, resource_type);
+    span1 = planner_add_span (ctx, 100, 100, 1);
+    bo = (bo || span1 == -1);
+    bo = (bo || planner_resize (ctx, 3) != 0);
+    bo = (bo || planner_avail_resources_at (ctx, 150) != 2);
+    span3 = planner_add_span (ctx, 150, 10, 2);
+    bo = (bo || span3 == -1 || span3 == span1);
+    bo = (bo || planner_span_size (ctx) != 2);
+    bo = (bo || planner_span_start_time (ctx, span1) != 100);
+    bo = (bo || planner_rem_span (ctx, span1) != 0);
+    bo = (bo || planner_avail_resources_at (ctx, 100) != 3);
+    bo = (bo || planner_avail_resources_at (ctx, 155) != 1);
+    ok (!bo && !errno, "resize: a unit-capacity planner keeps its spans");
+    planner_destroy (&ctx);
+    return 0;
+}
+
 int main (int argc, char *argv[])
 {
-    plan (51);
+    plan (58);
 
     test_planner_getters ();
 
@@ -687,6 +794,10 @@ int main (int argc, char *argv[])
 
     test_more_add_remove ();
 
+    test_unit_capacity ();
+
+    test_resize ();
+
     done_testing ();
 
     return EXIT_SUCCESS;
@@ -558,9 +558,46 @@ static int test_multi_add_remove ()
 }
 
 
+static int test_multi_resize ()
+{
+    size_t len = 3;
+    int64_t span1 = -1;
+    bool bo = false;
+    const uint64_t resource_totals[] = {10, 20, 30};
+    const uint64_t grown_totals[] = {20, 40, 30};
+    const uint64_t shrunk_totals[] = {20, 1, 30};
+    const char *resource_types[] = {"A", "B", "C"};
+    const uint64_t request1[] = {5, 10, 15};
+    const uint64_t request2[] = {15, 30, 15};
+    planner_multi_t *ctx = NULL;
+
+    errno = 0;
+    ctx = planner_multi_new (0, 1000, resource_totals, resource_types, len);
+    span1 = planner_multi_add_span (ctx, 0, 100, request1, len);
+    bo = (bo || span1 == -1);
+    bo = (bo || planner_multi_avail_during (ctx, 0, 100, request2, len) != -1);
+    errno = 0;
+    bo = (bo || planner_multi_resize (ctx, grown_totals, len) != 0);
+    bo = (bo || planner_multi_resource_totals (ctx)[1] != 40);
+    bo = (bo || planner_multi_resource_total_by_type (ctx, "B") != 40);
+    bo = (bo || planner_multi_avail_during (ctx, 0, 100, request2, len) != 0);
+    ok (!bo && !errno, "multi_resize grows totals keeping spans");
+
+    bo = (bo || planner_multi_resize (ctx, shrunk_totals, len) != -1);
+    bo = (bo || errno != ERANGE);
+    bo = (bo || planner_multi_resource_total_by_type (ctx, "A") != 20);
+    bo = (bo || planner_multi_resource_total_by_type (ctx, "B") != 40);
+    bo = (bo || planner_multi_resize (ctx, grown_totals, len - 1) != -1);
+    bo = (bo || errno != EINVAL);
+    ok (!bo, "multi_resize leaves totals unchanged on error");
+
+    planner_multi_destroy (&ctx);
+    return 0;
+}
+
 int main (int argc, char *argv[])
 {
-    plan (79);
+    plan (81);
 
     test_multi_basics ();
 
@@ -574,6 +611,8 @@ int main (int argc, char *argv[])
 
     test_multi_add_remove ();
 
+    test_multi_resize ();
+
     done_testing ();
 
     return EXIT_SUCCESS;
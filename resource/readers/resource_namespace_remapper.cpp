@@ -39,6 +39,27 @@ extern "C" {
 
 using namespace Flux::resource_model;
 
+/*! Return the number of elements of the vector v, sorted by key (),
+ *  whose key is not greater than k; i.e., the index one past the last
+ *  such element. The loop body has no data-dependent branch, which the
+ *  compiler lowers to a conditional move.
+ */
+template <typename T, typename KeyFn>
+static size_t upper_index (const std::vector<T> &v, uint64_t k, KeyFn key)
+{
+    const T *base = v.data ();
+    size_t n = v.size ();
+
+    if (n == 0)
+        return 0;
+    while (n > 1) {
+        size_t half = n / 2;
+        base = (key (base[half]) <= k)? base + half : base;
+        n -= half;
+    }
+    return (base - v.data ()) + (key (*base) <= k);
+}
+
 
 /********************************************************************************
  *                                                                              *
@@ -141,25 +162,35 @@ int resource_namespace_remapper_t::add (const uint64_t low, const uint64_t high,
 {
     try {
         const distinct_range_t exec_target_range{low, high};
-        auto m_remap_iter = m_remap.find (exec_target_range);
-
-        if (m_remap_iter == m_remap.end ()) {
-            m_remap.emplace (exec_target_range,
-                             std::map<const std::string,
-                                      std::map<uint64_t, uint64_t>> ());
-        } else if (exec_target_range != m_remap_iter->first)
-            goto inval; // key must be exact
-
-        if (m_remap[exec_target_range].find (name_type)
-            == m_remap[exec_target_range].end ())
-            m_remap[exec_target_range][name_type] = std::map<uint64_t,
-                                                             uint64_t> ();
-        if (m_remap[exec_target_range][name_type].find (ref_id)
-            != m_remap[exec_target_range][name_type].end ()) {
-            errno = EEXIST;
-            goto error;
+        remap_range_t *r = nullptr;
+        remap_type_t *t = nullptr;
+        size_t i = upper_index (m_remap, low, [] (const remap_range_t &e) {
+                                    return e.range.get_low (); });
+
+        // The key must be exact if it overlaps an existing range
+        if (i > 0 && m_remap[i - 1].range.get_high () >= low) {
+            if (m_remap[i - 1].range != exec_target_range)
+                goto inval;
+            r = &m_remap[i - 1];
+        } else if (i < m_remap.size () && m_remap[i].range.get_low () <= high) {
+            goto inval;
+        } else {
+            r = &*m_remap.insert (m_remap.begin () + i,
+                                  remap_range_t{exec_target_range, {}});
         }
-        m_remap[exec_target_range][name_type][ref_id] = remapped_id;
+
+        for (auto &type : r->types) {
+            if (type.name_type == name_type) {
+                t = &type;
+                break;
+            }
+        }
+        if (!t) {
+            r->types.push_back (remap_type_t{name_type, {}});
+            t = &r->types.back ();
+        }
+        if (add_run (t->runs, ref_id, remapped_id) < 0)
+            goto error;
     } catch (std::bad_alloc &) {
         errno = ENOMEM;
         goto error;
@@ -223,28 +254,20 @@ int resource_namespace_remapper_t::query (const uint64_t exec_target,
                                           uint64_t ref_id,
                                           uint64_t &remapped_id_out) const
 {
-    try {
-        remapped_id_out = m_remap.at (distinct_range_t{exec_target})
-                                         .at (name_type).at (ref_id);
-        return 0;
-    } catch (std::out_of_range &) {
+    const remap_run_t *run = find_run (exec_target, name_type, ref_id);
+    if (!run) {
         errno = ENOENT;
         return -1;
     }
+    remapped_id_out = run->remapped_low + (ref_id - run->ref_low);
+    return 0;
 }
 
 int resource_namespace_remapper_t::query_exec_target (
         const uint64_t exec_target, uint64_t &remapped_exec_target) const
 {
-    try {
-        remapped_exec_target = m_remap.at (distinct_range_t{exec_target})
-                                               .at ("exec-target")
-                                                        .at (exec_target);
-        return 0;
-    } catch (std::out_of_range &) {
-        errno = ENOENT;
-        return -1;
-    }
+    return query (exec_target, "exec-target", exec_target,
+                  remapped_exec_target);
 }
 
 bool resource_namespace_remapper_t::is_remapped () const
@@ -252,6 +275,69 @@ bool resource_namespace_remapper_t::is_remapped () const
     return !m_remap.empty ();
 }
 
+
+/********************************************************************************
+ *                                                                              *
+ *                   Private Resource Namespace Remapper API                    *
+ *                                                                              *
+ ********************************************************************************/
+
+const resource_namespace_remapper_t::remap_run_t *
+    resource_namespace_remapper_t::find_run (const uint64_t exec_target,
+                                             const std::string &name_type,
+                                             uint64_t ref_id) const
+{
+    size_t i = upper_index (m_remap, exec_target,
+                            [] (const remap_range_t &e) {
+                                return e.range.get_low (); });
+    if (i == 0 || m_remap[i - 1].range.get_high () < exec_target)
+        return nullptr;
+    for (auto &type : m_remap[i - 1].types) {
+        if (type.name_type != name_type)
+            continue;
+        size_t j = upper_index (type.runs, ref_id,
+                                [] (const remap_run_t &e) {
+                                    return e.ref_low; });
+        if (j == 0 || ref_id - type.runs[j - 1].ref_low
+                          >= type.runs[j - 1].count)
+            return nullptr;
+        return &type.runs[j - 1];
+    }
+    return nullptr;
+}
+
+int resource_namespace_remapper_t::add_run (std::vector<remap_run_t> &runs,
+                                            uint64_t ref_id,
+                                            uint64_t remapped_id)
+{
+    size_t i = upper_index (runs, ref_id, [] (const remap_run_t &e) {
+                                return e.ref_low; });
+    remap_run_t *prev = (i > 0)? &runs[i - 1] : nullptr;
+    remap_run_t *next = (i < runs.size ())? &runs[i] : nullptr;
+
+    if (prev && ref_id - prev->ref_low < prev->count) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (prev && prev->ref_low + prev->count == ref_id
+             && prev->remapped_low + prev->count == remapped_id) {
+        prev->count++;
+        if (next && next->ref_low == ref_id + 1
+                 && next->remapped_low == remapped_id + 1) {
+            prev->count += next->count;
+            runs.erase (runs.begin () + i);
+        }
+    } else if (next && next->ref_low == ref_id + 1
+                    && next->remapped_low == remapped_id + 1) {
+        next->ref_low = ref_id;
+        next->remapped_low = remapped_id;
+        next->count++;
+    } else {
+        runs.insert (runs.begin () + i, remap_run_t{ref_id, remapped_id, 1});
+    }
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
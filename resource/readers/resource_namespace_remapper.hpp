@@ -25,8 +25,8 @@
 #ifndef RESOURCE_NAMESPACE_REMAPPER_HPP
 #define RESOURCE_NAMESPACE_REMAPPER_HPP
 
-#include <map>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace Flux {
@@ -73,13 +73,39 @@ public:
     bool is_remapped () const;
 
 private:
+    /*! A run of consecutive ids [ref_low, ref_low + count) remapped to
+     *  [remapped_low, remapped_low + count). Consecutive rules added
+     *  one id at a time (e.g., by add_exec_target_range) coalesce into
+     *  a single run.
+     */
+    struct remap_run_t {
+        uint64_t ref_low;
+        uint64_t remapped_low;
+        uint64_t count;
+    };
+
+    //! Runs of one name type, sorted by ref_low and non-overlapping
+    struct remap_type_t {
+        std::string name_type;
+        std::vector<remap_run_t> runs;
+    };
+
+    //! Rules of one exec target range, a handful of name types each
+    struct remap_range_t {
+        distinct_range_t range;
+        std::vector<remap_type_t> types;
+    };
 
     int get_low_high (const std::string &exec_target_range,
                       uint64_t &low, uint64_t &high) const;
-
-    std::map<const distinct_range_t,
-             std::map<const std::string,
-                      std::map<uint64_t, uint64_t>>> m_remap;
+    const remap_run_t *find_run (const uint64_t exec_target,
+                                 const std::string &name_type,
+                                 uint64_t ref_id) const;
+    int add_run (std::vector<remap_run_t> &runs,
+                 uint64_t ref_id, uint64_t remapped_id);
+
+    // Sorted by exec target range; ranges never overlap
+    std::vector<remap_range_t> m_remap;
 };
 
 } // namespace resource_model
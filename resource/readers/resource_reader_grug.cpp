@@ -59,13 +59,14 @@ public:
 
     void set_rank (int rank);
     int get_rank ();
+    void set_out_degrees (const std::vector<size_t> *degrees);
 
 private:
     vtx_t emit_vertex (ggv_t u, gge_t e, const gg_t &recipe,
                        vtx_t src_v, int i, int sz, int j);
-    int raw_edge (vtx_t src_v, vtx_t tgt_v, edg_t &e);
+    int raw_edge (vtx_t src_v, vtx_t tgt_v, bool fresh, edg_t &e);
     void emit_edges (gge_t e, const gg_t &recipe,
-                     vtx_t src_v, vtx_t tgt_v);
+                     vtx_t src_v, vtx_t tgt_v, bool fresh);
     int path_prefix (const std::string &pth,
                      int upl, std::string &pref);
     int gen_id (gge_t e, const gg_t &recipe,
@@ -76,10 +77,26 @@ private:
     resource_graph_t *m_g_p = NULL;
     resource_graph_metadata_t *m_gm_p = NULL;
     resource_gen_spec_t *m_gspec_p = NULL;
+    const std::vector<size_t> *m_degrees_p = NULL;
     int m_rank = -1;
     std::string m_err_msg = "";
 };
 
+/*! DFS visitor that counts, without emitting anything, how many
+ *  resource vertex instances each generator vertex will produce. It
+ *  walks the same tree edges in the same order as dfs_emitter_t.
+ *  Like the emitter, it must be copy-constructible and lightweight.
+ */
+class dfs_counter_t : public boost::default_dfs_visitor {
+public:
+    dfs_counter_t (std::vector<size_t> *counts, const resource_gen_spec_t *g);
+    void tree_edge (gge_t e, const gg_t &recipe);
+
+private:
+    std::vector<size_t> *m_counts_p = NULL;
+    const resource_gen_spec_t *m_gspec_p = NULL;
+};
+
 
 /********************************************************************************
  *                                                                              *
@@ -142,17 +159,21 @@ int dfs_emitter_t::gen_id (gge_t e, const gg_t &recipe, int i, int sz, int j)
               + (i * recipe[e].id_stride);
 }
 
-int dfs_emitter_t::raw_edge (vtx_t src_v, vtx_t tgt_v, edg_t &e)
+int dfs_emitter_t::raw_edge (vtx_t src_v, vtx_t tgt_v, bool fresh, edg_t &e)
 {
     bool inserted;
     out_edg_iterator_t ei, ee;
     resource_graph_t &g = *m_g_p;
 
-    tie (ei, ee) = out_edges (src_v, g);
-    for ( ; ei != ee; ++ei) {
-        if (target (*ei, g) == tgt_v) {
-            e = (*ei);
-            return 0;
+    // No edge can exist yet between a freshly emitted vertex and its
+    // parent: skip the linear scan that would make wide fan-outs quadratic.
+    if (!fresh) {
+        tie (ei, ee) = out_edges (src_v, g);
+        for ( ; ei != ee; ++ei) {
+            if (target (*ei, g) == tgt_v) {
+                e = (*ei);
+                return 0;
+            }
         }
     }
     tie (e, inserted) = add_edge (src_v, tgt_v, g);
@@ -163,28 +184,8 @@ int dfs_emitter_t::raw_edge (vtx_t src_v, vtx_t tgt_v, edg_t &e)
         return -1;
     }
     // add this edge to by_outedges metadata
-    auto iter = m_gm_p->by_outedges.find (src_v);
-    if (iter == m_gm_p->by_outedges.end ()) {
-        auto ret = m_gm_p->by_outedges.insert (
-                       std::make_pair (
-                       src_v,
-                       std::map<std::pair<uint64_t, int64_t>, edg_t,
-                                std::greater<std::pair<uint64_t,
-                                                       int64_t>>> ()));
-        if (!ret.second) {
-            errno = ENOMEM;
-            m_err_msg += "error creating out-edge metadata map: "
-                              + g[src_v].name + " -> " + g[tgt_v].name + "; ";
-            return -1;
-        }
-        iter = m_gm_p->by_outedges.find (src_v);
-    }
-    // Use a temporary for readability
-    std::pair<uint64_t, int64_t> key = std::make_pair (
-                                                g[e].idata.get_weight (),
-                                                g[tgt_v].uniq_id);
-    auto ret = iter->second.insert (std::make_pair (key, e));
-    if (!ret.second) {
+    if (!m_gm_p->by_outedges[src_v].insert (g[e].idata.get_weight (),
+                                            g[tgt_v].uniq_id, e)) {
         errno = ENOMEM;
         m_err_msg += "error inserting an edge into out-edge metadata map:"
                          + g[src_v].name + " -> " + g[tgt_v].name + "; ";
@@ -194,21 +195,24 @@ int dfs_emitter_t::raw_edge (vtx_t src_v, vtx_t tgt_v, edg_t &e)
 }
 
 void dfs_emitter_t::emit_edges (gge_t ge, const gg_t &recipe,
-                                vtx_t src_v, vtx_t tgt_v)
+                                vtx_t src_v, vtx_t tgt_v, bool fresh)
 {
     edg_t e;
     int rc = 0;
     resource_graph_t &g = *m_g_p;
-    if ( (rc = raw_edge (src_v, tgt_v, e)) < 0)
+    resource_graph_metadata_t &m = *m_gm_p;
+    if ( (rc = raw_edge (src_v, tgt_v, fresh, e)) < 0)
         return;
     g[e].idata.member_of[recipe[ge].e_subsystem]
         = recipe[ge].relation;
-    g[e].name[recipe[ge].e_subsystem] = recipe[ge].relation;
-    if ( (rc = raw_edge (tgt_v, src_v, e)) < 0)
+    g[e].idata.member_of = m.shared_maps.intern (g[e].idata.member_of);
+    g[e].name = g[e].idata.member_of;
+    if ( (rc = raw_edge (tgt_v, src_v, fresh, e)) < 0)
         return;
     g[e].idata.member_of[recipe[ge].e_subsystem]
         = recipe[ge].rrelation;
-    g[e].name[recipe[ge].e_subsystem] = recipe[ge].rrelation;
+    g[e].idata.member_of = m.shared_maps.intern (g[e].idata.member_of);
+    g[e].name = g[e].idata.member_of;
 }
 
 vtx_t dfs_emitter_t::emit_vertex (ggv_t u, gge_t e, const gg_t &recipe,
@@ -220,11 +224,14 @@ vtx_t dfs_emitter_t::emit_vertex (ggv_t u, gge_t e, const gg_t &recipe,
         if (m.roots.find (recipe[u].subsystem) != m.roots.end ())
             return (m.roots)[recipe[u].subsystem];
 
-    vtx_t v = add_vertex (g);;
+    vtx_t v = add_vertex (g);
     std::string pref = "";
-    std::string ssys = recipe[u].subsystem;
+    const std::string &ssys = recipe[u].subsystem;
     int id = 0;
 
+    if (m_degrees_p)
+        g.m_vertices[v].m_out_edges.reserve ((*m_degrees_p)[u]);
+
     if (src_v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         // ROOT vertex of graph
         m.roots.emplace (recipe[u].subsystem, v);
@@ -245,19 +252,24 @@ vtx_t dfs_emitter_t::emit_vertex (ggv_t u, gge_t e, const gg_t &recipe,
     g[v].idata.x_checker = planner_new (0, INT64_MAX,
                                            X_CHECKER_NJOBS, X_CHECKER_JOBS_STR);
     g[v].id = id;
-    g[v].name = recipe[u].basename + istr;
-    g[v].paths[ssys] = pref + "/" + g[v].name;
+    g[v].name.reserve (recipe[u].basename.size () + istr.size ());
+    g[v].name.append (recipe[u].basename).append (istr);
+    std::string &path = g[v].paths[ssys];
+    path.reserve (pref.size () + 1 + g[v].name.size ());
+    path.append (pref).append (1, '/').append (g[v].name);
     g[v].idata.member_of[ssys] = "*";
-    g[v].uniq_id = v;
+    g[v].idata.member_of = m.shared_maps.intern (g[v].idata.member_of);
+    g[v].uniq_id = m.next_uniq_id++;
     g[v].rank = m_rank;
 
     //
     // Indexing for fast look-up...
     //
-    m.by_path[g[v].paths[ssys]] = v;
+    m.by_path.set (path, v);
     m.by_type[g[v].type].push_back (v);
     m.by_name[g[v].name].push_back (v);
     m.by_rank[m_rank].push_back (v);
+    m.index_rank_root (g, v);
     return v;
 }
 
@@ -287,6 +299,7 @@ dfs_emitter_t::dfs_emitter_t (const dfs_emitter_t &o)
     m_g_p = o.m_g_p;
     m_gm_p = o.m_gm_p;
     m_gspec_p = o.m_gspec_p;
+    m_degrees_p = o.m_degrees_p;
     m_err_msg = o.m_err_msg;
 }
 
@@ -301,6 +314,7 @@ dfs_emitter_t &dfs_emitter_t::operator=(const dfs_emitter_t &o)
     m_g_p = o.m_g_p;
     m_gm_p = o.m_gm_p;
     m_gspec_p = o.m_gspec_p;
+    m_degrees_p = o.m_degrees_p;
     m_err_msg = o.m_err_msg;
     return *this;
 }
@@ -336,6 +350,8 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
 
     switch (m_gspec_p->to_gen_method_t (recipe[e].gen_method)) {
     case MULTIPLY:
+        m_gen_src_vtx[tgt_ggv].reserve (m_gen_src_vtx[src_ggv].size ()
+                                        * recipe[e].multi_scale);
         for (src_it = m_gen_src_vtx[src_ggv].begin ();
              src_it != m_gen_src_vtx[src_ggv].end (); src_it++, j++) {
 
@@ -343,7 +359,7 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
             for (i = 0; i < recipe[e].multi_scale; ++i) {
                 tgt_vtx = emit_vertex (tgt_ggv, e, recipe, src_vtx, i,
                                        recipe[e].multi_scale, j);
-                emit_edges (e, recipe, src_vtx, tgt_vtx);
+                emit_edges (e, recipe, src_vtx, tgt_vtx, true);
                 // TODO: Next gen src vertex; where do you clear them?
                 m_gen_src_vtx[tgt_ggv].push_back (tgt_vtx);
             }
@@ -362,10 +378,14 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
                 g[tgt_vtx].paths[recipe[e].e_subsystem]
                     = g[src_vtx].paths[recipe[e].e_subsystem]
                           + "/" + g[tgt_vtx].name;
-                m.by_path[g[tgt_vtx].paths[recipe[e].e_subsystem]] = tgt_vtx;
+                m.by_path.set (g[tgt_vtx].paths[recipe[e].e_subsystem],
+                               tgt_vtx);
+                m.index_rank_root (g, tgt_vtx);
                 g[tgt_vtx].idata.member_of[recipe[e].e_subsystem]
                     = "*";
-                emit_edges (e, recipe, src_vtx, tgt_vtx);
+                g[tgt_vtx].idata.member_of
+                    = m.shared_maps.intern (g[tgt_vtx].idata.member_of);
+                emit_edges (e, recipe, src_vtx, tgt_vtx, false);
                 m_gen_src_vtx[tgt_ggv].push_back (tgt_vtx);
             }
         }
@@ -392,10 +412,14 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
                 g[tgt_vtx].paths[recipe[e].e_subsystem]
                     = g[src_vtx].paths[recipe[e].e_subsystem]
                           + "/" + g[tgt_vtx].name;
-                m.by_path[g[tgt_vtx].paths[recipe[e].e_subsystem]] = tgt_vtx;
+                m.by_path.set (g[tgt_vtx].paths[recipe[e].e_subsystem],
+                               tgt_vtx);
+                m.index_rank_root (g, tgt_vtx);
                 g[tgt_vtx].idata.member_of[recipe[e].e_subsystem]
                     = "*";
-                emit_edges (e, recipe, src_vtx, tgt_vtx);
+                g[tgt_vtx].idata.member_of
+                    = m.shared_maps.intern (g[tgt_vtx].idata.member_of);
+                emit_edges (e, recipe, src_vtx, tgt_vtx, false);
                 m_gen_src_vtx[tgt_ggv].push_back (tgt_vtx);
             }
         }
@@ -447,6 +471,97 @@ int dfs_emitter_t::get_rank ()
     return m_rank;
 }
 
+/*! Set the number of out-edges to reserve for each vertex generated
+ *  from each generator vertex. degrees must outlive the emitter.
+ */
+void dfs_emitter_t::set_out_degrees (const std::vector<size_t> *degrees)
+{
+    m_degrees_p = degrees;
+}
+
+
+/********************************************************************************
+ *                                                                              *
+ *                          DFS Visitor Counter                                 *
+ *                                                                              *
+ ********************************************************************************/
+
+dfs_counter_t::dfs_counter_t (std::vector<size_t> *counts,
+                              const resource_gen_spec_t *g)
+{
+    m_counts_p = counts;
+    m_gspec_p = g;
+}
+
+/*! Visitor method that is invoked on a tree-edge event. Mirror
+ *  dfs_emitter_t::tree_edge: a root yields one instance, whether
+ *  it is emitted or reuses the root its subsystem already has, and
+ *  MULTIPLY generates multi_scale targets per source instance.
+ *  Associations generate no new vertices.
+ *
+ *  \param e             resource generator graph edge descriptor
+ *  \param recipe        resource generator recipe graph
+ */
+void dfs_counter_t::tree_edge (gge_t e, const gg_t &recipe)
+{
+    std::vector<size_t> &counts = *m_counts_p;
+    ggv_t src_ggv = source (e, recipe);
+    ggv_t tgt_ggv = target (e, recipe);
+
+    if (recipe[src_ggv].root && counts[src_ggv] == 0)
+        counts[src_ggv] = 1;
+    if (m_gspec_p->to_gen_method_t (recipe[e].gen_method) == MULTIPLY)
+        counts[tgt_ggv] = counts[src_ggv] * recipe[e].multi_scale;
+}
+
+
+/********************************************************************************
+ *                                                                              *
+ *                   Private GRUG Resource Reader API                           *
+ *                                                                              *
+ ********************************************************************************/
+
+void resource_reader_grug_t::reserve (resource_graph_t &g,
+                                      resource_graph_metadata_t &m,
+                                      int rank, std::vector<size_t> &degrees)
+{
+    size_t total = 0;
+    boost::graph_traits<gg_t>::edge_iterator ei, ee;
+    boost::graph_traits<gg_t>::vertex_iterator vi, ve;
+    const gg_t &recipe = m_gspec.gen_graph ();
+    std::vector<size_t> counts (num_vertices (recipe), 0);
+    std::map<std::string, size_t> by_type;
+
+    dfs_counter_t counter (&counts, &m_gspec);
+    depth_first_search (recipe, boost::visitor (counter));
+
+    // Each generated vertex has an edge back to its parent and one edge
+    // to each of the targets that it multiplies into.
+    degrees.assign (num_vertices (recipe), 0);
+    for (boost::tie (ei, ee) = edges (recipe); ei != ee; ++ei) {
+        if (m_gspec.to_gen_method_t (recipe[*ei].gen_method) != MULTIPLY)
+            continue;
+        degrees[source (*ei, recipe)] += recipe[*ei].multi_scale;
+        degrees[target (*ei, recipe)] += 1;
+    }
+    for (boost::tie (vi, ve) = vertices (recipe); vi != ve; ++vi) {
+        // An existing root is reused rather than emitted again
+        if (recipe[*vi].root
+            && m.roots.find (recipe[*vi].subsystem) != m.roots.end ())
+            continue;
+        total += counts[*vi];
+        by_type[recipe[*vi].type] += counts[*vi];
+    }
+
+    g.m_vertices.reserve (num_vertices (g) + total);
+    for (auto &kv : by_type) {
+        std::vector<vtx_t> &v = m.by_type[kv.first];
+        v.reserve (v.size () + kv.second);
+    }
+    std::vector<vtx_t> &r = m.by_rank[rank];
+    r.reserve (r.size () + total);
+}
+
 
 /********************************************************************************
  *                                                                              *
@@ -478,8 +593,20 @@ int resource_reader_grug_t::unpack (resource_graph_t &g,
     // depth_first_search on the generator recipe graph
     // with emitter visitor.
     //
+    // Size the graph and its indices from the recipe's multiplicities
+    // up front so that emitting vertices never reallocates them.
+    std::vector<size_t> degrees;
+    try {
+        reserve (g, m, rank, degrees);
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        m_err_msg += "out of memory reserving graph storage; ";
+        return -1;
+    }
+
     dfs_emitter_t emitter (&g, &m, &m_gspec);
     emitter.set_rank (rank);
+    emitter.set_out_degrees (&degrees);
     depth_first_search (m_gspec.gen_graph (), boost::visitor (emitter));
     m_err_msg += emitter.err_message ();
 
@@ -26,6 +26,7 @@
 #define RESOURCE_READER_GRUG_HPP
 
 #include <string>
+#include <vector>
 #include <boost/graph/depth_first_search.hpp>
 #include "resource/schema/resource_graph.hpp"
 #include "resource/readers/resource_reader_base.hpp"
@@ -90,6 +91,9 @@ public:
     virtual bool is_allowlist_supported ();
 
 private:
+    void reserve (resource_graph_t &g, resource_graph_metadata_t &m,
+                  int rank, std::vector<size_t> &degrees);
+
     resource_gen_spec_t m_gspec;
 };
 
@@ -23,6 +23,13 @@
  \*****************************************************************************/
 
 #include <limits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
 #include "resource/readers/resource_reader_hwloc.hpp"
 #include "resource/store/resource_graph_store.hpp"
 
@@ -42,6 +49,46 @@ using namespace resource_model;
  *                                                                              *
  ********************************************************************************/
 
+static inline uint64_t fnv1a (uint64_t h, const void *data, size_t len)
+{
+    const unsigned char *p = static_cast<const unsigned char *> (data);
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/*! FNV-1a digest of a NUL-terminated xml string, also returning its length.
+ */
+static uint64_t xml_digest (const char *xml, size_t &len)
+{
+    len = strlen (xml);
+    return fnv1a (14695981039346656037ULL, xml, len);
+}
+
+uint64_t resource_reader_hwloc_t::shape_digest (
+             const std::vector<hwloc_vtx_t> &vertices)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (const auto &hv : vertices) {
+        h = fnv1a (h, &hv.parent, sizeof (hv.parent));
+        h = fnv1a (h, &hv.id, sizeof (hv.id));
+        h = fnv1a (h, &hv.size, sizeof (hv.size));
+        h = fnv1a (h, hv.type.data (), hv.type.size () + 1);
+        h = fnv1a (h, hv.basename.data (), hv.basename.size () + 1);
+    }
+    return h;
+}
+
+bool resource_reader_hwloc_t::hwloc_vtx_t::operator== (
+         const hwloc_vtx_t &o) const
+{
+    return parent == o.parent && id == o.id && size == o.size
+           && type == o.type && basename == o.basename
+           && properties == o.properties;
+}
+
 int resource_reader_hwloc_t::check_hwloc_version (std::string &m_err_msg)
 {
     unsigned int hwloc_version = hwloc_get_api_version ();
@@ -64,11 +111,13 @@ vtx_t resource_reader_hwloc_t::create_cluster_vertex (
 {
     // generate cluster root vertex
     const std::string subsys = "containment";
-    const std::map<std::string, std::string> properties;
+    const shared_map_t member_of = m.shared_maps.intern (
+                                       shared_map_t::map_t {{subsys, "*"}});
     vtx_t v = add_new_vertex (g, m, boost::
                               graph_traits<resource_graph_t>::
                               null_vertex (),
-                              0, subsys, "cluster", "cluster", properties, 1);
+                              0, subsys, "cluster", "cluster",
+                              member_of, shared_map_t (), 1);
     m.roots.emplace (subsys, v);
     m.v_rt_edges.emplace (subsys, relation_infra_t ());
 
@@ -81,7 +130,8 @@ vtx_t resource_reader_hwloc_t::add_new_vertex (resource_graph_t &g,
                                                const std::string &subsys,
                                                const std::string &type,
                                                const std::string &basename,
-                                               const std::map<std::string, std::string> &properties,
+                                               const shared_map_t &member_of,
+                                               const shared_map_t &properties,
                                                int size, int rank)
 {
     vtx_t v = boost::add_vertex (g);
@@ -96,7 +146,7 @@ vtx_t resource_reader_hwloc_t::add_new_vertex (resource_graph_t &g,
     g[v].type = type;
     g[v].basename = basename;
     g[v].size = size;
-    g[v].uniq_id = v;
+    g[v].uniq_id = m.next_uniq_id++;
     g[v].rank = rank;
     g[v].schedule.plans = planner_new (0, INT64_MAX, size, type.c_str ());
     g[v].idata.x_checker = planner_new (0, INT64_MAX,
@@ -104,15 +154,16 @@ vtx_t resource_reader_hwloc_t::add_new_vertex (resource_graph_t &g,
     g[v].id = id;
     g[v].name = basename + istr;
     g[v].paths[subsys] = prefix + "/" + g[v].name;
-    g[v].idata.member_of[subsys] = "*";
+    g[v].idata.member_of = member_of;
     g[v].status = resource_pool_t::status_t::UP;
     g[v].properties = properties;
 
     // Indexing for fast look-up
-    m.by_path[g[v].paths[subsys]] = v;
+    m.by_path.set (g[v].paths[subsys], v);
     m.by_type[g[v].type].push_back (v);
     m.by_name[g[v].name].push_back (v);
     m.by_rank[rank].push_back (v);
+    m.index_rank_root (g, v);
     return v;
 }
 
@@ -121,28 +172,8 @@ int resource_reader_hwloc_t::add_metadata (resource_graph_metadata_t &m,
                                            resource_graph_t &g)
 {
     // add this edge to by_outedges metadata
-    auto iter = m.by_outedges.find (src);
-    if (iter == m.by_outedges.end ()) {
-        auto ret = m.by_outedges.insert (
-                         std::make_pair (
-                             src,
-                             std::map<std::pair<uint64_t, int64_t>, edg_t,
-                                      std::greater<
-                                               std::pair<uint64_t,
-                                                         int64_t>>> ()));
-        if (!ret.second) {
-            errno = ENOMEM;
-            m_err_msg += "error creating out-edge metadata map: "
-                              + g[src].name + " -> " + g[tgt].name + "; ";
-            return -1;
-        }
-        iter = m.by_outedges.find (src);
-    }
-    std::pair<uint64_t, int64_t> key = std::make_pair (
-                                                g[e].idata.get_weight (),
-                                                g[tgt].uniq_id);
-    auto ret = iter->second.insert (std::make_pair (key, e));
-    if (!ret.second) {
+    if (!m.by_outedges[src].insert (g[e].idata.get_weight (),
+                                    g[tgt].uniq_id, e)) {
         errno = ENOMEM;
         m_err_msg += "error inserting an edge to out-edge metadata map: "
                           + g[src].name + " -> " + g[tgt].name + "; ";
@@ -151,11 +182,9 @@ int resource_reader_hwloc_t::add_metadata (resource_graph_metadata_t &m,
     return 0;
 }
 
-int resource_reader_hwloc_t::walk_hwloc (resource_graph_t &g,
-                                         resource_graph_metadata_t &m,
-                                         const hwloc_topology_t topo,
+int resource_reader_hwloc_t::walk_hwloc (const hwloc_topology_t topo,
                                          const hwloc_obj_t obj,
-                                         const vtx_t parent, int rank)
+                                         int parent, hwloc_subgraph_t &sub)
 {
     bool supported_resource = true;
     std::string type, basename;
@@ -288,22 +317,8 @@ int resource_reader_hwloc_t::walk_hwloc (resource_graph_t &g,
                 const char *delim = strchr (obj->name + 6, 'd');
                 id = atoi (delim + 1);
             }
-            if (namespace_remapper.is_remapped ()) {
-                uint64_t remap_id;
-                if (namespace_remapper.query (rank, "gpu", id, remap_id) < 0) {
-                    m_err_msg += "Error remapping gpu id="
-                                     + std::to_string (id) +"; ";
-                    rc = -1;
-                    break;
-                }
-                if (remap_id > std::numeric_limits<int>::max ()) {
-                    errno = EOVERFLOW;
-                    m_err_msg += "Remapped gpu id too large; ";
-                    rc = -1;
-                    break;
-                }
-                id = static_cast<int> (remap_id);
-            }
+            // Remapping depends on the rank and is left to graft so that
+            // the flattened topology can be shared by identical ranks.
             type = "gpu";
             basename = type;
             supported_resource = true;
@@ -315,14 +330,14 @@ int resource_reader_hwloc_t::walk_hwloc (resource_graph_t &g,
             const char* size_str = hwloc_obj_get_info_by_name (obj, "Size");
             if (size_str == NULL) {
                 errno = ENOENT;
-                m_err_msg += "Error getting the size of block storage device; ";
+                sub.err_msg += "Error getting the size of block storage device; ";
                 rc = -1;
                 break;
             }
             long int num_bytes = strtol (size_str, NULL, 10);
             if (num_bytes == 0 || num_bytes == LONG_MIN || num_bytes == LONG_MAX) {
                 // strtol sets errno to ERANGE
-                m_err_msg += "Error parsing the size of block storage device; ";
+                sub.err_msg += "Error parsing the size of block storage device; ";
                 rc = -1;
                 break;
             }
@@ -338,7 +353,7 @@ int resource_reader_hwloc_t::walk_hwloc (resource_graph_t &g,
             auto ret = properties.insert (std::pair<std::string, std::string>("LinuxDeviceID", devID_str));
             if (!ret.second) {
                 errno = EEXIST;
-                m_err_msg += "Error inserting LinuxDeviceID into properties map; ";
+                sub.err_msg += "Error inserting LinuxDeviceID into properties map; ";
                 rc = -1;
                 break;
             }
@@ -351,122 +366,197 @@ int resource_reader_hwloc_t::walk_hwloc (resource_graph_t &g,
     }
     }
 
-    // A valid ancestor vertex to pass to the recursive call
-    vtx_t valid_ancestor;
-    if (!supported_resource) {
-        valid_ancestor = parent;
-    } else {
-        const std::string subsys = "containment";
-        vtx_t v = add_new_vertex (g, m, parent,
-                                  id, subsys, type, basename,
-                                  properties, size, rank);
-        valid_ancestor = v;
-        std::string relation = "contains";
-        std::string rev_relation = "in";
-        edg_t e;
-        bool inserted; // set to false when we try and insert a parallel edge
-
-        tie (e, inserted) = add_edge (parent, v, g);
-        if (!inserted) {
-            errno = ENOMEM;
-            m_err_msg += "error inserting a new edge: "
-                            + g[parent].name + " -> " + g[v].name + "; ";
-            return -1;
-        }
-        g[e].idata.member_of[subsys] = relation;
-        g[e].name[subsys] = relation;
-        if (add_metadata (m, e, parent, v, g) < 0)
-            return -1;
-
-        tie (e, inserted) = add_edge (v, parent, g);
-        if (!inserted) {
-            errno = ENOMEM;
-            m_err_msg += "error inserting a new edge: "
-                            + g[v].name + " -> " + g[parent].name + "; ";
-            return -1;
-        }
-        g[e].idata.member_of[subsys] = rev_relation;
-        g[e].name[subsys] = rev_relation;
-        if (add_metadata (m, e, v, parent, g) < 0)
-            return -1;
+    // A valid ancestor to pass to the recursive call
+    int valid_ancestor = parent;
+    if (supported_resource) {
+        hwloc_vtx_t hv;
+        hv.parent = parent;
+        hv.id = id;
+        hv.size = size;
+        hv.type = type;
+        if (type == "node")
+            sub.hostnames.push_back (basename);
+        else
+            hv.basename = basename;
+        hv.properties = properties;
+        valid_ancestor = static_cast<int> (sub.vertices.size ());
+        sub.vertices.push_back (std::move (hv));
     }
 
     hwloc_obj_t curr_child = NULL;
     while ((curr_child = hwloc_get_next_child (topo, obj, curr_child)) != NULL) {
-        rc += walk_hwloc (g, m, topo, curr_child, valid_ancestor, rank);
+        rc += walk_hwloc (topo, curr_child, valid_ancestor, sub);
     }
 
     return rc;
 }
 
-int resource_reader_hwloc_t::unpack_internal (resource_graph_t &g,
-                                              resource_graph_metadata_t &m,
-                                              vtx_t &vtx,
-                                              const std::string &str, int rank)
+int resource_reader_hwloc_t::load_hwloc (const char *xml, size_t len,
+                                         hwloc_subgraph_t &sub)
 {
     int rc = -1;
-    size_t len = str.length ();
     hwloc_topology_t topo;
     hwloc_obj_t hwloc_root;
 
     if ( hwloc_topology_init (&topo) != 0 ) {
         errno = ENOMEM;
-        m_err_msg += "Error initializing hwloc topology; ";
+        sub.err_msg += "Error initializing hwloc topology; ";
         goto done;
     }
 #if HWLOC_API_VERSION < 0x20000
     if ( hwloc_topology_set_flags (topo, HWLOC_TOPOLOGY_FLAG_IO_DEVICES) != 0) {
         errno = EINVAL;
-        m_err_msg += "Error setting hwloc topology flag; ";
-        goto done;
+        sub.err_msg += "Error setting hwloc topology flag; ";
+        goto destroy;
     }
 #else
     if (hwloc_topology_set_io_types_filter (topo,
                                             HWLOC_TYPE_FILTER_KEEP_IMPORTANT)
         < 0) {
         errno = EINVAL;
-        m_err_msg += "hwloc_topology_set_io_types_filter; ";
-        goto done;
+        sub.err_msg += "hwloc_topology_set_io_types_filter; ";
+        goto destroy;
     }
     if (hwloc_topology_set_cache_types_filter (topo,
                                                HWLOC_TYPE_FILTER_KEEP_STRUCTURE)
         < 0) {
         errno = EINVAL;
-        m_err_msg += "hwloc_topology_set_cache_types_filter; ";
-        goto done;
+        sub.err_msg += "hwloc_topology_set_cache_types_filter; ";
+        goto destroy;
     }
     if (hwloc_topology_set_icache_types_filter (topo,
                                                 HWLOC_TYPE_FILTER_KEEP_STRUCTURE)
         < 0) {
         errno = EINVAL;
-        m_err_msg += "hwloc_topology_set_icache_types_filter; ";
-        goto done;
+        sub.err_msg += "hwloc_topology_set_icache_types_filter; ";
+        goto destroy;
     }
 #endif
-    if ( hwloc_topology_set_xmlbuffer (topo, str.c_str (), len) != 0) {
+    if ( hwloc_topology_set_xmlbuffer (topo, xml, len) != 0) {
         errno = EINVAL;
-        m_err_msg += "Error setting xmlbuffer; ";
-        goto done;
+        sub.err_msg += "Error setting xmlbuffer; ";
+        goto destroy;
     }
     if ( hwloc_topology_load (topo) != 0) {
-        hwloc_topology_destroy (topo);
-        m_err_msg += "Error hwloc load: rank " + std::to_string (rank) + "; ";
-        goto done;
+        sub.err_msg += "Error hwloc load: rank "
+                           + std::to_string (sub.rank) + "; ";
+        goto destroy;
     }
 
     hwloc_root = hwloc_get_root_obj (topo);
-    if ((rc = walk_hwloc (g, m, topo, hwloc_root, vtx, rank)) < 0) {
-        hwloc_topology_destroy (topo);
-        m_err_msg += "Error hwloc walk: rank " + std::to_string (rank) + "; ";
-        goto done;
+    if (walk_hwloc (topo, hwloc_root, -1, sub) < 0) {
+        sub.err_msg += "Error hwloc walk: rank "
+                           + std::to_string (sub.rank) + "; ";
+        goto destroy;
     }
-    hwloc_topology_destroy (topo);
     rc = 0;
 
+destroy:
+    hwloc_topology_destroy (topo);
 done:
+    sub.rc = rc;
+    sub.errnum = (rc < 0)? errno : 0;
     return rc;
 }
 
+int resource_reader_hwloc_t::remap_gpu_id (int rank, int id, int &remapped)
+{
+    uint64_t remap_id;
+    if (namespace_remapper.query (rank, "gpu", id, remap_id) < 0) {
+        m_err_msg += "Error remapping gpu id=" + std::to_string (id) +"; ";
+        return -1;
+    }
+    if (remap_id > std::numeric_limits<int>::max ()) {
+        errno = EOVERFLOW;
+        m_err_msg += "Remapped gpu id too large; ";
+        return -1;
+    }
+    remapped = static_cast<int> (remap_id);
+    return 0;
+}
+
+int resource_reader_hwloc_t::graft (resource_graph_t &g,
+                                    resource_graph_metadata_t &m,
+                                    vtx_t &vtx, const hwloc_subgraph_t &shape,
+                                    const std::vector<std::string> &hostnames,
+                                    int rank)
+{
+    const std::string subsys = "containment";
+    const std::string relation = "contains";
+    const std::string rev_relation = "in";
+    const bool remapped = namespace_remapper.is_remapped ();
+    // The maps of every vertex and edge come from the pool: only the
+    // vertices' scheduling state, names and paths are their own
+    const shared_map_t member_of = m.shared_maps.intern (
+                                       shared_map_t::map_t {{subsys, "*"}});
+    const shared_map_t contains = m.shared_maps.intern (
+                                      shared_map_t::map_t {{subsys, relation}});
+    const shared_map_t in = m.shared_maps.intern (
+                                shared_map_t::map_t {{subsys, rev_relation}});
+    std::vector<vtx_t> vtxs;
+
+    auto hostname = hostnames.begin ();
+
+    vtxs.reserve (shape.vertices.size ());
+    for (const hwloc_vtx_t &hv : shape.vertices) {
+        int id = hv.id;
+        if (remapped && hv.type == "gpu"
+            && remap_gpu_id (rank, hv.id, id) < 0)
+            return -1;
+        bool is_node = (hv.type == "node" && hostname != hostnames.end ());
+        vtx_t parent = (hv.parent == -1)? vtx : vtxs[hv.parent];
+        vtx_t v = add_new_vertex (g, m, parent,
+                                  id, subsys, hv.type,
+                                  is_node? *hostname++ : hv.basename,
+                                  member_of,
+                                  m.shared_maps.intern (hv.properties),
+                                  hv.size, rank);
+        vtxs.push_back (v);
+        edg_t e;
+        bool inserted; // set to false when we try and insert a parallel edge
+
+        tie (e, inserted) = add_edge (parent, v, g);
+        if (!inserted) {
+            errno = ENOMEM;
+            m_err_msg += "error inserting a new edge: "
+                            + g[parent].name + " -> " + g[v].name + "; ";
+            return -1;
+        }
+        g[e].idata.member_of = contains;
+        g[e].name = contains;
+        if (add_metadata (m, e, parent, v, g) < 0)
+            return -1;
+
+        tie (e, inserted) = add_edge (v, parent, g);
+        if (!inserted) {
+            errno = ENOMEM;
+            m_err_msg += "error inserting a new edge: "
+                            + g[v].name + " -> " + g[parent].name + "; ";
+            return -1;
+        }
+        g[e].idata.member_of = in;
+        g[e].name = in;
+        if (add_metadata (m, e, v, parent, g) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int resource_reader_hwloc_t::unpack_internal (resource_graph_t &g,
+                                              resource_graph_metadata_t &m,
+                                              vtx_t &vtx,
+                                              const std::string &str, int rank)
+{
+    hwloc_subgraph_t sub;
+
+    sub.rank = rank;
+    if (load_hwloc (str.c_str (), str.length (), sub) < 0) {
+        m_err_msg += sub.err_msg;
+        return -1;
+    }
+    return graft (g, m, vtx, sub, sub.hostnames, rank);
+}
+
 
 /********************************************************************************
  *                                                                              *
@@ -507,6 +597,143 @@ int resource_reader_hwloc_t::unpack_at (resource_graph_t &g,
     return unpack_internal (g, m, vtx, str, rank);
 }
 
+int resource_reader_hwloc_t::unpack_ranks_at (
+        resource_graph_t &g, resource_graph_metadata_t &m, vtx_t &vtx,
+        const std::vector<std::pair<int, const char *>> &xmls,
+        unsigned int nthreads)
+{
+    int rc = -1;
+    size_t i, nvertices = 0;
+    std::atomic<size_t> next (1);
+    std::mutex shapes_lock;
+    std::unordered_map<uint64_t, std::vector<size_t>> shapes;
+    std::vector<std::thread> workers;
+    std::vector<hwloc_subgraph_t> subs;
+    std::vector<size_t> sub_of;
+    std::vector<size_t> lens;
+
+    if (check_hwloc_version (m_err_msg) < 0)
+        return -1;
+    if (xmls.empty ())
+        return 0;
+
+    // Once walked, a topology that differs from an earlier one only
+    // in host name drops its vertices and grafts from that prototype,
+    // so memory held until the graft scales with the number of node
+    // shapes rather than the number of ranks.
+    auto dedup = [&] (size_t k) {
+        hwloc_subgraph_t &sub = subs[k];
+        uint64_t digest = shape_digest (sub.vertices);
+        std::lock_guard<std::mutex> guard (shapes_lock);
+        std::vector<size_t> &cands = shapes[digest];
+        for (size_t p : cands) {
+            if (subs[p].vertices == sub.vertices) {
+                sub.shape = p;
+                std::vector<hwloc_vtx_t> ().swap (sub.vertices);
+                return;
+            }
+        }
+        sub.shape = k;
+        cands.push_back (k);
+    };
+    auto load = [&] (size_t k) {
+        hwloc_subgraph_t &sub = subs[k];
+        try {
+            if (load_hwloc (xmls[sub.xml_index].second,
+                            lens[sub.xml_index], sub) == 0)
+                dedup (k);
+        } catch (std::bad_alloc &) {
+            sub.rc = -1;
+            sub.errnum = ENOMEM;
+            sub.err_msg = "Out of memory; ";
+        }
+    };
+    auto work = [&] () {
+        size_t k;
+        while ( (k = next.fetch_add (1)) < subs.size ())
+            load (k);
+    };
+
+    try {
+        // Ranks with byte-identical xml are loaded and walked only once
+        std::unordered_map<uint64_t, std::vector<size_t>> by_digest;
+        sub_of.resize (xmls.size ());
+        lens.resize (xmls.size ());
+        for (i = 0; i < xmls.size (); i++) {
+            const char *xml = xmls[i].second;
+            uint64_t digest = xml_digest (xml, lens[i]);
+            std::vector<size_t> &cands = by_digest[digest];
+            auto it = std::find_if (cands.begin (), cands.end (),
+                                    [&] (size_t p) {
+                size_t j = subs[p].xml_index;
+                return lens[j] == lens[i]
+                       && memcmp (xmls[j].second, xml, lens[i]) == 0;
+            });
+            if (it != cands.end ()) {
+                sub_of[i] = *it;
+                continue;
+            }
+            sub_of[i] = subs.size ();
+            cands.push_back (subs.size ());
+            subs.emplace_back ();
+            subs.back ().rank = xmls[i].first;
+            subs.back ().xml_index = i;
+        }
+
+        if (nthreads == 0)
+            nthreads = std::thread::hardware_concurrency ();
+        if (nthreads > subs.size ())
+            nthreads = subs.size ();
+
+        // Load the first topology on this thread before any worker starts
+        // so that hwloc and its XML parser initialize their global state
+        // without racing.
+        load (0);
+        for (i = 1; i < nthreads; i++)
+            workers.emplace_back (work);
+        work ();
+        for (auto &w : workers)
+            w.join ();
+        workers.clear ();
+    } catch (std::system_error &) {
+        // Fewer threads than asked for: the ones started, plus this
+        // thread, still pick up every remaining topology.
+        work ();
+        for (auto &w : workers)
+            w.join ();
+    } catch (std::bad_alloc &) {
+        errno = ENOMEM;
+        m_err_msg += "Out of memory; ";
+        for (auto &w : workers)
+            w.join ();
+        return -1;
+    }
+
+    for (auto &sub : subs) {
+        if (sub.rc < 0) {
+            errno = sub.errnum;
+            m_err_msg += sub.err_msg;
+            goto done;
+        }
+    }
+    for (i = 0; i < xmls.size (); i++)
+        nvertices += subs[subs[sub_of[i]].shape].vertices.size ();
+    g.m_vertices.reserve (g.m_vertices.size () + nvertices);
+
+    // Grafting into the shared graph is serial and in the given order,
+    // which keeps vertex ids deterministic regardless of thread timing.
+    for (i = 0; i < xmls.size (); i++) {
+        const hwloc_subgraph_t &sub = subs[sub_of[i]];
+        if ( (rc = graft (g, m, vtx, subs[sub.shape],
+                          sub.hostnames, xmls[i].first)) < 0)
+            goto done;
+    }
+    rc = 0;
+
+done:
+    return rc;
+}
+
 int resource_reader_hwloc_t::update (resource_graph_t &g,
                                      resource_graph_metadata_t &m,
                                      const std::string &str, int64_t jobid,
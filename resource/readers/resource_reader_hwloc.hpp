@@ -28,6 +28,8 @@
 extern "C" {
 #include <hwloc.h>
 }
+#include <vector>
+#include <utility>
 #include "resource/readers/resource_reader_base.hpp"
 
 namespace Flux {
@@ -70,6 +72,33 @@ public:
     virtual int unpack_at (resource_graph_t &g, resource_graph_metadata_t &m,
                            vtx_t &vtx, const std::string &str, int rank = -1);
 
+    /*! Unpack the hwloc xml of many ranks and graft the top-level
+     *  vertices of each to vtx. Each distinct xml string is loaded
+     *  and walked once, by up to nthreads threads, into a flattened
+     *  topology. Ranks whose topologies differ only in host name share
+     *  a single flattened prototype until they are grafted. The ranks
+     *  are then grafted one at a time in the order given, each with its
+     *  own vertices, planners and paths; their properties and subsystem
+     *  maps stay shared through m.shared_maps. The resulting graph is
+     *  identical to calling unpack_at on each rank in turn.
+     *
+     * \param g      resource graph
+     * \param m      resource graph meta data
+     * \param vtx    parent vtx at which to graft the deserialized graphs
+     * \param xmls   (rank, hwloc xml) pairs in graft order
+     * \param nthreads
+     *               maximum number of threads to use; 0 selects
+     *               the number of hardware threads
+     * \return       0 on success; non-zero integer on an error
+     *                   ENOMEM: out of memory
+     *                   EINVAL: invalid input or operation (e.g. malformed
+     *                               xml, hwloc version or operation error)
+     */
+    int unpack_ranks_at (resource_graph_t &g, resource_graph_metadata_t &m,
+                         vtx_t &vtx,
+                         const std::vector<std::pair<int, const char *>> &xmls,
+                         unsigned int nthreads = 0);
+
    /*! Update resource graph g with str.
      *
      * \param g      resource graph
@@ -94,6 +123,42 @@ public:
     virtual bool is_allowlist_supported ();
 
 private:
+    /*! A supported hwloc object, flattened out of its topology
+     *  so that it can be created before the graph is touched.
+     *  The basename of a node is its host name, which is kept per
+     *  rank instead so that identical nodes flatten identically.
+     */
+    struct hwloc_vtx_t {
+        int parent;       // index of the parent; -1 for the graft point
+        int id;
+        unsigned int size;
+        std::string type;
+        std::string basename;
+        shared_map_t properties;
+
+        bool operator== (const hwloc_vtx_t &o) const;
+    };
+
+    /*! Supported objects of one topology in the preorder walk_hwloc
+     *  visits them, along with the outcome of the load and walk.
+     *  When many ranks share a node shape, only one of them keeps
+     *  the vertices as the prototype; the others point at it through
+     *  shape and keep just their host names. The graft gives every
+     *  rank its own vertices with their own scheduling state, names
+     *  and paths, but their properties and the subsystem maps of them
+     *  and of their edges are shared through the graph's map pool.
+     */
+    struct hwloc_subgraph_t {
+        int rank = -1;
+        size_t xml_index = 0;
+        size_t shape = 0;
+        int rc = 0;
+        int errnum = 0;
+        std::string err_msg;
+        std::vector<std::string> hostnames;
+        std::vector<hwloc_vtx_t> vertices;
+    };
+
     int check_hwloc_version (std::string &m_err_msg);
     vtx_t create_cluster_vertex (resource_graph_t &g,
                                  resource_graph_metadata_t &m);
@@ -101,13 +166,19 @@ private:
                           const vtx_t &parent, int id,
                           const std::string &subsys, const std::string &type,
                           const std::string &basename,
-                          const std::map<std::string, std::string> &properties,
+                          const shared_map_t &member_of,
+                          const shared_map_t &properties,
                           int size, int rank = -1);
     int add_metadata (resource_graph_metadata_t &m,
                       edg_t e, vtx_t src, vtx_t tgt, resource_graph_t &g);
-    int walk_hwloc (resource_graph_t &g, resource_graph_metadata_t &m,
-                    const hwloc_topology_t topo, const hwloc_obj_t obj,
-                    const vtx_t parent, int rank);
+    int walk_hwloc (const hwloc_topology_t topo, const hwloc_obj_t obj,
+                    int parent, hwloc_subgraph_t &sub);
+    int load_hwloc (const char *xml, size_t len, hwloc_subgraph_t &sub);
+    static uint64_t shape_digest (const std::vector<hwloc_vtx_t> &vertices);
+    int remap_gpu_id (int rank, int id, int &remapped);
+    int graft (resource_graph_t &g, resource_graph_metadata_t &m,
+               vtx_t &vtx, const hwloc_subgraph_t &shape,
+               const std::vector<std::string> &hostnames, int rank);
     int unpack_internal (resource_graph_t &g, resource_graph_metadata_t &m,
                          vtx_t &vtx, const std::string &str, int rank = -1);
 };
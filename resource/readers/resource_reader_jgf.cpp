@@ -186,7 +186,7 @@ bool operator== (const resource_pool_t &r, const fetch_helper_t &f)
             && r.rank == static_cast<int> (f.rank)
             && r.id == f.id
             && r.name == f.name
-            && r.properties == f.properties
+            && r.properties.get () == f.properties
             && r.paths == f.paths);
 }
 
@@ -208,7 +208,7 @@ std::string diff (const resource_pool_t &r, const fetch_helper_t &f)
         sstream << " id=(" << r.id << ", " << f.id << ")";
     if (r.name != f.name)
         sstream << " name=(" << r.name << ", " << f.name << ")";
-    if (r.properties != f.properties) {
+    if (r.properties.get () != f.properties) {
         sstream << " properties=(";
         for (auto &kv : r.properties)
             sstream << kv.first << "=" << kv.second << " ";
@@ -471,11 +471,11 @@ vtx_t resource_reader_jgf_t::vtx_in_graph (const resource_graph_metadata_t &m,
                                            const std::map<std::string, 
                                                           std::string> &paths)
 {
-    std::map<std::string, vtx_t>::const_iterator bp_it;
+    vtx_t v = boost::graph_traits<resource_graph_t>::null_vertex ();
     for (auto const &paths_it : paths) {
-        bp_it = m.by_path.find (paths_it.second);
-        if (bp_it != m.by_path.end ()) {
-            return bp_it->second;
+        v = m.by_path.find (paths_it.second);
+        if (v != boost::graph_traits<resource_graph_t>::null_vertex ()) {
+            return v;
         }
     }
 
@@ -524,11 +524,12 @@ int resource_reader_jgf_t::add_graph_metadata (vtx_t v,
                 goto done;
             }
         }
-        m.by_path[kv.second] = v;
+        m.by_path.set (kv.second, v);
     }
     m.by_type[g[v].type].push_back (v);
     m.by_name[g[v].name].push_back (v);
     m.by_rank[g[v].rank].push_back (v);
+    m.index_rank_root (g, v);
     rc = 0;
 
 done:
@@ -580,6 +581,13 @@ int resource_reader_jgf_t::add_vtx (resource_graph_t &g,
     }
     if ( (v = create_vtx (g, fetcher)) == nullvtx)
         goto done;
+    // Vertices of the same node shape share their properties
+    // and subsystem membership
+    g[v].properties = m.shared_maps.intern (g[v].properties);
+    g[v].idata.member_of = m.shared_maps.intern (g[v].idata.member_of);
+    // Keep the uniq_ids the other readers hand out from clashing
+    if (fetcher.uniq_id >= m.next_uniq_id)
+        m.next_uniq_id = fetcher.uniq_id + 1;
     if ( (rc = check_root (v, g, root_checks)) == -1)
         goto done;
     if ( (rc = add_graph_metadata (v, g, m)) == -1)
@@ -914,33 +922,13 @@ int resource_reader_jgf_t::unpack_edges (resource_graph_t &g,
             json_object_foreach (name, key, value) {
                 g[e].name[std::string (key)]
                     = std::string (json_string_value (value));
-                g[e].idata.member_of[std::string (key)]
-                    = std::string (json_string_value (value));
             }
+            g[e].name = m.shared_maps.intern (g[e].name);
+            g[e].idata.member_of = g[e].name;
             // add this edge to by_outedges metadata
-            auto iter = m.by_outedges.find (vmap[source].v);
-            if (iter == m.by_outedges.end ()) {
-                auto ret = m.by_outedges.insert (
-                               std::make_pair (
-                                   vmap[source].v,
-                                   std::map<std::pair<uint64_t, int64_t>, edg_t,
-                                            std::greater<
-                                                     std::pair<uint64_t,
-                                                               int64_t>>> ()));
-                if (!ret.second) {
-                    errno = ENOMEM;
-                    m_err_msg += "error creating out-edge metadata map: "
-                                      + g[vmap[source].v].name + " -> "
-                                      + g[vmap[target].v].name + "; ";
-                    goto done;
-                }
-                iter = m.by_outedges.find (vmap[source].v);
-            }
-            std::pair<uint64_t, int64_t> key = std::make_pair (
-                                                   g[e].idata.get_weight (),
-                                                   g[vmap[target].v].uniq_id);
-            auto ret = iter->second.insert (std::make_pair (key, e));
-            if (!ret.second) {
+            if (!m.by_outedges[vmap[source].v].insert (
+                     g[e].idata.get_weight (),
+                     g[vmap[target].v].uniq_id, e)) {
                 errno = ENOMEM;
                 m_err_msg += "error inserting an edge to outedge metadata map: "
                              + g[vmap[source].v].name + " -> "
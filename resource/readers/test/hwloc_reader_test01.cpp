@@ -0,0 +1,320 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Unit tests for resource_reader_hwloc_t::unpack_ranks_at: the graph it
+ * grafts from many ranks must be identical to calling unpack_at on each
+ * rank in turn, whether the ranks share one node shape, differ only in
+ * host name or differ in shape. Also checks that the vertices and edges
+ * of all ranks share their subsystem maps, and that the uniq_ids of the
+ * vertices it creates are not reused once the graph has been compacted.
+ * The hwloc xml is exported from synthetic topologies so that no test
+ * data is needed.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+extern "C" {
+#include <hwloc.h>
+}
+
+#include <set>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include "resource/store/resource_graph_store.hpp"
+#include "resource/readers/resource_reader_hwloc.hpp"
+#include "src/common/libtap/tap.h"
+
+using namespace Flux::resource_model;
+
+/*! Export a synthetic topology named host as hwloc xml.
+ */
+static std::string synthetic_xml (const char *desc, const char *host)
+{
+    std::string xml = "";
+    hwloc_topology_t topo;
+    char *buf = NULL;
+    int len = 0;
+
+    if (hwloc_topology_init (&topo) < 0)
+        return xml;
+    if (hwloc_topology_set_synthetic (topo, desc) < 0
+        || hwloc_topology_load (topo) < 0)
+        goto done;
+    hwloc_obj_add_info (hwloc_get_root_obj (topo), "HostName", host);
+#if HWLOC_API_VERSION < 0x00020000
+    if (hwloc_topology_export_xmlbuffer (topo, &buf, &len) < 0)
+        goto done;
+#else
+    if (hwloc_topology_export_xmlbuffer (topo, &buf, &len, 0) < 0)
+        goto done;
+#endif
+    xml = buf;
+    hwloc_free_xmlbuffer (topo, buf);
+done:
+    hwloc_topology_destroy (topo);
+    return xml;
+}
+
+struct graph_t {
+    resource_graph_t g;
+    resource_graph_metadata_t m;
+    vtx_t root;
+    resource_reader_hwloc_t reader;
+
+    graph_t ()
+    {
+        reader.unpack (g, m, "");
+        root = m.roots["containment"];
+    }
+};
+
+static std::string vertex_str (const resource_graph_t &g, vtx_t v)
+{
+    std::string s = g[v].type + " " + g[v].name + " "
+                    + std::to_string (g[v].id) + " "
+                    + std::to_string (g[v].rank) + " "
+                    + std::to_string (g[v].size) + " "
+                    + g[v].paths.at ("containment");
+    for (auto &kv : g[v].properties)
+        s += " " + kv.first + "=" + kv.second;
+    return s;
+}
+
+/*! Vertices with their ids and edges in order: two graphs are equal
+ *  only if they were grafted in the same order.
+ */
+static std::vector<std::string> dump (const resource_graph_t &g)
+{
+    std::vector<std::string> out;
+    boost::graph_traits<resource_graph_t>::vertex_iterator vi, ve;
+    boost::graph_traits<resource_graph_t>::out_edge_iterator ei, ee;
+
+    for (boost::tie (vi, ve) = vertices (g); vi != ve; ++vi) {
+        out.push_back (std::to_string (*vi) + " " + vertex_str (g, *vi));
+        for (boost::tie (ei, ee) = out_edges (*vi, g); ei != ee; ++ei)
+            out.push_back ("  -> " + std::to_string (target (*ei, g)) + " "
+                           + g[*ei].name.at ("containment"));
+    }
+    return out;
+}
+
+static bool same_as_serial (
+                const std::vector<std::pair<int, std::string>> &ranks,
+                unsigned int nthreads, graph_t &par)
+{
+    graph_t ser;
+    std::vector<std::pair<int, const char *>> xmls;
+
+    for (auto &r : ranks) {
+        if (ser.reader.unpack_at (ser.g, ser.m, ser.root, r.second,
+                                  r.first) < 0)
+            return false;
+        xmls.push_back (std::make_pair (r.first, r.second.c_str ()));
+    }
+    if (par.reader.unpack_ranks_at (par.g, par.m, par.root, xmls,
+                                    nthreads) < 0)
+        return false;
+    return dump (ser.g) == dump (par.g);
+}
+
+static size_t count (graph_t &gr, int rank, const std::string &type)
+{
+    size_t n = 0;
+    for (vtx_t v : gr.m.by_rank[rank])
+        if (gr.g[v].type == type)
+            n++;
+    return n;
+}
+
+static std::set<std::string> hosts (const resource_graph_metadata_t &m)
+{
+    std::set<std::string> h;
+    for (auto &kv : m.by_name)
+        if (kv.first.compare (0, 4, "node") == 0 || kv.first[0] == 'x')
+            h.insert (kv.first);
+    return h;
+}
+
+static void test_identical_shapes ()
+{
+    graph_t par;
+    std::vector<std::pair<int, std::string>> ranks;
+    std::string xml = synthetic_xml ("package:2 core:4 pu:2", "node0");
+
+    ok (!xml.empty (), "export a synthetic topology");
+    // Byte-identical xml: every rank shares one load and one walk
+    for (int rank = 0; rank < 8; rank++)
+        ranks.push_back (std::make_pair (rank, xml));
+    ok (same_as_serial (ranks, 4, par),
+        "identical xml grafts the same graph as unpack_at");
+    ok (par.m.by_type["node"].size () == 8
+        && par.m.by_type["pu"].size () == 8 * 16,
+        "each rank gets its own vertices");
+    ok (count (par, 0, "core") == 8 && count (par, 7, "core") == 8
+        && par.m.by_rank[7].size () == par.m.by_rank[0].size (),
+        "each rank is indexed on its own");
+}
+
+static void test_hostnames ()
+{
+    graph_t par;
+    std::vector<std::pair<int, std::string>> ranks;
+    std::set<std::string> expected;
+
+    // Same shape, different host names: one prototype, per-rank names
+    for (int rank = 0; rank < 6; rank++) {
+        std::string host = "node" + std::to_string (rank);
+        ranks.push_back (std::make_pair (rank, synthetic_xml ("core:4 pu:1",
+                                                        host.c_str ())));
+        expected.insert (host);
+    }
+    ok (same_as_serial (ranks, 3, par),
+        "ranks differing in host name graft as unpack_at does");
+    ok (hosts (par.m) == expected, "each node keeps its own host name");
+    vtx_t pu = par.m.by_path.find ("/cluster0/node5/core3/pu3");
+    ok (pu != boost::graph_traits<resource_graph_t>::null_vertex ()
+        && par.g[pu].rank == 5,
+        "paths are built under each rank's own host name");
+}
+
+static void test_different_shapes ()
+{
+    graph_t par;
+    std::vector<std::pair<int, std::string>> ranks;
+
+    // Two shapes interleaved: each keeps its own prototype
+    for (int rank = 0; rank < 6; rank++) {
+        std::string host = "x" + std::to_string (rank);
+        const char *desc = (rank % 2)? "package:1 core:2 pu:1"
+                                     : "package:2 core:3 pu:1";
+        ranks.push_back (std::make_pair (rank, synthetic_xml (desc,
+                                                        host.c_str ())));
+    }
+    ok (same_as_serial (ranks, 0, par),
+        "different shapes graft as unpack_at does");
+    ok (count (par, 0, "socket") == 2 && count (par, 0, "core") == 6
+        && count (par, 1, "socket") == 1 && count (par, 1, "core") == 2,
+        "each rank gets the vertices of its own shape");
+    ok (par.m.by_type["core"].size () == 3 * 6 + 3 * 2,
+        "shapes are not mixed up");
+}
+
+static void test_shared_maps ()
+{
+    graph_t par;
+    std::vector<std::pair<int, std::string>> ranks;
+    boost::graph_traits<resource_graph_t>::edge_iterator ei, ee;
+    bool edges_share = true;
+
+    for (int rank = 0; rank < 4; rank++) {
+        std::string host = "node" + std::to_string (rank);
+        ranks.push_back (std::make_pair (rank, synthetic_xml ("core:2 pu:1",
+                                                        host.c_str ())));
+    }
+    ok (same_as_serial (ranks, 2, par),
+        "ranks sharing maps graft as unpack_at does");
+    vtx_t a = par.m.by_path.find ("/cluster0/node0/core1/pu1");
+    vtx_t b = par.m.by_path.find ("/cluster0/node3/core0/pu0");
+    ok (par.g[a].idata.member_of.shares (par.g[b].idata.member_of)
+        && par.g[a].idata.member_of.shares (
+               par.g[par.root].idata.member_of),
+        "vertices of all ranks share their subsystem map");
+    for (boost::tie (ei, ee) = edges (par.g); ei != ee; ++ei)
+        edges_share = edges_share
+                      && par.g[*ei].name.shares (par.g[*ei].idata.member_of);
+    ok (edges_share && par.m.shared_maps.size () == 3,
+        "edges share their relation maps");
+    par.g[a].idata.member_of["power"] = "*";
+    ok (par.g[a].idata.member_of.size () == 2
+        && par.g[b].idata.member_of.size () == 1
+        && par.g[b].idata.member_of.at ("containment") == "*",
+        "writing to a shared map leaves the other vertices alone");
+}
+
+static void test_errors ()
+{
+    graph_t par;
+    std::vector<std::pair<int, const char *>> xmls;
+    std::string xml = synthetic_xml ("core:2 pu:1", "node0");
+    size_t n = num_vertices (par.g);
+
+    ok (par.reader.unpack_ranks_at (par.g, par.m, par.root, xmls) == 0
+        && num_vertices (par.g) == n, "no ranks is a no-op");
+    xmls.push_back (std::make_pair (0, xml.c_str ()));
+    xmls.push_back (std::make_pair (1, "<topology>"));
+    ok (par.reader.unpack_ranks_at (par.g, par.m, par.root, xmls, 2) < 0
+        && num_vertices (par.g) == n,
+        "a malformed rank fails without grafting any rank");
+}
+
+static void test_uniq_ids_after_compact ()
+{
+    resource_graph_db_t db;
+    std::shared_ptr<resource_reader_base_t> rd
+        = std::make_shared<resource_reader_hwloc_t> ();
+    std::string xml = synthetic_xml ("core:4 pu:1", "node0");
+    std::set<int64_t> ids;
+    boost::graph_traits<resource_graph_t>::vertex_iterator vi, ve;
+    vtx_t root;
+    int rc = db.load ("", rd);
+
+    root = db.metadata.roots["containment"];
+    for (int rank = 0; rank < 4; rank++)
+        rc += db.load (xml, rd, root, rank);
+    ok (rc == 0 && db.detach ({0, 1}) == 0 && db.compact () == 0
+        && db.holes () == 0, "detach and compact two of four ranks");
+    // The new vertices take the slots freed by compact (), but not
+    // the uniq_ids of the vertices that used to sit there
+    ok (db.load (xml, rd, root, 4) == 0 && db.load (xml, rd, root, 5) == 0,
+        "ranks grafted after compact () get out-edges of their own");
+    for (boost::tie (vi, ve) = vertices (db.resource_graph); vi != ve; ++vi)
+        ids.insert (db.resource_graph[*vi].uniq_id);
+    ok (ids.size () == num_vertices (db.resource_graph),
+        "uniq_ids are unique after compact ()");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (19);
+
+    test_identical_shapes ();
+    test_hostnames ();
+    test_different_shapes ();
+    test_shared_maps ();
+    test_errors ();
+    test_uniq_ids_after_compact ();
+
+    done_testing ();
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,226 @@
+/*****************************************************************************\
+ *  Copyright (c) 2020 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Microbenchmark for resource_namespace_remapper_t. A nested instance
+ * is carved out of a parent whose nodes look like the sierra2 nodes
+ * of t1016-nest-namespace.t (44 cores, 4 gpus): every parent rank range
+ * of R_lite maps onto a 0-based range of the nested instance, and half
+ * of each node's cores and gpus are remapped to 0-based ids, the way
+ * remap_jgf_namespace and remap_hwloc_namespace populate the remapper.
+ * The test then performs the per-vertex lookups unpack_and_remap_vtx
+ * does and checks each against a reference built from nested std::maps.
+ *
+ * Usage: remapper_bench01 [NRANKS [NREPS]]
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+#include <chrono>
+#include <string>
+#include <cerrno>
+#include <cstdlib>
+#include "resource/readers/resource_namespace_remapper.hpp"
+#include "src/common/libtap/tap.h"
+
+using namespace Flux::resource_model;
+
+typedef std::map<distinct_range_t,
+                 std::map<std::string,
+                          std::map<uint64_t, uint64_t>>> ref_remap_t;
+
+static const uint64_t NCORES = 44;
+static const uint64_t NGPUS = 4;
+
+static int populate (uint64_t nranks,
+                     resource_namespace_remapper_t &remapper,
+                     ref_remap_t &ref)
+{
+    uint64_t k, j, p_rank = 0, rank = 0;
+
+    for (k = 0; p_rank < nranks; k++) {
+        uint64_t len = (k % 4) + 1;
+        uint64_t high = std::min (p_rank + len, nranks) - 1;
+        uint64_t core_off = (k * 11) % (NCORES / 2);
+        uint64_t gpu_off = (k % 2) * (NGPUS / 2);
+        std::string range = std::to_string (p_rank);
+        distinct_range_t key{p_rank, high};
+
+        if (high > p_rank)
+            range += "-" + std::to_string (high);
+        if (remapper.add_exec_target_range (
+                range, distinct_range_t{rank, rank + high - p_rank}) < 0)
+            return -1;
+        for (j = p_rank; j <= high; j++)
+            ref[key]["exec-target"][j] = rank + j - p_rank;
+        for (j = 0; j < NCORES / 2; j++) {
+            if (remapper.add (range, "core", j + core_off, j) < 0)
+                return -1;
+            ref[key]["core"][j + core_off] = j;
+        }
+        for (j = 0; j < NGPUS / 2; j++) {
+            if (remapper.add (range, "gpu", j + gpu_off, j) < 0)
+                return -1;
+            ref[key]["gpu"][j + gpu_off] = j;
+        }
+        rank += high - p_rank + 1;
+        // Leave a one-rank hole, so ranges are not contiguous
+        p_rank = high + 2;
+    }
+    return 0;
+}
+
+static uint64_t ref_query (const ref_remap_t &ref, uint64_t exec_target,
+                           const std::string &type, uint64_t id, bool &found)
+{
+    auto r = ref.find (distinct_range_t{exec_target});
+    found = false;
+    if (r == ref.end ())
+        return 0;
+    auto t = r->second.find (type);
+    if (t == r->second.end ())
+        return 0;
+    auto i = t->second.find (id);
+    if (i == t->second.end ())
+        return 0;
+    found = true;
+    return i->second;
+}
+
+/*! Look up every (rank, type, id) a JGF of the parent could carry;
+ *  return the number of answers that disagree with the reference.
+ */
+static uint64_t run_lookups (uint64_t nranks,
+                             const resource_namespace_remapper_t &remapper,
+                             const ref_remap_t &ref, bool check,
+                             uint64_t &hits)
+{
+    uint64_t rank, id, out, bad = 0;
+    bool found;
+    int rc;
+
+    hits = 0;
+    for (rank = 0; rank < nranks; rank++) {
+        rc = remapper.query_exec_target (rank, out);
+        hits += (rc == 0);
+        if (check) {
+            uint64_t expected = ref_query (ref, rank, "exec-target",
+                                           rank, found);
+            if ((rc == 0) != found || (rc == 0 && out != expected))
+                bad++;
+        }
+        for (id = 0; id < NCORES + NGPUS; id++) {
+            const char *type = (id < NCORES)? "core" : "gpu";
+            uint64_t tid = (id < NCORES)? id : id - NCORES;
+            rc = remapper.query (rank, type, tid, out);
+            hits += (rc == 0);
+            if (!check)
+                continue;
+            uint64_t expected = ref_query (ref, rank, type, tid, found);
+            if ((rc == 0) != found || (rc == 0 && out != expected)
+                || (rc < 0 && errno != ENOENT))
+                bad++;
+        }
+    }
+    return bad;
+}
+
+static uint64_t run_ref_lookups (uint64_t nranks, const ref_remap_t &ref)
+{
+    uint64_t rank, id, hits = 0;
+    bool found;
+
+    for (rank = 0; rank < nranks; rank++) {
+        ref_query (ref, rank, "exec-target", rank, found);
+        hits += found;
+        for (id = 0; id < NCORES + NGPUS; id++) {
+            if (id < NCORES)
+                ref_query (ref, rank, "core", id, found);
+            else
+                ref_query (ref, rank, "gpu", id - NCORES, found);
+            hits += found;
+        }
+    }
+    return hits;
+}
+
+static double elapsed (std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> d = std::chrono::steady_clock::now ()
+                                      - start;
+    return d.count ();
+}
+
+int main (int argc, char *argv[])
+{
+    uint64_t i, hits, ref_hits = 0, bad;
+    uint64_t nranks = (argc > 1)? strtoull (argv[1], NULL, 10) : 4096;
+    uint64_t nreps = (argc > 2)? strtoull (argv[2], NULL, 10) : 20;
+    resource_namespace_remapper_t remapper;
+    ref_remap_t ref;
+    double t_remap, t_ref;
+    uint64_t out;
+
+    plan (6);
+
+    auto start = std::chrono::steady_clock::now ();
+    ok (populate (nranks, remapper, ref) == 0, "populate %ju ranks",
+        (uintmax_t)nranks);
+    diag ("populate: %.6f s", elapsed (start));
+
+    bad = run_lookups (nranks, remapper, ref, true, hits);
+    ok (bad == 0 && hits > 0, "all %ju lookups agree with reference",
+        (uintmax_t)(nranks * (1 + NCORES + NGPUS)));
+
+    ok (remapper.add ("3", "core", 100, 0) < 0 && errno == EINVAL,
+        "adding a rule to an overlapping range fails with EINVAL");
+    ok (remapper.add ("0", "core", 0, 1) < 0 && errno == EEXIST,
+        "adding an existing rule fails with EEXIST");
+    ok (remapper.query (nranks + 1, "core", 0, out) < 0 && errno == ENOENT,
+        "querying an unmapped rank fails with ENOENT");
+
+    start = std::chrono::steady_clock::now ();
+    for (i = 0; i < nreps; i++)
+        run_lookups (nranks, remapper, ref, false, hits);
+    t_remap = elapsed (start);
+    start = std::chrono::steady_clock::now ();
+    for (i = 0; i < nreps; i++)
+        ref_hits = run_ref_lookups (nranks, ref);
+    t_ref = elapsed (start);
+    ok (hits == ref_hits, "timed lookups return %ju hits", (uintmax_t)hits);
+    diag ("%ju lookups x %ju: remapper %.6f s, nested maps %.6f s",
+          (uintmax_t)(nranks * (1 + NCORES + NGPUS)), (uintmax_t)nreps,
+          t_remap, t_ref);
+
+    done_testing ();
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
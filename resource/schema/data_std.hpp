@@ -23,8 +23,10 @@
 #ifndef DATA_STD_H
 #define DATA_STD_H
 
+#include <map>
 #include <set>
 #include <string>
+#include "resource/schema/shared_map.hpp"
 
 namespace Flux {
 namespace resource_model {
@@ -38,7 +40,7 @@ const char * const X_CHECKER_JOBS_STR = "jobs";
 const int64_t X_CHECKER_NJOBS = 0x40000000;
 
 using subsystem_t = std::string;
-using multi_subsystems_t = std::map<subsystem_t, std::string>;
+using multi_subsystems_t = shared_map_t;
 using multi_subsystemsS = std::map<subsystem_t, std::set<std::string>>;
 
 } // Flux
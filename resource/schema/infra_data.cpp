@@ -49,12 +49,49 @@ infra_base_t &infra_base_t::operator= (const infra_base_t &o)
     return *this;
 }
 
+infra_base_t::infra_base_t (infra_base_t &&o) noexcept
+{
+    member_of = std::move (o.member_of);
+}
+
+infra_base_t &infra_base_t::operator= (infra_base_t &&o) noexcept
+{
+    member_of = std::move (o.member_of);
+    return *this;
+}
+
 infra_base_t::~infra_base_t ()
 {
 
 }
 
 
+/****************************************************************************
+ *                                                                          *
+ *             Public Methods on Vertex Availability Probe                  *
+ *                                                                          *
+ ****************************************************************************/
+
+bool avail_probe_t::is_for (uint64_t t, int64_t a, uint64_t d) const
+{
+    return token == t && at == a && duration == d;
+}
+
+void avail_probe_t::reset (uint64_t t, int64_t a, uint64_t d)
+{
+    token = t;
+    at = a;
+    duration = d;
+    avail = -1;
+    njobs = -1;
+}
+
+void avail_probe_t::invalidate ()
+{
+    reset (0, -1, 0);
+}
+
+
 /****************************************************************************
  *                                                                          *
  *        Public Methods on Infrastructure Data for Resource Pool           *
@@ -121,6 +158,45 @@ pool_infra_t &pool_infra_t::operator= (const pool_infra_t &o)
                                  planner_resource_total (o.x_checker),
                                  planner_resource_type (o.x_checker));
     }
+    probe.invalidate ();
+    return *this;
+}
+
+pool_infra_t::pool_infra_t (pool_infra_t &&o) noexcept
+    : infra_base_t (std::move (o))
+{
+    // take over the infrastructure tables and subtree planner objects.
+    tags = std::move (o.tags);
+    x_spans = std::move (o.x_spans);
+    job2span = std::move (o.job2span);
+    x_checker = o.x_checker;
+    o.x_checker = NULL;
+    subplans = std::move (o.subplans);
+    o.subplans.clear ();
+    colors = std::move (o.colors);
+    ephemeral = std::move (o.ephemeral);
+    probe = o.probe;
+}
+
+pool_infra_t &pool_infra_t::operator= (pool_infra_t &&o) noexcept
+{
+    if (this != &o) {
+        infra_base_t::operator= (std::move (o));
+        for (auto &kv : subplans)
+            planner_multi_destroy (&(kv.second));
+        if (x_checker)
+            planner_destroy (&x_checker);
+        tags = std::move (o.tags);
+        x_spans = std::move (o.x_spans);
+        job2span = std::move (o.job2span);
+        x_checker = o.x_checker;
+        o.x_checker = NULL;
+        subplans = std::move (o.subplans);
+        o.subplans.clear ();
+        colors = std::move (o.colors);
+        ephemeral = std::move (o.ephemeral);
+        probe = o.probe;
+    }
     return *this;
 }
 
@@ -143,6 +219,7 @@ void pool_infra_t::scrub ()
     if (x_checker)
         planner_destroy (&x_checker);
     ephemeral.clear ();
+    probe.invalidate ();
 }
 
 
@@ -161,6 +238,7 @@ relation_infra_t::relation_infra_t (const relation_infra_t &o): infra_base_t (o)
 {
     m_needs = o.m_needs;
     m_trav_token = o.m_trav_token;
+    m_ordinal = o.m_ordinal;
     m_exclusive = o.m_exclusive;
 }
 
@@ -169,6 +247,7 @@ relation_infra_t &relation_infra_t::operator= (const relation_infra_t &o)
     infra_base_t::operator= (o);
     m_needs = o.m_needs;
     m_trav_token = o.m_trav_token;
+    m_ordinal = o.m_ordinal;
     m_exclusive = o.m_exclusive;
     return *this;
 }
@@ -218,6 +297,16 @@ void relation_infra_t::set_weight (uint64_t weight)
     m_weight = weight;
 }
 
+uint64_t relation_infra_t::get_ordinal () const
+{
+    return m_ordinal;
+}
+
+void relation_infra_t::set_ordinal (uint64_t ordinal)
+{
+    m_ordinal = ordinal;
+}
+
 } // resource_model
 } // Flux
 
@@ -40,16 +40,37 @@ struct infra_base_t {
     infra_base_t ();
     infra_base_t (const infra_base_t &o);
     infra_base_t &operator= (const infra_base_t &o);
+    infra_base_t (infra_base_t &&o) noexcept;
+    infra_base_t &operator= (infra_base_t &&o) noexcept;
     virtual ~infra_base_t ();
     virtual void scrub () = 0;
 
     multi_subsystems_t member_of;
 };
 
+/*! Availability of a vertex over the window [at, at+duration) as probed
+ *  by one traversal, identified by its traversal token. Each count is
+ *  -1 until the traversal first asks for it; a probe carrying another
+ *  token or window is stale.
+ */
+struct avail_probe_t {
+    bool is_for (uint64_t t, int64_t a, uint64_t d) const;
+    void reset (uint64_t t, int64_t a, uint64_t d);
+    void invalidate ();
+
+    uint64_t token = 0;
+    int64_t at = -1;
+    uint64_t duration = 0;
+    int64_t avail = -1;          // available units in schedule.plans
+    int64_t njobs = -1;          // available jobs in x_checker
+};
+
 struct pool_infra_t : public infra_base_t {
     pool_infra_t ();
     pool_infra_t (const pool_infra_t &o);
     pool_infra_t &operator= (const pool_infra_t &o);
+    pool_infra_t (pool_infra_t &&o) noexcept;
+    pool_infra_t &operator= (pool_infra_t &&o) noexcept;
     virtual ~pool_infra_t ();
     virtual void scrub ();
 
@@ -60,6 +81,7 @@ struct pool_infra_t : public infra_base_t {
     std::map<subsystem_t, planner_multi_t *> subplans;
     std::map<subsystem_t, uint64_t> colors;
     ephemeral_t ephemeral;
+    avail_probe_t probe;
 };
 
 class relation_infra_t : public infra_base_t {
@@ -79,10 +101,18 @@ public:
     uint64_t get_weight () const;
     void set_weight (uint64_t);
 
+    /*! Position of this edge among the out-edges of its source vertex,
+     *  1-based; 0 until the traverser assigns one. Only the relative
+     *  order among the edges of the same source is meaningful.
+     */
+    uint64_t get_ordinal () const;
+    void set_ordinal (uint64_t ordinal);
+
 private:
     uint64_t m_needs = 0;
     uint64_t m_trav_token = 0;
     uint64_t m_weight = std::numeric_limits<uint64_t>::max ();
+    uint64_t m_ordinal = 0;
     int m_exclusive = 0;
 };
 
@@ -70,6 +70,40 @@ resource_pool_t &resource_pool_t::operator= (const resource_pool_t &o)
     return *this;
 }
 
+resource_pool_t::resource_pool_t (resource_pool_t &&o) noexcept
+    : schedule (std::move (o.schedule)), idata (std::move (o.idata))
+{
+    type = std::move (o.type);
+    paths = std::move (o.paths);
+    basename = std::move (o.basename);
+    name = std::move (o.name);
+    properties = std::move (o.properties);
+    id = o.id;
+    uniq_id = o.uniq_id;
+    rank = o.rank;
+    size = o.size;
+    unit = std::move (o.unit);
+    status = o.status;
+}
+
+resource_pool_t &resource_pool_t::operator= (resource_pool_t &&o) noexcept
+{
+    type = std::move (o.type);
+    paths = std::move (o.paths);
+    basename = std::move (o.basename);
+    name = std::move (o.name);
+    properties = std::move (o.properties);
+    id = o.id;
+    uniq_id = o.uniq_id;
+    rank = o.rank;
+    size = o.size;
+    unit = std::move (o.unit);
+    schedule = std::move (o.schedule);
+    idata = std::move (o.idata);
+    status = o.status;
+    return *this;
+}
+
 resource_pool_t::~resource_pool_t ()
 {
 
@@ -43,6 +43,8 @@ struct resource_pool_t {
     resource_pool_t ();
     resource_pool_t (const resource_pool_t &o);
     resource_pool_t &operator= (const resource_pool_t &o);
+    resource_pool_t (resource_pool_t &&o) noexcept;
+    resource_pool_t &operator= (resource_pool_t &&o) noexcept;
     ~resource_pool_t ();
 
     enum class status_t : int { 
@@ -59,7 +61,7 @@ struct resource_pool_t {
     std::map<std::string, std::string> paths;
     std::string basename;
     std::string name;
-    std::map<std::string, std::string> properties;
+    shared_map_t properties;
     int64_t id = -1;
     int64_t uniq_id;
     unsigned int size = 0;
@@ -83,7 +85,7 @@ struct resource_relation_t {
     resource_relation_t &operator= (const resource_relation_t &o);
     ~resource_relation_t ();
 
-    std::map<std::string, std::string> name; //!< subsystem: relationship
+    shared_map_t name;      //!< subsystem: relationship
     relation_infra_t idata; //!< scheduling infrastructure data
 };
 
@@ -125,7 +125,8 @@ public:
     edg_label_writer_t (f_edg_infra_map_t &idata, subsystem_t &s)
         : m_infra (idata), m_s (s) {}
     void operator()(std::ostream& out, const edg_t &e) const {
-        multi_subsystems_t::iterator i = m_infra[e].member_of.find (m_s);
+        multi_subsystems_t::const_iterator i
+            = m_infra[e].member_of.find (m_s);
         if (i != m_infra[e].member_of.end ()) {
             out << "[label=\"" << i->second << "\"]";
         } else {
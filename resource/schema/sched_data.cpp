@@ -63,6 +63,28 @@ schedule_t &schedule_t::operator= (const schedule_t &o)
     return *this;
 }
 
+schedule_t::schedule_t (schedule_t &&o) noexcept
+{
+    // move constructor takes over the schedule tables and the planner
+    allocations = std::move (o.allocations);
+    reservations = std::move (o.reservations);
+    plans = o.plans;
+    o.plans = NULL;
+}
+
+schedule_t &schedule_t::operator= (schedule_t &&o) noexcept
+{
+    if (this != &o) {
+        if (plans)
+            planner_destroy (&plans);
+        allocations = std::move (o.allocations);
+        reservations = std::move (o.reservations);
+        plans = o.plans;
+        o.plans = NULL;
+    }
+    return *this;
+}
+
 schedule_t::~schedule_t ()
 {
     if (plans)
@@ -35,6 +35,8 @@ struct schedule_t {
     schedule_t ();
     schedule_t (const schedule_t &o);
     schedule_t &operator= (const schedule_t &o);
+    schedule_t (schedule_t &&o) noexcept;
+    schedule_t &operator= (schedule_t &&o) noexcept;
     ~schedule_t ();
 
     std::map<int64_t, int64_t> allocations;
@@ -0,0 +1,196 @@
+/*****************************************************************************\
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include "resource/schema/shared_map.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+static const shared_map_t::map_t empty_map;
+
+
+/****************************************************************************
+ *                                                                          *
+ *                        Shared Map Public API                             *
+ *                                                                          *
+ ****************************************************************************/
+
+shared_map_t::shared_map_t ()
+{
+
+}
+
+shared_map_t::shared_map_t (const map_t &m)
+{
+    if (!m.empty ())
+        m_map = std::make_shared<map_t> (m);
+}
+
+shared_map_t::shared_map_t (map_t &&m)
+{
+    if (!m.empty ())
+        m_map = std::make_shared<map_t> (std::move (m));
+}
+
+shared_map_t &shared_map_t::operator= (const map_t &m)
+{
+    if (m.empty ())
+        m_map.reset ();
+    else
+        m_map = std::make_shared<map_t> (m);
+    return *this;
+}
+
+shared_map_t::const_iterator shared_map_t::begin () const
+{
+    return get ().begin ();
+}
+
+shared_map_t::const_iterator shared_map_t::end () const
+{
+    return get ().end ();
+}
+
+shared_map_t::const_iterator shared_map_t::find (const std::string &key) const
+{
+    return get ().find (key);
+}
+
+const std::string &shared_map_t::at (const std::string &key) const
+{
+    return get ().at (key);
+}
+
+size_t shared_map_t::size () const
+{
+    return m_map? m_map->size () : 0;
+}
+
+bool shared_map_t::empty () const
+{
+    return !m_map || m_map->empty ();
+}
+
+const shared_map_t::map_t &shared_map_t::get () const
+{
+    return m_map? *m_map : empty_map;
+}
+
+std::pair<shared_map_t::const_iterator, bool> shared_map_t::insert (
+                                                  const value_type &kv)
+{
+    // Don't copy a shared map only to find the key already there
+    auto it = find (kv.first);
+    if (it != end ())
+        return std::make_pair (it, false);
+    return mutate ().insert (kv);
+}
+
+size_t shared_map_t::erase (const std::string &key)
+{
+    if (find (key) == end ())
+        return 0;
+    return mutate ().erase (key);
+}
+
+std::string &shared_map_t::operator[] (const std::string &key)
+{
+    return mutate ()[key];
+}
+
+void shared_map_t::clear ()
+{
+    m_map.reset ();
+}
+
+bool shared_map_t::shares (const shared_map_t &o) const
+{
+    return m_map && m_map == o.m_map;
+}
+
+bool shared_map_t::operator== (const shared_map_t &o) const
+{
+    return m_map == o.m_map || get () == o.get ();
+}
+
+bool shared_map_t::operator!= (const shared_map_t &o) const
+{
+    return !(*this == o);
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                        Shared Map Private API                            *
+ *                                                                          *
+ ****************************************************************************/
+
+shared_map_t::map_t &shared_map_t::mutate ()
+{
+    if (!m_map)
+        m_map = std::make_shared<map_t> ();
+    else if (m_map.use_count () > 1)
+        m_map = std::make_shared<map_t> (*m_map);
+    return *m_map;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                      Shared Map Pool Public API                          *
+ *                                                                          *
+ ****************************************************************************/
+
+shared_map_t shared_map_pool_t::intern (const shared_map_t &m)
+{
+    shared_map_t pooled;
+
+    if (m.empty ())
+        return pooled;
+    auto it = m_pool.insert (m.m_map).first;
+    pooled.m_map = *it;
+    return pooled;
+}
+
+shared_map_t shared_map_pool_t::intern (const shared_map_t::map_t &m)
+{
+    return intern (shared_map_t (m));
+}
+
+size_t shared_map_pool_t::size () const
+{
+    return m_pool.size ();
+}
+
+bool shared_map_pool_t::less_t::operator() (
+         const std::shared_ptr<shared_map_t::map_t> &a,
+         const std::shared_ptr<shared_map_t::map_t> &b) const
+{
+    return *a < *b;
+}
+
+} // namespace resource_model
+} // namespace Flux
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
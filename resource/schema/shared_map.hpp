@@ -0,0 +1,115 @@
+/*****************************************************************************\
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef SHARED_MAP_HPP
+#define SHARED_MAP_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <memory>
+#include <utility>
+
+namespace Flux {
+namespace resource_model {
+
+/*! String map whose storage is shared by copies of it until one of
+ *  them is written to (copy-on-write). The vertices and edges of the
+ *  same node shape hold equal maps (properties, subsystem membership,
+ *  relation names), so they can all point at a single copy.
+ *  An empty map holds no storage at all.
+ */
+class shared_map_t {
+public:
+    using map_t = std::map<std::string, std::string>;
+    using value_type = map_t::value_type;
+    using const_iterator = map_t::const_iterator;
+
+    shared_map_t ();
+    shared_map_t (const map_t &m);
+    shared_map_t (map_t &&m);
+    shared_map_t &operator= (const map_t &m);
+
+    const_iterator begin () const;
+    const_iterator end () const;
+    const_iterator find (const std::string &key) const;
+    const std::string &at (const std::string &key) const;
+    size_t size () const;
+    bool empty () const;
+
+    /*! Return the underlying map, e.g., to hand it to an interface
+     *  that takes a std::map.
+     */
+    const map_t &get () const;
+
+    /*! Writers: the storage is copied first if it is shared.
+     */
+    std::pair<const_iterator, bool> insert (const value_type &kv);
+    size_t erase (const std::string &key);
+    std::string &operator[] (const std::string &key);
+    void clear ();
+
+    /*! Return true if this map and o share their storage.
+     */
+    bool shares (const shared_map_t &o) const;
+
+    bool operator== (const shared_map_t &o) const;
+    bool operator!= (const shared_map_t &o) const;
+
+private:
+    friend class shared_map_pool_t;
+    map_t &mutate ();
+    std::shared_ptr<map_t> m_map;
+};
+
+/*! Pool of the distinct maps held by the graph. Readers intern the maps
+ *  they build so that equal maps share one copy across vertices, edges,
+ *  ranks and readers.
+ */
+class shared_map_pool_t {
+public:
+    /*! Return a map equal to m that shares the storage of the pooled
+     *  copy, adding m to the pool if it is not there yet.
+     */
+    shared_map_t intern (const shared_map_t &m);
+    shared_map_t intern (const shared_map_t::map_t &m);
+
+    /*! Return the number of distinct maps in the pool.
+     */
+    size_t size () const;
+
+private:
+    struct less_t {
+        bool operator() (const std::shared_ptr<shared_map_t::map_t> &a,
+                         const std::shared_ptr<shared_map_t::map_t> &b) const;
+    };
+    std::set<std::shared_ptr<shared_map_t::map_t>, less_t> m_pool;
+};
+
+} // namespace resource_model
+} // namespace Flux
+
+#endif // SHARED_MAP_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -22,12 +22,282 @@
  *  See also:  http://www.gnu.org/licenses/
  \*****************************************************************************/
 
+#include <cerrno>
+#include <algorithm>
+#include <stdexcept>
 #include "resource/store/resource_graph_store.hpp"
 #include "resource/readers/resource_reader_base.hpp"
 
 using namespace Flux;
 using namespace Flux::resource_model;
 
+static bool key_less (const outedges_t::entry_t &a,
+                      const outedges_t::entry_t &b)
+{
+    return (a.weight < b.weight)
+           || (a.weight == b.weight && a.uniq_id < b.uniq_id);
+}
+
+std::vector<outedges_t::entry_t>::iterator outedges_t::find (uint64_t weight,
+                                                             int64_t uniq_id)
+{
+    entry_t key = {weight, uniq_id, edg_t ()};
+    auto it = std::lower_bound (m_entries.begin (), m_entries.end (),
+                                key, key_less);
+    if (it == m_entries.end () || it->weight != weight
+        || it->uniq_id != uniq_id)
+        return m_entries.end ();
+    return it;
+}
+
+bool outedges_t::insert (uint64_t weight, int64_t uniq_id, edg_t e)
+{
+    entry_t ent = {weight, uniq_id, e};
+    // Readers add the out-edges of a vertex in creation order
+    if (m_entries.empty () || key_less (m_entries.back (), ent)) {
+        m_entries.push_back (ent);
+        return true;
+    }
+    auto it = std::lower_bound (m_entries.begin (), m_entries.end (),
+                                ent, key_less);
+    if (it->weight == weight && it->uniq_id == uniq_id)
+        return false;
+    m_entries.insert (it, ent);
+    return true;
+}
+
+bool outedges_t::reweigh (uint64_t weight, int64_t uniq_id,
+                          uint64_t new_weight)
+{
+    auto it = find (weight, uniq_id);
+    if (it == m_entries.end ())
+        return false;
+    if (new_weight == weight)
+        return true;
+    if (find (new_weight, uniq_id) != m_entries.end ())
+        return false;
+
+    entry_t key = {new_weight, uniq_id, it->edge};
+    if (new_weight > weight) {
+        auto pos = std::lower_bound (it + 1, m_entries.end (), key, key_less);
+        std::rotate (it, it + 1, pos);
+        *(pos - 1) = key;
+    } else {
+        auto pos = std::lower_bound (m_entries.begin (), it, key, key_less);
+        std::rotate (pos, it, it + 1);
+        *pos = key;
+    }
+    return true;
+}
+
+bool outedges_t::erase (uint64_t weight, int64_t uniq_id)
+{
+    auto it = find (weight, uniq_id);
+    if (it == m_entries.end ())
+        return false;
+    m_entries.erase (it);
+    return true;
+}
+
+size_t outedges_t::size () const
+{
+    return m_entries.size ();
+}
+
+outedges_t::const_iterator outedges_t::begin () const
+{
+    return m_entries.crbegin ();
+}
+
+outedges_t::const_iterator outedges_t::end () const
+{
+    return m_entries.crend ();
+}
+
+uint32_t path_index_t::walk (const std::string &path) const
+{
+    uint32_t node = 0;
+    size_t begin = 0;
+    std::string comp;
+
+    while (true) {
+        size_t end = path.find ('/', begin);
+        size_t n = (end == std::string::npos)? std::string::npos
+                                              : end - begin;
+        comp.assign (path, begin, n);
+        auto cit = m_comp_ids.find (comp);
+        if (cit == m_comp_ids.end ())
+            return NO_NODE;
+        auto it = m_children.find ((static_cast<uint64_t> (node) << 32)
+                                   | cit->second);
+        if (it == m_children.end ())
+            return NO_NODE;
+        node = it->second;
+        if (end == std::string::npos)
+            return node;
+        begin = end + 1;
+    }
+}
+
+void path_index_t::set (const std::string &path, vtx_t v)
+{
+    uint32_t node = 0;
+    size_t begin = 0;
+    std::string comp;
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+
+    while (true) {
+        size_t end = path.find ('/', begin);
+        size_t n = (end == std::string::npos)? std::string::npos
+                                              : end - begin;
+        // Look up first: only a new component or child allocates
+        comp.assign (path, begin, n);
+        auto cit = m_comp_ids.find (comp);
+        if (cit == m_comp_ids.end ())
+            cit = m_comp_ids.emplace (comp, static_cast<uint32_t> (
+                                                m_comp_ids.size ())).first;
+        uint64_t key = (static_cast<uint64_t> (node) << 32) | cit->second;
+        auto it = m_children.find (key);
+        if (it == m_children.end ()) {
+            it = m_children.emplace (key, static_cast<uint32_t> (
+                                              m_vtx.size ())).first;
+            m_vtx.push_back (null_v);
+        }
+        node = it->second;
+        if (end == std::string::npos)
+            break;
+        begin = end + 1;
+    }
+    if (m_vtx[node] == null_v)
+        m_size++;
+    m_vtx[node] = v;
+}
+
+vtx_t path_index_t::find (const std::string &path) const
+{
+    uint32_t node = walk (path);
+    return (node == NO_NODE)? boost::graph_traits<resource_graph_t>
+                                  ::null_vertex ()
+                            : m_vtx[node];
+}
+
+vtx_t path_index_t::at (const std::string &path) const
+{
+    vtx_t v = find (path);
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ())
+        throw std::out_of_range ("path_index_t::at: " + path);
+    return v;
+}
+
+bool path_index_t::erase (const std::string &path)
+{
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    uint32_t node = walk (path);
+    if (node == NO_NODE || m_vtx[node] == null_v)
+        return false;
+    m_vtx[node] = null_v;
+    m_size--;
+    return true;
+}
+
+size_t path_index_t::size () const
+{
+    return m_size;
+}
+
+size_t path_index_t::nodes () const
+{
+    return m_vtx.size ();
+}
+
+void path_index_t::renumber (const std::vector<vtx_t> &new_ids)
+{
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    std::vector<uint32_t> parent (m_vtx.size (), NO_NODE);
+    std::vector<uint32_t> new_node (m_vtx.size (), NO_NODE);
+    std::vector<uint32_t> new_comp (m_comp_ids.size (), NO_NODE);
+    std::vector<bool> keep (m_vtx.size (), false);
+    std::vector<bool> used (m_comp_ids.size (), false);
+    std::vector<vtx_t> vtx;
+    std::unordered_map<std::string, uint32_t> comp_ids;
+    std::unordered_map<uint64_t, uint32_t> children;
+    uint32_t n, p;
+
+    for (vtx_t &v : m_vtx) {
+        if (v == null_v)
+            continue;
+        v = new_ids[v];
+        if (v == null_v)
+            m_size--;
+    }
+
+    // Keep the mapped nodes and their ancestors. A node is always
+    // created after its parent, so the kept nodes are renumbered in
+    // order and a parent keeps a lower number than its children.
+    for (auto &kv : m_children)
+        parent[kv.second] = static_cast<uint32_t> (kv.first >> 32);
+    keep[0] = true;
+    for (n = 0; n < m_vtx.size (); n++) {
+        if (m_vtx[n] == null_v)
+            continue;
+        for (p = n; !keep[p]; p = parent[p])
+            keep[p] = true;
+    }
+    for (n = 0; n < m_vtx.size (); n++) {
+        if (!keep[n])
+            continue;
+        new_node[n] = static_cast<uint32_t> (vtx.size ());
+        vtx.push_back (m_vtx[n]);
+    }
+
+    for (auto &kv : m_children) {
+        if (keep[kv.second])
+            used[kv.first & UINT32_MAX] = true;
+    }
+    for (auto &kv : m_comp_ids) {
+        if (!used[kv.second])
+            continue;
+        new_comp[kv.second] = static_cast<uint32_t> (comp_ids.size ());
+        comp_ids.emplace (kv.first, new_comp[kv.second]);
+    }
+    children.reserve (vtx.size ());
+    for (auto &kv : m_children) {
+        if (!keep[kv.second])
+            continue;
+        uint64_t key = (static_cast<uint64_t> (
+                            new_node[kv.first >> 32]) << 32)
+                       | new_comp[kv.first & UINT32_MAX];
+        children.emplace (key, new_node[kv.second]);
+    }
+    m_vtx.swap (vtx);
+    m_comp_ids.swap (comp_ids);
+    m_children.swap (children);
+}
+
+void resource_graph_metadata_t::index_rank_root (const resource_graph_t &g,
+                                                 vtx_t v)
+{
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    if (g[v].rank < 0)
+        return;
+    size_t rank = static_cast<size_t> (g[v].rank);
+    for (auto &kv : g[v].paths) {
+        std::vector<vtx_t> &roots = by_rank_root[kv.first];
+        if (roots.size () <= rank)
+            roots.resize (rank + 1, null_v);
+        vtx_t &root = roots[rank];
+        if (root == null_v) {
+            root = v;
+            continue;
+        }
+        // Of equally short paths, the one added to by_rank first wins
+        size_t len = g[root].paths.at (kv.first).length ();
+        if (kv.second.length () < len
+            || (kv.second.length () == len && v < root))
+            root = v;
+    }
+}
+
 bool resource_graph_db_t::known_subsystem (const std::string &s)
 {
     return (metadata.roots.find (s) != metadata.roots.end ())? true : false;
@@ -37,6 +307,7 @@ int resource_graph_db_t::load (const std::string &str,
                                std::shared_ptr<resource_reader_base_t> &reader,
                                int rank)
 {
+    metadata.generation++;
     return reader->unpack (resource_graph, metadata, str, rank);
 };
 
@@ -44,9 +315,234 @@ int resource_graph_db_t::load (const std::string &str,
                                std::shared_ptr<resource_reader_base_t> &reader,
                                vtx_t &vtx_at, int rank)
 {
+    metadata.generation++;
     return reader->unpack_at (resource_graph, metadata, vtx_at, str, rank);
 };
 
+template <class key_t>
+static void unindex (std::map<key_t, std::vector<vtx_t>> &index,
+                     const std::set<key_t> &keys,
+                     const std::vector<bool> &gone)
+{
+    for (auto &key : keys) {
+        auto it = index.find (key);
+        if (it == index.end ())
+            continue;
+        std::vector<vtx_t> &vtcs = it->second;
+        vtcs.erase (std::remove_if (vtcs.begin (), vtcs.end (),
+                                    [&gone] (vtx_t v) { return gone[v]; }),
+                    vtcs.end ());
+        if (vtcs.empty ())
+            index.erase (it);
+    }
+}
+
+static bool is_below (const resource_graph_t &g, vtx_t u, vtx_t t)
+{
+    for (auto &kv : g[t].paths) {
+        auto it = g[u].paths.find (kv.first);
+        if (it == g[u].paths.end ())
+            continue;
+        const std::string &up = it->second;
+        if (kv.second.length () > up.length ()
+            && kv.second.compare (0, up.length (), up) == 0
+            && kv.second[up.length ()] == '/')
+            return true;
+    }
+    return false;
+}
+
+void resource_graph_db_t::rank_subgraphs (const std::set<int64_t> &ranks,
+                                          std::vector<vtx_t> &vtcs) const
+{
+    const resource_graph_t &g = resource_graph;
+    std::vector<bool> seen (num_vertices (g), false);
+    out_edg_iterator_t ei, ei_end;
+    size_t i;
+
+    for (auto rank : ranks) {
+        auto it = metadata.by_rank.find (rank);
+        if (it == metadata.by_rank.end ())
+            continue;
+        for (vtx_t v : it->second) {
+            if (!seen[v]) {
+                seen[v] = true;
+                vtcs.push_back (v);
+            }
+        }
+    }
+    // Vertices below a rank's vertices may carry no rank of their own.
+    // Follow only the out-edges that lead down a subsystem's paths, not
+    // the ones leading back up (e.g., "in" edges).
+    for (i = 0; i < vtcs.size (); i++) {
+        vtx_t u = vtcs[i];
+        for (boost::tie (ei, ei_end) = out_edges (u, g); ei != ei_end; ++ei) {
+            vtx_t t = target (*ei, g);
+            if (!seen[t] && is_below (g, u, t)) {
+                seen[t] = true;
+                vtcs.push_back (t);
+            }
+        }
+    }
+}
+
+int resource_graph_db_t::detach (const std::set<int64_t> &ranks)
+{
+    resource_graph_t &g = resource_graph;
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    std::vector<bool> gone (num_vertices (g), false);
+    std::vector<vtx_t> vtcs;
+    std::set<vtx_t> parents;
+    std::set<std::string> types, names;
+    std::set<int64_t> vtx_ranks;
+    out_edg_iterator_t ei, ei_end;
+
+    rank_subgraphs (ranks, vtcs);
+    for (vtx_t v : vtcs)
+        gone[v] = true;
+    for (auto &kv : metadata.roots) {
+        if (gone[kv.second]) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    for (vtx_t v : vtcs) {
+        if (!g[v].schedule.allocations.empty ()
+            || !g[v].schedule.reservations.empty ()
+            || !g[v].idata.tags.empty () || !g[v].idata.x_spans.empty ()) {
+            errno = EBUSY;
+            return -1;
+        }
+    }
+
+    for (vtx_t v : vtcs) {
+        for (auto &kv : g[v].paths) {
+            size_t pos = kv.second.rfind ('/');
+            vtx_t p = (pos == 0 || pos == std::string::npos)?
+                          null_v : metadata.by_path.find (kv.second.substr (0,
+                                                                        pos));
+            if (p != null_v && !gone[p])
+                parents.insert (p);
+        }
+    }
+    for (vtx_t p : parents) {
+        auto oit = metadata.by_outedges.find (p);
+        for (boost::tie (ei, ei_end) = out_edges (p, g); ei != ei_end; ++ei) {
+            vtx_t t = target (*ei, g);
+            if (gone[t] && oit != metadata.by_outedges.end ())
+                oit->second.erase (g[*ei].idata.get_weight (), g[t].uniq_id);
+        }
+        remove_out_edge_if (p, [&gone, &g] (const edg_t &e) {
+                                   return gone[target (e, g)];
+                               }, g);
+    }
+
+    for (vtx_t v : vtcs) {
+        clear_out_edges (v, g);
+        metadata.by_outedges.erase (v);
+        for (auto &kv : g[v].paths) {
+            if (metadata.by_path.find (kv.second) == v)
+                metadata.by_path.erase (kv.second);
+        }
+        for (auto &kv : metadata.by_rank_root) {
+            if (g[v].rank >= 0
+                && static_cast<size_t> (g[v].rank) < kv.second.size ()
+                && kv.second[g[v].rank] == v)
+                kv.second[g[v].rank] = null_v;
+        }
+        types.insert (g[v].type);
+        names.insert (g[v].name);
+        vtx_ranks.insert (g[v].rank);
+    }
+    unindex (metadata.by_type, types, gone);
+    unindex (metadata.by_name, names, gone);
+    unindex (metadata.by_rank, vtx_ranks, gone);
+    // A default vertex is a member of no subsystem, so filtered graphs
+    // no longer see the hole
+    for (vtx_t v : vtcs) {
+        g[v] = resource_pool_t ();
+        metadata.holes.push_back (v);
+    }
+    metadata.generation++;
+    return 0;
+}
+
+size_t resource_graph_db_t::holes () const
+{
+    return metadata.holes.size ();
+}
+
+int resource_graph_db_t::compact ()
+{
+    resource_graph_t &g = resource_graph;
+    resource_graph_t ng;
+    vtx_t u, v;
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    std::vector<vtx_t> new_ids (num_vertices (g), null_v);
+    std::vector<bool> hole (num_vertices (g), false);
+    std::map<vtx_t, outedges_t> by_outedges;
+    out_edg_iterator_t ei, ei_end;
+
+    if (metadata.holes.empty ())
+        return 0;
+    for (vtx_t h : metadata.holes)
+        hole[h] = true;
+    ng.m_vertices.reserve (num_vertices (g) - metadata.holes.size ());
+    for (u = 0; u < num_vertices (g); u++) {
+        if (!hole[u])
+            new_ids[u] = add_vertex (ng);
+    }
+
+    // Re-add the out-edges in order, so that traversals keep visiting
+    // the children in the same order, and re-key them by the same weights
+    for (u = 0; u < num_vertices (g); u++) {
+        if (new_ids[u] == null_v)
+            continue;
+        for (boost::tie (ei, ei_end) = out_edges (u, g); ei != ei_end; ++ei) {
+            edg_t e;
+            bool inserted;
+            if ( (v = new_ids[target (*ei, g)]) == null_v)
+                continue;
+            boost::tie (e, inserted) = add_edge (new_ids[u], v, g[*ei], ng);
+            ng[e].idata.set_weight (g[*ei].idata.get_weight ());
+            if (!by_outedges[new_ids[u]].insert (ng[e].idata.get_weight (),
+                                                 g[target (*ei, g)].uniq_id,
+                                                 e)) {
+                errno = EEXIST;
+                return -1;
+            }
+        }
+    }
+    for (u = 0; u < num_vertices (g); u++) {
+        if (new_ids[u] != null_v)
+            ng[new_ids[u]] = std::move (g[u]);
+    }
+    // Swap the storage rather than the graphs, so that filtered graphs
+    // over resource_graph stay valid
+    g.m_vertices.swap (ng.m_vertices);
+    g.m_edges.swap (ng.m_edges);
+
+    for (auto &kv : metadata.roots)
+        kv.second = new_ids[kv.second];
+    for (auto &kv : metadata.by_type)
+        for (vtx_t &w : kv.second)
+            w = new_ids[w];
+    for (auto &kv : metadata.by_name)
+        for (vtx_t &w : kv.second)
+            w = new_ids[w];
+    for (auto &kv : metadata.by_rank)
+        for (vtx_t &w : kv.second)
+            w = new_ids[w];
+    for (auto &kv : metadata.by_rank_root)
+        for (vtx_t &w : kv.second)
+            w = (w == null_v)? null_v : new_ids[w];
+    metadata.by_path.renumber (new_ids);
+    metadata.by_outedges.swap (by_outedges);
+    metadata.holes.clear ();
+    metadata.generation++;
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
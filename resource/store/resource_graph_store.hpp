@@ -25,8 +25,11 @@
 #ifndef RESOURCE_GRAPH_STORE_HPP
 #define RESOURCE_GRAPH_STORE_HPP
 
+#include <set>
 #include <string>
 #include <memory>
+#include <vector>
+#include <unordered_map>
 #include "resource/schema/resource_graph.hpp"
 
 namespace Flux {
@@ -34,6 +37,95 @@ namespace resource_model {
 
 class resource_reader_base_t;
 
+/*! Out-edges of a vertex ordered by their "weight" (the resources
+ *  available under the target at the last update) and then by the
+ *  target's uniq_id, heaviest first. Entries live in a single array kept
+ *  in ascending order, so edges with equal weight form contiguous buckets.
+ *  Readers append in creation order at no extra cost, and reweighing an
+ *  edge slides it to its new bucket in place without allocating.
+ */
+class outedges_t {
+public:
+    struct entry_t {
+        uint64_t weight;
+        int64_t uniq_id;
+        edg_t edge;
+    };
+    using const_iterator = std::vector<entry_t>::const_reverse_iterator;
+
+    /*! Insert an edge. Return false if (weight, uniq_id) already exists.
+     */
+    bool insert (uint64_t weight, int64_t uniq_id, edg_t e);
+
+    /*! Move the edge keyed by (weight, uniq_id) to new_weight.
+     *  Return false if there is no such edge.
+     */
+    bool reweigh (uint64_t weight, int64_t uniq_id, uint64_t new_weight);
+
+    /*! Remove the edge keyed by (weight, uniq_id).
+     *  Return false if there is no such edge.
+     */
+    bool erase (uint64_t weight, int64_t uniq_id);
+
+    size_t size () const;
+    //! Iterate from the heaviest out-edge to the lightest
+    const_iterator begin () const;
+    const_iterator end () const;
+
+private:
+    std::vector<entry_t>::iterator find (uint64_t weight, int64_t uniq_id);
+    std::vector<entry_t> m_entries;
+};
+
+/*! Index of vertices by path string, e.g. "/cluster0/rack3/node127".
+ *  Paths form a trie over their '/'-separated components. Each distinct
+ *  component string is stored once and interned to an id, and each trie
+ *  node is found from its parent through a hash keyed by (parent node,
+ *  component id). A path costs one hash probe per component to look up
+ *  and is never stored whole. Splitting keeps empty components, so any
+ *  two distinct strings map to distinct trie nodes.
+ */
+class path_index_t {
+public:
+    /*! Map path to v, replacing the vertex it was mapped to if any.
+     */
+    void set (const std::string &path, vtx_t v);
+
+    /*! Return the vertex mapped to path, or null_vertex if none.
+     */
+    vtx_t find (const std::string &path) const;
+
+    /*! Return the vertex mapped to path; throw std::out_of_range if none.
+     */
+    vtx_t at (const std::string &path) const;
+
+    /*! Unmap path. Return false if it was not mapped.
+     */
+    bool erase (const std::string &path);
+
+    //! Number of mapped paths
+    size_t size () const;
+
+    //! Number of trie nodes, including those of unmapped prefixes
+    size_t nodes () const;
+
+    /*! Map every path mapped to vertex v to new_ids[v] instead, e.g.,
+     *  after the vertices of the graph have been renumbered. erase ()
+     *  leaves the trie nodes of a path in place; here the trie is rebuilt
+     *  without the nodes and components that lead to no mapped path.
+     */
+    void renumber (const std::vector<vtx_t> &new_ids);
+
+private:
+    static const uint32_t NO_NODE = UINT32_MAX;
+    uint32_t walk (const std::string &path) const;
+    std::unordered_map<std::string, uint32_t> m_comp_ids;
+    std::unordered_map<uint64_t, uint32_t> m_children;
+    std::vector<vtx_t> m_vtx{boost::graph_traits<resource_graph_t>
+                                 ::null_vertex ()};
+    size_t m_size = 0;
+};
+
 /*! Resource graph data metadata.
  *  Adjacency_list graph, roots of this graph and various indexing.
  */
@@ -43,12 +135,32 @@ struct resource_graph_metadata_t {
     std::map<std::string, std::vector <vtx_t>> by_type;
     std::map<std::string, std::vector <vtx_t>> by_name;
     std::map<int64_t, std::vector <vtx_t>> by_rank;
-    std::map<std::string, vtx_t> by_path;
+    // by_rank_root[subsystem][rank] is the root of the subtree of rank's
+    // vertices in that subsystem, or null_vertex if rank has none there
+    std::map<subsystem_t, std::vector<vtx_t>> by_rank_root;
+    path_index_t by_path;
     // by_outedges enables graph traversing order to edge "weight"
     // E.g., the more available resources an edge point to, the heavier
-    std::map<vtx_t,
-             std::map<std::pair<uint64_t, int64_t>, edg_t,
-                      std::greater<std::pair<uint64_t, int64_t>>>> by_outedges;
+    std::map<vtx_t, outedges_t> by_outedges;
+    // generation is bumped whenever the graph's vertices, their status
+    // or their properties change, so that what was derived from an
+    // earlier graph (e.g., satisfiability verdicts) can tell it is stale
+    uint64_t generation = 0;
+    // vertices detached from the graph that still take up their slot
+    // in the vertex storage until the graph is compacted
+    std::vector<vtx_t> holes;
+    // uniq_id of the next vertex a reader creates. Unlike vertex
+    // descriptors, uniq_ids are never reused, even after compact ()
+    int64_t next_uniq_id = 0;
+    // properties and subsystem maps that readers share among vertices
+    // and edges of the same shape, so the graph keeps one copy of each
+    shared_map_pool_t shared_maps;
+
+    /*! Index v as the root of its rank's subtree in each subsystem in
+     *  which v has a shorter path than the current root. Readers call
+     *  this whenever they set a path of a vertex with a rank.
+     */
+    void index_rank_root (const resource_graph_t &g, vtx_t v);
 };
 
 /*! Resource graph data store.
@@ -92,6 +204,45 @@ struct resource_graph_db_t {
     int load (const std::string &str,
               std::shared_ptr<resource_reader_base_t> &reader,
               vtx_t &vtx_at, int rank = -1);
+
+    /*! Collect the vertices of the subgraphs of ranks into vtcs: the
+     *  vertices of each rank and every vertex below one of them along the
+     *  paths of a subsystem. A rank with no vertex is ignored.
+     *
+     * \param ranks  set of ranks whose subgraphs to collect
+     * \param vtcs   vector to append the collected vertices to
+     */
+    void rank_subgraphs (const std::set<int64_t> &ranks,
+                         std::vector<vtx_t> &vtcs) const;
+
+    /*! Detach the subgraphs of ranks (see rank_subgraphs ()) from the
+     *  resource graph. Their edges and their entries in the metadata
+     *  indexes are removed and their properties, including their
+     *  planners, are released. Edges into the detached vertices are found
+     *  through the paths of the vertices, i.e., from their parents. The
+     *  vertices are left as holes in the vertex storage until compact ()
+     *  is called.
+     *
+     * \param ranks  set of ranks whose vertices to detach
+     * \return       0 on success; -1 on an error with errno set
+     *                   EINVAL: a root vertex belongs to one of ranks
+     *                   EBUSY: a vertex is allocated or reserved to a job
+     */
+    int detach (const std::set<int64_t> &ranks);
+
+    /*! Return the number of holes left in the vertex storage by detach ()
+     */
+    size_t holes () const;
+
+    /*! Remove the holes from the vertex storage. The remaining vertices
+     *  are renumbered in order and keep their properties, including their
+     *  planned spans, and the order of their out-edges. Invalidates every
+     *  vertex and edge descriptor held outside of the metadata indexes.
+     *
+     * \return       0 on success; -1 on an error with errno set
+     *                   EEXIST: duplicate out-edge in by_outedges
+     */
+    int compact ();
 };
 
 }
@@ -0,0 +1,203 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Unit tests for path_index_t: set, find, at, erase and renumber,
+ * paths with empty components, the trie nodes freed by renumber, and
+ * a random mix of operations checked against a std::map reference.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdlib>
+#include "resource/store/resource_graph_store.hpp"
+#include "src/common/libtap/tap.h"
+
+using namespace Flux::resource_model;
+
+static const vtx_t null_v = boost::graph_traits<resource_graph_t>
+                                ::null_vertex ();
+
+static bool throws_at (const path_index_t &index, const std::string &path)
+{
+    try {
+        index.at (path);
+    } catch (std::out_of_range &) {
+        return true;
+    }
+    return false;
+}
+
+static void test_basic ()
+{
+    path_index_t index;
+
+    ok (index.size () == 0 && index.find ("/cluster0") == null_v,
+        "empty index");
+    index.set ("/cluster0", 0);
+    index.set ("/cluster0/rack0/node0", 2);
+    ok (index.size () == 2 && index.find ("/cluster0") == 0
+        && index.at ("/cluster0/rack0/node0") == 2, "set and find");
+    ok (index.find ("/cluster0/rack0") == null_v
+        && throws_at (index, "/cluster0/rack0"),
+        "an interior node that was never set is not mapped");
+    ok (index.find ("/cluster0/rack0/node") == null_v
+        && index.find ("/cluster0/rack0/node00") == null_v
+        && index.find ("/cluster0/rack0/node0/core0") == null_v,
+        "prefixes and extensions of a component do not match");
+    index.set ("/cluster0/rack0/node0", 5);
+    ok (index.size () == 2 && index.at ("/cluster0/rack0/node0") == 5,
+        "set replaces the vertex of a mapped path");
+    ok (index.erase ("/cluster0/rack0/node0") && index.size () == 1
+        && index.find ("/cluster0/rack0/node0") == null_v
+        && throws_at (index, "/cluster0/rack0/node0"), "erase");
+    ok (!index.erase ("/cluster0/rack0/node0")
+        && !index.erase ("/cluster0/rack0") && !index.erase ("/nothing")
+        && index.size () == 1, "erase of an unmapped path fails");
+    index.set ("/cluster0/rack0/node0", 7);
+    ok (index.size () == 2 && index.at ("/cluster0/rack0/node0") == 7,
+        "an erased path can be set again");
+}
+
+static void test_empty_components ()
+{
+    path_index_t index;
+    const std::vector<std::string> paths = {"", "/", "//", "a", "/a", "a/",
+                                            "/a/", "//a", "a//b", "/a/b"};
+
+    for (size_t i = 0; i < paths.size (); i++)
+        index.set (paths[i], i);
+    bool all = (index.size () == paths.size ());
+    for (size_t i = 0; i < paths.size (); i++)
+        if (index.find (paths[i]) != i)
+            all = false;
+    ok (all, "paths that differ only in empty components are distinct");
+    ok (index.erase ("/") && index.find ("") == 0 && index.find ("//") == 2
+        && index.size () == paths.size () - 1,
+        "erasing a path leaves those around it");
+}
+
+static void test_renumber ()
+{
+    path_index_t index;
+    std::vector<vtx_t> new_ids = {null_v, 0, null_v, 1};
+
+    index.set ("/c0", 1);
+    index.set ("/c0/n0", 2);
+    index.set ("/c0/n1", 3);
+    index.renumber (new_ids);
+    ok (index.size () == 2 && index.find ("/c0") == 0
+        && index.find ("/c0/n0") == null_v && index.find ("/c0/n1") == 1,
+        "renumber maps vertices to their new ids and drops removed ones");
+}
+
+static void test_renumber_prunes ()
+{
+    path_index_t index;
+    std::vector<vtx_t> same;
+
+    for (vtx_t v = 0; v < 10; v++) {
+        same.push_back (v);
+        index.set ("/c0/r0/n" + std::to_string (v) + "/core0", v);
+    }
+    size_t nodes = index.nodes ();
+    for (vtx_t v = 0; v < 9; v++)
+        index.erase ("/c0/r0/n" + std::to_string (v) + "/core0");
+    ok (index.nodes () == nodes, "erase leaves the trie nodes in place");
+    index.renumber (same);
+    ok (index.size () == 1 && index.nodes () == 6
+        && index.find ("/c0/r0/n9/core0") == 9
+        && index.find ("/c0/r0/n0/core0") == null_v,
+        "renumber frees the nodes that lead to no mapped path");
+    index.set ("/c0/r0/n0/core0", 0);
+    index.set ("/c0/r1", 1);
+    ok (index.size () == 3 && index.find ("/c0/r0/n0/core0") == 0
+        && index.find ("/c0/r1") == 1 && index.find ("/c0/r0/n9/core0") == 9,
+        "freed components can be set again");
+}
+
+static void test_against_map ()
+{
+    path_index_t index;
+    std::map<std::string, vtx_t> ref;
+    uint64_t x = 88172645463325252ULL;
+    int bad = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        std::string path = "/cluster0/rack" + std::to_string (x % 8)
+                           + "/node" + std::to_string ((x >> 8) % 32);
+        if ((x >> 16) % 3 == 0)
+            path += "/core" + std::to_string ((x >> 24) % 4);
+        if ((x >> 32) % 4 == 0) {
+            if (index.erase (path) != (ref.erase (path) == 1))
+                bad++;
+        } else {
+            index.set (path, static_cast<vtx_t> (i));
+            ref[path] = static_cast<vtx_t> (i);
+        }
+    }
+    ok (bad == 0, "erase agrees with the reference");
+    for (auto &kv : ref)
+        if (index.find (kv.first) != kv.second)
+            bad++;
+    ok (bad == 0 && index.size () == ref.size (),
+        "%zu paths agree with the reference", ref.size ());
+
+    std::vector<vtx_t> same (20000);
+    for (size_t i = 0; i < same.size (); i++)
+        same[i] = static_cast<vtx_t> (i);
+    index.renumber (same);
+    for (auto &kv : ref)
+        if (index.find (kv.first) != kv.second)
+            bad++;
+    ok (bad == 0 && index.size () == ref.size (),
+        "paths still agree with the reference once the trie is rebuilt");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (17);
+
+    test_basic ();
+    test_empty_components ();
+    test_renumber ();
+    test_renumber_prunes ();
+    test_against_map ();
+
+    done_testing ();
+    return EXIT_SUCCESS;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
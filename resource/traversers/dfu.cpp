@@ -43,6 +43,126 @@ using namespace Flux::Jobspec;
  *                                                                          *
  ****************************************************************************/
 
+static const char *op_name (match_op_t op)
+{
+    switch (op) {
+    case match_op_t::MATCH_ALLOCATE:
+        return "allocate";
+    case match_op_t::MATCH_ALLOCATE_W_SATISFIABILITY:
+        return "allocate_with_satisfiability";
+    case match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE:
+        return "allocate_orelse_reserve";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+int dfu_traverser_t::timed_select (Jobspec::Jobspec &jobspec, vtx_t root,
+                                   detail::jobmeta_t &meta, bool x)
+{
+    uint64_t t0 = match_perf_now ();
+    dfu_trace_t::span_t span (get_trace ().get (), "select", root);
+    int rc = detail::dfu_impl_t::select (jobspec, root, meta, x);
+    m_phase_times[match_phase_t::SELECT] += match_perf_now () - t0;
+    return rc;
+}
+
+int64_t dfu_traverser_t::timed_avail_time_first (planner_multi_t *p,
+                                                 int64_t t, uint64_t duration,
+                                                 const uint64_t *agg,
+                                                 size_t len)
+{
+    uint64_t t0 = match_perf_now ();
+    const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
+    dfu_trace_t::span_t span (get_trace ().get (),
+                              "planner_multi_avail_time_first",
+                              get_graph_db ()->metadata.roots.at (dom));
+    int64_t rc = planner_multi_avail_time_first (p, t, duration, agg, len);
+    m_phase_times[match_phase_t::AVAIL] += match_perf_now () - t0;
+    return rc;
+}
+
+int64_t dfu_traverser_t::timed_avail_time_next (planner_multi_t *p)
+{
+    uint64_t t0 = match_perf_now ();
+    const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
+    dfu_trace_t::span_t span (get_trace ().get (),
+                              "planner_multi_avail_time_next",
+                              get_graph_db ()->metadata.roots.at (dom));
+    int64_t rc = planner_multi_avail_time_next (p);
+    m_phase_times[match_phase_t::AVAIL] += match_perf_now () - t0;
+    return rc;
+}
+
+static void shape_key (const std::vector<Resource> &resources,
+                       std::string &key)
+{
+    // Labels only name the emitted resources; everything else can
+    // change what matches
+    for (auto &r : resources) {
+        key += r.type + "[" + std::to_string (r.count.min) + ":"
+               + std::to_string (r.count.max) + r.count.oper
+               + std::to_string (r.count.operand) + "]"
+               + std::to_string (static_cast<int> (r.exclusive))
+               + r.unit + "#" + r.id;
+        if (!r.with.empty ()) {
+            key += "{";
+            shape_key (r.with, key);
+            key += "}";
+        }
+        key += ";";
+    }
+}
+
+void dfu_traverser_t::sat_cache_put (const std::string &key, bool sat)
+{
+    if (m_sat_cache.size () >= SAT_CACHE_MAX) {
+        m_sat_cache.erase (m_sat_lru.back ());
+        m_sat_lru.pop_back ();
+    }
+    m_sat_lru.push_front (key);
+    m_sat_cache[key] = std::make_pair (sat, m_sat_lru.begin ());
+}
+
+int dfu_traverser_t::satisfiability (Jobspec::Jobspec &jobspec, vtx_t root,
+                                     detail::jobmeta_t &meta, bool x,
+                                     planner_multi_t *p)
+{
+    int rc = -1;
+    std::string key = std::to_string (meta.duration)
+                      + ((x)? "x:" : ":");
+    uint64_t generation = get_graph_db ()->metadata.generation;
+
+    shape_key (jobspec.resources, key);
+    if (m_sat_generation != generation) {
+        m_sat_cache.clear ();
+        m_sat_lru.clear ();
+        m_sat_generation = generation;
+    }
+    meta.alloc_type = jobmeta_t::alloc_type_t::AT_SATISFIABILITY;
+    meta.at = planner_multi_base_time (p)
+              + planner_multi_duration (p) - meta.duration - 1;
+
+    auto it = m_sat_cache.find (key);
+    if (it != m_sat_cache.end ()) {
+        m_sat_lru.splice (m_sat_lru.begin (), m_sat_lru, it->second.second);
+        rc = (it->second.first)? 0 : -1;
+    } else {
+        rc = timed_select (jobspec, root, meta, x);
+        m_total_preorder += detail::dfu_impl_t::get_preorder_count ();
+        m_total_postorder += detail::dfu_impl_t::get_postorder_count ();
+        // A verdict is only as good as the select that reached it
+        if (rc == 0 || errno == EBUSY)
+            sat_cache_put (key, rc == 0);
+    }
+    if (rc < 0) {
+        errno = (errno == EBUSY)? ENODEV : errno;
+        detail::dfu_impl_t::update ();
+    }
+    return rc;
+}
+
 int dfu_traverser_t::schedule (Jobspec::Jobspec &jobspec,
                                detail::jobmeta_t &meta, bool x, match_op_t op,
                                vtx_t root,
@@ -57,28 +177,20 @@ int dfu_traverser_t::schedule (Jobspec::Jobspec &jobspec,
     planner_multi_t *p = NULL;
     const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
 
-    if ((rc = detail::dfu_impl_t::select (jobspec, root, meta, x)) == 0) {
-        m_total_preorder = detail::dfu_impl_t::get_preorder_count ();
-        m_total_postorder = detail::dfu_impl_t::get_postorder_count ();
+    rc = timed_select (jobspec, root, meta, x);
+    m_total_preorder = detail::dfu_impl_t::get_preorder_count ();
+    m_total_postorder = detail::dfu_impl_t::get_postorder_count ();
+    if (rc == 0)
         goto out;
-    }
 
     /* Currently no resources/devices available... Do more... */
     switch (op) {
     case match_op_t::MATCH_ALLOCATE_W_SATISFIABILITY: {
         /* With satisfiability check */
         errno = EBUSY;
-        meta.alloc_type = jobmeta_t::alloc_type_t::AT_SATISFIABILITY;
         p = (*get_graph ())[root].idata.subplans.at (dom);
-        meta.at = planner_multi_base_time (p)
-                  + planner_multi_duration (p) - meta.duration - 1;
         detail::dfu_impl_t::count_relevant_types (p, dfv, agg);
-        if (detail::dfu_impl_t::select (jobspec, root, meta, x) < 0) {
-            errno = (errno == EBUSY)? ENODEV : errno;
-            detail::dfu_impl_t::update ();
-        }
-        m_total_preorder += detail::dfu_impl_t::get_preorder_count ();
-        m_total_postorder += detail::dfu_impl_t::get_postorder_count ();
+        satisfiability (jobspec, root, meta, x, p);
         break;
     }
     case match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE: {
@@ -90,25 +202,20 @@ int dfu_traverser_t::schedule (Jobspec::Jobspec &jobspec,
         len = planner_multi_resources_len (p);
         duration = meta.duration;
         detail::dfu_impl_t::count_relevant_types (p, dfv, agg);
-        for (t = planner_multi_avail_time_first (p, t, duration, &agg[0], len);
-             (t != -1 && rc && !errno); t = planner_multi_avail_time_next (p)) {
+        for (t = timed_avail_time_first (p, t, duration, &agg[0], len);
+             (t != -1 && rc && !errno); t = timed_avail_time_next (p)) {
             meta.at = t;
-            rc = detail::dfu_impl_t::select (jobspec, root, meta, x);
+            // Skip times at which too few vertices can take their share
+            if (detail::dfu_impl_t::screen (jobspec.resources, meta) < 0)
+                continue;
+            rc = timed_select (jobspec, root, meta, x);
             m_total_preorder += detail::dfu_impl_t::get_preorder_count ();
             m_total_postorder += detail::dfu_impl_t::get_postorder_count ();
         }
         // The planner layer returns ENOENT when no scheduleable point exists
         if (rc < 0 && errno == ENOENT) {
             errno = EBUSY;
-            meta.alloc_type = jobmeta_t::alloc_type_t::AT_SATISFIABILITY;
-            meta.at = planner_multi_base_time (p)
-                      + planner_multi_duration (p) - duration - 1;
-            if (detail::dfu_impl_t::select (jobspec, root, meta, x) < 0) {
-                errno = (errno == EBUSY)? ENODEV : errno;
-                detail::dfu_impl_t::update ();
-            }
-            m_total_preorder += detail::dfu_impl_t::get_preorder_count ();
-            m_total_postorder += detail::dfu_impl_t::get_postorder_count ();
+            satisfiability (jobspec, root, meta, x, p);
         }
         break;
     }
@@ -194,6 +301,37 @@ const unsigned int dfu_traverser_t::get_total_postorder_count () const
     return m_total_postorder;
 }
 
+const match_phase_times_t &dfu_traverser_t::get_phase_times () const
+{
+    return m_phase_times;
+}
+
+const std::shared_ptr<dfu_trace_t> &dfu_traverser_t::get_trace () const
+{
+    return detail::dfu_impl_t::get_trace ();
+}
+
+int dfu_traverser_t::enable_trace (const std::string &path,
+                                   uint64_t threshold, unsigned int sample)
+{
+    std::shared_ptr<dfu_trace_t> t = nullptr;
+    try {
+        t = std::make_shared<dfu_trace_t> ();
+    } catch (std::bad_alloc &e) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (t->open_file (path, threshold, sample) < 0)
+        return -1;
+    detail::dfu_impl_t::set_trace (t);
+    return 0;
+}
+
+void dfu_traverser_t::disable_trace ()
+{
+    detail::dfu_impl_t::set_trace (nullptr);
+}
+
 void dfu_traverser_t::set_graph (std::shared_ptr<f_resource_graph_t> g)
 {
     detail::dfu_impl_t::set_graph (g);
@@ -243,6 +381,28 @@ int dfu_traverser_t::initialize ()
                                                         root, from_dfv);
     }
     m_initialized = (rc == 0)? true : false;
+    m_nprimed = num_vertices (get_graph_db ()->resource_graph);
+    return rc;
+}
+
+int dfu_traverser_t::grow ()
+{
+    int rc = 0;
+    if (!m_initialized)
+        return initialize ();
+
+    for (auto &subsystem : get_match_cb ()->subsystems ()) {
+        if (get_graph_db ()->metadata.roots.find (subsystem)
+            == get_graph_db ()->metadata.roots.end ()) {
+            errno = ENOTSUP;
+            rc = -1;
+            break;
+        }
+        rc += detail::dfu_impl_t::prime_pruning_filter_from (subsystem,
+                                                             m_nprimed);
+    }
+    m_initialized = (rc == 0)? true : false;
+    m_nprimed = num_vertices (get_graph_db ()->resource_graph);
     return rc;
 }
 
@@ -270,15 +430,31 @@ int dfu_traverser_t::run (Jobspec::Jobspec &jobspec,
     }
 
     int rc = -1;
+    uint64_t t0 = 0;
     detail::jobmeta_t meta;
     vtx_t root = get_graph_db ()->metadata.roots.at (dom);
     bool x = detail::dfu_impl_t::exclusivity (jobspec.resources, root);
     std::unordered_map<std::string, int64_t> dfv;
+    dfu_trace_t *trace = get_trace ().get ();
+    m_phase_times.reset ();
+    if (trace)
+        trace->begin_match (jobid, op_name (op), root);
     detail::dfu_impl_t::prime_jobspec (jobspec.resources, dfv);
     meta.build (jobspec, detail::jobmeta_t::alloc_type_t::AT_ALLOC, jobid, *at);
     if ( (rc = schedule (jobspec, meta, x, op, root, dfv)) ==  0) {
         *at = meta.at;
-        rc = detail::dfu_impl_t::update (root, writers, meta);
+        t0 = match_perf_now ();
+        {
+            dfu_trace_t::span_t span (trace, "update", root);
+            rc = detail::dfu_impl_t::update (root, writers, meta);
+        }
+        m_phase_times[match_phase_t::UPDATE] += match_perf_now () - t0;
+    }
+    if (trace) {
+        // A trace write error must not fail the match itself
+        int saved_errno = errno;
+        trace->end_match (*get_graph (), dom);
+        errno = saved_errno;
     }
     return rc;
 }
@@ -301,13 +477,19 @@ int dfu_traverser_t::run (const std::string &str,
         return -1;
     }
 
+    int rc = -1;
+    uint64_t t0 = 0;
     vtx_t root = get_graph_db ()->metadata.roots.at (dom);
     detail::jobmeta_t meta;
     meta.jobid = id;
     meta.at = at;
     meta.duration = duration;
 
-    return detail::dfu_impl_t::update (root, writers, str, reader, meta);
+    m_phase_times.reset ();
+    t0 = match_perf_now ();
+    rc = detail::dfu_impl_t::update (root, writers, str, reader, meta);
+    m_phase_times[match_phase_t::UPDATE] += match_perf_now () - t0;
+    return rc;
 }
 
 int dfu_traverser_t::find (std::shared_ptr<match_writers_t> &writers,
@@ -316,7 +498,7 @@ int dfu_traverser_t::find (std::shared_ptr<match_writers_t> &writers,
     return detail::dfu_impl_t::find (writers, criteria);
 }
 
-int dfu_traverser_t::remove (int64_t jobid)
+int dfu_traverser_t::remove (int64_t jobid, int64_t now)
 {
     const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
     if (!get_graph () || !get_graph_db ()
@@ -328,7 +510,7 @@ int dfu_traverser_t::remove (int64_t jobid)
     }
 
     vtx_t root = get_graph_db ()->metadata.roots.at (dom);
-    return detail::dfu_impl_t::remove (root, jobid);
+    return detail::dfu_impl_t::remove (root, jobid, now);
 }
 
 int dfu_traverser_t::mark (const std::string &root_path, 
@@ -343,6 +525,18 @@ int dfu_traverser_t::mark (std::set<int64_t> &ranks,
     return detail::dfu_impl_t::mark (ranks, status);
 }
 
+int dfu_traverser_t::shrink (const std::set<int64_t> &ranks)
+{
+    int rc = -1;
+    if (!m_initialized) {
+        errno = EINVAL;
+        return rc;
+    }
+    rc = detail::dfu_impl_t::shrink (ranks);
+    m_nprimed = num_vertices (get_graph_db ()->resource_graph);
+    return rc;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
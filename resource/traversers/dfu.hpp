@@ -27,7 +27,9 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <list>
 #include "resource/traversers/dfu_impl.hpp"
+#include "resource/traversers/match_perf.hpp"
 
 namespace Flux {
 namespace resource_model {
@@ -57,6 +59,32 @@ public:
     const unsigned int get_total_preorder_count () const;
     const unsigned int get_total_postorder_count () const;
 
+    /*! Return the time spent in each phase (select, avail and update)
+     *  of the last run invocation.
+     */
+    const match_phase_times_t &get_phase_times () const;
+
+    /*! Start tracing the DFU walks of the match operations into path in
+     *  Chrome trace event format. Only one out of every sample matches
+     *  is recorded and it is written out only if it took at least
+     *  threshold nanoseconds.
+     *
+     *  \param path      output file path (truncated)
+     *  \param threshold minimum match latency in nanoseconds
+     *  \param sample    sampling period in matches (>= 1)
+     *  \return          0 on success; -1 on error with errno set.
+     */
+    int enable_trace (const std::string &path, uint64_t threshold,
+                      unsigned int sample);
+
+    /*! Stop tracing and close the trace file.
+     */
+    void disable_trace ();
+
+    /*! Return the tracer or nullptr if tracing is disabled.
+     */
+    const std::shared_ptr<dfu_trace_t> &get_trace () const;
+
     void set_graph (std::shared_ptr<f_resource_graph_t> g);
     void set_graph_db (std::shared_ptr<resource_graph_db_t> db);
     void set_match_cb (std::shared_ptr<dfu_match_cb_t> m);
@@ -101,6 +129,20 @@ public:
                     std::shared_ptr<resource_graph_db_t> db,
                     std::shared_ptr<dfu_match_cb_t> m);
 
+    /*! Prime the subtree plans of the vertices added to the resource graph
+     *  since the last initialize () or grow (), e.g., by attaching a
+     *  subgraph, without re-priming the rest of the graph. The subtree
+     *  plans of the existing ancestors of the new subtrees are resized in
+     *  place, so their planned spans are kept. Fall back to initialize ()
+     *  if the traverser has not been initialized.
+     *
+     *  \return          0 on success; -1 on error.
+     *                       EINVAL: graph, roots or match callback not set.
+     *                       ENOTSUP: roots does not contain a subsystem
+     *                                the match callback uses.
+     */
+    int grow ();
+
     /*! Begin a graph traversal for the jobspec and either allocate or
      *  reserve the resources in the resource graph. Best-matching resources
      *  are selected in accordance with the scoring done by the match callback
@@ -174,10 +216,13 @@ public:
      *  the resource state.
      *
      *  \param jobid     job id.
+     *  \param now       current time against which the out-edges into
+     *                   the freed resources are reweighed; if negative,
+     *                   the traversing order is left as is.
      *  \return          0 on success; -1 on error.
      *                       EINVAL: graph, roots or match callback not set.
      */
-    int remove (int64_t jobid);
+    int remove (int64_t jobid, int64_t now = -1);
 
     /*! Mark the resource status up|down|etc starting at subtree_root.
      *
@@ -197,13 +242,52 @@ public:
      */
     int mark (std::set<int64_t> &ranks, resource_pool_t::status_t status);
 
+    /*! Remove the subgraphs represented by ranks from the resource graph,
+     *  e.g., when their nodes leave for good, and subtract their resources
+     *  from the subtree plans of their ancestors. Jobs are not migrated:
+     *  the removal is refused while a job holds any of the resources.
+     *  Holes left in the vertex storage are compacted once they take up a
+     *  quarter of it, which renumbers the vertices.
+     *
+     *  \param ranks         set of ranks representing the subgraphs to remove.
+     *  \return              0 on success; -1 on error.
+     *                       EINVAL: the traverser is not initialized or
+     *                               a root belongs to one of ranks.
+     *                       EBUSY: a job is allocated or reserved in one of
+     *                              the subgraphs.
+     */
+    int shrink (const std::set<int64_t> &ranks);
+
 private:
     int schedule (Jobspec::Jobspec &jobspec, detail::jobmeta_t &meta,
                   bool x, match_op_t op, vtx_t root,
                   std::unordered_map<std::string, int64_t> &dfv);
+    int timed_select (Jobspec::Jobspec &jobspec, vtx_t root,
+                      detail::jobmeta_t &meta, bool x);
+    int64_t timed_avail_time_first (planner_multi_t *p, int64_t t,
+                                    uint64_t duration,
+                                    const uint64_t *agg, size_t len);
+    int64_t timed_avail_time_next (planner_multi_t *p);
+    int satisfiability (Jobspec::Jobspec &jobspec, vtx_t root,
+                        detail::jobmeta_t &meta, bool x, planner_multi_t *p);
+    void sat_cache_put (const std::string &key, bool sat);
     bool m_initialized = false;
+    // Vertices below this id have been primed
+    vtx_t m_nprimed = 0;
+    match_phase_times_t m_phase_times;
     unsigned int m_total_preorder = 0;
     unsigned int m_total_postorder = 0;
+
+    // Satisfiability verdicts keyed by the shape of the jobspec resources,
+    // valid as long as the graph stays at m_sat_generation. At most
+    // SAT_CACHE_MAX are kept; m_sat_lru orders their keys from the most
+    // to the least recently used, which is evicted first.
+    static const size_t SAT_CACHE_MAX = 1024;
+    std::list<std::string> m_sat_lru;
+    std::unordered_map<std::string,
+                       std::pair<bool, std::list<std::string>::iterator>>
+                           m_sat_cache;
+    uint64_t m_sat_generation = 0;
 };
 
 } // namespace resource_model
@@ -53,6 +53,7 @@ void dfu_impl_t::tick ()
 {
     m_best_k_cnt++;
     m_color.reset ();
+    m_commit.clear ();
 }
 
 bool dfu_impl_t::in_subsystem (edg_t e, const subsystem_t &subsystem) const
@@ -84,21 +85,50 @@ bool dfu_impl_t::exclusivity (const std::vector<Jobspec::Resource> &resources,
     return exclusive;
 }
 
+int64_t dfu_impl_t::avail_during (const jobmeta_t &meta, vtx_t u)
+{
+    avail_probe_t &probe = (*m_graph)[u].idata.probe;
+
+    if (!probe.is_for (m_best_k_cnt, meta.at, meta.duration))
+        probe.reset (m_best_k_cnt, meta.at, meta.duration);
+    if (probe.avail == -1) {
+        dfu_trace_t::span_t span (m_trace.get (),
+                                  "planner_avail_resources_during", u);
+        probe.avail = planner_avail_resources_during (
+                          (*m_graph)[u].schedule.plans,
+                          meta.at, meta.duration);
+    }
+    return probe.avail;
+}
+
+int64_t dfu_impl_t::njobs_during (const jobmeta_t &meta, vtx_t u)
+{
+    avail_probe_t &probe = (*m_graph)[u].idata.probe;
+
+    if (!probe.is_for (m_best_k_cnt, meta.at, meta.duration))
+        probe.reset (m_best_k_cnt, meta.at, meta.duration);
+    if (probe.njobs == -1) {
+        dfu_trace_t::span_t span (m_trace.get (),
+                                  "planner_avail_resources_during", u);
+        probe.njobs = planner_avail_resources_during (
+                          (*m_graph)[u].idata.x_checker,
+                          meta.at, meta.duration);
+    }
+    return probe.njobs;
+}
+
 int dfu_impl_t::by_avail (const jobmeta_t &meta, const std::string &s, vtx_t u,
                           const std::vector<Jobspec::Resource> &resources)
 {
     int rc = -1;
     int64_t avail = -1;
-    planner_t *p = NULL;
-    int64_t at = meta.at;
     int saved_errno = errno;
-    uint64_t duration = meta.duration;
 
     errno = 0;
     // Prune by the visiting resource vertex's availability
     // if rack has been allocated exclusively, no reason to descend further.
-    p = (*m_graph)[u].schedule.plans;
-    if ((avail = planner_avail_resources_during (p, at, duration)) == 0) {
+    avail = avail_during (meta, u);
+    if (avail == 0) {
         goto done;
     } else if (avail == -1) {
         m_err_msg += "by_avail: planner_avail_resources_during returned -1.\n";
@@ -119,11 +149,8 @@ int dfu_impl_t::by_excl (const jobmeta_t &meta, const std::string &s, vtx_t u,
                          bool exclusive_in, const Jobspec::Resource &resource)
 {
     int rc = -1;
-    planner_t *p = NULL;
-    int64_t at = meta.at;
     int64_t njobs = -1;
     int saved_errno = errno;
-    uint64_t duration = meta.duration;
 
     // If a non-exclusive resource request is explicitly given on a
     // resource that lies under slot, this spec is invalid.
@@ -139,8 +166,7 @@ int dfu_impl_t::by_excl (const jobmeta_t &meta, const std::string &s, vtx_t u,
     // its x_checker planner.
     if (exclusive_in || resource.exclusive == Jobspec::tristate_t::TRUE) {
         errno = 0;
-        p = (*m_graph)[u].idata.x_checker;
-        njobs = planner_avail_resources_during (p, at, duration);
+        njobs = njobs_during (meta, u);
         if (njobs == -1) {
             m_err_msg += "by_excl: planner_avail_resources_during.\n";
             if (errno != 0) {
@@ -181,7 +207,12 @@ int dfu_impl_t::by_subplan (const jobmeta_t &meta, const std::string &s, vtx_t u
     count_relevant_types (p, resource.user_data, aggs);
     errno = 0;
     len = aggs.size ();
-    if ((rc = planner_multi_avail_during (p, at, d, &(aggs[0]), len)) == -1) {
+    {
+        dfu_trace_t::span_t span (m_trace.get (),
+                                  "planner_multi_avail_during", u);
+        rc = planner_multi_avail_during (p, at, d, &(aggs[0]), len);
+    }
+    if (rc == -1) {
         if (errno != 0) {
             m_err_msg += "by_subplan: planner_multi_avail_during returned -1.\n";
             m_err_msg += strerror (errno);
@@ -200,6 +231,7 @@ int dfu_impl_t::prune (const jobmeta_t &meta, bool exclusive,
                        const std::vector<Jobspec::Resource> &resources)
 {
     int rc = 0;
+    dfu_trace_t::span_t span (m_trace.get (), "prune", u);
     // Prune by the visiting resource vertex's availability
     // If resource is not UP, no reason to descend further.
     if (meta.alloc_type != jobmeta_t::alloc_type_t::AT_SATISFIABILITY
@@ -226,6 +258,61 @@ done:
     return rc;
 }
 
+int64_t dfu_impl_t::count_anchors (const Jobspec::Resource &resource,
+                                   const jobmeta_t &meta, int64_t needs)
+{
+    int64_t n = 0;
+    int64_t avail = 0;
+    int saved_errno = errno;
+    std::vector<uint64_t> aggs;
+    const std::string &dom = m_match->dom_subsystem ();
+    const auto &by_type = m_graph_db->metadata.by_type;
+    auto it = by_type.find (resource.type);
+
+    // Without a vertex of this type to count, leave it to select
+    if (it == by_type.end ())
+        return needs;
+    for (vtx_t u : it->second) {
+        if ((*m_graph)[u].status != resource_pool_t::status_t::UP)
+            continue;
+        if ( (avail = planner_avail_resources_during (
+                          (*m_graph)[u].schedule.plans,
+                          meta.at, meta.duration)) <= 0)
+            continue;
+        auto sit = (*m_graph)[u].idata.subplans.find (dom);
+        if (sit != (*m_graph)[u].idata.subplans.end () && sit->second
+            && !resource.user_data.empty ()) {
+            aggs.clear ();
+            count_relevant_types (sit->second, resource.user_data, aggs);
+            if (planner_multi_avail_during (sit->second, meta.at,
+                                            meta.duration, &(aggs[0]),
+                                            aggs.size ()) != 0)
+                continue;
+        }
+        // A pool vertex (e.g., memory) holds as many instances as units
+        if ( (n += avail) >= needs)
+            break;
+    }
+    // A probe that fails, e.g., with ERANGE on a vertex too small for
+    // the request, rules that vertex out; it is not an error.
+    errno = saved_errno;
+    return n;
+}
+
+int dfu_impl_t::screen (const std::vector<Jobspec::Resource> &resources,
+                        const jobmeta_t &meta, int64_t needs)
+{
+    for (auto &resource : resources) {
+        int64_t n = needs * resource.count.min;
+        if (resource.type != "slot"
+            && count_anchors (resource, meta, n) < n)
+            return -1;
+        if (screen (resource.with, meta, n) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 planner_multi_t *dfu_impl_t::subtree_plan (vtx_t u, std::vector<uint64_t> &av,
                                            std::vector<const char *> &tp)
 {
@@ -235,6 +322,46 @@ planner_multi_t *dfu_impl_t::subtree_plan (vtx_t u, std::vector<uint64_t> &av,
     return planner_multi_new (base_time, duration, &av[0], &tp[0], len);
 }
 
+vtx_t dfu_impl_t::parent_by_path (const subsystem_t &s, vtx_t u) const
+{
+    size_t pos;
+    auto it = (*m_graph)[u].paths.find (s);
+    if (it == (*m_graph)[u].paths.end ()
+        || (pos = it->second.rfind ('/')) == 0 || pos == std::string::npos)
+        return boost::graph_traits<resource_graph_t>::null_vertex ();
+    return m_graph_db->metadata.by_path.find (it->second.substr (0, pos));
+}
+
+int dfu_impl_t::resize_subplan (const subsystem_t &s, vtx_t u,
+                                const std::map<std::string, int64_t> &delta)
+{
+    int rc = 0;
+    bool changed = false;
+    auto it = (*m_graph)[u].idata.subplans.find (s);
+    if (it == (*m_graph)[u].idata.subplans.end () || !it->second)
+        return 0;
+
+    planner_multi_t *p = it->second;
+    size_t len = planner_multi_resources_len (p);
+    const char **types = planner_multi_resource_types (p);
+    const uint64_t *totals = planner_multi_resource_totals (p);
+    std::vector<uint64_t> resized (totals, totals + len);
+    for (size_t i = 0; i < len; i++) {
+        auto d = delta.find (types[i]);
+        if (d != delta.end ()) {
+            resized[i] += d->second;
+            changed = true;
+        }
+    }
+    if (changed && (rc = planner_multi_resize (p, &resized[0], len)) != 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": planner_multi_resize: ";
+        m_err_msg += strerror (errno);
+        m_err_msg += ".\n";
+    }
+    return rc;
+}
+
 int dfu_impl_t::match (vtx_t u, const std::vector<Resource> &resources,
                        const Resource **slot_resource, unsigned int *nslots,
                        const Resource **match_resource)
@@ -379,7 +506,8 @@ int dfu_impl_t::prime_exp (const subsystem_t &subsystem, vtx_t u,
     int rc = 0;
     f_out_edg_iterator_t ei, ei_end;
     for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
-        if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
+        if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem)
+            || target (*ei, *m_graph) < m_prime_floor)
             continue;
         if ((rc = prime_pruning_filter (subsystem,
                                         target (*ei, *m_graph), dfv)) != 0)
@@ -479,8 +607,8 @@ int dfu_impl_t::explore_dynamically (const jobmeta_t &meta, vtx_t u,
     std::set<std::string> sat_types;
     // outedges contains outedge map for vertex u, sorted in available resources
     auto &outedges = iter->second;
-    for (auto &kv : outedges) {
-        edg_t e = kv.second;
+    for (auto &oe : outedges) {
+        edg_t e = oe.edge;
         if (!in_subsystem (e, subsystem) || stop_explore (e, subsystem))
             continue;
         vtx_t tgt = target (e, *m_graph);
@@ -535,10 +663,9 @@ int dfu_impl_t::aux_upv (const jobmeta_t &meta, vtx_t u, const subsystem_t &aux,
 {
     int rc = -1;
     scoring_api_t upv;
-    int64_t avail = 0, at = meta.at;
-    uint64_t duration = meta.duration;
-    planner_t *p = NULL;
+    int64_t avail = 0;
     bool x_in = *excl;
+    dfu_trace_t::span_t span (m_trace.get (), "aux_upv", u);
 
     if ((prune (meta, x_in, aux, u, resources) == -1)
         || (m_match->aux_discover_vtx (u, aux, resources, *m_graph)) != 0)
@@ -547,8 +674,8 @@ int dfu_impl_t::aux_upv (const jobmeta_t &meta, vtx_t u, const subsystem_t &aux,
     if (u != (*m_roots)[aux])
         explore (meta, u, aux, resources, pristine, excl, visit_t::UPV, upv);
 
-    p = (*m_graph)[u].schedule.plans;
-    if ( (avail = planner_avail_resources_during (p, at, duration)) == 0) {
+    avail = avail_during (meta, u);
+    if (avail == 0) {
         goto done;
     } else if (avail == -1) {
         m_err_msg += "aux_upv: planner_avail_resources_during returned -1. ";
@@ -676,15 +803,14 @@ int dfu_impl_t::dom_dfv (const jobmeta_t &meta, vtx_t u,
 {
     int rc = -1;
     match_kind_t sm;
-    int64_t avail = 0, at = meta.at;
-    uint64_t duration = meta.duration;
+    int64_t avail = 0;
     bool x_in = *excl || exclusivity (resources, u);
     bool x_inout = x_in;
     bool check_pres = pristine;
     unsigned int nslots = 0;
     scoring_api_t dfu;
-    planner_t *p = NULL;
     const std::string &dom = m_match->dom_subsystem ();
+    dfu_trace_t::span_t span (m_trace.get (), "dom_dfv", u);
     const std::vector<Resource> &next = test (u, resources,
                                               check_pres, nslots, sm);
 
@@ -701,8 +827,9 @@ int dfu_impl_t::dom_dfv (const jobmeta_t &meta, vtx_t u,
         dom_exp (meta, u, next, check_pres, &x_inout, dfu);
     *excl = x_in;
     (*m_graph)[u].idata.colors[dom] = m_color.black ();
-    p = (*m_graph)[u].schedule.plans;
-    if ( (avail = planner_avail_resources_during (p, at, duration)) == 0) {
+    // prune has already probed this window; reuse its answer
+    avail = avail_during (meta, u);
+    if (avail == 0) {
         goto done;
     } else if (avail == -1) {
         m_err_msg += "dom_dfv: planner_avail_resources_during returned -1.\n";
@@ -818,6 +945,7 @@ int dfu_impl_t::resolve (vtx_t root, std::vector<Resource> &resources,
     unsigned int qc;
     unsigned int count;
     const subsystem_t &dom = m_match->dom_subsystem ();
+    dfu_trace_t::span_t span (m_trace.get (), "resolve", root);
     if (m_match->dom_finish_graph (dom, resources, *m_graph, dfu) != 0)
         goto done;
 
@@ -877,6 +1005,7 @@ int dfu_impl_t::enforce (const subsystem_t &subsystem, scoring_api_t &dfu)
                     continue;
                 const eval_egroup_t &egroup = dfu.at (subsystem, t, i);
                 for (auto &e : egroup.edges) {
+                    commit_edg (e.edge);
                     (*m_graph)[e.edge].idata.set_for_trav_update (e.needs,
                                                                   e.exclusive,
                                                                   m_best_k_cnt);
@@ -890,6 +1019,43 @@ int dfu_impl_t::enforce (const subsystem_t &subsystem, scoring_api_t &dfu)
     return rc;
 }
 
+void dfu_impl_t::order_out_edges (vtx_t u)
+{
+    uint64_t ordinal = 0;
+    f_out_edg_iterator_t ei, ei_end;
+    for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei)
+        (*m_graph)[*ei].idata.set_ordinal (++ordinal);
+}
+
+void dfu_impl_t::commit_edg (edg_t e)
+{
+    // An edge already carrying this traversal's token is on the list
+    if (m_commit_token != m_best_k_cnt
+        || (*m_graph)[e].idata.get_trav_token () == m_best_k_cnt)
+        return;
+    vtx_t src = source (e, *m_graph);
+    // Out-edges are only ever appended to or removed from a vertex's
+    // list, so ordinals once assigned keep their relative order and
+    // a source is only rescanned when it gained an edge since.
+    if ((*m_graph)[e].idata.get_ordinal () == 0)
+        order_out_edges (src);
+    m_commit.push_back ({src, (*m_graph)[e].idata.get_ordinal (), e});
+}
+
+void dfu_impl_t::sort_commit ()
+{
+    std::sort (m_commit.begin (), m_commit.end (),
+               [] (const commit_edg_t &a, const commit_edg_t &b) {
+                   return (a.src < b.src)
+                          || (a.src == b.src && a.ordinal < b.ordinal);
+               });
+}
+
+bool dfu_impl_t::commit_valid () const
+{
+    return m_commit_token == m_best_k_cnt;
+}
+
 
 /****************************************************************************
  *                                                                          *
@@ -918,7 +1084,11 @@ dfu_impl_t::dfu_impl_t (const dfu_impl_t &o)
     m_graph = o.m_graph;
     m_graph_db = o.m_graph_db;
     m_match = o.m_match;
+    m_trace = o.m_trace;
     m_err_msg = o.m_err_msg;
+    m_commit = o.m_commit;
+    m_commit_token = o.m_commit_token;
+    m_prime_floor = o.m_prime_floor;
 }
 
 dfu_impl_t &dfu_impl_t::operator= (const dfu_impl_t &o)
@@ -929,7 +1099,11 @@ dfu_impl_t &dfu_impl_t::operator= (const dfu_impl_t &o)
     m_graph = o.m_graph;
     m_graph_db = o.m_graph_db;
     m_match = o.m_match;
+    m_trace = o.m_trace;
     m_err_msg = o.m_err_msg;
+    m_commit = o.m_commit;
+    m_commit_token = o.m_commit_token;
+    m_prime_floor = o.m_prime_floor;
     return *this;
 }
 
@@ -969,6 +1143,11 @@ const unsigned int dfu_impl_t::get_postorder_count () const
     return m_postorder;
 }
 
+const std::shared_ptr<dfu_trace_t> &dfu_impl_t::get_trace () const
+{
+    return m_trace;
+}
+
 void dfu_impl_t::set_graph (std::shared_ptr<f_resource_graph_t> g)
 {
     m_graph = g;
@@ -989,6 +1168,11 @@ void dfu_impl_t::clear_err_message ()
     m_err_msg = "";
 }
 
+void dfu_impl_t::set_trace (std::shared_ptr<dfu_trace_t> t)
+{
+    m_trace = t;
+}
+
 void dfu_impl_t::reset_color ()
 {
     m_color.reset ();
@@ -1041,6 +1225,40 @@ done:
     return rc;
 }
 
+int dfu_impl_t::prime_pruning_filter_from (const subsystem_t &s, vtx_t first)
+{
+    int rc = 0;
+    vtx_t u, p;
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    vtx_t end = num_vertices (m_graph_db->resource_graph);
+    std::map<vtx_t, std::map<std::string, int64_t>> deltas;
+
+    m_color.reset ();
+    m_prime_floor = first;
+    for (u = first; u < end; u++) {
+        if ((*m_graph)[u].paths.find (s) == (*m_graph)[u].paths.end ())
+            continue;
+        // A new vertex under a new parent is primed with its parent
+        if ((p = parent_by_path (s, u)) != null_v && p >= first)
+            continue;
+        std::map<std::string, int64_t> to_parent;
+        if ( (rc = prime_pruning_filter (s, u, to_parent)) != 0)
+            break;
+        for (; p != null_v; p = parent_by_path (s, p)) {
+            for (auto &aggr : to_parent)
+                deltas[p][aggr.first] += aggr.second;
+        }
+    }
+    m_prime_floor = 0;
+
+    for (auto &kv : deltas) {
+        if (rc != 0)
+            break;
+        rc = resize_subplan (s, kv.first, kv.second);
+    }
+    return rc;
+}
+
 void dfu_impl_t::prime_jobspec (std::vector<Resource> &resources,
                                 std::unordered_map<std::string,
                                                    int64_t> &to_parent)
@@ -1067,6 +1285,7 @@ int dfu_impl_t::select (Jobspec::Jobspec &j, vtx_t root, jobmeta_t &meta,
     const std::string &dom = m_match->dom_subsystem ();
 
     tick ();
+    m_commit_token = m_best_k_cnt;
     m_preorder = 0;
     m_postorder = 0;
     rc = dom_dfv (meta, root, j.resources, true, &x_in, dfu);
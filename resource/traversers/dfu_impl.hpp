@@ -30,6 +30,7 @@
 #include <cstdlib>
 #include <cstdint>
 #include <memory>
+#include <vector>
 #include "resource/libjobspec/jobspec.hpp"
 #include "resource/config/system_defaults.hpp"
 #include "resource/schema/resource_data.hpp"
@@ -41,6 +42,7 @@
 #include "resource/writers/match_writers.hpp"
 #include "resource/store/resource_graph_store.hpp"
 #include "resource/readers/resource_reader_base.hpp"
+#include "resource/traversers/dfu_trace.hpp"
 #include "resource/planner/planner.h"
 
 namespace Flux {
@@ -122,6 +124,7 @@ public:
     const expr_eval_api_t &get_expr_eval () const;
     const unsigned int get_preorder_count () const;
     const unsigned int get_postorder_count () const;
+    const std::shared_ptr<dfu_trace_t> &get_trace () const;
 
     void set_graph (std::shared_ptr<f_resource_graph_t> g);
     void set_graph_db (std::shared_ptr<resource_graph_db_t> db);
@@ -129,6 +132,12 @@ public:
     void clear_err_message ();
     void reset_color ();
 
+    /*! Set the tracer that records the spans of the traversals.
+     *  nullptr (the default) disables tracing at the cost of a branch
+     *  per instrumented routine.
+     */
+    void set_trace (std::shared_ptr<dfu_trace_t> t);
+
     /*! Exclusive request? Return true if a resource in resources vector
      *  matches resource vertex u and its exclusivity field value is TRUE.
      *  (Note that when the system default configuration is added, it can
@@ -157,6 +166,20 @@ public:
     int prime_pruning_filter (const subsystem_t &subsystem, vtx_t u,
                              std::map<std::string, int64_t> &to_parent);
 
+    /*! Prime the subtree plans of the vertices added to the resource graph
+     *  since it was last primed, i.e., vertices whose id is first or greater.
+     *  Each new subtree whose parent already existed is primed on its own,
+     *  then its aggregates are added to the subtree plans of its ancestors.
+     *  The ancestors' subtree plans are resized in place and keep their
+     *  planned spans. Parents are looked up through the paths of subsystem.
+     *
+     *  \param subsystem depth-first walk on this subsystem graph for priming.
+     *  \param first     first vertex added since the last priming.
+     *  \return          0 on success; -1 on error -- call err_message ()
+     *                   for detail.
+     */
+    int prime_pruning_filter_from (const subsystem_t &subsystem, vtx_t first);
+
     /*! Prime the resource section of the jobspec. Aggregate configured
      *  subtree resources into jobspec's user_data.  For example,
      *  cluster[1]->rack[2]->node[4]->socket[1]->core[2]
@@ -190,6 +213,22 @@ public:
     int count_relevant_types (planner_multi_t *plan, const lookup_t &lookup,
                               std::vector<uint64_t> &resource_counts);
 
+    /*! Rule out a candidate time without traversing. Every instance of a
+     *  non-slot resource in the jobspec must land on a unit of a vertex of
+     *  its type that prune would let through at meta.at: one that is up,
+     *  has available units and whose subtree plan holds the instance's
+     *  aggregates. For each such resource, count the available units of
+     *  these vertices from the by_type index until there are enough.
+     *
+     *  \param resources Resource request vector, primed by prime_jobspec.
+     *  \param meta      metadata on this job with the candidate time.
+     *  \param needs     number of instances of the enclosing resource.
+     *  \return          0 if a select at meta.at may succeed; -1 if there
+     *                   are not enough vertices of some type for it to.
+     */
+    int screen (const std::vector<Jobspec::Resource> &resources,
+                const jobmeta_t &meta, int64_t needs = 1);
+
     /*! Entry point for graph matching and scoring depth-first-and-up (DFU) walk.
      *  It finds best-matching resources and resolves hierarchical constraints.
      *  For example, rack[2]->node[2] will mark the resource graph to select
@@ -283,9 +322,12 @@ public:
      *
      *  \param root      root resource vertex.
      *  \param jobid     job id.
+     *  \param now       current time against which the out-edges into
+     *                   the freed resources are reweighed; if negative,
+     *                   the traversing order is left as is.
      *  \return          0 on success; -1 on error.
      */
-    int remove (vtx_t root, int64_t jobid);
+    int remove (vtx_t root, int64_t jobid, int64_t now);
 
     /*! Update the resource status to up|down|etc starting at subtree_root.
      *
@@ -306,6 +348,21 @@ public:
      */
     int mark (std::set<int64_t> &ranks, resource_pool_t::status_t status);
 
+    /*! Detach the subgraphs represented by ranks from the resource graph.
+     *  The aggregates of the detached subgraphs are subtracted from the
+     *  subtree plans of their remaining ancestors in place, so those keep
+     *  their planned spans. The vertex storage is compacted once holes
+     *  take up a quarter of it.
+     *
+     *  \param ranks         set of ranks representing the subgraphs to detach.
+     *  \return              0 on success; -1 on error -- call err_message ()
+     *                       for detail.
+     *                       EINVAL: a root belongs to one of ranks.
+     *                       EBUSY: a job is allocated or reserved in one of
+     *                              the subgraphs.
+     */
+    int shrink (const std::set<int64_t> &ranks);
+
 private:
 
     /************************************************************************
@@ -319,6 +376,15 @@ private:
     bool in_subsystem (edg_t e, const subsystem_t &subsystem) const;
     bool stop_explore (edg_t e, const subsystem_t &subsystem) const;
 
+    /*! Available units of u's schedule.plans and available jobs of its
+     *  x_checker over [meta.at, meta.at + meta.duration). Each planner is
+     *  searched at most once per vertex and window within a select; the
+     *  answer is cached in u's avail_probe_t under the traversal token.
+     *  Return -1 on error.
+     */
+    int64_t avail_during (const jobmeta_t &meta, vtx_t u);
+    int64_t njobs_during (const jobmeta_t &meta, vtx_t u);
+
     /*! Various pruning methods
      */
     int by_avail (const jobmeta_t &meta, const std::string &s, vtx_t u,
@@ -330,6 +396,13 @@ private:
     int prune (const jobmeta_t &meta, bool excl, const std::string &subsystem,
                vtx_t u, const std::vector<Jobspec::Resource> &resources);
 
+    /*! Count, up to needs, the available units of the vertices that could
+     *  hold an instance of resource at meta.at. See screen. errno is
+     *  left unchanged.
+     */
+    int64_t count_anchors (const Jobspec::Resource &resource,
+                           const jobmeta_t &meta, int64_t needs);
+
     planner_multi_t *subtree_plan (vtx_t u, std::vector<uint64_t> &avail,
                                    std::vector<const char *> &types);
 
@@ -411,6 +484,12 @@ private:
     int resolve (scoring_api_t &dfu, scoring_api_t &to_parent);
     int enforce (const subsystem_t &subsystem, scoring_api_t &dfu);
 
+    // Record the edges enforce selects so that update can replay them
+    void order_out_edges (vtx_t u);
+    void commit_edg (edg_t e);
+    void sort_commit ();
+    bool commit_valid () const;
+
 
     /************************************************************************
      *                                                                      *
@@ -430,7 +509,7 @@ private:
     int upd_idata (vtx_t u, const subsystem_t &s, const jobmeta_t &jobmeta,
                    const std::map<std::string, int64_t> &dfu);
     int upd_by_outedges (const subsystem_t &subsystem,
-                         const jobmeta_t &jobmeta, vtx_t u, edg_t e);
+                         int64_t now, vtx_t u, edg_t e);
     int upd_plan (vtx_t u, const subsystem_t &s, unsigned int needs,
                   bool excl, const jobmeta_t &jobmeta, bool full, int &n);
     int accum_to_parent (vtx_t u, const subsystem_t &s, unsigned int needs,
@@ -449,6 +528,9 @@ private:
                  const subsystem_t &subsystem, unsigned int needs, bool excl,
                  const jobmeta_t &jobmeta, bool full,
                  std::map<std::string, int64_t> &to_parent);
+    int upd_edg (vtx_t u, edg_t e, std::shared_ptr<match_writers_t> &writers,
+                 const subsystem_t &subsystem, const jobmeta_t &jobmeta,
+                 bool full, std::map<std::string, int64_t> &dfu);
     int upd_dfv (vtx_t u, std::shared_ptr<match_writers_t> &writers,
                  unsigned int needs, bool excl, const jobmeta_t &jobmeta,
                  bool full, std::map<std::string, int64_t> &to_parent);
@@ -458,9 +540,18 @@ private:
     int rem_idata (vtx_t u, int64_t jobid, const std::string &s, bool &stop);
     int rem_plan (vtx_t u, int64_t jobid);
     int rem_upv (vtx_t u, int64_t jobid);
-    int rem_dfv (vtx_t u, int64_t jobid);
+    int rem_dfv (vtx_t u, int64_t jobid, int64_t now);
     int rem_exv (int64_t jobid);
 
+    /************************************************************************
+     *                                                                      *
+     *                 Private Incremental Priming API                      *
+     *                                                                      *
+     ************************************************************************/
+    vtx_t parent_by_path (const subsystem_t &subsystem, vtx_t u) const;
+    int resize_subplan (const subsystem_t &subsystem, vtx_t u,
+                        const std::map<std::string, int64_t> &delta);
+
 
     /************************************************************************
      *                                                                      *
@@ -476,8 +567,27 @@ private:
     std::shared_ptr<f_resource_graph_t> m_graph = nullptr;
     std::shared_ptr<resource_graph_db_t> m_graph_db = nullptr;
     std::shared_ptr<dfu_match_cb_t> m_match = nullptr;
+    std::shared_ptr<dfu_trace_t> m_trace = nullptr;
     expr_eval_api_t m_expr_eval;
     std::string m_err_msg = "";
+
+    /*! Commit list: the edges the last select enforced, sorted by source
+     *  vertex and then by out-edge order once update starts. update
+     *  replays only these edges instead of scanning every out-edge of
+     *  the vertices along the selected paths. It is valid only while
+     *  m_commit_token equals m_best_k_cnt; an update driven by a reader
+     *  falls back to scanning for the trav tokens set by that reader.
+     */
+    struct commit_edg_t {
+        vtx_t src;
+        uint64_t ordinal;
+        edg_t edge;
+    };
+    std::vector<commit_edg_t> m_commit;
+    uint64_t m_commit_token = 0;
+
+    //! Priming doesn't descend into vertices below this id
+    vtx_t m_prime_floor = 0;
 }; // the end of class dfu_impl_t
 
 template <class lookup_t>
@@ -120,7 +120,7 @@ done:
 }
 
 int dfu_impl_t::upd_by_outedges (const subsystem_t &subsystem,
-                                 const jobmeta_t &jobmeta, vtx_t u, edg_t e)
+                                 int64_t now, vtx_t u, edg_t e)
 {
     size_t len = 0;
     vtx_t tgt = target (e, *m_graph);
@@ -130,32 +130,30 @@ int dfu_impl_t::upd_by_outedges (const subsystem_t &subsystem,
             return -1;
 
         // Set dynamic traversing order based on the following heuristics:
-        //     1. Current-time (jobmeta.now) resource availability
+        //     1. Current-time (now) resource availability
         //     2. Last pruning filter resource type (if additional
         //        pruning filter type was given, that's a good
         //        indication that it is the scarcest resource)
         int64_t avail = planner_multi_avail_resources_at (subplan,
-                                                          jobmeta.now, len - 1);
+                                                          now, len - 1);
         // Special case to skip (e.g., leaf resource vertices)
         if (avail == 0 && planner_multi_span_size (subplan) == 0)
             return 0;
 
-        auto key = std::make_pair ((*m_graph)[e].idata.get_weight (),
-                                   (*m_graph)[tgt].uniq_id);
-        m_graph_db->metadata.by_outedges[u].erase (key);
-
-        (*m_graph)[e].idata.set_weight ((avail == -1)? 0 : avail);
-        key = std::make_pair ((*m_graph)[e].idata.get_weight (),
-                              (*m_graph)[tgt].uniq_id);
-        // Reinsert so that outedges are maintained according to the current
-        // resource availability state. Leverage the fact that std::map
-        // uses a RedBlack tree keep its elemented in sorted order.
-        auto ret = m_graph_db->metadata.by_outedges[u].insert (
-                                            std::make_pair (key, e));
-        if (!ret.second) {
+        uint64_t weight = (*m_graph)[e].idata.get_weight ();
+        uint64_t new_weight = (avail == -1)? 0 : avail;
+        int64_t uniq_id = (*m_graph)[tgt].uniq_id;
+        outedges_t &outedges = m_graph_db->metadata.by_outedges[u];
+
+        // Slide the edge into the bucket of its new weight so that
+        // outedges are maintained according to the current resource
+        // availability state.
+        if (!outedges.reweigh (weight, uniq_id, new_weight)
+            && !outedges.insert (new_weight, uniq_id, e)) {
             errno = ENOMEM;
             return -1;
         }
+        (*m_graph)[e].idata.set_weight (new_weight);
     }
     return 0;
 }
@@ -285,6 +283,43 @@ int dfu_impl_t::upd_upv (vtx_t u, std::shared_ptr<match_writers_t> &writers,
     return 0;
 }
 
+int dfu_impl_t::upd_edg (vtx_t u, edg_t e,
+                         std::shared_ptr<match_writers_t> &writers,
+                         const subsystem_t &subsystem, const jobmeta_t &jobmeta,
+                         bool full, std::map<std::string, int64_t> &dfu)
+{
+    if (!in_subsystem (e, subsystem) || stop_explore (e, subsystem))
+        return 0;
+    if ((*m_graph)[e].idata.get_trav_token () != m_best_k_cnt)
+        return 0;
+
+    int n_plan_sub = 0;
+    bool x = (*m_graph)[e].idata.get_exclusive ();
+    unsigned int needs = (*m_graph)[e].idata.get_needs ();
+    vtx_t tgt = target (e, *m_graph);
+    if (subsystem == m_match->dom_subsystem ()) {
+        n_plan_sub += upd_dfv (tgt, writers,
+                               needs, x, jobmeta, full, dfu);
+    } else {
+        n_plan_sub += upd_upv (tgt, writers, subsystem,
+                               needs, x, jobmeta, full, dfu);
+    }
+
+    if (n_plan_sub > 0) {
+        if (m_match->get_stop_on_k_matches () > 0
+            && upd_by_outedges (subsystem, jobmeta.now, u, e) < 0) {
+            m_err_msg += __FUNCTION__;
+            m_err_msg += ": upd_by_outedges returned -1.\n";
+        }
+        if (emit_edg (e, writers) == -1) {
+            m_err_msg += __FUNCTION__;
+            m_err_msg += ": emit_edg returned -1.\n";
+        }
+        return n_plan_sub;
+    }
+    return 0;
+}
+
 int dfu_impl_t::upd_dfv (vtx_t u, std::shared_ptr<match_writers_t> &writers,
                          unsigned int needs, bool excl,
                          const jobmeta_t &jobmeta, bool full,
@@ -296,37 +331,24 @@ int dfu_impl_t::upd_dfv (vtx_t u, std::shared_ptr<match_writers_t> &writers,
     f_out_edg_iterator_t ei, ei_end;
     m_trav_level++;
     (*m_graph)[u].idata.colors[dom] = m_color.gray ();
-    for (auto &subsystem : m_match->subsystems ()) {
-        for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
-            if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
-                continue;
-            if ((*m_graph)[*ei].idata.get_trav_token () != m_best_k_cnt)
-                continue;
-
-            int n_plan_sub = 0;
-            bool x = (*m_graph)[*ei].idata.get_exclusive ();
-            unsigned int needs = (*m_graph)[*ei].idata.get_needs ();
-            vtx_t tgt = target (*ei, *m_graph);
-            if (subsystem == dom) {
-                n_plan_sub += upd_dfv (tgt, writers,
-                                       needs, x, jobmeta, full, dfu);
-            } else {
-                n_plan_sub += upd_upv (tgt, writers, subsystem,
-                                       needs, x, jobmeta, full, dfu);
-            }
-
-            if (n_plan_sub > 0) {
-                if (m_match->get_stop_on_k_matches () > 0
-                    && upd_by_outedges (subsystem, jobmeta, u, *ei) < 0) {
-                    m_err_msg += __FUNCTION__;
-                    m_err_msg += ": upd_by_outedges returned -1.\n";
-                }
-                if (emit_edg (*ei, writers) == -1) {
-                    m_err_msg += __FUNCTION__;
-                    m_err_msg += ": emit_edg returned -1.\n";
-                }
-                n_plans += n_plan_sub;
-            }
+    if (commit_valid ()) {
+        // Only the edges select enforced out of u can carry the token
+        commit_edg_t key = {u, 0, edg_t ()};
+        auto range = std::equal_range (m_commit.begin (), m_commit.end (), key,
+                                       [] (const commit_edg_t &a,
+                                           const commit_edg_t &b) {
+                                           return a.src < b.src;
+                                       });
+        for (auto &subsystem : m_match->subsystems ()) {
+            for (auto it = range.first; it != range.second; ++it)
+                n_plans += upd_edg (u, it->edge, writers,
+                                    subsystem, jobmeta, full, dfu);
+        }
+    } else {
+        for (auto &subsystem : m_match->subsystems ()) {
+            for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei)
+                n_plans += upd_edg (u, *ei, writers,
+                                    subsystem, jobmeta, full, dfu);
         }
     }
     (*m_graph)[u].idata.colors[dom] = m_color.black ();
@@ -448,7 +470,7 @@ int dfu_impl_t::rem_upv (vtx_t u, int64_t jobid)
     return 0;
 }
 
-int dfu_impl_t::rem_dfv (vtx_t u, int64_t jobid)
+int dfu_impl_t::rem_dfv (vtx_t u, int64_t jobid, int64_t now)
 {
     int rc = 0;
     bool stop = false;
@@ -464,10 +486,21 @@ int dfu_impl_t::rem_dfv (vtx_t u, int64_t jobid)
             if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
                 continue;
             vtx_t tgt = target (*ei, *m_graph);
-            if (subsystem == dom)
-                rc += rem_dfv (tgt, jobid);
-            else
+            if (subsystem == dom) {
+                bool tagged = ((*m_graph)[tgt].idata.tags.find (jobid)
+                               != (*m_graph)[tgt].idata.tags.end ());
+                rc += rem_dfv (tgt, jobid, now);
+                // Give the freed resources back to the dynamic traversing
+                // order, as upd_dfv did when the job took them.
+                if (tagged && now >= 0
+                    && m_match->get_stop_on_k_matches () > 0
+                    && upd_by_outedges (subsystem, now, u, *ei) < 0) {
+                    m_err_msg += __FUNCTION__;
+                    m_err_msg += ": upd_by_outedges returned -1.\n";
+                }
+            } else {
                 rc += rem_upv (tgt, jobid);
+            }
         }
     }
 done:
@@ -541,6 +574,7 @@ int dfu_impl_t::update (vtx_t root, std::shared_ptr<match_writers_t> &writers,
     bool x = (excl == 0)? false : true;
     unsigned int needs = m_graph_db->metadata.v_rt_edges[dom].get_needs ();
     m_color.reset ();
+    sort_commit ();
 
     if ((rc = upd_dfv (root, writers, needs, x, jobmeta, true, dfu)) > 0) {
          uint64_t starttime = jobmeta.at;
@@ -623,28 +657,28 @@ int dfu_impl_t::update (vtx_t root, std::shared_ptr<match_writers_t> &writers,
     return (rc > 0)? 0: -1;
 }
 
-int dfu_impl_t::remove (vtx_t root, int64_t jobid)
+int dfu_impl_t::remove (vtx_t root, int64_t jobid, int64_t now)
 {
     bool root_has_jtag = ((*m_graph)[root].idata.tags.find (jobid)
                           != (*m_graph)[root].idata.tags.end ());
     m_color.reset ();
-    return (root_has_jtag)? rem_dfv (root, jobid) : rem_exv (jobid);
+    return (root_has_jtag)? rem_dfv (root, jobid, now) : rem_exv (jobid);
 }
 
 int dfu_impl_t::mark (const std::string &root_path, 
                       resource_pool_t::status_t status)
 {
-    std::map<std::string, vtx_t>::const_iterator vit_root =
-        m_graph_db->metadata.by_path.find (root_path);
+    vtx_t root = m_graph_db->metadata.by_path.find (root_path);
 
-    if (vit_root == m_graph_db->metadata.by_path.end ()) {
+    if (root == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         errno = EINVAL;
         m_err_msg += __FUNCTION__;                
         m_err_msg += ": could not find subtree path ("
                   + root_path + ") in resource graph.\n";
         return -1;
     }
-    (*m_graph)[vit_root->second].status = status;
+    (*m_graph)[root].status = status;
+    m_graph_db->metadata.generation++;
     
     return 0;
 }
@@ -657,8 +691,21 @@ int dfu_impl_t::mark (std::set<int64_t> &ranks,
         std::string subtree_path = "", tmp_path = "";
         const std::string &dom = m_match->dom_subsystem ();
         vtx_t subtree_root;
+        vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+        static const std::vector<vtx_t> no_roots;
+        auto rit = m_graph_db->metadata.by_rank_root.find (dom);
+        const std::vector<vtx_t> &roots =
+            (rit != m_graph_db->metadata.by_rank_root.end ())? rit->second
+                                                             : no_roots;
 
         for (auto &rank : ranks) {
+            // The subtree root of an indexed rank is a single lookup
+            if (rank >= 0 && static_cast<size_t> (rank) < roots.size ()
+                && roots[rank] != null_v) {
+                (*m_graph)[roots[rank]].status = status;
+                continue;
+            }
+
             // Now iterate through subgraphs keyed by rank and
             // set status appropriately
             vit = m_graph_db->metadata.by_rank.find (rank);
@@ -677,6 +724,7 @@ int dfu_impl_t::mark (std::set<int64_t> &ranks,
             }
             (*m_graph)[subtree_root].status = status;
         }
+        m_graph_db->metadata.generation++;
     } catch (std::out_of_range &) {
         errno = ENOENT;
         return -1;
@@ -684,6 +732,69 @@ int dfu_impl_t::mark (std::set<int64_t> &ranks,
     return 0;
 }
 
+int dfu_impl_t::shrink (const std::set<int64_t> &ranks)
+{
+    int rc = -1;
+    vtx_t p;
+    vtx_t null_v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    resource_graph_t &g = m_graph_db->resource_graph;
+    std::vector<bool> gone (num_vertices (g), false);
+    std::vector<vtx_t> vtcs;
+    std::map<subsystem_t,
+             std::map<vtx_t, std::map<std::string, int64_t>>> deltas;
+
+    m_graph_db->rank_subgraphs (ranks, vtcs);
+    for (vtx_t v : vtcs)
+        gone[v] = true;
+
+    // Sum up what each detached vertex contributed to the subtree plans
+    // of its remaining ancestors while its paths can still be looked up
+    for (auto &s : m_match->subsystems ()) {
+        std::map<vtx_t, std::map<std::string, int64_t>> lost;
+        for (vtx_t v : vtcs) {
+            if (g[v].paths.find (s) == g[v].paths.end ())
+                continue;
+            p = parent_by_path (s, v);
+            while (p != null_v && gone[p])
+                p = parent_by_path (s, p);
+            if (p != null_v)
+                accum_if (s, g[v].type, g[v].size, lost[p]);
+        }
+        for (auto &kv : lost) {
+            for (p = kv.first; p != null_v; p = parent_by_path (s, p)) {
+                for (auto &aggr : kv.second)
+                    deltas[s][p][aggr.first] -= aggr.second;
+            }
+        }
+    }
+
+    if ( (rc = m_graph_db->detach (ranks)) != 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": detach: ";
+        m_err_msg += strerror (errno);
+        m_err_msg += ".\n";
+        goto done;
+    }
+    for (auto &skv : deltas) {
+        for (auto &kv : skv.second) {
+            if ( (rc = resize_subplan (skv.first, kv.first, kv.second)) != 0)
+                goto done;
+        }
+    }
+    // Compacting costs a pass over the whole graph, so let holes pile
+    // up to a quarter of the vertex storage before paying for it
+    if (m_graph_db->holes () * 4 >= num_vertices (g)
+        && (rc = m_graph_db->compact ()) != 0) {
+        m_err_msg += __FUNCTION__;
+        m_err_msg += ": compact: ";
+        m_err_msg += strerror (errno);
+        m_err_msg += ".\n";
+    }
+
+done:
+    return rc;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -0,0 +1,241 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+extern "C" {
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+}
+
+#include <cerrno>
+#include <cinttypes>
+#include "resource/traversers/dfu_trace.hpp"
+#include "resource/traversers/match_perf.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+// Bound the memory a single pathological match can consume
+static const size_t max_spans = 1 << 20;
+
+
+/****************************************************************************
+ *                                                                          *
+ *                      DFU Trace Private Methods                           *
+ *                                                                          *
+ ****************************************************************************/
+
+size_t dfu_trace_t::open (const char *name, vtx_t u)
+{
+    if (m_spans.size () >= max_spans) {
+        m_truncated = true;
+        return max_spans;
+    }
+    m_spans.push_back (span_rec_t{ name, u, match_perf_now (), 0 });
+    return m_spans.size () - 1;
+}
+
+void dfu_trace_t::close (size_t i)
+{
+    if (i < m_spans.size ())
+        m_spans[i].end = match_perf_now ();
+}
+
+static void escape (const std::string &in, std::string &out)
+{
+    out.clear ();
+    for (char c : in) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char> (c) < 0x20)
+            continue;
+        out += c;
+    }
+}
+
+int dfu_trace_t::write_event (const span_rec_t &s, const f_resource_graph_t &g,
+                              const std::string &subsystem, bool top)
+{
+    int rc = 0;
+    std::string path;
+    std::string type;
+    const auto &p = g[s.u].paths;
+    auto it = p.find (subsystem);
+
+    escape ((it != p.end ())? it->second : g[s.u].name, path);
+    escape (g[s.u].type, type);
+    rc = fprintf (m_fp, "%s{\"name\":\"%s\",\"cat\":\"dfu\",\"ph\":\"X\","
+                        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%jd,"
+                        "\"args\":{\"path\":\"%s\",\"type\":\"%s\"",
+                  (m_nevents)? ",\n" : "", s.name,
+                  static_cast<double> (s.start - m_epoch) / 1000.0f,
+                  static_cast<double> (s.end - s.start) / 1000.0f,
+                  static_cast<intmax_t> (m_jobid), path.c_str (), type.c_str ());
+    if (rc >= 0 && top)
+        rc = fprintf (m_fp, ",\"jobid\":%jd,\"op\":\"%s\",\"truncated\":%s",
+                      static_cast<intmax_t> (m_jobid), m_op.c_str (),
+                      (m_truncated)? "true" : "false");
+    if (rc >= 0)
+        rc = fprintf (m_fp, "}}");
+    if (rc < 0) {
+        errno = EIO;
+        return -1;
+    }
+    m_nevents++;
+    return 0;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                       DFU Trace Public API                               *
+ *                                                                          *
+ ****************************************************************************/
+
+dfu_trace_t::~dfu_trace_t ()
+{
+    close_file ();
+}
+
+int dfu_trace_t::open_file (const std::string &path, uint64_t threshold,
+                            unsigned int sample)
+{
+    close_file ();
+    if (path == "" || sample == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ( !(m_fp = fopen (path.c_str (), "w+")))
+        return -1;
+    if (fputs ("[\n]\n", m_fp) == EOF || fflush (m_fp) == EOF) {
+        close_file ();
+        errno = EIO;
+        return -1;
+    }
+    m_path = path;
+    m_threshold = threshold;
+    m_sample = sample;
+    m_nmatches = 0;
+    m_nevents = 0;
+    m_kept = 0;
+    m_dropped = 0;
+    m_epoch = match_perf_now ();
+    return 0;
+}
+
+void dfu_trace_t::close_file ()
+{
+    if (m_fp) {
+        fclose (m_fp);
+        m_fp = nullptr;
+    }
+    m_recording = false;
+    m_spans.clear ();
+    m_spans.shrink_to_fit ();
+}
+
+void dfu_trace_t::begin_match (int64_t jobid, const char *op, vtx_t root)
+{
+    if (!m_fp || (m_nmatches++ % m_sample) != 0)
+        return;
+    m_spans.clear ();
+    m_truncated = false;
+    m_jobid = jobid;
+    m_op = op;
+    m_recording = true;
+    open ("match", root);
+}
+
+int dfu_trace_t::end_match (const f_resource_graph_t &g,
+                            const std::string &subsystem)
+{
+    int rc = 0;
+
+    if (!m_recording)
+        return 0;
+    m_recording = false;
+    close (0);
+    if (m_spans.empty () || m_spans[0].end - m_spans[0].start < m_threshold) {
+        m_dropped++;
+        goto done;
+    }
+    // Overwrite the closing bracket so that the file stays valid JSON
+    if (fseek (m_fp, -2, SEEK_END) < 0) {
+        rc = -1;
+        goto done;
+    }
+    for (size_t i = 0; i < m_spans.size (); i++) {
+        if (m_spans[i].end == 0)
+            m_spans[i].end = m_spans[0].end;
+        if ( (rc = write_event (m_spans[i], g, subsystem, i == 0)) < 0)
+            goto done;
+    }
+    if (fputs ("\n]\n", m_fp) == EOF || fflush (m_fp) == EOF) {
+        errno = EIO;
+        rc = -1;
+        goto done;
+    }
+    m_kept++;
+
+done:
+    m_spans.clear ();
+    return rc;
+}
+
+bool dfu_trace_t::is_open () const
+{
+    return m_fp != nullptr;
+}
+
+const std::string &dfu_trace_t::get_path () const
+{
+    return m_path;
+}
+
+uint64_t dfu_trace_t::get_threshold () const
+{
+    return m_threshold;
+}
+
+unsigned int dfu_trace_t::get_sample () const
+{
+    return m_sample;
+}
+
+uint64_t dfu_trace_t::get_kept () const
+{
+    return m_kept;
+}
+
+uint64_t dfu_trace_t::get_dropped () const
+{
+    return m_dropped;
+}
+
+} // namespace resource_model
+} // namespace Flux
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,151 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef DFU_TRACE_HPP
+#define DFU_TRACE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "resource/schema/resource_graph.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+/*! Sampling tracer of DFU traversals. While a match is being recorded,
+ *  spans of the instrumented traverser routines (dom_dfv, aux_upv,
+ *  prune, resolve and the planner queries) are buffered in memory with
+ *  the vertex they visited. A recorded match is written out only if it
+ *  took at least the configured threshold, in the Chrome trace event
+ *  format (a JSON array of complete events) which chrome://tracing and
+ *  Perfetto load directly. The file is kept a valid JSON document after
+ *  every match so that it can be inspected while tracing is on.
+ */
+class dfu_trace_t {
+public:
+    /*! RAII span: opened on construction and closed on destruction.
+     *  A null tracer or one that is not recording makes it a no-op.
+     */
+    class span_t {
+    public:
+        span_t (dfu_trace_t *t, const char *name, vtx_t u)
+        {
+            if (t && t->m_recording) {
+                m_trace = t;
+                m_index = t->open (name, u);
+            }
+        }
+        ~span_t ()
+        {
+            if (m_trace)
+                m_trace->close (m_index);
+        }
+        span_t (const span_t &o) = delete;
+        span_t &operator= (const span_t &o) = delete;
+    private:
+        dfu_trace_t *m_trace = nullptr;
+        size_t m_index = 0;
+    };
+
+    ~dfu_trace_t ();
+
+    /*! Start tracing into path, truncating it.
+     *
+     * \param path       output file path
+     * \param threshold  minimum match latency in nanoseconds to keep a trace
+     * \param sample     record one out of every sample matches (>= 1)
+     * \return           0 on success; -1 on error with errno set.
+     */
+    int open_file (const std::string &path, uint64_t threshold,
+                   unsigned int sample);
+
+    /*! Stop tracing and close the output file.
+     */
+    void close_file ();
+
+    /*! Begin recording a match of jobid if this match is sampled.
+     *
+     * \param jobid      job id of the match
+     * \param op         name of the match operation
+     * \param root       root vertex of the traversal
+     */
+    void begin_match (int64_t jobid, const char *op, vtx_t root);
+
+    /*! End recording the current match and write it out if it is
+     *  slower than the threshold. The vertex paths and types of the spans
+     *  are resolved against g, which must be the graph traversed.
+     *
+     * \return           0 on success; -1 on a write error with errno set.
+     */
+    int end_match (const f_resource_graph_t &g, const std::string &subsystem);
+
+    bool is_open () const;
+    const std::string &get_path () const;
+    uint64_t get_threshold () const;
+    unsigned int get_sample () const;
+
+    /*! Return the number of matches written out and dropped for being
+     *  faster than the threshold since open_file.
+     */
+    uint64_t get_kept () const;
+    uint64_t get_dropped () const;
+
+private:
+    struct span_rec_t {
+        const char *name;
+        vtx_t u;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    size_t open (const char *name, vtx_t u);
+    void close (size_t i);
+    int write_event (const span_rec_t &s, const f_resource_graph_t &g,
+                     const std::string &subsystem, bool top);
+
+    FILE *m_fp = nullptr;
+    std::string m_path = "";
+    uint64_t m_threshold = 0;
+    unsigned int m_sample = 1;
+    uint64_t m_nmatches = 0;
+    uint64_t m_nevents = 0;
+    uint64_t m_kept = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_epoch = 0;
+    bool m_recording = false;
+    bool m_truncated = false;
+    int64_t m_jobid = -1;
+    std::string m_op = "";
+    std::vector<span_rec_t> m_spans;
+};
+
+} // namespace resource_model
+} // namespace Flux
+
+#endif // DFU_TRACE_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,200 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+extern "C" {
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <time.h>
+}
+
+#include <algorithm>
+#include "resource/traversers/match_perf.hpp"
+
+namespace Flux {
+namespace resource_model {
+
+
+/****************************************************************************
+ *                                                                          *
+ *                    Log-Linear Histogram Definitions                      *
+ *                                                                          *
+ ****************************************************************************/
+
+log_linear_hist_t::log_linear_hist_t ()
+    : m_counts (nbuckets, 0)
+{
+
+}
+
+int log_linear_hist_t::index_of (uint64_t v)
+{
+    if (v < static_cast<uint64_t> (sub_count))
+        return static_cast<int> (v);
+    int e = 63 - __builtin_clzll (v);
+    int shift = e - sub_bits;
+    return ((shift + 1) << sub_bits)
+           + static_cast<int> ((v >> shift) - sub_count);
+}
+
+uint64_t log_linear_hist_t::upper_bound_of (int i)
+{
+    if (i < sub_count)
+        return static_cast<uint64_t> (i);
+    int shift = (i >> sub_bits) - 1;
+    uint64_t sub = static_cast<uint64_t> (i & (sub_count - 1));
+    uint64_t lower = (sub_count + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void log_linear_hist_t::record (uint64_t v)
+{
+    m_counts[index_of (v)]++;
+    m_count++;
+    m_sum += static_cast<double> (v);
+    m_min = std::min (m_min, v);
+    m_max = std::max (m_max, v);
+}
+
+void log_linear_hist_t::reset ()
+{
+    std::fill (m_counts.begin (), m_counts.end (), 0);
+    m_count = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+    m_sum = 0.0f;
+}
+
+uint64_t log_linear_hist_t::percentile (double p) const
+{
+    uint64_t rank = 0;
+    uint64_t seen = 0;
+
+    if (m_count == 0)
+        return 0;
+    p = std::min (std::max (p, 0.0), 1.0);
+    rank = static_cast<uint64_t> (p * static_cast<double> (m_count) + 0.5);
+    rank = std::max (rank, static_cast<uint64_t> (1));
+    for (int i = 0; i < nbuckets; i++) {
+        seen += m_counts[i];
+        if (seen >= rank)
+            return std::min (upper_bound_of (i), m_max);
+    }
+    return m_max;
+}
+
+uint64_t log_linear_hist_t::count () const
+{
+    return m_count;
+}
+
+uint64_t log_linear_hist_t::min () const
+{
+    return (m_count)? m_min : 0;
+}
+
+uint64_t log_linear_hist_t::max () const
+{
+    return m_max;
+}
+
+double log_linear_hist_t::mean () const
+{
+    return (m_count)? m_sum / static_cast<double> (m_count) : 0.0f;
+}
+
+
+/****************************************************************************
+ *                                                                          *
+ *                    Match Phase Statistics Definitions                    *
+ *                                                                          *
+ ****************************************************************************/
+
+const char *match_phase_name (match_phase_t phase)
+{
+    switch (phase) {
+    case match_phase_t::PARSE:
+        return "parse";
+    case match_phase_t::SELECT:
+        return "select";
+    case match_phase_t::AVAIL:
+        return "avail";
+    case match_phase_t::UPDATE:
+        return "update";
+    case match_phase_t::EMIT:
+        return "emit";
+    case match_phase_t::TOTAL:
+        return "total";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+void match_phase_times_t::reset ()
+{
+    std::fill (ns, ns + static_cast<int> (match_phase_t::COUNT), 0);
+}
+
+uint64_t &match_phase_times_t::operator[] (match_phase_t phase)
+{
+    return ns[static_cast<int> (phase)];
+}
+
+uint64_t match_phase_times_t::operator[] (match_phase_t phase) const
+{
+    return ns[static_cast<int> (phase)];
+}
+
+void match_op_perf_t::record (const match_phase_times_t &t,
+                              uint64_t npreorder, uint64_t npostorder)
+{
+    for (int i = 0; i < static_cast<int> (match_phase_t::COUNT); i++)
+        phases[i].record (t.ns[i]);
+    preorder.record (npreorder);
+    postorder.record (npostorder);
+}
+
+void match_op_perf_t::reset ()
+{
+    for (auto &h : phases)
+        h.reset ();
+    preorder.reset ();
+    postorder.reset ();
+}
+
+uint64_t match_perf_now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t> (ts.tv_sec) * 1000000000ULL
+           + static_cast<uint64_t> (ts.tv_nsec);
+}
+
+} // namespace resource_model
+} // namespace Flux
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
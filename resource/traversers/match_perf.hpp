@@ -0,0 +1,115 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef MATCH_PERF_HPP
+#define MATCH_PERF_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace Flux {
+namespace resource_model {
+
+/*! Log-linear histogram of non-negative integer samples. Each power-of-two
+ *  range is split into 2^sub_bits linear sub-buckets so that the relative
+ *  error of a reported percentile is bounded by 2^-sub_bits, while
+ *  recording a sample costs a count-leading-zeros and an increment.
+ */
+class log_linear_hist_t {
+public:
+    log_linear_hist_t ();
+    void record (uint64_t v);
+    void reset ();
+
+    /*! Return the value at or below which fraction p (0 <= p <= 1)
+     *  of the recorded samples falls, rounded up to the upper bound of its
+     *  bucket and clamped to the maximum sample. 0 if empty.
+     */
+    uint64_t percentile (double p) const;
+    uint64_t count () const;
+    uint64_t min () const;
+    uint64_t max () const;
+    double mean () const;
+
+private:
+    static const int sub_bits = 4;
+    static const int sub_count = 1 << sub_bits;
+    static const int nbuckets = (64 - sub_bits + 1) * sub_count;
+    static int index_of (uint64_t v);
+    static uint64_t upper_bound_of (int i);
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+    double m_sum = 0.0f;
+};
+
+/*! Phases of a match or update request.
+ */
+enum class match_phase_t : int {
+    PARSE = 0,   /* jobspec or R parsing */
+    SELECT,      /* DFU walks (dfu_impl_t::select) */
+    AVAIL,       /* planner avail_time_first/next iteration */
+    UPDATE,      /* planner updates of the selected resources */
+    EMIT,        /* R emission */
+    TOTAL,       /* the whole request */
+    COUNT
+};
+
+const char *match_phase_name (match_phase_t phase);
+
+/*! Per-phase wall-clock time of a single traversal in nanoseconds.
+ */
+struct match_phase_times_t {
+    uint64_t ns[static_cast<int> (match_phase_t::COUNT)] = { 0 };
+    void reset ();
+    uint64_t &operator[] (match_phase_t phase);
+    uint64_t operator[] (match_phase_t phase) const;
+};
+
+/*! Latency and visit-count distributions of one kind of match operation.
+ */
+struct match_op_perf_t {
+    log_linear_hist_t phases[static_cast<int> (match_phase_t::COUNT)];
+    log_linear_hist_t preorder;
+    log_linear_hist_t postorder;
+
+    void record (const match_phase_times_t &t,
+                 uint64_t npreorder, uint64_t npostorder);
+    void reset ();
+};
+
+/*! Return a monotonic timestamp in nanoseconds.
+ */
+uint64_t match_perf_now ();
+
+} // namespace resource_model
+} // namespace Flux
+
+#endif // MATCH_PERF_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
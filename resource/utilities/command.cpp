@@ -56,6 +56,8 @@ command_t commands[] = {
 "resource-query> update allocate jgf_file jobid starttime duration" },
     { "attach", "j", cmd_attach, "Experimental: attach a JGF subgraph to the "
 "resource graph: resource-query> attach jgf_file" },
+    { "shrink", "k", cmd_shrink, "Remove the subgraphs of ranks from the "
+"resource graph: resource-query> shrink rank1 [rank2 ...]" },
     { "find", "f", cmd_find, "Find resources matched with criteria "
 "(predicates: status={up|down} sched-now={allocated|free} sched-future={reserved|free}): "
 "resource-query> find status=down and sched-now=allocated" },
@@ -74,6 +76,10 @@ command_t commands[] = {
 "Print info on a jobid: resource-query> info jobid" },
     { "stat", "s", cmd_stat,
  "Print overall stats: resource-query> stat jobid" },
+    { "trace", "T", cmd_trace, "Trace the DFU walks of the matches slower "
+"than THRESHOLD milliseconds (default 0) into FILE in Chrome trace format, "
+"recording one out of every SAMPLE matches (default 1): "
+"resource-query> trace on FILE [THRESHOLD] [SAMPLE] | trace off" },
     { "cat", "a", cmd_cat, "Print jobspec file: resource-query> cat jobspec" },
     { "help", "h", cmd_help, "Print help message: resource-query> help" },
     { "quit", "q", cmd_quit, "Quit the session: resource-query> quit" },
@@ -83,7 +89,8 @@ command_t commands[] = {
 static int do_remove (std::shared_ptr<resource_context_t> &ctx, int64_t jobid)
 {
     int rc = -1;
-    if ((rc = ctx->traverser->remove ((int64_t)jobid)) == 0) {
+    // resource-query matches always take place at time 0
+    if ((rc = ctx->traverser->remove ((int64_t)jobid, 0)) == 0) {
         if (ctx->jobs.find (jobid) != ctx->jobs.end ()) {
            std::shared_ptr<job_info_t> info = ctx->jobs[jobid];
            info->state = job_lifecycle_t::CANCELED;
@@ -414,13 +421,14 @@ static int attach (std::shared_ptr<resource_context_t> &ctx,
     // Unpack_at currently does not use the vertex attachment point.
     // This functionality is currently experimental.
     vtx_t v = boost::graph_traits<resource_graph_t>::null_vertex ();
+    ctx->db->metadata.generation++;
     if ( (rd->unpack_at (ctx->db->resource_graph, ctx->db->metadata, 
                          v, buffer.str (), -1)) != 0) {
         std::cerr << "ERROR: can't attach JGF subgraph " << std::endl;
         std::cerr << "ERROR: " << rd->err_message ();
         return -1;
     }
-    if (ctx->traverser->initialize (ctx->fgraph, ctx->db, ctx->matcher) != 0) {
+    if (ctx->traverser->grow () != 0) {
         std::cerr << "ERROR: can't reinitialize traverser after attach" 
                   << std::endl;
         return -1;
@@ -437,11 +445,6 @@ int cmd_attach (std::shared_ptr<resource_context_t> &ctx,
             std::cerr << "ERROR: malformed command" << std::endl;
             return 0;
         }
-        if ( !(ctx->allocations.empty () && ctx->reservations.empty ())) {
-            std::cerr << "ERROR: attach isn't currently supported when an"
-                      << " allocation or reservation exists" << std::endl;
-            return 0;
-        }        
         attach (ctx, args);
 
     } catch (std::ifstream::failure &e) {
@@ -452,6 +455,25 @@ int cmd_attach (std::shared_ptr<resource_context_t> &ctx,
     return 0;
 }
 
+int cmd_shrink (std::shared_ptr<resource_context_t> &ctx,
+                std::vector<std::string> &args)
+{
+    std::set<int64_t> ranks;
+
+    if (args.size () < 2) {
+        std::cerr << "ERROR: malformed command" << std::endl;
+        return 0;
+    }
+    for (size_t i = 1; i < args.size (); i++)
+        ranks.insert (std::strtoll (args[i].c_str (), NULL, 10));
+    if (ctx->traverser->shrink (ranks) != 0) {
+        std::cerr << "ERROR: can't shrink the resource graph" << std::endl;
+        std::cerr << "ERROR: " << ctx->traverser->err_message ();
+        ctx->traverser->clear_err_message ();
+    }
+    return 0;
+}
+
 int cmd_find (std::shared_ptr<resource_context_t> &ctx,
                 std::vector<std::string> &args)
 {
@@ -559,16 +581,13 @@ int cmd_set_property (std::shared_ptr<resource_context_t> &ctx,
         property_value = args[2].substr (pos + 1);
     }
 
-    std::map<std::string, vtx_t>::const_iterator it =
-        ctx->db->metadata.by_path.find (resource_path);
+    vtx_t v = ctx->db->metadata.by_path.find (resource_path);
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         out << "Couldn't find path " << resource_path
             << " in resource graph." << std::endl;
     }
     else {
-        vtx_t v = it->second;
-
         /* Note that map.insert () does not insert if the key exists.
          * Assuming we want to update the value though, we do an erase
          * before we insert. */
@@ -580,6 +599,7 @@ int cmd_set_property (std::shared_ptr<resource_context_t> &ctx,
         ctx->db->resource_graph[v].properties.insert (
             std::pair<std::string, std::string> (property_key,
                                                  property_value));
+        ctx->db->metadata.generation++;
     }
     return 0;
 }
@@ -596,15 +616,13 @@ int cmd_get_property (std::shared_ptr<resource_context_t> &ctx,
     std::ostream &out = (ctx->params.r_fname != "") ? ctx->params.r_out
                                                     : std::cout;
 
-    std::map<std::string, vtx_t>::const_iterator it =
-        ctx->db->metadata.by_path.find (resource_path);
+    vtx_t v = ctx->db->metadata.by_path.find (resource_path);
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         out << "Could not find path " << resource_path
             << " in resource graph." << std::endl;
     }
     else {
-        vtx_t v = it->second;
         if (ctx->db->resource_graph[v].properties.size () == 0) {
             out << "No properties were found for " << resource_path
                 << ". " << std::endl;
@@ -628,14 +646,13 @@ int cmd_set_status (std::shared_ptr<resource_context_t> &ctx,
     }
     std::string vtx_path = args[1];
     std::string status = args[2];
-    std::map<std::string, vtx_t>::const_iterator it =
-        ctx->db->metadata.by_path.find (vtx_path);
+    vtx_t v = ctx->db->metadata.by_path.find (vtx_path);
     resource_pool_t::string_to_status sts = resource_pool_t::str_to_status;
 
     std::ostream &out = (ctx->params.r_fname != "") ? ctx->params.r_out
                                                     : std::cout;
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         out << "Could not find path " << vtx_path
             << " in resource graph." << std::endl;
         return 0;
@@ -658,8 +675,7 @@ int cmd_get_status (std::shared_ptr<resource_context_t> &ctx,
         return 0;
     }
     std::string vtx_path = args[1];
-    std::map<std::string, vtx_t>::const_iterator it =
-        ctx->db->metadata.by_path.find (vtx_path);
+    vtx_t v = ctx->db->metadata.by_path.find (vtx_path);
     resource_pool_t::string_to_status sts = resource_pool_t::str_to_status;
     std::string status = "";
 
@@ -667,14 +683,14 @@ int cmd_get_status (std::shared_ptr<resource_context_t> &ctx,
                                                     : std::cout;
 
 
-    if (it == ctx->db->metadata.by_path.end ()) {
+    if (v == boost::graph_traits<resource_graph_t>::null_vertex ()) {
         out << "Could not find path " << vtx_path
             << " in resource graph." << std::endl;
         return 0;
     }
 
     for (auto &status_it : sts) {
-        if (status_it.second == ctx->db->resource_graph[it->second].status) {
+        if (status_it.second == ctx->db->resource_graph[v].status) {
             status = status_it.first;
             break;
         }
@@ -691,6 +707,36 @@ int cmd_get_status (std::shared_ptr<resource_context_t> &ctx,
     return 0;
 }
 
+int cmd_trace (std::shared_ptr<resource_context_t> &ctx,
+               std::vector<std::string> &args)
+{
+    double threshold = 0.0f;
+    long sample = 1;
+
+    if (args.size () == 2 && args[1] == "off") {
+        ctx->traverser->disable_trace ();
+        return 0;
+    }
+    if (args.size () < 3 || args.size () > 5 || args[1] != "on") {
+        std::cerr << "ERROR: malformed command" << std::endl;
+        return 0;
+    }
+    if (args.size () > 3)
+        threshold = std::strtod (args[3].c_str (), NULL);
+    if (args.size () > 4)
+        sample = std::strtol (args[4].c_str (), NULL, 10);
+    if (threshold < 0.0f || sample < 1) {
+        std::cerr << "ERROR: invalid threshold or sample" << std::endl;
+        return 0;
+    }
+    if (ctx->traverser->enable_trace (args[2],
+                                      static_cast<uint64_t> (threshold * 1e6),
+                                      static_cast<unsigned int> (sample)) < 0)
+        std::cerr << "ERROR: can't trace into " << args[2] << ": "
+                  << strerror (errno) << std::endl;
+    return 0;
+}
+
 int cmd_list (std::shared_ptr<resource_context_t> &ctx,
               std::vector<std::string> &args)
 {
@@ -89,6 +89,8 @@ int cmd_update (std::shared_ptr<resource_context_t> &ctx,
                 std::vector<std::string> &args);
 int cmd_attach (std::shared_ptr<resource_context_t> &ctx,
                 std::vector<std::string> &args);
+int cmd_shrink (std::shared_ptr<resource_context_t> &ctx,
+                std::vector<std::string> &args);
 int cmd_find (std::shared_ptr<resource_context_t> &ctx,
                 std::vector<std::string> &args);
 int cmd_cancel (std::shared_ptr<resource_context_t> &ctx,
@@ -107,6 +109,8 @@ int cmd_info (std::shared_ptr<resource_context_t> &ctx,
               std::vector<std::string> &args);
 int cmd_stat (std::shared_ptr<resource_context_t> &ctx,
               std::vector<std::string> &args);
+int cmd_trace (std::shared_ptr<resource_context_t> &ctx,
+               std::vector<std::string> &args);
 int cmd_cat (std::shared_ptr<resource_context_t> &ctx,
              std::vector<std::string> &args);
 int cmd_quit (std::shared_ptr<resource_context_t> &ctx,
@@ -0,0 +1,860 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <getopt.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <boost/algorithm/string.hpp>
+#include "resource/store/resource_graph_store.hpp"
+#include "resource/readers/resource_reader_factory.hpp"
+#include "resource/policies/dfu_match_policy_factory.hpp"
+#include "resource/traversers/dfu.hpp"
+#include "resource/traversers/match_perf.hpp"
+#include "resource/writers/match_writers.hpp"
+
+extern "C" {
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+}
+
+using namespace Flux::resource_model;
+
+/*! System size from which a GRUG recipe is generated:
+ *  cluster[1]->rack[racks]->node[nodes]->socket[sockets]->core[cores]
+ *                                                       ->gpu[gpus]
+ *                                                       ->memory[memory]
+ */
+struct bench_system_t {
+    unsigned racks = 1;
+    unsigned nodes = 16;
+    unsigned sockets = 2;
+    unsigned cores = 16;
+    unsigned gpus = 0;
+    unsigned memory = 0;
+};
+
+/*! A job shape: nodes (0 for a node-local job) and the cores and gpus
+ *  of its single slot.
+ */
+struct bench_shape_t {
+    unsigned nodes = 0;
+    unsigned cores = 0;
+    unsigned gpus = 0;
+};
+
+struct bench_job_t {
+    size_t shape = 0;
+    uint64_t duration = 0;
+};
+
+struct bench_params_t {
+    bench_system_t system;
+    std::vector<bench_shape_t> shapes;
+    uint64_t min_duration = 60;
+    uint64_t max_duration = 3600;
+    unsigned njobs = 1000;
+    unsigned depth = 64;
+    unsigned long seed = 1;
+    std::string match_op = "allocate_orelse_reserve";
+    std::string match_format = "rv1_nosched";
+    std::vector<std::string> policies;
+    std::vector<std::string> prune_filters;
+    std::string o_fname = "";
+    std::string grug_fname = "";
+};
+
+/*! Outcome of running the job stream against one policy and filter.
+ */
+struct bench_result_t {
+    uint64_t nvertices = 0;
+    uint64_t nedges = 0;
+    uint64_t load_ns = 0;
+    uint64_t sched_ns = 0;
+    uint64_t allocated = 0;
+    uint64_t reserved = 0;
+    uint64_t busy = 0;
+    uint64_t unsat = 0;
+    uint64_t errors = 0;
+    uint64_t canceled = 0;
+    log_linear_hist_t match;
+    log_linear_hist_t cancel;
+    log_linear_hist_t preorder;
+};
+
+#define OPTIONS "R:N:s:c:G:m:J:D:j:q:O:F:P:p:S:o:g:h"
+static const struct option longopts[] = {
+    {"racks",            required_argument,  0, 'R'},
+    {"nodes",            required_argument,  0, 'N'},
+    {"sockets",          required_argument,  0, 's'},
+    {"cores",            required_argument,  0, 'c'},
+    {"gpus",             required_argument,  0, 'G'},
+    {"memory",           required_argument,  0, 'm'},
+    {"job-shapes",       required_argument,  0, 'J'},
+    {"durations",        required_argument,  0, 'D'},
+    {"jobs",             required_argument,  0, 'j'},
+    {"queue-depth",      required_argument,  0, 'q'},
+    {"match-op",         required_argument,  0, 'O'},
+    {"match-format",     required_argument,  0, 'F'},
+    {"match-policies",   required_argument,  0, 'P'},
+    {"prune-filters",    required_argument,  0, 'p'},
+    {"seed",             required_argument,  0, 'S'},
+    {"output",           required_argument,  0, 'o'},
+    {"grug-output",      required_argument,  0, 'g'},
+    {"help",             no_argument,        0, 'h'},
+    { 0, 0, 0, 0 },
+};
+
+static void usage (int code)
+{
+    std::cerr <<
+"usage: resource-bench [OPTIONS...]\n"
+"\n"
+"Synthetic workload benchmark for the resource matcher.\n"
+"\n"
+"Generate a GRUG recipe of a system of the given size and a reproducible\n"
+"stream of jobs of the given shapes and durations. Then, for each\n"
+"combination of match policy and pruning filters, load the generated\n"
+"resource graph afresh and drive a dfu_traverser_t through the job stream:\n"
+"each job is matched with the match operation and, whenever the number of\n"
+"allocated or reserved jobs reaches the queue depth, the oldest job is\n"
+"canceled first. Each combination runs in its own child process so that\n"
+"its peak resident set size is reported independently.\n"
+"\n"
+"One JSON object per combination is written as a line to the output:\n"
+"graph size and load time, match outcome counts, scheduler throughput\n"
+"(jobs/s over the time spent in match and cancel), match and cancel\n"
+"latency percentiles in nanoseconds, preorder visit counts and peak RSS.\n"
+"\n"
+"OPTIONS:\n"
+"    -h, --help\n"
+"            Display this usage information\n"
+"\n"
+"    -R, --racks=<count>\n"
+"            Number of racks (default=1)\n"
+"\n"
+"    -N, --nodes=<count>\n"
+"            Number of nodes per rack (default=16)\n"
+"\n"
+"    -s, --sockets=<count>\n"
+"            Number of sockets per node (default=2)\n"
+"\n"
+"    -c, --cores=<count>\n"
+"            Number of cores per socket (default=16)\n"
+"\n"
+"    -G, --gpus=<count>\n"
+"            Number of gpus per socket (default=0)\n"
+"\n"
+"    -m, --memory=<count>\n"
+"            Number of 1GB memory pools per socket (default=0)\n"
+"\n"
+"    -J, --job-shapes=<nodes:cores:gpus[,nodes:cores:gpus...]>\n"
+"            Shapes drawn uniformly at random for each job. A shape\n"
+"            requests nodes exclusive nodes, each with one slot of cores\n"
+"            and gpus spread evenly over as few sockets as hold them, or\n"
+"            a single slot anywhere when nodes is 0\n"
+"            (default=0:1:0,0:8:0,1:16:0)\n"
+"\n"
+"    -D, --durations=<min:max>\n"
+"            Range of job durations in seconds drawn uniformly at random\n"
+"            (default=60:3600)\n"
+"\n"
+"    -j, --jobs=<count>\n"
+"            Number of jobs in the stream (default=1000)\n"
+"\n"
+"    -q, --queue-depth=<count>\n"
+"            Number of allocated or reserved jobs kept in the resource\n"
+"            graph before the oldest one is canceled (default=64)\n"
+"\n"
+"    -O, --match-op=<allocate|allocate_orelse_reserve|"
+                      "allocate_with_satisfiability>\n"
+"            Match operation used for each job\n"
+"            (default=allocate_orelse_reserve)\n"
+"\n"
+"    -F, --match-format=<simple|pretty_simple|jgf|rlite|rv1|rv1_nosched>\n"
+"            Emit format of the matched resource set. Emission is timed\n"
+"            as part of each match (default=rv1_nosched)\n"
+"\n"
+"    -P, --match-policies=<policy1[,policy2...]>\n"
+"            Match policies to benchmark (default=high)\n"
+"\n"
+"    -p, --prune-filters=<HL-resource1:LL-resource1[,...]>\n"
+"            Pruning filters to benchmark. May be given multiple times,\n"
+"            once per filter set; \"none\" disables pruning\n"
+"            (default=ALL:core)\n"
+"\n"
+"    -S, --seed=<seed>\n"
+"            Seed of the job stream generator (default=1)\n"
+"\n"
+"    -o, --output=<filename>\n"
+"            Write results into filename instead of standard output\n"
+"\n"
+"    -g, --grug-output=<filename>\n"
+"            Also write the generated GRUG recipe into filename\n"
+"\n";
+    exit (code);
+}
+
+static int to_unsigned (const char *s, unsigned &v)
+{
+    char *end = nullptr;
+    unsigned long n;
+
+    errno = 0;
+    n = strtoul (s, &end, 10);
+    if (errno != 0 || !end || *end != '\0' || end == s || n > UINT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    v = static_cast<unsigned> (n);
+    return 0;
+}
+
+static int parse_shapes (const std::string &spec,
+                         std::vector<bench_shape_t> &shapes)
+{
+    std::vector<std::string> tokens;
+
+    shapes.clear ();
+    boost::split (tokens, spec, boost::is_any_of (","));
+    for (auto &t : tokens) {
+        std::vector<std::string> f;
+        bench_shape_t shape;
+        boost::split (f, t, boost::is_any_of (":"));
+        if (f.size () != 3
+            || to_unsigned (f[0].c_str (), shape.nodes) < 0
+            || to_unsigned (f[1].c_str (), shape.cores) < 0
+            || to_unsigned (f[2].c_str (), shape.gpus) < 0
+            || (shape.cores == 0 && shape.gpus == 0)) {
+            errno = EINVAL;
+            return -1;
+        }
+        shapes.push_back (shape);
+    }
+    return 0;
+}
+
+static int parse_durations (const std::string &spec, bench_params_t &params)
+{
+    unsigned lo, hi;
+    std::vector<std::string> f;
+
+    boost::split (f, spec, boost::is_any_of (":"));
+    if (f.size () != 2
+        || to_unsigned (f[0].c_str (), lo) < 0
+        || to_unsigned (f[1].c_str (), hi) < 0
+        || lo == 0 || lo > hi) {
+        errno = EINVAL;
+        return -1;
+    }
+    params.min_duration = lo;
+    params.max_duration = hi;
+    return 0;
+}
+
+static void process_args (bench_params_t &params, int argc, char *argv[])
+{
+    int ch = 0;
+    int rc = 0;
+    std::string token;
+    std::vector<std::string> policies;
+
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'h': /* --help */
+                usage (0);
+                break;
+            case 'R': /* --racks */
+                rc = to_unsigned (optarg, params.system.racks);
+                break;
+            case 'N': /* --nodes */
+                rc = to_unsigned (optarg, params.system.nodes);
+                break;
+            case 's': /* --sockets */
+                rc = to_unsigned (optarg, params.system.sockets);
+                break;
+            case 'c': /* --cores */
+                rc = to_unsigned (optarg, params.system.cores);
+                break;
+            case 'G': /* --gpus */
+                rc = to_unsigned (optarg, params.system.gpus);
+                break;
+            case 'm': /* --memory */
+                rc = to_unsigned (optarg, params.system.memory);
+                break;
+            case 'J': /* --job-shapes */
+                rc = parse_shapes (optarg, params.shapes);
+                break;
+            case 'D': /* --durations */
+                rc = parse_durations (optarg, params);
+                break;
+            case 'j': /* --jobs */
+                rc = to_unsigned (optarg, params.njobs);
+                break;
+            case 'q': /* --queue-depth */
+                rc = to_unsigned (optarg, params.depth);
+                if (rc == 0 && params.depth == 0)
+                    rc = -1;
+                break;
+            case 'O': /* --match-op */
+                params.match_op = optarg;
+                if (params.match_op != "allocate"
+                    && params.match_op != "allocate_orelse_reserve"
+                    && params.match_op != "allocate_with_satisfiability")
+                    rc = -1;
+                break;
+            case 'F': /* --match-format */
+                params.match_format = optarg;
+                if (!known_match_format (params.match_format))
+                    rc = -1;
+                break;
+            case 'P': /* --match-policies */
+                token = optarg;
+                boost::split (policies, token, boost::is_any_of (","));
+                for (auto &p : policies) {
+                    if (!known_match_policy (p))
+                        rc = -1;
+                    params.policies.push_back (p);
+                }
+                break;
+            case 'p': /* --prune-filters */
+                params.prune_filters.push_back (optarg);
+                break;
+            case 'S': /* --seed */
+                params.seed = strtoul (optarg, NULL, 10);
+                break;
+            case 'o': /* --output */
+                params.o_fname = optarg;
+                break;
+            case 'g': /* --grug-output */
+                params.grug_fname = optarg;
+                break;
+            default:
+                usage (1);
+                break;
+        }
+        if (rc != 0) {
+            std::cerr << "[ERROR] invalid argument for -" << (char)ch << ": ";
+            std::cerr << optarg << std::endl;
+            usage (1);
+        }
+    }
+
+    if (optind != argc)
+        usage (1);
+    if (params.system.racks == 0 || params.system.nodes == 0
+        || params.system.sockets == 0 || params.system.cores == 0) {
+        std::cerr << "[ERROR] racks, nodes, sockets and cores must be nonzero"
+                  << std::endl;
+        usage (1);
+    }
+    if (params.shapes.empty ())
+        parse_shapes ("0:1:0,0:8:0,1:16:0", params.shapes);
+    if (params.policies.empty ())
+        params.policies.push_back (HIGH_ID_FIRST);
+    if (params.prune_filters.empty ())
+        params.prune_filters.push_back ("ALL:core");
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ *                     Recipe and Job Stream Generation                       *
+ *                                                                            *
+ ******************************************************************************/
+
+static void grug_key (std::ostream &o, const std::string &id,
+                      const std::string &dom, const std::string &type,
+                      const std::string &def)
+{
+    o << "    <key id=\"" << id << "\" for=\"" << dom << "\" attr.name=\""
+      << id << "\" attr.type=\"" << type << "\"";
+    if (def == "")
+        o << "/>\n";
+    else
+        o << ">\n        <default>" << def << "</default>\n    </key>\n";
+}
+
+static void grug_node (std::ostream &o, const std::string &type,
+                       bool root, unsigned size, const std::string &unit)
+{
+    o << "        <node id=\"" << type << "\">\n";
+    if (root)
+        o << "            <data key=\"root\">1</data>\n";
+    o << "            <data key=\"type\">" << type << "</data>\n"
+      << "            <data key=\"basename\">" << (root? "bench" : type)
+      << "</data>\n";
+    if (size != 0)
+        o << "            <data key=\"size\">" << size << "</data>\n";
+    if (unit != "")
+        o << "            <data key=\"unit\">" << unit << "</data>\n";
+    o << "        </node>\n";
+}
+
+static void grug_edge (std::ostream &o, const std::string &src,
+                       const std::string &tgt, unsigned scale, bool scoped)
+{
+    o << "        <edge id=\"" << src << "2" << tgt << "\" source=\"" << src
+      << "\" target=\"" << tgt << "\">\n";
+    if (scoped)
+        o << "            <data key=\"id_scope\">1</data>\n";
+    o << "            <data key=\"multi_scale\">" << scale << "</data>\n"
+      << "        </edge>\n";
+}
+
+static std::string generate_recipe (const bench_system_t &s)
+{
+    std::ostringstream o;
+
+    o << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<!-- generated by resource-bench: cluster[1]->rack["
+      << s.racks << "]->node[" << s.nodes << "]->socket[" << s.sockets
+      << "]->core[" << s.cores << "],gpu[" << s.gpus << "],memory["
+      << s.memory << "] -->\n"
+      << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n";
+    grug_key (o, "root", "node", "int", "0");
+    grug_key (o, "type", "node", "string", "");
+    grug_key (o, "basename", "node", "string", "");
+    grug_key (o, "unit", "node", "string", "");
+    grug_key (o, "size", "node", "long", "1");
+    grug_key (o, "subsystem", "node", "string", "containment");
+    grug_key (o, "e_subsystem", "edge", "string", "containment");
+    grug_key (o, "relation", "edge", "string", "contains");
+    grug_key (o, "rrelation", "edge", "string", "in");
+    grug_key (o, "id_scope", "edge", "int", "0");
+    grug_key (o, "id_start", "edge", "int", "0");
+    grug_key (o, "id_stride", "edge", "int", "1");
+    grug_key (o, "gen_method", "edge", "string", "MULTIPLY");
+    grug_key (o, "multi_scale", "edge", "int", "1");
+    grug_key (o, "as_tgt_subsystem", "edge", "string", "containment");
+    grug_key (o, "as_tgt_uplvl", "edge", "int", "1");
+    grug_key (o, "as_src_uplvl", "edge", "int", "1");
+
+    o << "    <graph id=\"bench\" edgedefault=\"directed\">\n";
+    grug_node (o, "cluster", true, 0, "");
+    grug_node (o, "rack", false, 0, "");
+    grug_node (o, "node", false, 0, "");
+    grug_node (o, "socket", false, 0, "");
+    grug_node (o, "core", false, 0, "");
+    if (s.gpus)
+        grug_node (o, "gpu", false, 0, "");
+    if (s.memory)
+        grug_node (o, "memory", false, 1, "GB");
+    grug_edge (o, "cluster", "rack", s.racks, false);
+    grug_edge (o, "rack", "node", s.nodes, false);
+    grug_edge (o, "node", "socket", s.sockets, false);
+    grug_edge (o, "socket", "core", s.cores, true);
+    if (s.gpus)
+        grug_edge (o, "socket", "gpu", s.gpus, true);
+    if (s.memory)
+        grug_edge (o, "socket", "memory", s.memory, true);
+    o << "    </graph>\n"
+      << "</graphml>\n";
+    return o.str ();
+}
+
+static unsigned div_ceil (unsigned n, unsigned d)
+{
+    return (d == 0)? n : (n + d - 1) / d;
+}
+
+static std::string generate_jobspec (const bench_system_t &s,
+                                     const bench_shape_t &shape,
+                                     uint64_t duration)
+{
+    std::ostringstream o;
+    std::string ind = shape.nodes? "        " : "";
+    unsigned nsockets = 1;
+
+    o << "version: 9999\n"
+      << "resources:\n";
+    if (shape.nodes) {
+        // Below a node, the request can't skip the socket level: spread
+        // the slot over as few sockets as hold its cores and gpus
+        nsockets = std::max (div_ceil (shape.cores, s.cores),
+                             div_ceil (shape.gpus, s.gpus));
+        nsockets = std::max (nsockets, 1u);
+        o << "  - type: node\n"
+          << "    count: " << shape.nodes << "\n"
+          << "    with:\n"
+          << "      - type: slot\n"
+          << "        count: 1\n"
+          << "        label: default\n"
+          << "        with:\n"
+          << "          - type: socket\n"
+          << "            count: " << nsockets << "\n"
+          << "            with:\n";
+    } else {
+        o << "  - type: slot\n"
+          << "    count: 1\n"
+          << "    label: default\n"
+          << "    with:\n";
+    }
+    if (shape.cores)
+        o << ind << "      - type: core\n"
+          << ind << "        count: " << div_ceil (shape.cores, nsockets)
+          << "\n";
+    if (shape.gpus)
+        o << ind << "      - type: gpu\n"
+          << ind << "        count: " << div_ceil (shape.gpus, nsockets)
+          << "\n";
+    o << "attributes:\n"
+      << "  system:\n"
+      << "    duration: " << duration << "\n"
+      << "tasks:\n"
+      << "  - command: [ \"app\" ]\n"
+      << "    slot: default\n"
+      << "    count:\n"
+      << "      per_slot: 1\n";
+    return o.str ();
+}
+
+static void generate_jobs (const bench_params_t &params,
+                           std::vector<bench_job_t> &jobs)
+{
+    std::mt19937_64 gen (params.seed);
+    std::uniform_int_distribution<size_t> shape (0, params.shapes.size () - 1);
+    std::uniform_int_distribution<uint64_t> duration (params.min_duration,
+                                                      params.max_duration);
+    jobs.clear ();
+    jobs.reserve (params.njobs);
+    for (unsigned i = 0; i < params.njobs; i++) {
+        bench_job_t job;
+        job.shape = shape (gen);
+        job.duration = duration (gen);
+        jobs.push_back (job);
+    }
+}
+
+
+/******************************************************************************
+ *                                                                            *
+ *                              Benchmark Run                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+static match_op_t to_match_op (const std::string &op)
+{
+    if (op == "allocate")
+        return match_op_t::MATCH_ALLOCATE;
+    else if (op == "allocate_with_satisfiability")
+        return match_op_t::MATCH_ALLOCATE_W_SATISFIABILITY;
+    return match_op_t::MATCH_ALLOCATE_ORELSE_RESERVE;
+}
+
+static int setup (const bench_params_t &params, const std::string &recipe,
+                  const std::string &policy, const std::string &filters,
+                  std::shared_ptr<resource_graph_db_t> &db,
+                  std::shared_ptr<f_resource_graph_t> &fgraph,
+                  std::shared_ptr<dfu_match_cb_t> &matcher,
+                  std::shared_ptr<dfu_traverser_t> &traverser,
+                  std::shared_ptr<match_writers_t> &writers)
+{
+    std::shared_ptr<resource_reader_base_t> rd;
+
+    try {
+        db = std::make_shared<resource_graph_db_t> ();
+        traverser = std::make_shared<dfu_traverser_t> ();
+    } catch (std::bad_alloc &e) {
+        std::cerr << "ERROR: out of memory" << std::endl;
+        return -1;
+    }
+    if ( !(rd = create_resource_reader ("grug"))) {
+        std::cerr << "ERROR: can't create grug reader" << std::endl;
+        return -1;
+    }
+    if (db->load (recipe, rd) != 0) {
+        std::cerr << "ERROR: " << rd->err_message () << std::endl;
+        return -1;
+    }
+    if ( !(matcher = create_match_cb (policy))) {
+        std::cerr << "ERROR: unknown match policy " << policy << std::endl;
+        return -1;
+    }
+    matcher->set_matcher_name ("CA");
+    matcher->add_subsystem ("containment", "*");
+
+    resource_graph_t &g = db->resource_graph;
+    vtx_infra_map_t vmap = get (&resource_pool_t::idata, g);
+    edg_infra_map_t emap = get (&resource_relation_t::idata, g);
+    const multi_subsystemsS &filter = matcher->subsystemsS ();
+    subsystem_selector_t<vtx_t, f_vtx_infra_map_t> vtxsel (vmap, filter);
+    subsystem_selector_t<edg_t, f_edg_infra_map_t> edgsel (emap, filter);
+    try {
+        fgraph = std::make_shared<f_resource_graph_t> (g, edgsel, vtxsel);
+    } catch (std::bad_alloc &e) {
+        std::cerr << "ERROR: out of memory allocating f_resource_graph_t"
+                  << std::endl;
+        return -1;
+    }
+
+    if (filters != "none"
+        && matcher->set_pruning_types_w_spec (matcher->dom_subsystem (),
+                                              filters) < 0) {
+        std::cerr << "ERROR: setting pruning filters: " << filters
+                  << std::endl;
+        return -1;
+    }
+    if (traverser->initialize (fgraph, db, matcher) != 0) {
+        std::cerr << "ERROR: initializing traverser" << std::endl;
+        return -1;
+    }
+    match_format_t format = match_writers_factory_t::
+                                get_writers_type (params.match_format);
+    if ( !(writers = match_writers_factory_t::create (format))) {
+        std::cerr << "ERROR: out of memory allocating writers" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+static int drive (const bench_params_t &params,
+                  const std::vector<bench_job_t> &jobs,
+                  std::shared_ptr<dfu_traverser_t> &traverser,
+                  std::shared_ptr<match_writers_t> &writers,
+                  bench_result_t &r)
+{
+    int64_t jobid = 0;
+    std::deque<int64_t> queue;
+    std::vector<std::string> specs;
+    match_op_t op = to_match_op (params.match_op);
+
+    for (auto &job : jobs) {
+        int rc = 0;
+        int64_t at = 0;
+        uint64_t start, elapse;
+        std::stringstream o;
+
+        while (queue.size () >= params.depth) {
+            start = match_perf_now ();
+            rc = traverser->remove (queue.front (), 0);
+            elapse = match_perf_now () - start;
+            if (rc != 0) {
+                std::cerr << "ERROR: cancel jobid=" << queue.front ()
+                          << ": " << traverser->err_message ();
+                return -1;
+            }
+            r.cancel.record (elapse);
+            r.sched_ns += elapse;
+            r.canceled++;
+            queue.pop_front ();
+        }
+
+        // Jobspec parsing isn't part of the matcher: keep it off the clock.
+        Flux::Jobspec::Jobspec js {generate_jobspec (params.system,
+                                                     params.shapes[job.shape],
+                                                     job.duration)};
+        jobid++;
+        start = match_perf_now ();
+        rc = traverser->run (js, writers, op, jobid, &at);
+        // The rv1 writers return the number of R_lite entries they emit
+        if (rc == 0 && writers->emit (o) < 0)
+            rc = -1;
+        elapse = match_perf_now () - start;
+        r.match.record (elapse);
+        r.sched_ns += elapse;
+        r.preorder.record (traverser->get_total_preorder_count ());
+
+        if (rc == 0) {
+            if (at == 0)
+                r.allocated++;
+            else
+                r.reserved++;
+            queue.push_back (jobid);
+        } else if (errno == EBUSY) {
+            r.busy++;
+        } else if (errno == ENODEV) {
+            r.unsat++;
+        } else {
+            r.errors++;
+        }
+        traverser->clear_err_message ();
+    }
+    return 0;
+}
+
+static void hist_to_json (std::ostream &o, const std::string &key,
+                          const log_linear_hist_t &h)
+{
+    o << "\"" << key << "\": {"
+      << "\"count\": " << h.count ()
+      << ", \"min\": " << h.min ()
+      << ", \"mean\": " << static_cast<uint64_t> (h.mean ())
+      << ", \"p50\": " << h.percentile (0.50)
+      << ", \"p90\": " << h.percentile (0.90)
+      << ", \"p99\": " << h.percentile (0.99)
+      << ", \"p999\": " << h.percentile (0.999)
+      << ", \"max\": " << h.max () << "}";
+}
+
+static void result_to_json (std::ostream &o, const bench_params_t &params,
+                            const std::string &policy,
+                            const std::string &filters,
+                            const bench_result_t &r)
+{
+    struct rusage ru;
+    double secs = static_cast<double> (r.sched_ns) / 1000000000.0f;
+    double jobs_per_sec = (secs > 0.0f)? params.njobs / secs : 0.0f;
+
+    getrusage (RUSAGE_SELF, &ru);
+    o << "{\"policy\": \"" << policy << "\""
+      << ", \"prune_filters\": \"" << filters << "\""
+      << ", \"match_op\": \"" << params.match_op << "\""
+      << ", \"racks\": " << params.system.racks
+      << ", \"nodes\": " << params.system.racks * params.system.nodes
+      << ", \"vertices\": " << r.nvertices
+      << ", \"edges\": " << r.nedges
+      << ", \"load_s\": " << static_cast<double> (r.load_ns) / 1000000000.0f
+      << ", \"jobs\": " << params.njobs
+      << ", \"queue_depth\": " << params.depth
+      << ", \"allocated\": " << r.allocated
+      << ", \"reserved\": " << r.reserved
+      << ", \"busy\": " << r.busy
+      << ", \"unsatisfiable\": " << r.unsat
+      << ", \"errors\": " << r.errors
+      << ", \"canceled\": " << r.canceled
+      << ", \"sched_s\": " << secs
+      << ", \"jobs_per_sec\": " << jobs_per_sec
+      << ", ";
+    hist_to_json (o, "match_ns", r.match);
+    o << ", ";
+    hist_to_json (o, "cancel_ns", r.cancel);
+    o << ", ";
+    hist_to_json (o, "preorder", r.preorder);
+    o << ", \"peak_rss_kb\": " << ru.ru_maxrss << "}" << std::endl;
+}
+
+static int run_bench (const bench_params_t &params, const std::string &recipe,
+                      const std::vector<bench_job_t> &jobs,
+                      const std::string &policy, const std::string &filters,
+                      std::ostream &out)
+{
+    uint64_t start;
+    bench_result_t r;
+    std::shared_ptr<resource_graph_db_t> db;
+    std::shared_ptr<f_resource_graph_t> fgraph;
+    std::shared_ptr<dfu_match_cb_t> matcher;
+    std::shared_ptr<dfu_traverser_t> traverser;
+    std::shared_ptr<match_writers_t> writers;
+
+    start = match_perf_now ();
+    if (setup (params, recipe, policy, filters,
+               db, fgraph, matcher, traverser, writers) < 0)
+        return -1;
+    r.load_ns = match_perf_now () - start;
+    r.nvertices = num_vertices (db->resource_graph);
+    r.nedges = num_edges (db->resource_graph);
+    if (drive (params, jobs, traverser, writers, r) < 0)
+        return -1;
+    result_to_json (out, params, policy, filters, r);
+    return 0;
+}
+
+static int run_isolated (const bench_params_t &params,
+                         const std::string &recipe,
+                         const std::vector<bench_job_t> &jobs,
+                         const std::string &policy, const std::string &filters,
+                         std::ostream &out)
+{
+    pid_t pid;
+    int status = 0;
+
+    out.flush ();
+    if ( (pid = fork ()) < 0) {
+        std::cerr << "ERROR: fork: " << strerror (errno) << std::endl;
+        return -1;
+    } else if (pid == 0) {
+        int rc = run_bench (params, recipe, jobs, policy, filters, out);
+        out.flush ();
+        _exit (rc == 0? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    if (waitpid (pid, &status, 0) < 0) {
+        std::cerr << "ERROR: waitpid: " << strerror (errno) << std::endl;
+        return -1;
+    }
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS) {
+        std::cerr << "ERROR: benchmark failed for policy=" << policy
+                  << " prune-filters=" << filters << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int main (int argc, char *argv[])
+{
+    int rc = EXIT_SUCCESS;
+    bench_params_t params;
+    std::string recipe;
+    std::ofstream o_file;
+    std::vector<bench_job_t> jobs;
+
+    process_args (params, argc, argv);
+    recipe = generate_recipe (params.system);
+    generate_jobs (params, jobs);
+
+    if (params.grug_fname != "") {
+        std::ofstream g_file (params.grug_fname);
+        g_file << recipe;
+        if (!g_file.good ()) {
+            std::cerr << "ERROR: can't write " << params.grug_fname
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (params.o_fname != "") {
+        o_file.open (params.o_fname);
+        if (!o_file.good ()) {
+            std::cerr << "ERROR: can't open " << params.o_fname << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &out = (params.o_fname != "")? o_file : std::cout;
+
+    for (auto &policy : params.policies) {
+        for (auto &filters : params.prune_filters) {
+            if (run_isolated (params, recipe, jobs,
+                              policy, filters, out) < 0)
+                rc = EXIT_FAILURE;
+        }
+    }
+    return rc;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -282,7 +282,7 @@ int jgf_match_writers_t::emit_vtx (const std::string &prefix,
         rc = -1;
         goto out;
     }
-    if ((rc = map2json (b, g[u].properties, "properties") < 0)) {
+    if ((rc = map2json (b, g[u].properties.get (), "properties") < 0)) {
         json_decref (b);
         goto out;
     }
@@ -6,6 +6,7 @@
 #
 from __future__ import print_function
 import argparse
+import os
 import errno
 import yaml
 import json
@@ -59,8 +60,11 @@ class ResourceModuleInterface:
         payload = {'jobid' : jobid}
         return self.f.rpc ("sched-fluxion-resource.info", payload).get ()
 
-    def rpc_stat (self):
-        return self.f.rpc ("sched-fluxion-resource.stat").get ()
+    def rpc_stat (self, reset=False):
+        if not reset:
+            return self.f.rpc ("sched-fluxion-resource.stat").get ()
+        payload = {'reset' : True}
+        return self.f.rpc ("sched-fluxion-resource.stat", payload).get ()
 
     def rpc_cancel (self, jobid):
         payload = {'jobid' : jobid}
@@ -84,6 +88,9 @@ class ResourceModuleInterface:
     def rpc_status (self):
         return self.f.rpc ("sched-fluxion-resource.status").get ()
 
+    def rpc_trace (self, payload=None):
+        return self.f.rpc ("sched-fluxion-resource.trace", payload).get ()
+
     def rpc_namespace_info (self, rank, type_name, identity):
         payload = {'rank' : rank, 'type-name' : type_name, 'id' : identity}
         return self.f.rpc ("sched-fluxion-resource.ns-info", payload).get ()
@@ -169,7 +176,10 @@ def info_action (args):
 """
 def stat_action (args):
     r = ResourceModuleInterface ()
-    resp = r.rpc_stat ()
+    resp = r.rpc_stat (args.reset)
+    if args.json:
+        print (json.dumps (resp['match']))
+        return
     print ("Num. of Vertices: ", resp['V'])
     print ("Num. of Edges: ", resp['E'])
     print ("Num. of Vertices by Rank: ", json.dumps (resp['by_rank']))
@@ -178,6 +188,17 @@ def stat_action (args):
     print ("Min. Match Time: ", resp['min-match'], "Secs")
     print ("Max. Match Time: ", resp['max-match'], "Secs")
     print ("Avg. Match Time: ", resp['avg-match'], "Secs")
+    for op, perf in sorted (resp['match'].items ()):
+        if perf['phases']['total']['count'] == 0:
+            continue
+        print ("Match Op: ", op)
+        for phase, h in sorted (perf['phases'].items ()):
+            print ("    {:8} p50={:.6f} p99={:.6f} p999={:.6f} max={:.6f} Secs"
+                   .format (phase, h['p50'], h['p99'], h['p999'], h['max']))
+        for visit in ['preorder', 'postorder']:
+            h = perf[visit]
+            print ("    {:8} p50={:.0f} p99={:.0f} p999={:.0f} max={:.0f}"
+                   .format (visit, h['p50'], h['p99'], h['p999'], h['max']))
 
 """
     Action for set-property sub-command
@@ -224,6 +245,21 @@ def status_action (args):
     print ('MATCHED RESOURCES:')
     print (json.dumps (resp))
 
+"""
+    Action for trace sub-command
+"""
+def trace_action (args):
+    r = ResourceModuleInterface ()
+    payload = None
+    if args.action == 'on':
+        if not args.file:
+            raise ValueError ('trace on requires a file')
+        payload = {'enable' : True, 'file' : os.path.abspath (args.file),
+                   'threshold' : args.threshold, 'sample' : args.sample}
+    elif args.action == 'off':
+        payload = {'enable' : False}
+    print (json.dumps (r.rpc_trace (payload)))
+
 """
     Action for ns-info sub-command
 """
@@ -263,6 +299,7 @@ def main ():
     pstr = "Set property-key=value for specified resource."
     gstr = "Get value for specified resource and property-key."
     nstr = "Get remapped ID given raw ID seen by the selected reader."
+    tstr = "Trace the DFU walks of slow matches in Chrome trace format"
     parser_m = subpar.add_parser ('match', help=mstr, description=mstr)
     parser_u = subpar.add_parser ('update', help=ustr, description=ustr)
     parser_i = subpar.add_parser ('info', help=istr, description=istr)
@@ -273,6 +310,7 @@ def main ():
     parser_sp = subpar.add_parser ('set-property', help=pstr, description=pstr)
     parser_gp = subpar.add_parser ('get-property', help=gstr, description=gstr)
     parser_n = subpar.add_parser ('ns-info', help=nstr, description=nstr)
+    parser_t = subpar.add_parser ('trace', help=tstr, description=tstr)
 
     #
     # Add subparser for the match sub-command
@@ -307,6 +345,10 @@ def main ():
     #
     # Action for stat sub-command
     #
+    parser_s.add_argument ('-r', '--reset', action='store_true',
+                           help='Reset match statistics after reporting')
+    parser_s.add_argument ('-j', '--json', action='store_true',
+                           help='Print per-op match statistics in JSON')
     parser_s.set_defaults (func=stat_action)
 
     #
@@ -377,6 +419,19 @@ def main ():
                            help='raw Id seen by the reader')
     parser_n.set_defaults (func=namespace_info_action)
 
+    # Arguments for trace sub-command
+    #
+    parser_t.add_argument ('action', metavar='Action', type=str,
+                           choices=['on', 'off', 'status'],
+                           help='on | off | status')
+    parser_t.add_argument ('file', metavar='File', type=str, nargs='?',
+                           help='trace output file (with on)')
+    parser_t.add_argument ('-t', '--threshold', type=float, default=0.0,
+                           help='keep matches slower than this (seconds)')
+    parser_t.add_argument ('-s', '--sample', type=int, default=1,
+                           help='record one out of every SAMPLE matches')
+    parser_t.set_defaults (func=trace_action)
+
     #
     # Parse the args and call an action routine as part of that
     #
@@ -47,6 +47,30 @@ test_expect_success 'qmanager: rapidly cancel all jobs' '
     flux queue idle
 '
 
+for policy in easy hybrid conservative
+do
+    test_expect_success "qmanager: reloading qmanager (queue-policy=${policy})" '
+        reload_qmanager queue-policy=${policy}
+    '
+
+    test_expect_success "qmanager: many basic job submitted (${policy})" '
+        jobid=$(flux job submit basic.json) &&
+        flux job wait-event -t 10 ${jobid} start &&
+        submit_jobs 30 basic.json > jobids.${policy} &&
+        next=$(head -n 1 jobids.${policy})
+    '
+
+    test_expect_success "qmanager: a cancel leads to a job schedule (${policy})" '
+        flux job cancel ${jobid} &&
+        flux job wait-event -t 10 ${next} start
+    '
+
+    test_expect_success "qmanager: rapidly cancel all jobs (${policy})" '
+        flux job cancelall -f &&
+        flux queue idle
+    '
+done
+
 test_expect_success 'removing resource and qmanager modules' '
     remove_qmanager &&
     remove_resource
@@ -0,0 +1,101 @@
+#!/bin/sh
+
+test_description='Test the state recovery of the resource module from its job log
+
+Both qmanager and resource restart and the resource module rebuilds
+its allocations from the job log before qmanager reconstructs them.
+'
+
+. `dirname $0`/sharness.sh
+
+hwloc_basepath=`readlink -e ${SHARNESS_TEST_SRCDIR}/data/hwloc-data`
+# 1 brokers, each (exclusively) have: 1 node, 2 sockets, 16 cores (8 per socket)
+excl_1N1B="${hwloc_basepath}/001N/exclusive/01-brokers"
+joblog=${SHARNESS_TRASH_DIRECTORY}/fluxion.joblog
+
+export FLUX_SCHED_MODULE=none
+test_under_flux 1
+
+test_expect_success 'joblog: generate a test jobspec' '
+    flux mini run --dry-run -N 1 -n 4 -t 1h sleep 3600 > basic.json
+'
+
+test_expect_success 'load test resources' '
+    load_test_resources ${excl_1N1B}
+'
+
+test_expect_success 'joblog: loading flux-sched modules works' '
+    load_resource load-allowlist=node,core,gpu match-format=rv1 \
+policy=high joblog-file=${joblog} joblog-checkpoint=4 &&
+    load_qmanager &&
+    test -f ${joblog}
+'
+
+# jobid1 - 4 will be scheduled; jobid 5 - 6 pending
+test_expect_success 'joblog: submit to occupy resources fully' '
+    jobid1=$(flux job submit basic.json) &&
+    jobid2=$(flux job submit basic.json) &&
+    jobid3=$(flux job submit basic.json) &&
+    jobid4=$(flux job submit basic.json) &&
+    jobid5=$(flux job submit basic.json) &&
+    jobid6=$(flux job submit basic.json) &&
+    flux job wait-event -t 10 ${jobid4} start &&
+    flux job wait-event -t 10 ${jobid6} submit
+'
+
+test_expect_success 'joblog: allocations are logged' '
+    test $(grep -c "^A " ${joblog}) -ge 4
+'
+
+test_expect_success 'joblog: cancel one running job without fluxion' '
+    remove_qmanager &&
+    remove_resource &&
+    flux job cancel ${jobid1} &&
+    flux job wait-event -t 10 ${jobid1} release
+'
+
+test_expect_success 'joblog: both modules restart and replay the log' '
+    load_resource load-allowlist=node,core,gpu match-format=rv1 \
+policy=high joblog-file=${joblog} joblog-checkpoint=4 &&
+    load_qmanager &&
+    flux module stats sched-fluxion-qmanager &&
+    flux module stats sched-fluxion-resource &&
+    flux dmesg | grep "replayed 4 of 4" &&
+    test_must_fail flux ion-resource info ${jobid1} &&
+    flux ion-resource info ${jobid2} | grep "ALLOCATED" &&
+    flux ion-resource info ${jobid3} | grep "ALLOCATED" &&
+    flux ion-resource info ${jobid4} | grep "ALLOCATED" &&
+    flux job wait-event -t 10 ${jobid5} start &&
+    test_expect_code 3 flux ion-resource info ${jobid6}
+'
+
+test_expect_success 'joblog: a cancel leads to a job schedule' '
+    flux job cancel ${jobid2} &&
+    flux job wait-event -t 10 ${jobid6} start
+'
+
+test_expect_success 'joblog: a truncated log falls back to R' '
+    remove_qmanager &&
+    remove_resource &&
+    head -n 1 ${joblog} > ${joblog}.trunc &&
+    mv ${joblog}.trunc ${joblog} &&
+    load_resource load-allowlist=node,core,gpu match-format=rv1 \
+policy=high joblog-file=${joblog} &&
+    load_qmanager &&
+    flux module stats sched-fluxion-qmanager &&
+    flux ion-resource info ${jobid3} | grep "ALLOCATED" &&
+    flux ion-resource info ${jobid4} | grep "ALLOCATED" &&
+    flux ion-resource info ${jobid5} | grep "ALLOCATED" &&
+    flux ion-resource info ${jobid6} | grep "ALLOCATED"
+'
+
+test_expect_success 'cleanup active jobs' '
+    cleanup_active_jobs
+'
+
+test_expect_success 'removing resource and qmanager modules' '
+    remove_qmanager &&
+    remove_resource
+'
+
+test_done
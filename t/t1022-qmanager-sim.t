@@ -0,0 +1,112 @@
+#!/bin/sh
+
+test_description='Test the offline qmanager simulator on a virtual clock'
+
+. `dirname $0`/sharness.sh
+
+grug="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/tiny.graphml"
+sim="../../qmanager/utilities/qmanager-sim"
+
+skip_all_unless_have jq
+
+# Usage: node_jobspec <nnodes> <duration>
+node_jobspec() {
+    cat <<-EOF
+	version: 9999
+	resources:
+	  - type: node
+	    count: $1
+	    with:
+	      - type: slot
+	        count: 1
+	        label: default
+	        with:
+	          - type: socket
+	            count: 2
+	            with:
+	              - type: core
+	                count: 18
+	attributes:
+	  system:
+	    duration: $2
+	tasks:
+	  - command: [ "app" ]
+	    slot: default
+	    count:
+	      per_slot: 1
+	EOF
+}
+
+test_expect_success 'generate jobspecs and a job trace' '
+    mkdir -p trace &&
+    node_jobspec 1 100 > trace/node1_100.yaml &&
+    node_jobspec 2 100 > trace/node2_100.yaml &&
+    node_jobspec 1 50 > trace/node1_50.yaml &&
+    node_jobspec 3 100 > trace/node3_100.yaml &&
+    cat > trace/trace001 <<-EOF
+	# submit duration jobspec
+	0 100 node1_100.yaml
+	1 100 node2_100.yaml
+	2 10 node1_50.yaml
+	EOF
+'
+
+test_expect_success 'fcfs blocks the short job behind the large one' '
+    ${sim} -L ${grug} -t trace/trace001 -Q fcfs -E events001 \
+> out001.json &&
+    test $(jq ".completed" out001.json) -eq 3 &&
+    test $(jq ".makespan" out001.json) -eq 210 &&
+    test $(jq ".wait.max" out001.json) -eq 198 &&
+    test $(jq ".cores" out001.json) -eq 72 &&
+    test $(wc -l < events001) -eq 6 &&
+    test $(jq -s "map(.t)" events001 | jq -c .) = "[0,1,2,100,200,210]"
+'
+
+test_expect_success 'easy backfills the short job onto the idle node' '
+    ${sim} -L ${grug} -t trace/trace001 -Q easy -o out002.json &&
+    test $(jq ".completed" out002.json) -eq 3 &&
+    test $(jq ".makespan" out002.json) -eq 200 &&
+    test $(jq ".wait.max" out002.json) -eq 99 &&
+    jq -e ".utilization > $(jq .utilization out001.json)" out002.json
+'
+
+test_expect_success 'conservative and hybrid policies replay the trace' '
+    ${sim} -L ${grug} -t trace/trace001 -Q conservative > out003.json &&
+    test $(jq ".completed" out003.json) -eq 3 &&
+    ${sim} -L ${grug} -t trace/trace001 -Q hybrid -r reservation-depth=2 \
+> out004.json &&
+    test $(jq ".completed" out004.json) -eq 3
+'
+
+test_expect_success 'a run is cut short at the jobspec duration' '
+    cat > trace/trace002 <<-EOF &&
+	0 1000 node1_50.yaml
+	EOF
+    ${sim} -L ${grug} -t trace/trace002 > out005.json &&
+    test $(jq ".makespan" out005.json) -eq 50
+'
+
+test_expect_success 'unsatisfiable jobs are rejected' '
+    cat > trace/trace003 <<-EOF &&
+	0 10 node3_100.yaml
+	0 10 node1_50.yaml
+	EOF
+    ${sim} -L ${grug} -t trace/trace003 > out006.json &&
+    test $(jq ".rejected" out006.json) -eq 1 &&
+    test $(jq ".completed" out006.json) -eq 1
+'
+
+test_expect_success 'scheduler CPU time is reported per event' '
+    jq -e ".sched_cpu_ns.count == .events and .sched_cpu_s >= 0" \
+out001.json &&
+    jq -s -e "all (.[]; .sched_cpu_ns >= 0)" events001
+'
+
+test_expect_success 'malformed traces are rejected' '
+    echo "0 foo node1_50.yaml" > trace/bad &&
+    test_must_fail ${sim} -L ${grug} -t trace/bad &&
+    test_must_fail ${sim} -L ${grug} -t trace/nosuchtrace &&
+    test_must_fail ${sim} -L ${grug} -t trace/trace001 -Q nosuchpolicy
+'
+
+test_done
@@ -7,6 +7,7 @@ test_description='Test reservations of jobs of varying geometries and durations'
 cmd_dir="${SHARNESS_TEST_SRCDIR}/data/resource/commands/reservation"
 exp_dir="${SHARNESS_TEST_SRCDIR}/data/resource/expected/reservation"
 grugs="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/resv_test.graphml"
+hetero="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/hetero.graphml"
 query="../../resource/utilities/resource-query"
 
 #
@@ -37,4 +38,18 @@ test_expect_success "${test002_desc}" '
     test_cmp 002.R.out ${exp_dir}/002.R.out
 '
 
+#
+# Heterogeneous nodes -- nodes too small for a request must not end
+#     the search for a reservation (e.g., with an ERANGE left over
+#     from probing their subtree plans)
+#
+
+cmds003="${cmd_dir}/cmds02.in"
+test003_desc="reserve past nodes too small for the job (pol=hi)"
+test_expect_success "${test003_desc}" '
+    sed "s~@TEST_SRCDIR@~${SHARNESS_TEST_SRCDIR}~g" ${cmds003} > cmds003 &&
+    ${query} -L ${hetero} -S CA -P high -t 003.R.out < cmds003 &&
+    test_cmp 003.R.out ${exp_dir}/003.R.out
+'
+
 test_done
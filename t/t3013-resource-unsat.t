@@ -33,4 +33,26 @@ test_expect_success "${test003_desc}" '
     test_cmp 003.R.out ${exp_dir}/003.R.out
 '
 
+test004_desc="cache satisfiability verdicts until the graph changes"
+test_expect_success "${test004_desc}" '
+    jobspec=${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/satisfiability/test014.yaml &&
+    cat > cmds004 <<-EOF &&
+	match allocate_with_satisfiability ${jobspec}
+	match allocate_with_satisfiability ${jobspec}
+	match allocate_with_satisfiability ${jobspec}
+	match allocate_with_satisfiability ${jobspec}
+	set-property /tiny0/rack0/node0 color=blue
+	match allocate_with_satisfiability ${jobspec}
+	match allocate_with_satisfiability ${jobspec}
+	quit
+EOF
+    ${query} -L ${grugs} -S CA -P low -e < cmds004 > 004.R.out &&
+    test $(grep -c "No matching resources found" 004.R.out) -eq 4 &&
+    grep "PREORDER VISIT COUNT" 004.R.out | sed "s/.*=//" > 004.counts &&
+    miss=$(sed -n 3p 004.counts) && hit=$(sed -n 4p 004.counts) &&
+    test ${hit} -lt ${miss} &&
+    test $(sed -n 5p 004.counts) -eq ${miss} &&
+    test $(sed -n 6p 004.counts) -eq ${hit}
+'
+
 test_done
@@ -0,0 +1,77 @@
+#!/bin/sh
+
+test_description='Test tracing of slow matches in Chrome trace format'
+
+. $(dirname $0)/sharness.sh
+
+jobspec="${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/basics/test001.yaml"
+grugs="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/tiny.graphml"
+query="../../resource/utilities/resource-query"
+
+skip_all_unless_have jq
+
+test_expect_success 'tracing all matches records the DFU walks' '
+    cat > cmds001 <<-EOF &&
+	trace on trace001.json
+	match allocate ${jobspec}
+	match allocate ${jobspec}
+	trace off
+	match allocate ${jobspec}
+	quit
+EOF
+    ${query} -L ${grugs} -S CA -P high < cmds001 &&
+    jq -e "length > 0" trace001.json &&
+    test $(jq "[.[] | select (.name == \"match\")] | length" trace001.json) \
+-eq 2 &&
+    test $(jq "[.[] | select (.name == \"match\")][0].args.jobid" \
+trace001.json) -eq 1 &&
+    for n in select dom_dfv prune resolve update \
+planner_avail_resources_during; do
+        jq -e "any (.[]; .name == \"${n}\")" trace001.json || return 1
+    done
+'
+
+test_expect_success 'trace events are complete events tagged with vertices' '
+    jq -e "all (.[]; .ph == \"X\" and .dur >= 0 and .args.path != null)" \
+trace001.json &&
+    jq -e "any (.[]; .name == \"dom_dfv\" and .args.type == \"node\")" \
+trace001.json
+'
+
+test_expect_success 'matches faster than the threshold are not kept' '
+    cat > cmds002 <<-EOF &&
+	trace on trace002.json 100000
+	match allocate ${jobspec}
+	quit
+EOF
+    ${query} -L ${grugs} -S CA -P high < cmds002 &&
+    test $(jq "length" trace002.json) -eq 0
+'
+
+test_expect_success 'only one out of every sample matches is recorded' '
+    cat > cmds003 <<-EOF &&
+	trace on trace003.json 0 2
+	match allocate ${jobspec}
+	match allocate ${jobspec}
+	match allocate ${jobspec}
+	quit
+EOF
+    ${query} -L ${grugs} -S CA -P high < cmds003 &&
+    test $(jq "[.[] | select (.name == \"match\")] | length" trace003.json) \
+-eq 2
+'
+
+test_expect_success 'satisfiability and reserve matches are traced' '
+    cat > cmds004 <<-EOF &&
+	trace on trace004.json
+	match allocate_with_satisfiability ${jobspec}
+	match allocate_orelse_reserve ${jobspec}
+	quit
+EOF
+    ${query} -L ${grugs} -S CA -P high < cmds004 &&
+    jq -e "any (.[]; .args.op == \"allocate_with_satisfiability\")" \
+trace004.json &&
+    jq -e "any (.[]; .args.op == \"allocate_orelse_reserve\")" trace004.json
+'
+
+test_done
@@ -0,0 +1,77 @@
+#!/bin/sh
+
+test_description='Test the synthetic workload benchmark of the resource matcher'
+
+. $(dirname $0)/sharness.sh
+
+bench="../../resource/utilities/resource-bench"
+query="../../resource/utilities/resource-query"
+
+skip_all_unless_have jq
+
+test_expect_success 'resource-bench runs one combination by default' '
+    ${bench} -N 2 -c 4 -j 20 -q 4 > out001.json &&
+    test $(wc -l < out001.json) -eq 1 &&
+    test $(jq ".policy" out001.json) = "\"high\"" &&
+    test $(jq ".prune_filters" out001.json) = "\"ALL:core\"" &&
+    test $(jq ".jobs" out001.json) -eq 20
+'
+
+test_expect_success 'resource-bench reports every policy and filter set' '
+    ${bench} -N 2 -s 2 -c 4 -G 1 -J 0:2:0,1:4:1 -j 50 -q 4 \
+-P high,low -p ALL:core -p none -o out002.json &&
+    test $(wc -l < out002.json) -eq 4 &&
+    test $(jq -c -s "map(.vertices) | unique" out002.json) = "[28]" &&
+    jq -s -e "all (.[]; .errors == 0 and .unsatisfiable == 0)" \
+out002.json &&
+    jq -s -e "all (.[]; .allocated + .reserved + .busy == 50)" \
+out002.json &&
+    jq -s -e "all (.[]; .canceled > 0 and .match_ns.count == 50)" \
+out002.json &&
+    jq -s -e "all (.[]; .match_ns.p50 <= .match_ns.p99 and
+.match_ns.p99 <= .match_ns.max)" out002.json &&
+    jq -s -e "all (.[]; .jobs_per_sec > 0 and .peak_rss_kb > 0)" \
+out002.json
+'
+
+test_expect_success 'the default rv1_nosched format counts matches' '
+    ${bench} -N 2 -s 2 -c 4 -J 0:2:0 -j 10 > out007.a.json &&
+    ${bench} -N 2 -s 2 -c 4 -J 0:2:0 -j 10 -F simple > out007.b.json &&
+    jq -e ".errors == 0 and .allocated > 0" out007.a.json &&
+    for k in allocated reserved busy errors; do
+        test $(jq ".${k}" out007.a.json) -eq $(jq ".${k}" out007.b.json) \
+|| return 1
+    done
+'
+
+test_expect_success 'the same seed yields the same job stream' '
+    ${bench} -N 2 -c 4 -j 40 -q 8 -S 7 > out003.a.json &&
+    ${bench} -N 2 -c 4 -j 40 -q 8 -S 7 > out003.b.json &&
+    for k in allocated reserved busy canceled; do
+        test $(jq ".${k}" out003.a.json) -eq $(jq ".${k}" out003.b.json) \
+|| return 1
+    done
+'
+
+test_expect_success 'unsatisfiable shapes are counted' '
+    ${bench} -N 2 -c 4 -J 4:1:0 -j 5 -O allocate_with_satisfiability \
+> out004.json &&
+    test $(jq ".unsatisfiable" out004.json) -eq 5
+'
+
+test_expect_success 'the generated recipe can be loaded by resource-query' '
+    ${bench} -R 2 -N 2 -c 4 -m 2 -j 1 -g bench.graphml > out005.json &&
+    echo "quit" > cmds005 &&
+    ${query} -L bench.graphml -e -S CA -P high < cmds005 > out005.txt &&
+    vtx=$(grep "Vertex" out005.txt | sed "s/INFO: Vertex Count: //") &&
+    test ${vtx} -eq $(jq ".vertices" out005.json)
+'
+
+test_expect_success 'resource-bench rejects invalid arguments' '
+    test_must_fail ${bench} -J 1:0:0 &&
+    test_must_fail ${bench} -D 10:1 &&
+    test_must_fail ${bench} -q 0 &&
+    test_must_fail ${bench} -P nosuchpolicy
+'
+
+test_done
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+test_description='Test resource graph shrinkage'
+
+. $(dirname $0)/sharness.sh
+
+node1_job="${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/shrink/node1.yaml"
+full_job="${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/RV/full.yaml"
+exp_dir="${SHARNESS_TEST_SRCDIR}/data/resource/expected/shrink"
+jgf="${SHARNESS_TEST_SRCDIR}/data/resource/jgfs/4node.rank0123.nid0123.orig.json"
+query="../../resource/utilities/resource-query"
+
+test_expect_success 'shrink removes idle ranks and keeps allocations' '
+    cat > cmds001 <<-EOF &&
+	match allocate ${node1_job}
+	shrink 0 1
+	find status=up
+	match allocate_with_satisfiability ${full_job}
+	match allocate ${node1_job}
+	match allocate ${node1_job}
+	quit
+EOF
+    ${query} -L ${jgf} -f jgf -F rv1_nosched -t 001.R.out -P high \
+    < cmds001 &&
+    test_cmp 001.R.out ${exp_dir}/001.R.out
+'
+
+test_expect_success 'shrink refuses a rank with a job or the root' '
+    cat > cmds002 <<-EOF &&
+	match allocate ${node1_job}
+	shrink 3
+	shrink -1
+	find status=up
+	cancel 1
+	shrink 3
+	find status=up
+	quit
+EOF
+    ${query} -L ${jgf} -f jgf -F rv1_nosched -t 002.R.out -P high \
+    < cmds002 2> 002.R.err &&
+    test_cmp 002.R.out ${exp_dir}/002.R.out &&
+    test_cmp 002.R.err ${exp_dir}/002.R.err
+'
+
+test_expect_success 'shrink with an unknown rank is a no-op' '
+    cat > cmds003 <<-EOF &&
+	shrink 7
+	find status=up
+	quit
+EOF
+    ${query} -L ${jgf} -f jgf -F rv1_nosched -t 003.R.out -P high \
+    < cmds003 &&
+    test_cmp 003.R.out ${exp_dir}/003.R.out
+'
+
+test_done
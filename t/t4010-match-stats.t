@@ -0,0 +1,83 @@
+#!/bin/sh
+#set -x
+
+test_description='Test per-phase match statistics of the resource module
+
+Ensure that stat reports per-op latency and visit distributions
+and that they can be reset
+'
+
+ORIG_HOME=${HOME}
+
+. `dirname $0`/sharness.sh
+
+#
+# sharness modifies $HOME environment variable, but this interferes
+# with python's package search path, in particular its user site package.
+#
+HOME=${ORIG_HOME}
+
+grug="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/tiny.graphml"
+jobspec="${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/basics/test001.yaml"
+
+skip_all_unless_have jq
+
+#
+# test_under_flux is under sharness.d/
+#
+test_under_flux 1
+
+test_expect_success 'loading resource module with a tiny machine config works' '
+    load_resource \
+load-file=${grug} prune-filters=ALL:core \
+load-format=grug subsystems=containment policy=high
+'
+
+test_expect_success 'stat reports empty distributions before any match' '
+    flux ion-resource stat -j > stat.0 &&
+    test $(jq ".allocate.phases.total.count" stat.0) -eq 0 &&
+    test $(jq ".update.phases.total.count" stat.0) -eq 0
+'
+
+test_expect_success 'match ops are recorded under their own op' '
+    flux ion-resource match allocate ${jobspec} &&
+    flux ion-resource match allocate ${jobspec} &&
+    flux ion-resource match allocate_orelse_reserve ${jobspec} &&
+    flux ion-resource match allocate_with_satisfiability ${jobspec} &&
+    flux ion-resource stat -j > stat.1 &&
+    test $(jq ".allocate.phases.total.count" stat.1) -eq 2 &&
+    test $(jq ".allocate_orelse_reserve.phases.total.count" stat.1) -eq 1 &&
+    test $(jq ".allocate_with_satisfiability.phases.total.count" stat.1) \
+-eq 1
+'
+
+test_expect_success 'every phase and visit distribution is reported' '
+    for p in parse select avail update emit total; do
+        jq -e ".allocate.phases.${p} | .p50, .p99, .p999" stat.1 || return 1
+    done &&
+    test $(jq ".allocate.preorder.count" stat.1) -eq 2 &&
+    test $(jq ".allocate.preorder.max > 0" stat.1) = "true" &&
+    test $(jq ".allocate.postorder.max > 0" stat.1) = "true" &&
+    test $(jq ".allocate.phases.total.p50 <= .allocate.phases.total.max" \
+stat.1) = "true"
+'
+
+test_expect_success 'stat without JSON output prints per-op summaries' '
+    flux ion-resource stat > stat.out &&
+    grep "Match Op:  allocate" stat.out &&
+    grep p999 stat.out
+'
+
+test_expect_success 'stat --reset reports and then clears the statistics' '
+    flux ion-resource stat --reset -j > stat.2 &&
+    test $(jq ".allocate.phases.total.count" stat.2) -eq 2 &&
+    flux ion-resource stat -j > stat.3 &&
+    test $(jq ".allocate.phases.total.count" stat.3) -eq 0 &&
+    test $(jq ".allocate_orelse_reserve.phases.total.count" stat.3) -eq 0
+'
+
+test_expect_success 'removing resource works' '
+    remove_resource
+'
+
+test_done
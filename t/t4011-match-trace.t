@@ -0,0 +1,72 @@
+#!/bin/sh
+#set -x
+
+test_description='Test runtime tracing of slow matches in the resource module
+'
+
+ORIG_HOME=${HOME}
+
+. `dirname $0`/sharness.sh
+
+#
+# sharness modifies $HOME environment variable, but this interferes
+# with python's package search path, in particular its user site package.
+#
+HOME=${ORIG_HOME}
+
+grug="${SHARNESS_TEST_SRCDIR}/data/resource/grugs/tiny.graphml"
+jobspec="${SHARNESS_TEST_SRCDIR}/data/resource/jobspecs/basics/test001.yaml"
+
+skip_all_unless_have jq
+
+#
+# test_under_flux is under sharness.d/
+#
+test_under_flux 1
+
+test_expect_success 'loading resource module with a tiny machine config works' '
+    load_resource \
+load-file=${grug} prune-filters=ALL:core \
+load-format=grug subsystems=containment policy=high
+'
+
+test_expect_success 'tracing is off by default' '
+    flux ion-resource trace status > status.0 &&
+    test $(jq ".enabled" status.0) = "false"
+'
+
+test_expect_success 'trace on requires a file' '
+    test_must_fail flux ion-resource trace on
+'
+
+test_expect_success 'matches are traced once tracing is turned on' '
+    flux ion-resource trace on trace.json > status.1 &&
+    test $(jq ".enabled" status.1) = "true" &&
+    flux ion-resource match allocate ${jobspec} &&
+    flux ion-resource match allocate ${jobspec} &&
+    flux ion-resource trace status > status.2 &&
+    test $(jq ".kept" status.2) -eq 2 &&
+    test $(jq "[.[] | select (.name == \"match\")] | length" trace.json) \
+-eq 2 &&
+    jq -e "any (.[]; .name == \"dom_dfv\")" trace.json
+'
+
+test_expect_success 'a large threshold drops fast matches' '
+    flux ion-resource trace on trace2.json -t 100 &&
+    flux ion-resource match allocate ${jobspec} &&
+    flux ion-resource trace status > status.3 &&
+    test $(jq ".kept" status.3) -eq 0 &&
+    test $(jq ".dropped" status.3) -eq 1 &&
+    test $(jq "length" trace2.json) -eq 0
+'
+
+test_expect_success 'tracing can be turned off' '
+    flux ion-resource trace off > status.4 &&
+    test $(jq ".enabled" status.4) = "false"
+'
+
+test_expect_success 'removing resource works' '
+    remove_resource
+'
+
+test_done